@@ -0,0 +1,84 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-13
+// Last changed:
+//
+// Run in parallel (mpirun -n N) to measure scaling of the distributed
+// dual graph construction used for mesh partitioning. The number of
+// threads for the local part is set by --num_threads.
+
+#include <dolfin.h>
+
+using namespace dolfin;
+
+#define NUM_REPS 5
+#define SIZE 64
+
+int main(int argc, char* argv[])
+{
+  info("Building distributed dual graph for unit cube of size %d x %d x %d (%d repetitions)",
+       SIZE, SIZE, SIZE, NUM_REPS);
+
+  parameters.parse(argc, argv);
+
+  UnitCubeMesh mesh(SIZE, SIZE, SIZE);
+  const std::size_t D = mesh.topology().dim();
+
+  // Copy cells of distributed mesh to local mesh data, using global
+  // vertex indices
+  LocalMeshData data(mesh.mpi_comm());
+  data.gdim = mesh.geometry().dim();
+  data.tdim = D;
+  data.num_vertices_per_cell = D + 1;
+  data.num_global_vertices = mesh.size_global(0);
+  data.num_global_cells = mesh.size_global(D);
+  data.cell_vertices.resize(boost::extents[mesh.num_cells()][D + 1]);
+  const std::vector<std::size_t>& global_vertex_indices
+    = mesh.topology().global_indices(0);
+  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  {
+    for (std::size_t j = 0; j < D + 1; ++j)
+    {
+      data.cell_vertices[cell->index()][j]
+        = global_vertex_indices[cell->entities(0)[j]];
+    }
+    data.global_cell_indices.push_back(cell->index());
+  }
+
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    Timer timer("Build dual graph");
+    std::size_t num_ghost_nodes = 0;
+    const CSRGraph<std::int64_t> graph
+      = GraphBuilder::compute_dual_graph<std::int64_t>(mesh.mpi_comm(), data,
+                                                       num_ghost_nodes);
+    timer.stop();
+
+    const std::size_t num_nodes = MPI::sum(mesh.mpi_comm(), graph.num_nodes());
+    const std::size_t num_edges = MPI::sum(mesh.mpi_comm(), graph.num_edges());
+    const std::size_t num_ghosts = MPI::sum(mesh.mpi_comm(), num_ghost_nodes);
+    info("Built dual graph with %d nodes, %d edges and %d ghost nodes",
+         num_nodes, num_edges, num_ghosts);
+  }
+
+  // Report timings
+  list_timings(TimingClear::keep,
+               { TimingType::wall, TimingType::user, TimingType::system });
+
+  return 0;
+}
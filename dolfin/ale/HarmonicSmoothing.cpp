@@ -16,12 +16,16 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-08-11
-// Last changed: 2013-12-02
+// Last changed: 2015-06-13
 
 #include <dolfin/common/Array.h>
+#include <dolfin/common/NoDeleter.h>
+#include <dolfin/common/Timer.h>
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/fem/assemble.h>
 #include <dolfin/fem/fem_utils.h>
+#include <dolfin/fem/GenericDofMap.h>
+#include <dolfin/la/KrylovSolver.h>
 #include <dolfin/la/Matrix.h>
 #include <dolfin/la/solve.h>
 #include <dolfin/la/Vector.h>
@@ -38,56 +42,57 @@
 
 using namespace dolfin;
 
+//-----------------------------------------------------------------------------
+Parameters HarmonicSmoothing::default_parameters()
+{
+  Parameters p("harmonic_smoothing");
+  p.add("reassemble_operator", false);
+  p.add("warm_start", false);
+
+  Parameters p_krylov = KrylovSolver::default_parameters();
+  p_krylov.rename("krylov_solver");
+  p.add(p_krylov);
+
+  return p;
+}
+//-----------------------------------------------------------------------------
+HarmonicSmoothing::HarmonicSmoothing(std::shared_ptr<Mesh> mesh)
+  : Variable("harmonic_smoothing", "Harmonic mesh smoothing"), _mesh(mesh),
+    _topology_hash(0)
+{
+  parameters = default_parameters();
+}
+//-----------------------------------------------------------------------------
+HarmonicSmoothing::~HarmonicSmoothing()
+{
+  // Do nothing
+}
 //-----------------------------------------------------------------------------
 std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
                                             const BoundaryMesh& new_boundary)
+{
+  HarmonicSmoothing smoothing(reference_to_no_delete_pointer(mesh));
+  return smoothing.move(new_boundary);
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<MeshDisplacement>
+HarmonicSmoothing::move(const BoundaryMesh& new_boundary)
 {
   // Now this works regardless of reorder_dofs_serial value
-  const bool reorder_dofs_serial = parameters["reorder_dofs_serial"];
+  const bool reorder_dofs_serial = dolfin::parameters["reorder_dofs_serial"];
   if (!reorder_dofs_serial)
   {
     warning("The function HarmonicSmoothing::move no longer needs "
             "parameters[\"reorder_dofs_serial\"] = false");
   }
 
-  const std::size_t D = mesh.topology().dim();
+  dolfin_assert(_mesh);
+  Mesh& mesh = *_mesh;
   const std::size_t d = mesh.geometry().dim();
 
-  // Choose form and function space
-  std::shared_ptr<FunctionSpace> V;
-  std::shared_ptr<Form> form;
-  switch (D)
-  {
-  case 1:
-    V.reset(new Poisson1D::FunctionSpace(mesh));
-    form.reset(new Poisson1D::BilinearForm(V, V));
-    break;
-  case 2:
-    V.reset(new Poisson2D::FunctionSpace(mesh));
-    form.reset(new Poisson2D::BilinearForm(V, V));
-    break;
-  case 3:
-    V.reset(new Poisson3D::FunctionSpace(mesh));
-    form.reset(new Poisson3D::BilinearForm(V, V));
-    break;
-  default:
-    dolfin_error("HarmonicSmoothing.cpp",
-                 "move mesh using harmonic smoothing",
-                 "Illegal mesh dimension (%d)", D);
-  }
-
-  // Assemble matrix
-  auto A = std::make_shared<Matrix>();
-  assemble(*A, *form);
-
   // Number of mesh vertices (local)
   const std::size_t num_vertices = mesh.num_vertices();
 
-  // Dof range
-  const dolfin::la_index n0 = V->dofmap()->ownership_range().first;
-  const dolfin::la_index n1 = V->dofmap()->ownership_range().second;
-  const dolfin::la_index num_owned_dofs = n1 - n0;
-
   // Mapping of new_boundary vertex numbers to mesh vertex numbers
   const MeshFunction<std::size_t>& vertex_map_mesh_func
     = new_boundary.entity_map(0);
@@ -96,65 +101,57 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
     vertex_map(vertex_map_mesh_func.values(),
                vertex_map_mesh_func.values() + num_boundary_vertices);
 
-  // Mapping of mesh vertex numbers to dofs (including ghost dofs)
-  const std::vector<dolfin::la_index> vertex_to_dofs = vertex_to_dof_map(*V);
+  // Build or update operator, solver and boundary data
+  const bool reassemble_operator = parameters["reassemble_operator"];
+  if (!_A || mesh.topology().hash() != _topology_hash
+      || vertex_map != _vertex_map)
+  {
+    init(vertex_map);
+  }
+  else if (reassemble_operator)
+  {
+    Timer timer("Harmonic smoothing: reassemble operator");
+    assemble(*_A, *_form);
+    _A->ident(_boundary_dofs.size(), _boundary_dofs.data());
+    _A->apply("insert");
+    _solver->set_operator(_A);
+  }
+  dolfin_assert(_A);
+  dolfin_assert(_solver);
 
-  // Array of all dofs (including ghosts) with local numbering
-  std::vector<dolfin::la_index> all_global_dofs(num_vertices);
-  for (std::size_t i = 0; i < num_vertices; i++)
-    all_global_dofs[i] = vertex_to_dofs[i];
+  const std::size_t num_boundary_dofs = _boundary_dofs.size();
 
-  // Create arrays for setting bcs.  Their indexing does not matter -
-  // same ordering does.
-  std::size_t num_boundary_dofs = 0;
-  std::vector<dolfin::la_index> boundary_dofs;
-  boundary_dofs.reserve(num_boundary_vertices);
-  std::vector<std::size_t> boundary_vertices;
-  boundary_vertices.reserve(num_boundary_vertices);
-  for (std::size_t vert = 0; vert < num_boundary_vertices; vert++)
+  // Compute Dirichlet condition (boundary displacement) for all
+  // coordinate directions in one pass over the boundary
+  std::vector<double> boundary_values(d*num_boundary_dofs);
+  for (std::size_t i = 0; i < num_boundary_dofs; i++)
   {
-    // Skip ghosts
-    const dolfin::la_index dof = vertex_to_dofs[vertex_map[vert]];
-    if (dof < num_owned_dofs)
+    const std::size_t vert = _boundary_vertices[i];
+    for (std::size_t dim = 0; dim < d; dim++)
     {
-      // Global dof numbers
-      boundary_dofs.push_back(dof + n0);
-
-      // new_boundary vertex indices
-      boundary_vertices.push_back(vert);
-
-      num_boundary_dofs++;
+      boundary_values[dim*num_boundary_dofs + i]
+        = new_boundary.geometry().x(vert, dim)
+        - mesh.geometry().x(vertex_map[vert], dim);
     }
   }
 
-  // Modify matrix (insert 1 on diagonal)
-  A->ident(num_boundary_dofs, boundary_dofs.data());
-  A->apply("insert");
-
-  // Arrays for storing Dirichlet condition and solution
-  std::vector<double> boundary_values(num_boundary_dofs);
-  std::vector<double> displacement;
-  displacement.reserve(d*num_vertices);
-
-  // Pick amg as preconditioner if available
-  const std::string
-    prec(has_krylov_solver_preconditioner("amg") ? "amg" : "default");
-
   // Displacement solution wrapped in Expression subclass
   // MeshDisplacement
   std::shared_ptr<MeshDisplacement> u(new MeshDisplacement(mesh));
 
+  // Use previous displacement as initial guess if requested and
+  // available
+  const bool warm_start = parameters["warm_start"];
+  std::shared_ptr<const MeshDisplacement> u0;
+  if (warm_start && _u && (*_u)[0].vector()->size() == (*u)[0].vector()->size())
+    u0 = _u;
+
   // RHS vector
   Vector b(*(*u)[0].vector());
 
-  // Prepare solver
-  // NOTE: GMRES needs to be used until Eigen a4b7b6e or 8dcc4ed is widespread;
-  //       afterwards CG can be used again
-  KrylovSolver solver("bicgstab", prec);
-  solver.parameters["nonzero_initial_guess"] = true;
-  solver.set_operator(A);
-
-  // Solve system for each dimension
+  // Solve the systems for all coordinate directions with the same
+  // operator and preconditioner
+  std::vector<double> displacement(d*num_vertices);
   for (std::size_t dim = 0; dim < d; dim++)
   {
     // Get solution vector
@@ -164,23 +161,25 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
       b.zero();
 
     // Store bc into RHS and solution so that CG solver can be used
-    for (std::size_t i = 0; i < num_boundary_dofs; i++)
+    b.set(boundary_values.data() + dim*num_boundary_dofs, num_boundary_dofs,
+          _boundary_dofs.data());
+    b.apply("insert");
+    if (u0)
     {
-      boundary_values[i] = new_boundary.geometry().x(boundary_vertices[i], dim)
-        - mesh.geometry().x(vertex_map[boundary_vertices[i]], dim);
+      *x = *(*u0)[dim].vector();
+      x->set(boundary_values.data() + dim*num_boundary_dofs,
+             num_boundary_dofs, _boundary_dofs.data());
+      x->apply("insert");
     }
-    b.set(boundary_values.data(), num_boundary_dofs, boundary_dofs.data());
-    b.apply("insert");
-    *x = b;
+    else
+      *x = b;
 
     // Solve the system
-    solver.solve(*x, b);
+    _solver->solve(*x, b);
 
     // Get displacement
-    std::vector<double> _displacement(num_vertices);
-    x->get_local(_displacement.data(), num_vertices, all_global_dofs.data());
-    displacement.insert(displacement.end(), _displacement.begin(),
-                        _displacement.end());
+    x->get_local(displacement.data() + dim*num_vertices, num_vertices,
+                 _vertex_to_dofs.data());
   }
 
   // Modify mesh coordinates
@@ -193,7 +192,97 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
     geometry.set(i, coord);
   }
 
+  // Keep displacement for warm start of next call
+  _u = u;
+
   // Return calculated displacement
   return u;
 }
 //-----------------------------------------------------------------------------
+void HarmonicSmoothing::init(const std::vector<std::size_t>& vertex_map)
+{
+  Timer timer("Harmonic smoothing: init");
+
+  dolfin_assert(_mesh);
+  Mesh& mesh = *_mesh;
+  const std::size_t D = mesh.topology().dim();
+
+  // Choose form and function space
+  switch (D)
+  {
+  case 1:
+    _V.reset(new Poisson1D::FunctionSpace(mesh));
+    _form.reset(new Poisson1D::BilinearForm(_V, _V));
+    break;
+  case 2:
+    _V.reset(new Poisson2D::FunctionSpace(mesh));
+    _form.reset(new Poisson2D::BilinearForm(_V, _V));
+    break;
+  case 3:
+    _V.reset(new Poisson3D::FunctionSpace(mesh));
+    _form.reset(new Poisson3D::BilinearForm(_V, _V));
+    break;
+  default:
+    dolfin_error("HarmonicSmoothing.cpp",
+                 "move mesh using harmonic smoothing",
+                 "Illegal mesh dimension (%d)", D);
+  }
+
+  // Assemble matrix
+  _A = std::make_shared<Matrix>();
+  assemble(*_A, *_form);
+
+  // Dof range
+  const dolfin::la_index n0 = _V->dofmap()->ownership_range().first;
+  const dolfin::la_index n1 = _V->dofmap()->ownership_range().second;
+  const dolfin::la_index num_owned_dofs = n1 - n0;
+
+  // Mapping of mesh vertex numbers to dofs (including ghost dofs)
+  _vertex_to_dofs = vertex_to_dof_map(*_V);
+  _vertex_to_dofs.resize(mesh.num_vertices());
+
+  // Create arrays for setting bcs.  Their indexing does not matter -
+  // same ordering does.
+  _boundary_dofs.clear();
+  _boundary_dofs.reserve(vertex_map.size());
+  _boundary_vertices.clear();
+  _boundary_vertices.reserve(vertex_map.size());
+  for (std::size_t vert = 0; vert < vertex_map.size(); vert++)
+  {
+    // Skip ghosts
+    const dolfin::la_index dof = _vertex_to_dofs[vertex_map[vert]];
+    if (dof < num_owned_dofs)
+    {
+      // Global dof numbers
+      _boundary_dofs.push_back(dof + n0);
+
+      // new_boundary vertex indices
+      _boundary_vertices.push_back(vert);
+    }
+  }
+
+  // Modify matrix (insert 1 on diagonal)
+  _A->ident(_boundary_dofs.size(), _boundary_dofs.data());
+  _A->apply("insert");
+
+  // Pick amg as preconditioner if available
+  const std::string
+    prec(has_krylov_solver_preconditioner("amg") ? "amg" : "default");
+
+  // Prepare solver. The preconditioner is built on the first solve
+  // and reused until the operator changes.
+  // NOTE: GMRES needs to be used until Eigen a4b7b6e or 8dcc4ed is widespread;
+  //       afterwards CG can be used again
+  _solver = std::make_shared<KrylovSolver>("bicgstab", prec);
+  _solver->parameters.update(parameters("krylov_solver"));
+  _solver->parameters["nonzero_initial_guess"] = true;
+  _solver->set_operator(_A);
+
+  // Previous displacement is not valid for new topology
+  _u.reset();
+
+  // Store data for which cache is valid
+  _topology_hash = mesh.topology().hash();
+  _vertex_map = vertex_map;
+}
+//-----------------------------------------------------------------------------
@@ -16,34 +16,99 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-08-11
-// Last changed: 2013-03-06
+// Last changed: 2015-06-13
 
 #ifndef __HARMONIC_SMOOTHING_H
 #define __HARMONIC_SMOOTHING_H
 
 #include <memory>
+#include <vector>
+#include <dolfin/common/types.h>
+#include <dolfin/common/Variable.h>
 #include "MeshDisplacement.h"
 
 namespace dolfin
 {
 
   class BoundaryMesh;
+  class Form;
+  class FunctionSpace;
+  class KrylovSolver;
+  class Matrix;
   class Mesh;
 
   /// This class implements harmonic mesh smoothing. Poisson's equation
   /// is solved with zero right-hand side (Laplace's equation) for each
   /// coordinate direction to compute new coordinates for all vertices,
   /// given new locations for the coordinates of the boundary.
+  ///
+  /// When the same mesh is moved repeatedly (for example in every
+  /// time step of a moving-boundary problem), a HarmonicSmoothing
+  /// object should be created for the mesh and its member function
+  /// move() called. The Poisson operator, the preconditioner and the
+  /// boundary dofs are then computed on the first call and reused as
+  /// long as the mesh topology and the boundary vertices do not
+  /// change. By default the operator assembled on the first call
+  /// (on the initial geometry) is reused; with the parameter
+  /// "reassemble_operator" set, it is reassembled on the current
+  /// geometry in each call, reusing its sparsity pattern. With the
+  /// parameter "warm_start" set, the previous displacement is used
+  /// as initial guess for the linear solver.
 
-  class HarmonicSmoothing
+  class HarmonicSmoothing : public Variable
   {
   public:
 
+    /// Create harmonic smoothing for given mesh
+    explicit HarmonicSmoothing(std::shared_ptr<Mesh> mesh);
+
+    /// Destructor
+    ~HarmonicSmoothing();
+
+    /// Move coordinates of mesh according to new boundary coordinates
+    /// and return the displacement
+    std::shared_ptr<MeshDisplacement> move(const BoundaryMesh& new_boundary);
+
     /// Move coordinates of mesh according to new boundary coordinates
     /// and return the displacement
-    static std::shared_ptr<MeshDisplacement> move(Mesh& mesh, 
+    static std::shared_ptr<MeshDisplacement> move(Mesh& mesh,
                                         const BoundaryMesh& new_boundary);
 
+    /// Default parameter values
+    static Parameters default_parameters();
+
+  private:
+
+    // Build function space, operator, solver and boundary data
+    void init(const std::vector<std::size_t>& vertex_map);
+
+    // The mesh
+    std::shared_ptr<Mesh> _mesh;
+
+    // Topology hash and boundary vertex map for which cached data
+    // were computed
+    std::size_t _topology_hash;
+    std::vector<std::size_t> _vertex_map;
+
+    // Function space, Poisson form and operator
+    std::shared_ptr<FunctionSpace> _V;
+    std::shared_ptr<Form> _form;
+    std::shared_ptr<Matrix> _A;
+
+    // Linear solver (holds preconditioner)
+    std::shared_ptr<KrylovSolver> _solver;
+
+    // Mapping of mesh vertex numbers to dofs (including ghost dofs)
+    std::vector<dolfin::la_index> _vertex_to_dofs;
+
+    // Global numbers of owned boundary dofs and corresponding
+    // new_boundary vertex indices
+    std::vector<dolfin::la_index> _boundary_dofs;
+    std::vector<std::size_t> _boundary_vertices;
+
+    // Most recent displacement (initial guess for next solve)
+    std::shared_ptr<MeshDisplacement> _u;
+
   };
 
 }
@@ -0,0 +1,197 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-02
+// Last changed: 2015-06-12
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <dolfin/log/log.h>
+#include "HardwareCounters.h"
+
+using namespace dolfin;
+
+namespace
+{
+  #ifdef __linux__
+  // Open a single counter for the calling thread on any CPU, return
+  // -1 on failure
+  int open_counter(std::uint32_t type, std::uint64_t config)
+  {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  #endif
+
+  // Warn once (for all threads) if counters are requested but cannot
+  // be opened
+  void warn_unavailable()
+  {
+    static std::atomic<bool> warned(false);
+    if (warned.exchange(true))
+      return;
+
+    #ifdef __linux__
+    warning("Hardware performance counters are not available "
+            "(check /proc/sys/kernel/perf_event_paranoid). "
+            "Counters will be reported as -1.");
+    #else
+    warning("Hardware performance counters are only available on GNU/Linux. "
+            "Counters will be reported as -1.");
+    #endif
+  }
+
+  // Counters of the calling thread (opened on first use)
+  thread_local std::shared_ptr<HardwareCounters> _thread_counters;
+}
+
+//-----------------------------------------------------------------------------
+HardwareCounters::HardwareCounters(long flops_event)
+  : _flops_event(flops_event)
+{
+  _fd.fill(-1);
+
+  #ifdef __linux__
+  _fd[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  _fd[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  _fd[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  if (flops_event != 0)
+    _fd[3] = open_counter(PERF_TYPE_RAW, flops_event);
+  #endif
+
+  if (!available())
+    warn_unavailable();
+}
+//-----------------------------------------------------------------------------
+HardwareCounters::~HardwareCounters()
+{
+  #ifdef __linux__
+  for (auto fd : _fd)
+  {
+    if (fd >= 0)
+      close(fd);
+  }
+  #endif
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<HardwareCounters>
+HardwareCounters::thread_counters(long flops_event)
+{
+  if (!_thread_counters || _thread_counters->_flops_event != flops_event)
+  {
+    _thread_counters.reset(new HardwareCounters(flops_event));
+    _thread_counters->start();
+  }
+  return _thread_counters;
+}
+//-----------------------------------------------------------------------------
+void HardwareCounters::start()
+{
+  #ifdef __linux__
+  for (auto fd : _fd)
+  {
+    if (fd >= 0)
+    {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  #endif
+}
+//-----------------------------------------------------------------------------
+void HardwareCounters::resume()
+{
+  #ifdef __linux__
+  for (auto fd : _fd)
+  {
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  #endif
+}
+//-----------------------------------------------------------------------------
+void HardwareCounters::stop()
+{
+  #ifdef __linux__
+  for (auto fd : _fd)
+  {
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+  #endif
+}
+//-----------------------------------------------------------------------------
+std::array<double, 4> HardwareCounters::values() const
+{
+  std::array<double, 4> v;
+  v.fill(-1.0);
+
+  #ifdef __linux__
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (_fd[i] < 0)
+      continue;
+
+    // Read (value, time enabled, time running)
+    std::uint64_t data[3];
+    if (read(_fd[i], data, sizeof(data)) != sizeof(data))
+      continue;
+
+    // Scale if counter has been multiplexed
+    if (data[2] == 0)
+      v[i] = 0.0;
+    else if (data[2] < data[1])
+    {
+      v[i] = static_cast<double>(data[0])*static_cast<double>(data[1])
+        /static_cast<double>(data[2]);
+    }
+    else
+      v[i] = static_cast<double>(data[0]);
+  }
+  #endif
+
+  return v;
+}
+//-----------------------------------------------------------------------------
+bool HardwareCounters::available() const
+{
+  for (auto fd : _fd)
+  {
+    if (fd >= 0)
+      return true;
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,103 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-02
+// Last changed: 2015-06-12
+
+#ifndef __HARDWARE_COUNTERS_H
+#define __HARDWARE_COUNTERS_H
+
+#include <array>
+#include <memory>
+
+namespace dolfin
+{
+
+  /// This class provides access to the hardware performance counters
+  /// of the calling thread (cycles, instructions, last-level cache
+  /// misses and, optionally, floating point operations). It is built
+  /// on the Linux perf_event interface. When the counters are not
+  /// available (other platforms, missing kernel support or
+  /// insufficient permissions, see /proc/sys/kernel/perf_event_paranoid)
+  /// the counters read as -1 and no error is raised.
+  ///
+  /// The counters only count events of the thread that opened them;
+  /// events of other threads (for example OpenMP threads started
+  /// within a Timer region) are not included.
+  ///
+  /// Counters are collected for named Timer regions when the global
+  /// parameter "timer_hardware_counters" is set, and may be reported
+  /// by list_timings(). Timers use the counters of the calling thread
+  /// (see thread_counters()), which are opened once and then kept
+  /// running.
+
+  class HardwareCounters
+  {
+  public:
+
+    /// Number of counters
+    static const std::size_t size = 4;
+
+    /// Open counters. The floating point operation counter is a raw
+    /// (processor specific) event and is only opened when flops_event
+    /// is nonzero
+    explicit HardwareCounters(long flops_event=0);
+
+    /// Destructor
+    ~HardwareCounters();
+
+    /// Return counters of the calling thread. The counters are
+    /// opened and started on first use (or when flops_event changes)
+    /// and are then kept running, so regions are measured by
+    /// differences of values().
+    static std::shared_ptr<HardwareCounters>
+      thread_counters(long flops_event=0);
+
+    /// Zero and start counters
+    void start();
+
+    /// Resume counters
+    void resume();
+
+    /// Stop counters
+    void stop();
+
+    /// Return counter values (cycles, instructions, cache misses,
+    /// flops). Values are scaled if the kernel multiplexed the
+    /// counters. Unavailable counters are -1.
+    std::array<double, 4> values() const;
+
+    /// Return true if at least one counter could be opened
+    bool available() const;
+
+  private:
+
+    // Disable copying
+    HardwareCounters(const HardwareCounters&);
+    HardwareCounters& operator= (const HardwareCounters&);
+
+    // Raw floating point event (0 if not counted)
+    long _flops_event;
+
+    // File descriptors for counters (-1 if not available)
+    std::array<int, 4> _fd;
+
+  };
+
+}
+
+#endif
@@ -154,7 +154,7 @@ namespace dolfin
     /// Return global min value
     template<typename T> static T min(MPI_Comm comm, const T& value);
 
-    /// Sum values and return sum
+    /// Sum values and return sum (element-wise for std::vector)
     template<typename T> static T sum(MPI_Comm comm, const T& value);
 
     /// Return average across comm; implemented only for T == Table
@@ -164,6 +164,11 @@ namespace dolfin
     template<typename T, typename X> static
       T all_reduce(MPI_Comm comm, const T& value, X op);
 
+    /// All reduce, element-wise for vector of values
+    template<typename T, typename X> static
+      std::vector<T> all_reduce(MPI_Comm comm, const std::vector<T>& value,
+                                X op);
+
     /// Find global offset (index) (wrapper for MPI_(Ex)Scan with
     /// MPI_SUM as reduction op)
     static std::size_t global_offset(MPI_Comm comm,
@@ -617,6 +622,20 @@ namespace dolfin
     #endif
   }
   //---------------------------------------------------------------------------
+  template<typename T, typename X>
+    std::vector<T> dolfin::MPI::all_reduce(MPI_Comm comm,
+                                           const std::vector<T>& value, X op)
+  {
+    #ifdef HAS_MPI
+    std::vector<T> out(value.size());
+    MPI_Allreduce(const_cast<T*>(value.data()), out.data(), value.size(),
+                  mpi_type<T>(), op, comm);
+    return out;
+    #else
+    return value;
+    #endif
+  }
+  //---------------------------------------------------------------------------
   template<typename T> T dolfin::MPI::max(MPI_Comm comm, const T& value)
   {
     #ifdef HAS_MPI
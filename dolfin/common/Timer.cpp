@@ -16,10 +16,11 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-09-08
-// Last changed:
+// Last changed: 2015-06-12
 
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/log/LogManager.h>
+#include "HardwareCounters.h"
 #include "Timer.h"
 
 using namespace dolfin;
@@ -34,6 +35,15 @@ Timer::Timer(std::string task) : _task("")
 {
   const std::string prefix = parameters["timer_prefix"];
   _task = prefix + task;
+
+  // Start hardware counters (of calling thread) if requested
+  if (parameters["timer_hardware_counters"])
+  {
+    const int flops_event = parameters["timer_flops_event"];
+    _counters = HardwareCounters::thread_counters(flops_event);
+    _counters_start = _counters->values();
+    _counters_elapsed.fill(0.0);
+  }
 }
 //-----------------------------------------------------------------------------
 Timer::~Timer()
@@ -45,6 +55,11 @@ Timer::~Timer()
 void Timer::start()
 {
   _timer.start();
+  if (_counters)
+  {
+    _counters_start = _counters->values();
+    _counters_elapsed.fill(0.0);
+  }
 }
 //-----------------------------------------------------------------------------
 void Timer::resume()
@@ -55,14 +70,33 @@ void Timer::resume()
                  "Resuming is not well-defined for logging timer. "
                  "Only non-logging timer can be resumed");
   _timer.resume();
+  if (_counters)
+    _counters_start = _counters->values();
 }
 //-----------------------------------------------------------------------------
 double Timer::stop()
 {
   _timer.stop();
+  if (_counters)
+  {
+    // Accumulate counter differences (-1 if counter not available)
+    const std::array<double, 4> values = _counters->values();
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      if (values[i] < 0.0 || _counters_start[i] < 0.0)
+        _counters_elapsed[i] = -1.0;
+      else
+        _counters_elapsed[i] += values[i] - _counters_start[i];
+    }
+  }
+
   const auto elapsed = this->elapsed();
   if (_task.size() > 0)
+  {
     LogManager::logger.register_timing(_task, elapsed);
+    if (_counters && _counters->available())
+      LogManager::logger.register_counters(_task, _counters_elapsed);
+  }
   return std::get<0>(elapsed);
 }
 //-----------------------------------------------------------------------------
@@ -16,11 +16,13 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-06-13
-// Last changed: 2010-11-16
+// Last changed: 2015-06-12
 
 #ifndef __TIMER_H
 #define __TIMER_H
 
+#include <array>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <boost/timer/timer.hpp>
@@ -43,6 +45,14 @@ namespace dolfin
   /// by calling
   ///
   ///   list_timings();
+  ///
+  /// If the global parameter "timer_hardware_counters" is set,
+  /// hardware performance counters (see HardwareCounters) are
+  /// collected for timers with logging and reported together with
+  /// the timings. The counters only include events of the thread
+  /// that created the timer.
+
+  class HardwareCounters;
 
   class Timer
   {
@@ -83,6 +93,12 @@ namespace dolfin
     // Implementation of timer
     boost::timer::cpu_timer _timer;
 
+    // Hardware performance counters of thread (optional)
+    std::shared_ptr<HardwareCounters> _counters;
+
+    // Counter values at (re)start and accumulated counter values
+    std::array<double, 4> _counters_start, _counters_elapsed;
+
   };
 
 }
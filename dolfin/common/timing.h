@@ -32,8 +32,12 @@ namespace dolfin
 
   /// Timing type: wall-clock time, user (cpu) time, system (kernel) time.
   /// Precision of wall is around 1 microsecond, user and system are around
-  /// 10 millisecond (on Linux).
-  enum class TimingType : int32_t { wall = 0, user = 1, system = 2 };
+  /// 10 millisecond (on Linux). The types cycles, instructions,
+  /// cache_misses and flops are hardware counters which are only
+  /// collected if the parameter "timer_hardware_counters" is set.
+  enum class TimingType : int32_t { wall = 0, user = 1, system = 2,
+                                    cycles = 3, instructions = 4,
+                                    cache_misses = 5, flops = 6 };
 
   /// Start timing (should not be used internally in DOLFIN!)
   void tic();
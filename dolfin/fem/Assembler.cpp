@@ -22,6 +22,7 @@
 // Modified by Martin Alnaes 2013-2015
 
 #include <algorithm>
+#include <functional>
 #include <dolfin/log/log.h>
 #include <dolfin/log/Progress.h>
 #include <dolfin/common/Array.h>
@@ -35,6 +36,8 @@
 #include <dolfin/mesh/MeshData.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/SubDomain.h>
+#include <dolfin/mesh/SubdomainIndex.h>
+#include <dolfin/function/Function.h>
 #include <dolfin/function/GenericFunction.h>
 #include <dolfin/function/FunctionSpace.h>
 #include "GenericDofMap.h"
@@ -45,10 +48,175 @@
 #include "AssemblerBase.h"
 #include "Assembler.h"
 
+#include <dolfin/la/CSRMatrixBuffer.h>
 #include <dolfin/la/GenericMatrix.h>
+#include <dolfin/la/GenericVector.h>
+#include <dolfin/la/TensorLayout.h>
 
 using namespace dolfin;
 
+namespace
+{
+  // Adds element tensors to the global tensor. Element matrices of
+  // bilinear forms are added to the matrix buffer if bulk insertion
+  // is used. Otherwise they are added using block indices when the
+  // matrix and the dofmaps share a block size bs > 1, and the dofs
+  // of the cell are blocked (the dof of component c of node k being
+  // dofs[k] + c). In all other cases the element tensor is added
+  // entry by entry.
+  class ElementTensorAdder
+  {
+  public:
+
+    ElementTensorAdder(GenericTensor& A,
+                       const std::vector<const GenericDofMap*>& dofmaps,
+                       CSRMatrixBuffer* buffer)
+      : _A(A), _buffer(buffer), _matrix(0), _bs(1)
+    {
+      if (dofmaps.size() != 2 || _buffer)
+        return;
+
+      const std::size_t bs = dofmaps[0]->block_size;
+      if (bs < 2 || dofmaps[1]->block_size != bs)
+        return;
+
+      _matrix = dynamic_cast<GenericMatrix*>(&A);
+      if (_matrix && _matrix->block_size() == bs)
+        _bs = bs;
+    }
+
+    void add_local(const double* Ae,
+                   const std::vector<ArrayView<const dolfin::la_index>>& dofs)
+    {
+      if (_buffer && dofs.size() == 2)
+      {
+        _buffer->add_local(Ae, dofs);
+        return;
+      }
+
+      if (_bs == 1 || !compute_block_dofs(dofs[0], _rows)
+          || !compute_block_dofs(dofs[1], _cols))
+      {
+        _A.add_local(Ae, dofs);
+        return;
+      }
+
+      // Reorder element matrix from component-wise ordering of dofs
+      // to node-wise ordering (components of each node contiguous)
+      const std::size_t m = _rows.size(), n = _cols.size();
+      const std::size_t num_cols = n*_bs;
+      _Ab.resize(m*_bs*num_cols);
+      for (std::size_t c = 0; c < _bs; ++c)
+        for (std::size_t k = 0; k < m; ++k)
+        {
+          const double* Ae_row = Ae + (c*m + k)*num_cols;
+          double* Ab_row = _Ab.data() + (k*_bs + c)*num_cols;
+          for (std::size_t d = 0; d < _bs; ++d)
+            for (std::size_t l = 0; l < n; ++l)
+              Ab_row[l*_bs + d] = Ae_row[d*n + l];
+        }
+
+      _matrix->add_local_blocked(_Ab.data(), _bs, m, _rows.data(),
+                                 n, _cols.data());
+    }
+
+  private:
+
+    // Compute block indices of cell dofs, returns false if the cell
+    // dofs are not blocked
+    bool compute_block_dofs(const ArrayView<const dolfin::la_index>& dofs,
+                            std::vector<dolfin::la_index>& block_dofs) const
+    {
+      if (dofs.size() % _bs != 0)
+        return false;
+
+      const std::size_t num_nodes = dofs.size()/_bs;
+      block_dofs.resize(num_nodes);
+      for (std::size_t k = 0; k < num_nodes; ++k)
+      {
+        const dolfin::la_index dof = dofs[k];
+        if (dof % _bs != 0)
+          return false;
+        for (std::size_t c = 1; c < _bs; ++c)
+        {
+          if (dofs[c*num_nodes + k] != dof + (dolfin::la_index) c)
+            return false;
+        }
+        block_dofs[k] = dof/_bs;
+      }
+
+      return true;
+    }
+
+    // Global tensor, buffer for bulk insertion (if any) and matrix
+    // interface of global tensor (if blocked insertion is used)
+    GenericTensor& _A;
+    CSRMatrixBuffer* _buffer;
+    GenericMatrix* _matrix;
+
+    // Block size (1 if blocked insertion is not used)
+    std::size_t _bs;
+
+    // Work arrays for block indices and reordered element matrix
+    std::vector<dolfin::la_index> _rows, _cols;
+    std::vector<double> _Ab;
+  };
+
+  // Mark cells with dofs (of any of the given dofmaps) owned by other
+  // processes
+  void mark_cells_with_unowned_dofs(
+    std::vector<bool>& marked, const Mesh& mesh,
+    const std::vector<const GenericDofMap*>& dofmaps)
+  {
+    marked.assign(mesh.num_cells(), false);
+    for (std::size_t i = 0; i < dofmaps.size(); ++i)
+    {
+      const dolfin::la_index num_owned = dofmaps[i]->local_dimension("owned");
+      for (std::size_t c = 0; c < marked.size(); ++c)
+      {
+        if (marked[c])
+          continue;
+        const ArrayView<const dolfin::la_index> dofs
+          = dofmaps[i]->cell_dofs(c);
+        for (std::size_t k = 0; k < dofs.size(); ++k)
+        {
+          if (dofs[k] >= num_owned)
+          {
+            marked[c] = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // Calls the given function when going out of scope, such that
+  // ghost updates are not left in progress if assembly throws
+  class ScopeGuard
+  {
+  public:
+
+    explicit ScopeGuard(std::function<void()> f) : _f(f) {}
+
+    ~ScopeGuard()
+    {
+      try
+      {
+        _f();
+      }
+      catch (...)
+      {
+        // Do not throw from destructor
+      }
+    }
+
+  private:
+
+    std::function<void()> _f;
+
+  };
+}
+
 //----------------------------------------------------------------------------
 void Assembler::assemble(GenericTensor& A, const Form& a)
 {
@@ -97,11 +265,31 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
     coefficients = a.coefficients();
 
   // Initialize global tensor
-  init_global_tensor(A, a);
+  std::shared_ptr<const TensorLayout> tensor_layout
+    = init_global_tensor_layout(A, a);
+
+  // Create buffer for bulk insertion of values into newly created
+  // matrix
+  _matrix_buffer.reset();
+  if (bulk_insertion && tensor_layout && !add_values
+      && CSRMatrixBuffer::supported(*tensor_layout))
+  {
+    _matrix_buffer.reset(new CSRMatrixBuffer(*tensor_layout));
+  }
+  tensor_layout.reset();
+
+  // Start update of ghost values of coefficients (completed during
+  // assembly over cells, or by the guard if assembly throws)
+  start_ghost_updates(a);
+  ScopeGuard ghost_update_guard([this]() { finish_ghost_updates(); });
 
   // Assemble over cells
   assemble_cells(A, a, ufc, cell_domains, NULL);
 
+  // Complete update of ghost values (if not completed by
+  // assemble_cells)
+  finish_ghost_updates();
+
   // Assemble over exterior facets
   assemble_exterior_facets(A, a, ufc, exterior_facet_domains, NULL);
 
@@ -112,6 +300,9 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
   // Assemble over vertices
   assemble_vertices(A, a, ufc, vertex_domains);
 
+  // Insert values accumulated for bulk insertion (if any)
+  flush_matrix_buffer(A);
+
   // Finalize assembly of global tensor
   if (finalize_tensor)
     A.apply("add");
@@ -148,61 +339,138 @@ void Assembler::assemble_cells(
   // Vector to hold dof map for a cell
   std::vector<ArrayView<const dolfin::la_index>> dofs(form_rank);
 
+  // Insertion of element tensors into global tensor
+  ElementTensorAdder adder(A, dofmaps, _matrix_buffer.get());
+
   // Cell integral
   ufc::cell_integral* integral = ufc.default_cell_integral.get();
 
-  // Check whether integral is domain-dependent
+  // Check whether integral is domain-dependent. If so, get cells
+  // grouped by sub domain such that only cells of sub domains with
+  // an integral are visited
   bool use_domains = domains && !domains->empty();
+  std::shared_ptr<const SubdomainIndex> domain_index;
+  if (use_domains)
+    domain_index = a.domain_index(*domains);
+  const std::size_t num_groups = use_domains ? domain_index->num_values() : 1;
+
+  // Ghost cells (if any) are numbered last and are not assembled over
+  const std::size_t num_regular_cells
+    = mesh.topology().ghost_offset(mesh.topology().dim());
+
+  // Cells are assembled over in up to three passes, such that
+  // communication overlaps with assembly:
+  //
+  //   0: cells with only locally owned coefficient dofs (while ghost
+  //      values of coefficients are being updated), and, if values of
+  //      rows owned by other processes are sent ahead of flushing the
+  //      matrix buffer, with such rows
+  //   1: cells with coefficient dofs owned by other processes (after
+  //      the update of ghost values has been completed)
+  //   2: remaining cells (while values of rows owned by other
+  //      processes are being sent)
+  const bool send_nonlocal = _matrix_buffer && form_rank == 2
+    && MPI::size(mesh.mpi_comm()) > 1;
+  std::vector<unsigned char> cell_pass;
+  std::size_t num_passes = 1;
+  if (!_ghost_updates.empty() || send_nonlocal)
+  {
+    std::vector<bool> needs_ghosts, has_nonlocal_rows;
+    if (!_ghost_updates.empty())
+      mark_cells_with_unowned_dofs(needs_ghosts, mesh, _ghost_dofmaps);
+    if (send_nonlocal)
+    {
+      const std::vector<const GenericDofMap*> row_dofmap(1, dofmaps[0]);
+      mark_cells_with_unowned_dofs(has_nonlocal_rows, mesh, row_dofmap);
+    }
+
+    cell_pass.resize(mesh.num_cells());
+    for (std::size_t c = 0; c < cell_pass.size(); ++c)
+    {
+      if (!needs_ghosts.empty() && needs_ghosts[c])
+        cell_pass[c] = 1;
+      else if (!send_nonlocal || has_nonlocal_rows[c])
+        cell_pass[c] = 0;
+      else
+        cell_pass[c] = 2;
+    }
+    num_passes = send_nonlocal ? 3 : 2;
+  }
 
   // Assemble over cells
   ufc::cell ufc_cell;
   std::vector<double> vertex_coordinates;
   Progress p(AssemblerBase::progress_message(A.rank(), "cells"),
              mesh.num_cells());
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  for (std::size_t pass = 0; pass < num_passes; ++pass)
   {
-    // Get integral for sub domain (if any)
-    if (use_domains)
-      integral = ufc.get_cell_integral((*domains)[*cell]);
+    if (pass == 1)
+      finish_ghost_updates();
+    else if (pass == 2)
+      _matrix_buffer->send_nonlocal_begin();
 
-    // Skip if no integral on current domain
-    if (!integral)
-      continue;
+    for (std::size_t group = 0; group < num_groups; ++group)
+    {
+      // Get integral for sub domain (if any)
+      ArrayView<const unsigned int> group_cells;
+      if (use_domains)
+      {
+        integral = ufc.get_cell_integral(domain_index->values()[group]);
+        group_cells = domain_index->entities(group);
+      }
 
-    // Check that cell is not a ghost
-    dolfin_assert(!cell->is_ghost());
+      // Skip if no integral on current domain
+      if (!integral)
+        continue;
 
-    // Update to current cell
-    cell->get_cell_data(ufc_cell);
-    cell->get_vertex_coordinates(vertex_coordinates);
-    ufc.update(*cell, vertex_coordinates, ufc_cell,
-               integral->enabled_coefficients());
+      const std::size_t num_cells = use_domains
+        ? std::lower_bound(group_cells.begin(), group_cells.end(),
+                           num_regular_cells) - group_cells.begin()
+        : num_regular_cells;
+      for (std::size_t c = 0; c < num_cells; ++c)
+      {
+        const Cell cell(mesh, use_domains ? group_cells[c] : c);
 
-    // Get local-to-global dof maps for cell
-    bool empty_dofmap = false;
-    for (std::size_t i = 0; i < form_rank; ++i)
-    {
-      dofs[i] = dofmaps[i]->cell_dofs(cell->index());
-      empty_dofmap = empty_dofmap || dofs[i].size() == 0;
-    }
+        // Skip if cell is assembled over in other pass
+        if (num_passes > 1 && cell_pass[cell.index()] != pass)
+          continue;
 
-    // Skip if at least one dofmap is empty
-    if (empty_dofmap)
-      continue;
+        // Check that cell is not a ghost
+        dolfin_assert(!cell.is_ghost());
 
-    // Tabulate cell tensor
-    integral->tabulate_tensor(ufc.A.data(), ufc.w(),
-                              vertex_coordinates.data(),
-                              ufc_cell.orientation);
+        // Update to current cell
+        cell.get_cell_data(ufc_cell);
+        cell.get_vertex_coordinates(vertex_coordinates);
+        ufc.update(cell, vertex_coordinates, ufc_cell,
+                   integral->enabled_coefficients());
 
-    // Add entries to global tensor. Either store values cell-by-cell
-    // (currently only available for functionals)
-    if (is_cell_functional)
-      (*values)[cell->index()] = ufc.A[0];
-    else
-      A.add_local(ufc.A.data(), dofs);
+        // Get local-to-global dof maps for cell
+        bool empty_dofmap = false;
+        for (std::size_t i = 0; i < form_rank; ++i)
+        {
+          dofs[i] = dofmaps[i]->cell_dofs(cell.index());
+          empty_dofmap = empty_dofmap || dofs[i].size() == 0;
+        }
 
-    p++;
+        // Skip if at least one dofmap is empty
+        if (empty_dofmap)
+          continue;
+
+        // Tabulate cell tensor
+        integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                                  vertex_coordinates.data(),
+                                  ufc_cell.orientation);
+
+        // Add entries to global tensor. Either store values
+        // cell-by-cell (currently only available for functionals)
+        if (is_cell_functional)
+          (*values)[cell.index()] = ufc.A[0];
+        else
+          adder.add_local(ufc.A.data(), dofs);
+
+        p++;
+      }
+    }
   }
 }
 //-----------------------------------------------------------------------------
@@ -234,75 +502,102 @@ void Assembler::assemble_exterior_facets(
   // Vector to hold dof map for a cell
   std::vector<ArrayView<const dolfin::la_index>> dofs(form_rank);
 
+  // Insertion of element tensors into global tensor
+  ElementTensorAdder adder(A, dofmaps, _matrix_buffer.get());
+
   // Exterior facet integral
   const ufc::exterior_facet_integral* integral
     = ufc.default_exterior_facet_integral.get();
 
-  // Check whether integral is domain-dependent
-  bool use_domains = domains && !domains->empty();
-
   // Compute facets and facet - cell connectivity if not already computed
   const std::size_t D = mesh.topology().dim();
   mesh.init(D - 1);
   mesh.init(D - 1, D);
   dolfin_assert(mesh.ordered());
 
+  // Check whether integral is domain-dependent. If so, get facets
+  // grouped by sub domain such that only facets of sub domains with
+  // an integral are visited
+  bool use_domains = domains && !domains->empty();
+  std::shared_ptr<const SubdomainIndex> domain_index;
+  if (use_domains)
+    domain_index = a.domain_index(*domains);
+  const std::size_t num_groups = use_domains ? domain_index->num_values() : 1;
+
+  // Ghost facets (if any) are numbered last and are not assembled
+  // over
+  const std::size_t num_regular_facets = mesh.topology().ghost_offset(D - 1);
+
   // Assemble over exterior facets (the cells of the boundary)
   ufc::cell ufc_cell;
   std::vector<double> vertex_coordinates;
   Progress p(AssemblerBase::progress_message(A.rank(), "exterior facets"),
              mesh.num_facets());
-  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+  for (std::size_t group = 0; group < num_groups; ++group)
   {
-    // Only consider exterior facets
-    if (!facet->exterior())
-    {
-      p++;
-      continue;
-    }
-
     // Get integral for sub domain (if any)
+    ArrayView<const unsigned int> group_facets;
     if (use_domains)
-      integral = ufc.get_exterior_facet_integral((*domains)[*facet]);
+    {
+      integral
+        = ufc.get_exterior_facet_integral(domain_index->values()[group]);
+      group_facets = domain_index->entities(group);
+    }
 
     // Skip integral if zero
     if (!integral)
       continue;
 
-    // Get mesh cell to which mesh facet belongs (pick first, there is
-    // only one)
-    dolfin_assert(facet->num_entities(D) == 1);
-    Cell mesh_cell(mesh, facet->entities(D)[0]);
+    const std::size_t num_facets = use_domains
+      ? std::lower_bound(group_facets.begin(), group_facets.end(),
+                         num_regular_facets) - group_facets.begin()
+      : num_regular_facets;
+    for (std::size_t f = 0; f < num_facets; ++f)
+    {
+      const Facet facet(mesh, use_domains ? group_facets[f] : f);
 
-    // Check that cell is not a ghost
-    dolfin_assert(!mesh_cell.is_ghost());
+      // Only consider exterior facets
+      if (!facet.exterior())
+      {
+        p++;
+        continue;
+      }
 
-    // Get local index of facet with respect to the cell
-    const std::size_t local_facet = mesh_cell.index(*facet);
+      // Get mesh cell to which mesh facet belongs (pick first, there
+      // is only one)
+      dolfin_assert(facet.num_entities(D) == 1);
+      Cell mesh_cell(mesh, facet.entities(D)[0]);
 
-    // Update UFC cell
-    mesh_cell.get_cell_data(ufc_cell, local_facet);
-    mesh_cell.get_vertex_coordinates(vertex_coordinates);
+      // Check that cell is not a ghost
+      dolfin_assert(!mesh_cell.is_ghost());
 
-    // Update UFC object
-    ufc.update(mesh_cell, vertex_coordinates, ufc_cell,
-               integral->enabled_coefficients());
+      // Get local index of facet with respect to the cell
+      const std::size_t local_facet = mesh_cell.index(facet);
 
-    // Get local-to-global dof maps for cell
-    for (std::size_t i = 0; i < form_rank; ++i)
-      dofs[i] = dofmaps[i]->cell_dofs(mesh_cell.index());
+      // Update UFC cell
+      mesh_cell.get_cell_data(ufc_cell, local_facet);
+      mesh_cell.get_vertex_coordinates(vertex_coordinates);
 
-    // Tabulate exterior facet tensor
-    integral->tabulate_tensor(ufc.A.data(),
-                              ufc.w(),
-                              vertex_coordinates.data(),
-                              local_facet,
-                              ufc_cell.orientation);
+      // Update UFC object
+      ufc.update(mesh_cell, vertex_coordinates, ufc_cell,
+                 integral->enabled_coefficients());
 
-    // Add entries to global tensor
-    A.add_local(ufc.A.data(), dofs);
+      // Get local-to-global dof maps for cell
+      for (std::size_t i = 0; i < form_rank; ++i)
+        dofs[i] = dofmaps[i]->cell_dofs(mesh_cell.index());
 
-    p++;
+      // Tabulate exterior facet tensor
+      integral->tabulate_tensor(ufc.A.data(),
+                                ufc.w(),
+                                vertex_coordinates.data(),
+                                local_facet,
+                                ufc_cell.orientation);
+
+      // Add entries to global tensor
+      adder.add_local(ufc.A.data(), dofs);
+
+      p++;
+    }
   }
 }
 //-----------------------------------------------------------------------------
@@ -339,6 +634,9 @@ void Assembler::assemble_interior_facets(
   std::vector<std::vector<dolfin::la_index>> macro_dofs(form_rank);
   std::vector<ArrayView<const dolfin::la_index>> macro_dof_ptrs(form_rank);
 
+  // Insertion of element tensors into global tensor
+  ElementTensorAdder adder(A, dofmaps, _matrix_buffer.get());
+
   // Interior facet integral
   const ufc::interior_facet_integral* integral
     = ufc.default_interior_facet_integral.get();
@@ -448,7 +746,7 @@ void Assembler::assemble_interior_facets(
     }
 
     // Add entries to global tensor
-    A.add_local(ufc.macro_A.data(), macro_dof_ptrs);
+    adder.add_local(ufc.macro_A.data(), macro_dof_ptrs);
 
     p++;
   }
@@ -547,6 +845,9 @@ void Assembler::assemble_vertices(
   // Vector to hold dof map for a cell
   std::vector<ArrayView<const dolfin::la_index>> dofs(form_rank);
 
+  // Insertion of element tensors into global tensor
+  ElementTensorAdder adder(A, dofmaps, _matrix_buffer.get());
+
   // Exterior point integral
   const ufc::vertex_integral* integral
     = ufc.default_vertex_integral.get();
@@ -658,7 +959,7 @@ void Assembler::assemble_vertices(
     if (form_rank == 0)
     {
       // Add entries to global tensor
-      A.add_local(ufc.A.data(), dofs);
+      adder.add_local(ufc.A.data(), dofs);
     }
     else if (form_rank == 1)
     {
@@ -667,7 +968,7 @@ void Assembler::assemble_vertices(
         local_values[i] = ufc.A[local_to_local_dofs[0][i]];
 
       // Add local entries to global tensor
-      A.add_local(local_values.data(), global_dofs_p);
+      adder.add_local(local_values.data(), global_dofs_p);
     }
     else
     {
@@ -684,10 +985,74 @@ void Assembler::assemble_vertices(
       }
 
       // Add local entries to global tensor
-      A.add_local(local_values.data(), global_dofs_p);
+      adder.add_local(local_values.data(), global_dofs_p);
     }
 
     p++;
   }
 }
 //-----------------------------------------------------------------------------
+void Assembler::flush_matrix_buffer(GenericTensor& A)
+{
+  if (!_matrix_buffer)
+    return;
+
+  Timer timer("Flush matrix buffer");
+  _matrix_buffer->flush(A.down_cast<GenericMatrix>());
+  _matrix_buffer.reset();
+}
+//-----------------------------------------------------------------------------
+void Assembler::start_ghost_updates(const Form& a)
+{
+  _ghost_updates.clear();
+  _ghost_dofmaps.clear();
+
+  // Ghost values need to be updated in parallel only
+  const Mesh& mesh = a.mesh();
+  if (MPI::size(mesh.mpi_comm()) == 1)
+    return;
+
+  const std::vector<std::shared_ptr<const GenericFunction>>
+    coefficients = a.coefficients();
+  for (std::size_t i = 0; i < coefficients.size(); ++i)
+  {
+    // Only functions have vectors with ghost values
+    std::shared_ptr<const Function> function
+      = std::dynamic_pointer_cast<const Function>(coefficients[i]);
+    if (!function)
+      continue;
+
+    // Skip vectors already being updated (sub-functions share the
+    // vector of their parent)
+    std::shared_ptr<const GenericVector> x = function->vector();
+    bool updating = false;
+    for (std::size_t j = 0; j < _ghost_updates.size(); ++j)
+      updating = updating || _ghost_updates[j] == x;
+    if (updating)
+      continue;
+
+    x->update_ghost_values_begin();
+
+    // Functions on other meshes are evaluated at arbitrary points, so
+    // their update must be completed before assembly
+    std::shared_ptr<const FunctionSpace> V = function->function_space();
+    if (V->mesh()->id() != mesh.id())
+    {
+      x->update_ghost_values_end();
+      continue;
+    }
+
+    _ghost_updates.push_back(x);
+    _ghost_dofmaps.push_back(V->dofmap().get());
+  }
+}
+//-----------------------------------------------------------------------------
+void Assembler::finish_ghost_updates()
+{
+  for (std::size_t i = 0; i < _ghost_updates.size(); ++i)
+    _ghost_updates[i]->update_ghost_values_end();
+
+  _ghost_updates.clear();
+  _ghost_dofmaps.clear();
+}
+//-----------------------------------------------------------------------------
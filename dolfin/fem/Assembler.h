@@ -23,6 +23,7 @@
 #ifndef __ASSEMBLER_H
 #define __ASSEMBLER_H
 
+#include <memory>
 #include <vector>
 #include "AssemblerBase.h"
 
@@ -30,7 +31,10 @@ namespace dolfin
 {
 
   // Forward declarations
+  class CSRMatrixBuffer;
+  class GenericDofMap;
   class GenericTensor;
+  class GenericVector;
   class Form;
   class UFC;
   template<typename T> class MeshFunction;
@@ -54,7 +58,16 @@ namespace dolfin
   public:
 
     /// Constructor
-    Assembler() {}
+    Assembler() : bulk_insertion(false) {}
+
+    /// bulk_insertion (bool)
+    ///     Default value is false.
+    ///     This controls whether the assembler accumulates the
+    ///     entries of a newly created matrix in compressed row
+    ///     storage and inserts them in bulk after assembly,
+    ///     instead of inserting each element matrix. Requires
+    ///     memory for a copy of the matrix.
+    bool bulk_insertion;
 
     /// Assemble tensor from given form
     ///
@@ -93,6 +106,32 @@ namespace dolfin
     void assemble_vertices(GenericTensor& A, const Form& a, UFC& ufc,
                            std::shared_ptr<const MeshFunction<std::size_t> > domains);
 
+  private:
+
+    // Insert values accumulated in matrix buffer (if any) into global
+    // tensor and delete buffer
+    void flush_matrix_buffer(GenericTensor& A);
+
+    // Buffer for bulk insertion of values into newly created matrix
+    // (if bulk_insertion is true)
+    std::shared_ptr<CSRMatrixBuffer> _matrix_buffer;
+
+    // Start update of ghost values of the coefficient vectors of a
+    // form (in parallel). Cells with dofs of the coefficients owned
+    // by other processes are assembled after the update has been
+    // completed, such that the communication overlaps with assembly
+    // over the remaining cells. Vectors with up-to-date ghost values,
+    // or with an update in progress, are not updated again.
+    void start_ghost_updates(const Form& a);
+
+    // Complete ghost updates started by start_ghost_updates()
+    void finish_ghost_updates();
+
+    // Coefficient vectors with ghost updates in progress, and their
+    // dofmaps
+    std::vector<std::shared_ptr<const GenericVector>> _ghost_updates;
+    std::vector<const GenericDofMap*> _ghost_dofmaps;
+
   };
 
 }
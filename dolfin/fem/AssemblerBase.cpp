@@ -46,6 +46,12 @@ using namespace dolfin;
 
 //-----------------------------------------------------------------------------
 void AssemblerBase::init_global_tensor(GenericTensor& A, const Form& a)
+{
+  init_global_tensor_layout(A, a);
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<const TensorLayout>
+AssemblerBase::init_global_tensor_layout(GenericTensor& A, const Form& a)
 {
   dolfin_assert(a.ufc_form());
 
@@ -54,12 +60,13 @@ void AssemblerBase::init_global_tensor(GenericTensor& A, const Form& a)
   for (std::size_t i = 0; i < a.rank(); ++i)
     dofmaps.push_back(a.function_space(i)->dofmap().get());
 
+  // Layout for initialising tensor (if not already initialised)
+  std::shared_ptr<TensorLayout> tensor_layout;
   if (A.empty())
   {
     Timer t0("Build sparsity");
 
-    // Create layout for initialising tensor
-    std::shared_ptr<TensorLayout> tensor_layout;
+    // Create layout
     tensor_layout = A.factory().create_layout(a.rank());
     dolfin_assert(tensor_layout);
 
@@ -168,6 +175,8 @@ void AssemblerBase::init_global_tensor(GenericTensor& A, const Form& a)
 
   if (!add_values)
     A.zero();
+
+  return tensor_layout;
 }
 //-----------------------------------------------------------------------------
 void AssemblerBase::check(const Form& a)
@@ -19,11 +19,12 @@
 // Modified by Ola Skavhaug, 2008.
 //
 // First added:  2007-01-17
-// Last changed: 2013-09-19
+// Last changed: 2015-06-12
 
 #ifndef __ASSEMBLER_BASE_H
 #define __ASSEMBLER_BASE_H
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -36,6 +37,7 @@ namespace dolfin
   // Forward declarations
   class GenericTensor;
   class Form;
+  class TensorLayout;
 
   /// This class provides some common functions used in assembler
   /// classes.
@@ -72,6 +74,11 @@ namespace dolfin
 
   protected:
 
+    // Initialize global tensor and return the tensor layout it was
+    // initialized with (null if the tensor was already initialized)
+    std::shared_ptr<const TensorLayout>
+      init_global_tensor_layout(GenericTensor& A, const Form& a);
+
     // Check form
     static void check(const Form& a);
 
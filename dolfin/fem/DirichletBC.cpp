@@ -22,12 +22,13 @@
 // Modified by Mikael Mortensen, 2013
 //
 // First added:  2007-04-10
-// Last changed: 2014-01-23
+// Last changed: 2015-06-12
 
 #include <map>
 #include <cinttypes>
 #include <cstdlib>
 #include <utility>
+#include <boost/container/flat_map.hpp>
 #include <ufc.h>
 
 #include <dolfin/common/Array.h>
@@ -47,6 +48,7 @@
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/MeshData.h>
 #include <dolfin/mesh/MeshDomains.h>
+#include <dolfin/mesh/CompactMeshFunction.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/MeshValueCollection.h>
 #include <dolfin/mesh/SubDomain.h>
@@ -119,6 +121,19 @@ DirichletBC::DirichletBC(std::shared_ptr<const FunctionSpace> V,
   parameters = default_parameters();
 }
 //-----------------------------------------------------------------------------
+DirichletBC::DirichletBC(std::shared_ptr<const FunctionSpace> V,
+                         std::shared_ptr<const GenericFunction> g,
+                         std::shared_ptr<const CompactMeshFunction> sub_domains,
+                         std::size_t sub_domain,
+                         std::string method)
+  : Hierarchical<DirichletBC>(*this), _function_space(V), _g(g),
+    _method(method), _user_compact_mesh_function(sub_domains),
+    _user_sub_domain_marker(sub_domain), _check_midpoint(true)
+{
+  check();
+  parameters = default_parameters();
+}
+//-----------------------------------------------------------------------------
 DirichletBC::DirichletBC(const FunctionSpace& V, const GenericFunction& g,
                          std::size_t sub_domain, std::string method)
   : Hierarchical<DirichletBC>(*this),
@@ -676,11 +691,23 @@ void DirichletBC::check() const
                  "Mesh is not ordered according to the UFC numbering convention. Consider calling mesh.order()");
   }
 
-  // Check user supplied MeshFunction
+  // Check user supplied MeshFunction (or CompactMeshFunction)
+  std::shared_ptr<const Mesh> user_mesh;
+  std::size_t user_dim = 0;
   if (_user_mesh_function)
+  {
+    user_mesh = _user_mesh_function->mesh();
+    user_dim = _user_mesh_function->dim();
+  }
+  else if (_user_compact_mesh_function)
+  {
+    user_mesh = _user_compact_mesh_function->mesh();
+    user_dim = _user_compact_mesh_function->dim();
+  }
+  if (_user_mesh_function || _user_compact_mesh_function)
   {
     // Check that Meshfunction is initialised
-    if (!_user_mesh_function->mesh())
+    if (!user_mesh)
     {
       dolfin_error("DirichletBC.cpp",
                    "create Dirichlet boundary condition",
@@ -689,8 +716,8 @@ void DirichletBC::check() const
     }
 
     // Check that Meshfunction is a FacetFunction
-    const std::size_t tdim = _user_mesh_function->mesh()->topology().dim();
-    if (_user_mesh_function->dim() != tdim - 1)
+    const std::size_t tdim = user_mesh->topology().dim();
+    if (user_dim != tdim - 1)
     {
       dolfin_error("DirichletBC.cpp",
                    "create Dirichlet boundary condition",
@@ -699,7 +726,7 @@ void DirichletBC::check() const
 
     // Check that Meshfunction and FunctionSpace meshes match
     dolfin_assert(_function_space->mesh());
-    if (_user_mesh_function->mesh()->id() != _function_space->mesh()->id())
+    if (user_mesh->id() != _function_space->mesh()->id())
     {
       dolfin_error("DirichletBC.cpp",
                    "create Dirichlet boundary condition",
@@ -719,6 +746,11 @@ void DirichletBC::init_facets(const MPI_Comm mpi_comm) const
     init_from_sub_domain(_user_sub_domain);
   else if (_user_mesh_function)
     init_from_mesh_function(*_user_mesh_function, _user_sub_domain_marker);
+  else if (_user_compact_mesh_function)
+  {
+    init_from_compact_mesh_function(*_user_compact_mesh_function,
+                                    _user_sub_domain_marker);
+  }
   else
     init_from_mesh(_user_sub_domain_marker);
 }
@@ -772,6 +804,26 @@ void DirichletBC::init_from_mesh_function(const MeshFunction<std::size_t>& sub_d
   }
 }
 //-----------------------------------------------------------------------------
+void DirichletBC::init_from_compact_mesh_function(
+  const CompactMeshFunction& sub_domains, std::size_t sub_domain) const
+{
+  // Get mesh
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+
+  // Make sure we have the facet - cell connectivity
+  const std::size_t D = mesh.topology().dim();
+  mesh.init(D - 1, D);
+
+  // Build set of boundary facets
+  dolfin_assert(_facets.empty());
+  for (std::size_t i = 0; i < sub_domains.size(); ++i)
+  {
+    if (sub_domains[i] == sub_domain)
+      _facets.push_back(i);
+  }
+}
+//-----------------------------------------------------------------------------
 void DirichletBC::init_from_mesh(std::size_t sub_domain) const
 {
   // For this to work, the mesh *needs* to be ordered according to
@@ -785,7 +837,7 @@ void DirichletBC::init_from_mesh(std::size_t sub_domain) const
 
   // Assign domain numbers for each facet
   const std::size_t D = mesh.topology().dim();
-  const std::map<std::size_t, std::size_t>& markers
+  const boost::container::flat_map<std::size_t, std::size_t>& markers
     = mesh.domains().markers(D - 1);
 
   dolfin_assert(_facets.empty());
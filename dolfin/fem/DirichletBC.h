@@ -53,6 +53,7 @@ namespace dolfin
   class GenericMatrix;
   class GenericVector;
   class SubDomain;
+  class CompactMeshFunction;
   template<typename T> class MeshFunction;
 
   /// This class specifies the interface for setting (strong)
@@ -200,6 +201,27 @@ namespace dolfin
                 std::size_t sub_domain,
                 std::string method="topological");
 
+    /// Create boundary condition for subdomain specified by index,
+    /// with subdomain markers in compact storage
+    ///
+    /// *Arguments*
+    ///     V (_FunctionSpace_)
+    ///         The function space.
+    ///     g (_GenericFunction_)
+    ///         The value.
+    ///     sub_domains (_CompactMeshFunction_)
+    ///         Subdomain markers
+    ///     sub_domain (std::size_t)
+    ///         The subdomain index (number)
+    ///     method (std::string)
+    ///         Optional argument: A string specifying the
+    ///         method to identify dofs.
+    DirichletBC(std::shared_ptr<const FunctionSpace> V,
+                std::shared_ptr<const GenericFunction> g,
+                std::shared_ptr<const CompactMeshFunction> sub_domains,
+                std::size_t sub_domain,
+                std::string method="topological");
+
     /// Create boundary condition for boundary data included in the mesh
     ///
     /// *Arguments*
@@ -457,6 +479,11 @@ namespace dolfin
     void init_from_mesh_function(const MeshFunction<std::size_t>& sub_domains,
                                  std::size_t sub_domain) const;
 
+    // Initialize sub domain markers from CompactMeshFunction
+    void
+      init_from_compact_mesh_function(const CompactMeshFunction& sub_domains,
+                                      std::size_t sub_domain) const;
+
     // Initialize sub domain markers from mesh
     void init_from_mesh(std::size_t sub_domain) const;
 
@@ -515,6 +542,9 @@ namespace dolfin
     // User defined mesh function
     std::shared_ptr<const MeshFunction<std::size_t> > _user_mesh_function;
 
+    // User defined mesh function (compact storage)
+    std::shared_ptr<const CompactMeshFunction> _user_compact_mesh_function;
+
     // User defined sub domain marker for mesh or mesh function
     std::size_t _user_sub_domain_marker;
 
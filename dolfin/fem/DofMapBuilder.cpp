@@ -1218,7 +1218,7 @@ DofMapBuilder::build_ufc_node_graph_constrained(
   compute_constrained_mesh_indices(global_entity_indices,
                                    num_mesh_entities_global,
                                    required_mesh_entities,
-                                   mesh, *constrained_domain);
+                                   mesh, constrained_domain);
 
   // Extract sub-dofmaps
   std::vector<std::shared_ptr<const ufc::dofmap>> dofmaps(block_size);
@@ -1347,24 +1347,27 @@ void DofMapBuilder::compute_constrained_mesh_indices(
   std::vector<std::size_t>& num_mesh_entities_global,
   const std::vector<bool>& needs_mesh_entities,
   const Mesh& mesh,
-  const SubDomain& constrained_domain)
+  std::shared_ptr<const SubDomain> constrained_domain)
 {
   // Topological dimension
   const std::size_t D = mesh.topology().dim();
   dolfin_assert(needs_mesh_entities.size() == (D + 1));
 
-  // Compute slave-master pairs
+  // Compute slave-master pairs (reused if already computed for this
+  // constrained domain and mesh)
   std::map<unsigned int,
-           std::map<unsigned int, std::pair<unsigned int, unsigned int>>>
+           std::shared_ptr<const std::map<unsigned int,
+                                          std::pair<unsigned int,
+                                                    unsigned int>>>>
     slave_master_mesh_entities;
   for (std::size_t d = 0; d <= D; ++d)
   {
     if (needs_mesh_entities[d])
     {
       slave_master_mesh_entities.insert(std::make_pair(d,
-        PeriodicBoundaryComputation::compute_periodic_pairs(mesh,
-                                                            constrained_domain,
-                                                            d)));
+        PeriodicBoundaryComputation::cached_periodic_pairs(mesh,
+                                                           constrained_domain,
+                                                           d)));
     }
   }
 
@@ -1381,7 +1384,7 @@ void DofMapBuilder::compute_constrained_mesh_indices(
       // Get master-slave map
       dolfin_assert(slave_master_mesh_entities.find(d) != slave_master_mesh_entities.end());
       const auto& slave_to_master_mesh_entities
-        = slave_master_mesh_entities.find(d)->second;
+        = *slave_master_mesh_entities.find(d)->second;
       if (d == 0)
       {
         // Compute modified global vertex indices
@@ -1531,9 +1534,9 @@ void DofMapBuilder::compute_node_reordering(
     global_to_local_nodes_unowned(node_pairs.begin(), node_pairs.end());
   std::vector<std::pair<std::size_t, int>>().swap(node_pairs);
 
-  // Build graph for re-ordering. Below block is scoped to clear
-  // working data structures once graph is constructed.
-  Graph graph(owned_local_size);
+  // Build graph for re-ordering. The graph is first collected as a
+  // list of edges and then compressed.
+  std::vector<int> graph_edges;
 
   // Create contiguous local numbering for locally owned dofs
   std::size_t my_counter = 0;
@@ -1568,7 +1571,7 @@ void DofMapBuilder::compute_node_reordering(
       // Add to graph if node n0_local is owned
       if (n0_local != -1)
       {
-        dolfin_assert(n0_local < (int) graph.size());
+        dolfin_assert(n0_local < (int) owned_local_size);
         local_old.push_back(n0_local);
       }
     }
@@ -1576,8 +1579,13 @@ void DofMapBuilder::compute_node_reordering(
     for (std::size_t i = 0; i < local_old.size(); ++i)
       for (std::size_t j = 0; j < local_old.size(); ++j)
         if (i != j)
-          graph[local_old[i]].insert(local_old[j]);
+        {
+          graph_edges.push_back(local_old[i]);
+          graph_edges.push_back(local_old[j]);
+        }
   }
+  const Graph graph = GraphBuilder::local_graph(owned_local_size, graph_edges);
+  std::vector<int>().swap(graph_edges);
 
   // Reorder nodes
   const std::string ordering_library
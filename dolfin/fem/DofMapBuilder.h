@@ -140,7 +140,7 @@ namespace dolfin
       std::vector<std::size_t>& num_mesh_entities_global,
       const std::vector<bool>& needs_mesh_entities,
       const Mesh& mesh,
-      const SubDomain& constrained_domain);
+      std::shared_ptr<const SubDomain> constrained_domain);
 
     static std::shared_ptr<const ufc::dofmap>
       build_ufc_node_graph(
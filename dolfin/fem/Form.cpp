@@ -19,7 +19,7 @@
 // Modified by Martin Alnes 2008
 //
 // First added:  2007-12-10
-// Last changed: 2014-02-14
+// Last changed: 2015-06-12
 
 #include <memory>
 #include <string>
@@ -34,6 +34,7 @@
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/MeshData.h>
 #include <dolfin/mesh/MeshFunction.h>
+#include <dolfin/mesh/SubdomainIndex.h>
 #include "Form.h"
 
 using namespace dolfin;
@@ -339,6 +340,29 @@ void Form::set_vertex_domains
   _vertex_domains = vertex_domains;
 }
 //-----------------------------------------------------------------------------
+std::shared_ptr<const SubdomainIndex>
+Form::domain_index(const MeshFunction<std::size_t>& domains) const
+{
+  // Look for index of these markers, rebuild if markers have changed
+  for (auto& index : _domain_indices)
+  {
+    if (index.first == domains.id())
+    {
+      index.second->update(domains);
+      return index.second;
+    }
+  }
+
+  // Create new index, keeping at most one index for each kind of
+  // domain (cell, exterior facet, interior facet, vertex)
+  if (_domain_indices.size() == 4)
+    _domain_indices.erase(_domain_indices.begin());
+  std::shared_ptr<SubdomainIndex> index(new SubdomainIndex(domains));
+  _domain_indices.push_back(std::make_pair(domains.id(), index));
+
+  return index;
+}
+//-----------------------------------------------------------------------------
 std::shared_ptr<const ufc::form> Form::ufc_form() const
 {
   return _ufc_form;
@@ -19,12 +19,13 @@
 // Modified by Martin Alnes 2008
 //
 // First added:  2007-04-02
-// Last changed: 2014-02-14
+// Last changed: 2015-06-12
 
 #ifndef __FORM_H
 #define __FORM_H
 
 #include <map>
+#include <utility>
 #include <vector>
 #include <memory>
 
@@ -46,6 +47,7 @@ namespace dolfin
   class GenericFunction;
   class Mesh;
   template <typename T> class MeshFunction;
+  class SubdomainIndex;
 
   /// Base class for UFC code generated by FFC for DOLFIN with option -l.
   ///
@@ -334,6 +336,20 @@ namespace dolfin
     ///         The vertex domains.
     void set_vertex_domains(std::shared_ptr<const MeshFunction<std::size_t> > vertex_domains);
 
+    /// Return entities of domain markers grouped by marker value, for
+    /// assembly over subdomains. The index is cached by the form and
+    /// rebuilt only when the markers have changed.
+    ///
+    /// *Arguments*
+    ///     domains (_MeshFunction_ <std::size_t>)
+    ///         The domain markers.
+    ///
+    /// *Returns*
+    ///     _SubdomainIndex_
+    ///         The entities grouped by marker value.
+    std::shared_ptr<const SubdomainIndex>
+      domain_index(const MeshFunction<std::size_t>& domains) const;
+
     /// Return UFC form shared pointer
     ///
     /// *Returns*
@@ -386,6 +402,11 @@ namespace dolfin
 
     const std::size_t _rank;
 
+    // Cached indices of domain markers (with id of markers)
+    mutable std::vector<std::pair<std::size_t,
+                                  std::shared_ptr<SubdomainIndex>>>
+      _domain_indices;
+
   };
 
 }
@@ -27,6 +27,7 @@
 #include <dolfin/la/GenericMatrix.h>
 #include <dolfin/function/Function.h>
 #include "Assembler.h"
+#include "SystemAssembler.h"
 #include "Form.h"
 #include "NonlinearVariationalProblem.h"
 #include "NonlinearVariationalSolver.h"
@@ -234,3 +235,37 @@ NonlinearVariationalSolver::NonlinearDiscreteProblem::J(GenericMatrix& A,
     info(A, true);
 }
 //-----------------------------------------------------------------------------
+bool NonlinearVariationalSolver::NonlinearDiscreteProblem::F_and_J(
+  GenericVector& b, GenericMatrix& A, const GenericVector& x)
+{
+  // Get problem data
+  dolfin_assert(_problem);
+  std::shared_ptr<const Form> F(_problem->residual_form());
+  std::shared_ptr<const Form> J(_problem->jacobian_form());
+  std::vector<std::shared_ptr<const DirichletBC>> bcs(_problem->bcs());
+  std::vector<const DirichletBC*> _bcs;
+  for (std::size_t i = 0; i < bcs.size(); i++)
+  {
+    dolfin_assert(bcs[i]);
+    _bcs.push_back(bcs[i].get());
+  }
+
+  // Assemble Jacobian and residual in a single pass, applying
+  // boundary conditions symmetrically
+  dolfin_assert(F);
+  dolfin_assert(J);
+  SystemAssembler assembler(J, F, _bcs);
+  assembler.assemble(A, b, x);
+
+  // Print matrix and vector
+  dolfin_assert(_solver);
+  const bool print_rhs = _solver->parameters["print_rhs"];
+  if (print_rhs)
+    info(b, true);
+  const bool print_matrix = _solver->parameters["print_matrix"];
+  if (print_matrix)
+    info(A, true);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
@@ -157,6 +157,10 @@ namespace dolfin
       // Compute J = F' at current point x
       virtual void J(GenericMatrix& A, const GenericVector& x);
 
+      // Compute F and J together at current point x
+      virtual bool F_and_J(GenericVector& b, GenericMatrix& A,
+                           const GenericVector& x);
+
     private:
 
       // Problem and solver objects
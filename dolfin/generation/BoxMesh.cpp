@@ -19,19 +19,35 @@
 // Modified by Nuno Lopes, 2008.
 //
 // First added:  2005-12-02
-// Last changed: 2014-02-06
+// Last changed: 2015-06-11
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <boost/multi_array.hpp>
 
 #include <dolfin/common/constants.h>
 #include <dolfin/common/MPI.h>
+#include <dolfin/common/Set.h>
 #include <dolfin/common/Timer.h>
+#include <dolfin/mesh/LocalMeshData.h>
 #include <dolfin/mesh/MeshPartitioning.h>
 #include <dolfin/mesh/MeshEditor.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "BoxMesh.h"
 
 using namespace dolfin;
 
+namespace
+{
+  // Vertices of the six tetrahedra in each cube. The cube vertices
+  // are numbered such that bit i of the local vertex number is the
+  // offset in direction i.
+  const std::size_t cube_cells[6][4] = {{0, 1, 3, 7}, {0, 1, 7, 5},
+                                        {0, 5, 7, 4}, {0, 3, 2, 7},
+                                        {0, 6, 4, 7}, {0, 2, 6, 7}};
+}
+
 //-----------------------------------------------------------------------------
 BoxMesh::BoxMesh(double x0, double y0, double z0,
                  double x1, double y1, double z1,
@@ -56,13 +72,6 @@ void BoxMesh::build(double x0, double y0, double z0,
 {
   Timer timer("Generate Box mesh");
 
-  // Receive mesh according to parallel policy
-  if (MPI::is_receiver(this->mpi_comm()))
-  {
-    MeshPartitioning::build_distributed_mesh(*this);
-    return;
-  }
-
   const double a = x0;
   const double b = x1;
   const double c = y0;
@@ -87,74 +96,173 @@ void BoxMesh::build(double x0, double y0, double z0,
 
   rename("mesh", "Mesh of the cuboid (a,b) x (c,d) x (e,f)");
 
-  // Open mesh for editing
-  MeshEditor editor;
-  editor.open(*this, CellType::tetrahedron, 3, 3);
+  // Each process generates the vertices and the cubes (six cells
+  // each) in its part of the global index ranges directly, so the
+  // mesh is never built on a single process
+  const MPI_Comm mpi_comm = this->mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  const std::size_t num_cubes = nx*ny*nz;
+
+  LocalMeshData data(mpi_comm);
+  data.gdim = 3;
+  data.tdim = 3;
+  data.num_vertices_per_cell = 4;
+  data.num_global_vertices = (nx + 1)*(ny + 1)*(nz + 1);
+  data.num_global_cells = 6*num_cubes;
 
-  // Storage for vertex coordinates
-  std::vector<double> x(3);
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) dolfin::parameters["num_threads"], 1);
+  #endif
 
   // Create vertices
-  editor.init_vertices_global((nx + 1)*(ny + 1)*(nz + 1),
-                              (nx + 1)*(ny + 1)*(nz + 1));
-  std::size_t vertex = 0;
-  for (std::size_t iz = 0; iz <= nz; iz++)
+  const std::pair<std::size_t, std::size_t> vertex_range
+    = MPI::local_range(mpi_comm, data.num_global_vertices);
+  const std::int64_t num_local_vertices
+    = vertex_range.second - vertex_range.first;
+  data.vertex_coordinates.resize(boost::extents[num_local_vertices][3]);
+  data.vertex_indices.resize(num_local_vertices);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_local_vertices; i++)
   {
-    x[2] = e + (static_cast<double>(iz))*(f-e) / static_cast<double>(nz);
-    for (std::size_t iy = 0; iy <= ny; iy++)
-    {
-      x[1] = c + (static_cast<double>(iy))*(d-c) / static_cast<double>(ny);
-      for (std::size_t ix = 0; ix <= nx; ix++)
-      {
-        x[0] = a + (static_cast<double>(ix))*(b-a) / static_cast<double>(nx);
-        editor.add_vertex(vertex, x);
-        vertex++;
-      }
-    }
+    const std::size_t vertex = vertex_range.first + i;
+    const std::size_t ix = vertex % (nx + 1);
+    const std::size_t iy = (vertex/(nx + 1)) % (ny + 1);
+    const std::size_t iz = vertex/((nx + 1)*(ny + 1));
+    data.vertex_indices[i] = vertex;
+    data.vertex_coordinates[i][0]
+      = a + (static_cast<double>(ix))*(b-a) / static_cast<double>(nx);
+    data.vertex_coordinates[i][1]
+      = c + (static_cast<double>(iy))*(d-c) / static_cast<double>(ny);
+    data.vertex_coordinates[i][2]
+      = e + (static_cast<double>(iz))*(f-e) / static_cast<double>(nz);
   }
 
   // Create tetrahedra
-  editor.init_cells_global(6*nx*ny*nz, 6*nx*ny*nz);
-  std::size_t cell = 0;
-  boost::multi_array<std::size_t, 2> cells(boost::extents[6][4]);
-  for (std::size_t iz = 0; iz < nz; iz++)
+  const std::pair<std::size_t, std::size_t> cube_range
+    = MPI::local_range(mpi_comm, num_cubes);
+  const std::int64_t num_local_cubes = cube_range.second - cube_range.first;
+  data.cell_vertices.resize(boost::extents[6*num_local_cubes][4]);
+  data.global_cell_indices.resize(6*num_local_cubes);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_local_cubes; i++)
   {
-    for (std::size_t iy = 0; iy < ny; iy++)
+    const std::size_t cube = cube_range.first + i;
+    const std::size_t ix = cube % nx;
+    const std::size_t iy = (cube/nx) % ny;
+    const std::size_t iz = cube/(nx*ny);
+
+    // Global indices of cube vertices
+    std::size_t v[8];
+    v[0] = iz*(nx + 1)*(ny + 1) + iy*(nx + 1) + ix;
+    v[1] = v[0] + 1;
+    v[2] = v[0] + (nx + 1);
+    v[3] = v[1] + (nx + 1);
+    for (std::size_t j = 0; j < 4; j++)
+      v[j + 4] = v[j] + (nx + 1)*(ny + 1);
+
+    for (std::size_t k = 0; k < 6; k++)
     {
-      for (std::size_t ix = 0; ix < nx; ix++)
-      {
-        const std::size_t v0 = iz*(nx + 1)*(ny + 1) + iy*(nx + 1) + ix;
-        const std::size_t v1 = v0 + 1;
-        const std::size_t v2 = v0 + (nx + 1);
-        const std::size_t v3 = v1 + (nx + 1);
-        const std::size_t v4 = v0 + (nx + 1)*(ny + 1);
-        const std::size_t v5 = v1 + (nx + 1)*(ny + 1);
-        const std::size_t v6 = v2 + (nx + 1)*(ny + 1);
-        const std::size_t v7 = v3 + (nx + 1)*(ny + 1);
-
-        // Note that v0 < v1 < v2 < v3 < vmid.
-        cells[0][0] = v0; cells[0][1] = v1; cells[0][2] = v3; cells[0][3] = v7;
-        cells[1][0] = v0; cells[1][1] = v1; cells[1][2] = v7; cells[1][3] = v5;
-        cells[2][0] = v0; cells[2][1] = v5; cells[2][2] = v7; cells[2][3] = v4;
-        cells[3][0] = v0; cells[3][1] = v3; cells[3][2] = v2; cells[3][3] = v7;
-        cells[4][0] = v0; cells[4][1] = v6; cells[4][2] = v4; cells[4][3] = v7;
-        cells[5][0] = v0; cells[5][1] = v2; cells[5][2] = v6; cells[5][3] = v7;
-
-        // Add cells
-        for (auto _cell = cells.begin(); _cell != cells.end(); ++_cell)
-          editor.add_cell(cell++, *_cell);
-      }
+      const std::size_t cell = 6*i + k;
+      data.global_cell_indices[cell] = 6*cube + k;
+      for (std::size_t j = 0; j < 4; j++)
+        data.cell_vertices[cell][j] = v[cube_cells[k][j]];
     }
   }
 
-  // Close mesh editor
-  editor.close();
-
-  // Broadcast mesh according to parallel policy
-  if (MPI::is_broadcaster(this->mpi_comm()))
+  if (num_processes == 1)
   {
-    MeshPartitioning::build_distributed_mesh(*this);
+    // Build mesh from local data
+    MeshEditor editor;
+    editor.open(*this, CellType::tetrahedron, 3, 3);
+
+    editor.init_vertices_global(num_local_vertices, num_local_vertices);
+    std::vector<double> x(3);
+    for (std::int64_t i = 0; i < num_local_vertices; i++)
+    {
+      std::copy(data.vertex_coordinates[i].begin(),
+                data.vertex_coordinates[i].end(), x.begin());
+      editor.add_vertex(i, x);
+    }
+
+    editor.init_cells_global(6*num_local_cubes, 6*num_local_cubes);
+    for (std::int64_t i = 0; i < 6*num_local_cubes; i++)
+      editor.add_cell(i, data.cell_vertices[i]);
+
+    // Close mesh editor
+    editor.close();
     return;
   }
+
+  // Cells are owned by the generating process. A cell with a facet
+  // on a cube face shared with a cube on another process is ghosted
+  // on that process.
+  const unsigned int process_number = MPI::rank(mpi_comm);
+  const std::vector<std::size_t> cell_partition(6*num_local_cubes,
+                                                process_number);
+  std::map<std::size_t, dolfin::Set<unsigned int>> ghost_procs;
+  const std::string ghost_mode = dolfin::parameters["ghost_mode"];
+  if (ghost_mode != "none")
+  {
+    const std::size_t n[3] = {nx, ny, nz};
+    const std::size_t stride[3] = {1, nx, nx*ny};
+    for (std::size_t cube = cube_range.first; cube < cube_range.second;
+         cube++)
+    {
+      const std::size_t index[3] = {cube % nx, (cube/nx) % ny, cube/(nx*ny)};
+      for (std::size_t dim = 0; dim < 3; dim++)
+      {
+        for (std::size_t side = 0; side < 2; side++)
+        {
+          // Get process owning neighbouring cube
+          if ((side == 0 && index[dim] == 0)
+              || (side == 1 && index[dim] + 1 == n[dim]))
+          {
+            continue;
+          }
+          const std::size_t neighbour
+            = side == 0 ? cube - stride[dim] : cube + stride[dim];
+          const unsigned int process
+            = MPI::index_owner(mpi_comm, neighbour, num_cubes);
+          if (process == process_number)
+            continue;
+
+          // Find cells with a facet (three vertices) on shared face
+          for (std::size_t k = 0; k < 6; k++)
+          {
+            std::size_t num_face_vertices = 0;
+            for (std::size_t j = 0; j < 4; j++)
+            {
+              if (((cube_cells[k][j] >> dim) & 1) == side)
+                ++num_face_vertices;
+            }
+            if (num_face_vertices != 3)
+              continue;
+
+            const std::size_t cell = 6*(cube - cube_range.first) + k;
+            auto map_it = ghost_procs.find(cell);
+            if (map_it == ghost_procs.end())
+            {
+              // Owning process goes first
+              dolfin::Set<unsigned int> sharing_processes;
+              sharing_processes.insert(process_number);
+              sharing_processes.insert(process);
+              ghost_procs.insert(std::make_pair(cell, sharing_processes));
+            }
+            else
+              map_it->second.insert(process);
+          }
+        }
+      }
+    }
+  }
+
+  // Build distributed mesh from local data, skipping graph
+  // partitioning
+  MeshPartitioning::build_distributed_mesh(*this, data, cell_partition,
+                                           ghost_procs);
 }
 //-----------------------------------------------------------------------------
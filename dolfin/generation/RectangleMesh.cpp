@@ -19,16 +19,51 @@
 // Modified by Nuno Lopes 2008.
 // Modified by Kristian B. Oelgaard 2009.
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <boost/multi_array.hpp>
 
 #include <dolfin/common/constants.h>
 #include <dolfin/common/MPI.h>
+#include <dolfin/common/Set.h>
+#include <dolfin/mesh/LocalMeshData.h>
 #include <dolfin/mesh/MeshEditor.h>
 #include <dolfin/mesh/MeshPartitioning.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "RectangleMesh.h"
 
 using namespace dolfin;
 
+namespace
+{
+  // Vertices of the triangles in each square. The square vertices
+  // are numbered such that bit i of the local vertex number is the
+  // offset in direction i, and 4 is the midpoint.
+  const std::size_t crossed_cells[4][3] = {{0, 1, 4}, {0, 2, 4},
+                                           {1, 3, 4}, {2, 3, 4}};
+  const std::size_t left_cells[2][3] = {{0, 1, 2}, {1, 2, 3}};
+  const std::size_t right_cells[2][3] = {{0, 1, 3}, {0, 2, 3}};
+
+  // Return local vertices of cell k in square (ix, iy)
+  const std::size_t* square_cell(const std::string& diagonal,
+                                 std::size_t ix, std::size_t iy,
+                                 std::size_t k)
+  {
+    if (diagonal == "crossed")
+      return crossed_cells[k];
+
+    // Alternating diagonals start with the first named diagonal in
+    // the first square of every other row
+    bool left = (diagonal == "left");
+    if (diagonal == "right/left")
+      left = (ix + iy) % 2 == 0;
+    else if (diagonal == "left/right")
+      left = (ix + iy) % 2 == 1;
+    return left ? left_cells[k] : right_cells[k];
+  }
+}
+
 //-----------------------------------------------------------------------------
 RectangleMesh::RectangleMesh(double x0, double y0, double x1, double y1,
                              std::size_t nx, std::size_t ny,
@@ -49,13 +84,6 @@ void RectangleMesh::build(double x0, double y0, double x1, double y1,
                           std::size_t nx, std::size_t ny,
                           std::string diagonal)
 {
-  // Receive mesh according to parallel policy
-  if (MPI::is_receiver(this->mpi_comm()))
-  {
-    MeshPartitioning::build_distributed_mesh(*this);
-    return;
-  }
-
   // Check options
   if (diagonal != "left" && diagonal != "right" && diagonal != "right/left"
           && diagonal != "left/right" && diagonal != "crossed")
@@ -85,139 +113,190 @@ void RectangleMesh::build(double x0, double y0, double x1, double y1,
   }
 
   rename("mesh", "Mesh of the unit square (a,b) x (c,d)");
-  // Open mesh for editing
-  MeshEditor editor;
-  editor.open(*this, CellType::triangle, 2, 2);
 
-  // Create vertices and cells:
+  // Each process generates the vertices and the squares in its part
+  // of the global index ranges directly, so the mesh is never built
+  // on a single process. Midpoint vertices (crossed diagonals) are
+  // numbered after the main vertices.
+  const MPI_Comm mpi_comm = this->mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  const std::size_t num_squares = nx*ny;
+  const std::size_t num_main_vertices = (nx + 1)*(ny + 1);
+  const std::size_t cells_per_square = (diagonal == "crossed") ? 4 : 2;
+
+  LocalMeshData data(mpi_comm);
+  data.gdim = 2;
+  data.tdim = 2;
+  data.num_vertices_per_cell = 3;
+  data.num_global_vertices = num_main_vertices;
   if (diagonal == "crossed")
-  {
-    editor.init_vertices_global((nx + 1)*(ny + 1) + nx*ny,
-                                  (nx + 1)*(ny + 1) + nx*ny);
-    editor.init_cells_global(4*nx*ny, 4*nx*ny);
-  }
-  else
-  {
-    editor.init_vertices_global((nx + 1)*(ny + 1), (nx + 1)*(ny + 1));
-    editor.init_cells_global(2*nx*ny, 2*nx*ny);
-  }
+    data.num_global_vertices += num_squares;
+  data.num_global_cells = cells_per_square*num_squares;
 
-  // Storage for vertices
-  std::vector<double> x(2);
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) dolfin::parameters["num_threads"], 1);
+  #endif
 
-  // Create main vertices:
-  std::size_t vertex = 0;
-  for (std::size_t iy = 0; iy <= ny; iy++)
+  // Create main and midpoint vertices
+  const std::pair<std::size_t, std::size_t> vertex_range
+    = MPI::local_range(mpi_comm, data.num_global_vertices);
+  const std::int64_t num_local_vertices
+    = vertex_range.second - vertex_range.first;
+  data.vertex_coordinates.resize(boost::extents[num_local_vertices][2]);
+  data.vertex_indices.resize(num_local_vertices);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_local_vertices; i++)
   {
-    x[1] = c + ((static_cast<double>(iy))*(d - c)/static_cast<double>(ny));
-    for (std::size_t ix = 0; ix <= nx; ix++)
+    const std::size_t vertex = vertex_range.first + i;
+    double x, y;
+    if (vertex < num_main_vertices)
+    {
+      x = static_cast<double>(vertex % (nx + 1));
+      y = static_cast<double>(vertex/(nx + 1));
+    }
+    else
     {
-      x[0] = a + ((static_cast<double>(ix))*(b - a)/static_cast<double>(nx));
-      editor.add_vertex(vertex, x);
-      vertex++;
+      x = static_cast<double>((vertex - num_main_vertices) % nx) + 0.5;
+      y = static_cast<double>((vertex - num_main_vertices)/nx) + 0.5;
     }
+    data.vertex_indices[i] = vertex;
+    data.vertex_coordinates[i][0] = a + x*(b - a)/static_cast<double>(nx);
+    data.vertex_coordinates[i][1] = c + y*(d - c)/static_cast<double>(ny);
   }
 
-  // Create midpoint vertices if the mesh type is crossed
-  if (diagonal == "crossed")
+  // Create triangles
+  const std::pair<std::size_t, std::size_t> square_range
+    = MPI::local_range(mpi_comm, num_squares);
+  const std::int64_t num_local_squares
+    = square_range.second - square_range.first;
+  const std::int64_t num_local_cells = cells_per_square*num_local_squares;
+  data.cell_vertices.resize(boost::extents[num_local_cells][3]);
+  data.global_cell_indices.resize(num_local_cells);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_local_squares; i++)
   {
-    for (std::size_t iy = 0; iy < ny; iy++)
+    const std::size_t square = square_range.first + i;
+    const std::size_t ix = square % nx;
+    const std::size_t iy = square/nx;
+
+    // Global indices of square vertices and midpoint
+    std::size_t v[5];
+    v[0] = iy*(nx + 1) + ix;
+    v[1] = v[0] + 1;
+    v[2] = v[0] + (nx + 1);
+    v[3] = v[1] + (nx + 1);
+    v[4] = num_main_vertices + iy*nx + ix;
+
+    for (std::size_t k = 0; k < cells_per_square; k++)
     {
-      x[1] = c +(static_cast<double>(iy) + 0.5)*(d - c)/static_cast<double>(ny);
-      for (std::size_t ix = 0; ix < nx; ix++)
-      {
-        x[0] = a + (static_cast<double>(ix) + 0.5)*(b - a)/static_cast<double>(nx);
-        editor.add_vertex(vertex, x);
-        vertex++;
-      }
+      const std::size_t cell = cells_per_square*i + k;
+      const std::size_t* cell_vertices = square_cell(diagonal, ix, iy, k);
+      data.global_cell_indices[cell] = cells_per_square*square + k;
+      for (std::size_t j = 0; j < 3; j++)
+        data.cell_vertices[cell][j] = v[cell_vertices[j]];
     }
   }
 
-  // Create triangles
-  std::size_t cell = 0;
-  if (diagonal == "crossed")
+  if (num_processes == 1)
   {
-    boost::multi_array<std::size_t, 2> cells(boost::extents[4][3]);
-    for (std::size_t iy = 0; iy < ny; iy++)
+    // Build mesh from local data
+    MeshEditor editor;
+    editor.open(*this, CellType::triangle, 2, 2);
+
+    editor.init_vertices_global(num_local_vertices, num_local_vertices);
+    std::vector<double> x(2);
+    for (std::int64_t i = 0; i < num_local_vertices; i++)
     {
-      for (std::size_t ix = 0; ix < nx; ix++)
-      {
-        const std::size_t v0 = iy*(nx + 1) + ix;
-        const std::size_t v1 = v0 + 1;
-        const std::size_t v2 = v0 + (nx + 1);
-        const std::size_t v3 = v1 + (nx + 1);
-        const std::size_t vmid = (nx + 1)*(ny + 1) + iy*nx + ix;
-
-        // Note that v0 < v1 < v2 < v3 < vmid.
-        cells[0][0] = v0; cells[0][1] = v1; cells[0][2] = vmid;
-        cells[1][0] = v0; cells[1][1] = v2; cells[1][2] = vmid;
-        cells[2][0] = v1; cells[2][1] = v3; cells[2][2] = vmid;
-        cells[3][0] = v2; cells[3][1] = v3; cells[3][2] = vmid;
-
-        // Add cells
-        for (auto _cell = cells.begin(); _cell != cells.end(); ++_cell)
-          editor.add_cell(cell++, *_cell);
-      }
+      std::copy(data.vertex_coordinates[i].begin(),
+                data.vertex_coordinates[i].end(), x.begin());
+      editor.add_vertex(i, x);
     }
+
+    editor.init_cells_global(num_local_cells, num_local_cells);
+    for (std::int64_t i = 0; i < num_local_cells; i++)
+      editor.add_cell(i, data.cell_vertices[i]);
+
+    // Close mesh editor
+    editor.close();
+    return;
   }
-  else if (diagonal == "left" || diagonal == "right" || diagonal == "right/left" || diagonal == "left/right")
+
+  // Cells are owned by the generating process. A cell with a facet
+  // on a square side shared with a square on another process is
+  // ghosted on that process.
+  const unsigned int process_number = MPI::rank(mpi_comm);
+  const std::vector<std::size_t> cell_partition(num_local_cells,
+                                                process_number);
+  std::map<std::size_t, dolfin::Set<unsigned int>> ghost_procs;
+  const std::string ghost_mode = dolfin::parameters["ghost_mode"];
+  if (ghost_mode != "none")
   {
-    std::string local_diagonal = diagonal;
-    boost::multi_array<std::size_t, 2> cells(boost::extents[2][3]);
-    for (std::size_t iy = 0; iy < ny; iy++)
+    const std::size_t n[2] = {nx, ny};
+    const std::size_t stride[2] = {1, nx};
+    for (std::size_t square = square_range.first;
+         square < square_range.second; square++)
     {
-      // Set up alternating diagonal
-      if (diagonal == "right/left")
-      {
-        if (iy % 2)
-          local_diagonal = "right";
-        else
-          local_diagonal = "left";
-      }
-      if (diagonal == "left/right")
+      const std::size_t index[2] = {square % nx, square/nx};
+      for (std::size_t dim = 0; dim < 2; dim++)
       {
-        if (iy % 2)
-          local_diagonal = "left";
-        else
-          local_diagonal = "right";
-      }
+        for (std::size_t side = 0; side < 2; side++)
+        {
+          // Get process owning neighbouring square
+          if ((side == 0 && index[dim] == 0)
+              || (side == 1 && index[dim] + 1 == n[dim]))
+          {
+            continue;
+          }
+          const std::size_t neighbour
+            = side == 0 ? square - stride[dim] : square + stride[dim];
+          const unsigned int process
+            = MPI::index_owner(mpi_comm, neighbour, num_squares);
+          if (process == process_number)
+            continue;
 
-      for (std::size_t ix = 0; ix < nx; ix++)
-      {
-        const std::size_t v0 = iy*(nx + 1) + ix;
-        const std::size_t v1 = v0 + 1;
-        const std::size_t v2 = v0 + (nx + 1);
-        const std::size_t v3 = v1 + (nx + 1);
-        std::vector<std::size_t> cell_data;
+          // Find cells with a facet (two vertices) on shared side
+          for (std::size_t k = 0; k < cells_per_square; k++)
+          {
+            const std::size_t* cell_vertices
+              = square_cell(diagonal, index[0], index[1], k);
+            std::size_t num_side_vertices = 0;
+            for (std::size_t j = 0; j < 3; j++)
+            {
+              if (cell_vertices[j] < 4
+                  && ((cell_vertices[j] >> dim) & 1) == side)
+              {
+                ++num_side_vertices;
+              }
+            }
+            if (num_side_vertices != 2)
+              continue;
 
-        if(local_diagonal == "left")
-        {
-          cells[0][0] = v0; cells[0][1] = v1; cells[0][2] = v2;
-          cells[1][0] = v1; cells[1][1] = v2; cells[1][2] = v3;
-          if (diagonal == "right/left" || diagonal == "left/right")
-            local_diagonal = "right";
+            const std::size_t cell
+              = cells_per_square*(square - square_range.first) + k;
+            auto map_it = ghost_procs.find(cell);
+            if (map_it == ghost_procs.end())
+            {
+              // Owning process goes first
+              dolfin::Set<unsigned int> sharing_processes;
+              sharing_processes.insert(process_number);
+              sharing_processes.insert(process);
+              ghost_procs.insert(std::make_pair(cell, sharing_processes));
+            }
+            else
+              map_it->second.insert(process);
+          }
         }
-        else
-        {
-          cells[0][0] = v0; cells[0][1] = v1; cells[0][2] = v3;
-          cells[1][0] = v0; cells[1][1] = v2; cells[1][2] = v3;
-          if (diagonal == "right/left" || diagonal == "left/right")
-            local_diagonal = "left";
-        }
-        editor.add_cell(cell++, cells[0]);
-        editor.add_cell(cell++, cells[1]);
       }
     }
   }
 
-  // Close mesh editor
-  editor.close();
-
-  // Broadcast mesh according to parallel policy
-  if (MPI::is_broadcaster(this->mpi_comm()))
-  {
-    MeshPartitioning::build_distributed_mesh(*this);
-    return;
-  }
+  // Build distributed mesh from local data, skipping graph
+  // partitioning
+  MeshPartitioning::build_distributed_mesh(*this, data, cell_partition,
+                                           ghost_procs);
 }
 //-----------------------------------------------------------------------------
@@ -56,27 +56,21 @@ namespace dolfin
       // Number of vertices
       const std::size_t n = graph.size();
 
-      // Count number of edges
-      Graph::const_iterator vertex;
-      std::size_t num_edges = 0;
-      for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
-        num_edges += vertex->size();
-
       // Build list of graph edges
       std::vector<std::pair<std::size_t, std::size_t> > edges;
-      edges.reserve(num_edges);
-      graph_set_type::const_iterator edge;
-      for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
+      edges.reserve(graph.num_edges());
+      for (std::size_t vertex_index = 0; vertex_index < n; ++vertex_index)
       {
-        for (edge = vertex->begin(); edge != vertex->end(); ++edge)
+        for (auto edge : graph[vertex_index])
         {
-          const std::size_t vertex_index = vertex - graph.begin();
-          if (vertex_index != (std::size_t) *edge)
-            edges.push_back(std::make_pair(vertex_index, *edge));
+          if (vertex_index != (std::size_t) edge)
+            edges.push_back(std::make_pair(vertex_index, edge));
         }
       }
-      // Build Boost graph
-      const BoostGraph g(boost::edges_are_unsorted_multi_pass,
+
+      // Build Boost graph (edges of a CSR graph are sorted by source
+      // vertex)
+      const BoostGraph g(boost::edges_are_sorted,
                          edges.begin(), edges.end(), n);
 
       // Resize vector to hold colors
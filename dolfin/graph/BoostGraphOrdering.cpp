@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2012-07-06
-// Last changed: 2012-11-12
+// Last changed: 2015-06-12
 
 #define BOOST_NO_HASH
 
@@ -126,15 +126,12 @@ T BoostGraphOrdering::build_undirected_graph(const X& graph)
 
   // Build Boost graph
   T boost_graph(n);
-  typename X::const_iterator vertex;
-  graph_set_type::const_iterator edge;
-  for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
+  for (std::size_t vertex_index = 0; vertex_index < n; ++vertex_index)
   {
-    const std::size_t vertex_index = vertex - graph.begin();
-    for (edge = vertex->begin(); edge != vertex->end(); ++edge)
+    for (auto edge : graph[vertex_index])
     {
-      if (vertex_index < *edge)
-        boost::add_edge(vertex_index, *edge, boost_graph);
+      if (vertex_index < (std::size_t) edge)
+        boost::add_edge(vertex_index, edge, boost_graph);
     }
   }
 
@@ -151,15 +148,12 @@ T BoostGraphOrdering::build_directed_graph(const X& graph)
 
   // Build Boost graph
   T boost_graph(n);
-  typename X::const_iterator vertex;
-  graph_set_type::const_iterator edge;
-  for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
+  for (std::size_t vertex_index = 0; vertex_index < n; ++vertex_index)
   {
-    const std::size_t vertex_index = vertex - graph.begin();
-    for (edge = vertex->begin(); edge != vertex->end(); ++edge)
+    for (auto edge : graph[vertex_index])
     {
-      if (vertex_index != *edge)
-        boost::add_edge(vertex_index, *edge, boost_graph);
+      if (vertex_index != (std::size_t) edge)
+        boost::add_edge(vertex_index, edge, boost_graph);
     }
   }
 
@@ -171,24 +165,20 @@ T BoostGraphOrdering::build_csr_directed_graph(const X& graph)
 {
   Timer timer("Build Boost CSR graph");
 
-  // Count number of edges
-  Graph::const_iterator vertex;
-  std::size_t num_edges = 0;
-  for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
-    num_edges += vertex->size();
+  // Number of vertices
+  const std::size_t n = graph.size();
 
   // Build list of graph edges
   std::vector<std::pair<std::size_t, std::size_t>> edges;
-  edges.reserve(num_edges);
-  graph_set_type::const_iterator edge;
-  for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
-    for (edge = vertex->begin(); edge != vertex->end(); ++edge)
-      edges.push_back(std::make_pair(vertex - graph.begin(), *edge));
-
-  // Number of vertices
-  const std::size_t n = graph.size();
+  edges.reserve(graph.num_edges());
+  for (std::size_t vertex_index = 0; vertex_index < n; ++vertex_index)
+  {
+    for (auto edge : graph[vertex_index])
+      edges.push_back(std::make_pair(vertex_index, edge));
+  }
 
-  // Build and return Boost graph
-  return T(boost::edges_are_unsorted_multi_pass, edges.begin(), edges.end(), n);
+  // Build and return Boost graph (edges of a CSR graph are sorted by
+  // source vertex)
+  return T(boost::edges_are_sorted, edges.begin(), edges.end(), n);
 }
 //-----------------------------------------------------------------------------
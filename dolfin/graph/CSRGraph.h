@@ -16,12 +16,13 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:
-// Last changed:
+// Last changed: 2015-06-12
 
 #ifndef __CSRGRAPH_H
 #define __CSRGRAPH_H
 
 #include <vector>
+#include <dolfin/common/ArrayView.h>
 #include <dolfin/common/MPI.h>
 
 namespace dolfin
@@ -71,9 +72,36 @@ namespace dolfin
       calculate_node_distribution();
     }
 
+    /// Create a CSR Graph from edges and node offsets in compressed
+    /// form (see edges() and nodes()). The contents of the vectors
+    /// are moved into the graph, and the vectors are empty on return
+    CSRGraph(MPI_Comm mpi_comm, std::vector<T>& edges,
+             std::vector<T>& node_offsets) : _mpi_comm(mpi_comm)
+    {
+      dolfin_assert(!node_offsets.empty());
+      dolfin_assert((std::size_t) node_offsets.back() == edges.size());
+      _edges.swap(edges);
+      _node_offsets.swap(node_offsets);
+
+      // Compute node offsets
+      calculate_node_distribution();
+    }
+
     /// Destructor
     ~CSRGraph() {}
 
+    /// Edges (outgoing) of local node i
+    ArrayView<const T> operator[](std::size_t i) const
+    {
+      dolfin_assert(i < num_nodes());
+      return ArrayView<const T>(_node_offsets[i + 1] - _node_offsets[i],
+                                _edges.data() + _node_offsets[i]);
+    }
+
+    /// Number of local nodes in graph (same as num_nodes())
+    std::size_t size() const
+    { return num_nodes(); }
+
     /// Vector containing all edges for all local nodes
     const std::vector<T>& edges() const
     { return _edges; }
@@ -99,6 +127,10 @@ namespace dolfin
     const std::vector<T>& node_distribution() const
     { return _node_distribution; }
 
+    /// Return MPI communicator
+    MPI_Comm mpi_comm() const
+    { return _mpi_comm; }
+
   private:
 
     // Compute offset of number of nodes on each process
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2010-11-16
-// Last changed: 2010-11-25
+// Last changed: 2015-06-12
 
 #ifndef __GRAPH_TYPES_H
 #define __GRAPH_TYPES_H
@@ -28,15 +28,16 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/unordered_set.hpp>
 #include <dolfin/common/Set.h>
+#include "CSRGraph.h"
 
 namespace dolfin
 {
 
   /// Typedefs for simple graph data structures
 
-  /// Vector of unordered sets
-  typedef dolfin::Set<int> graph_set_type;
-  typedef std::vector<graph_set_type> Graph;
+  /// Local graph in compressed sparse row format. Local graphs are
+  /// built by GraphBuilder.
+  typedef CSRGraph<int> Graph;
 
 }
 
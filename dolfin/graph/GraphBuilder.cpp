@@ -18,15 +18,23 @@
 // Modified by Chris Richardson, 2012-2014
 //
 // First added:  2010-02-19
-// Last changed: 2013-01-31
+// Last changed: 2015-06-12
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <numeric>
 #include <set>
 #include <utility>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef HAS_OPENMP
+#include <omp.h>
+#endif
 
 #include <dolfin/log/log.h>
 #include <dolfin/common/MPI.h>
@@ -37,17 +45,74 @@
 #include <dolfin/mesh/LocalMeshData.h>
 #include <dolfin/mesh/MeshEntityIterator.h>
 #include <dolfin/mesh/Vertex.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "GraphBuilder.h"
 
 using namespace dolfin;
 
+namespace
+{
+  // Hash of facet (sorted list of vertex indices). The hash is used
+  // for facet lookup and to distribute facets between threads and
+  // processes, so must be the same on all processes.
+  struct FacetHash
+  {
+    std::size_t operator()(const std::array<std::size_t, 3>& facet) const
+    { return boost::hash_range(facet.begin(), facet.end()); }
+  };
+
+  // Build CSR graph from a list of directed edges [i0, j0, i1, j1,
+  // ...] by two-pass counting: first count the edges from each node,
+  // then insert them. Edges of each node are sorted and duplicates
+  // removed.
+  template<typename T, typename X>
+  CSRGraph<T> build_csr_graph(const MPI_Comm mpi_comm, std::size_t num_nodes,
+                              const std::vector<X>& edge_list)
+  {
+    dolfin_assert(edge_list.size() % 2 == 0);
+
+    // Count number of edges from each node
+    std::vector<T> node_offsets(num_nodes + 1, 0);
+    for (std::size_t e = 0; e < edge_list.size(); e += 2)
+    {
+      dolfin_assert((std::size_t) edge_list[e] < num_nodes);
+      ++node_offsets[edge_list[e] + 1];
+    }
+    std::partial_sum(node_offsets.begin(), node_offsets.end(),
+                     node_offsets.begin());
+
+    // Insert edges
+    std::vector<T> edges(node_offsets.back());
+    std::vector<T> position(node_offsets.begin(), node_offsets.end() - 1);
+    for (std::size_t e = 0; e < edge_list.size(); e += 2)
+      edges[position[edge_list[e]]++] = edge_list[e + 1];
+
+    // Sort edges of each node and remove duplicates, compacting the
+    // edge array in place
+    std::size_t num_edges = 0;
+    for (std::size_t i = 0; i < num_nodes; ++i)
+    {
+      auto begin = edges.begin() + node_offsets[i];
+      auto end = edges.begin() + node_offsets[i + 1];
+      std::sort(begin, end);
+      end = std::unique(begin, end);
+      node_offsets[i] = num_edges;
+      num_edges = std::copy(begin, end, edges.begin() + num_edges)
+        - edges.begin();
+    }
+    node_offsets[num_nodes] = num_edges;
+    edges.resize(num_edges);
+
+    return CSRGraph<T>(mpi_comm, edges, node_offsets);
+  }
+}
+
 //-----------------------------------------------------------------------------
 Graph GraphBuilder::local_graph(const Mesh& mesh, const GenericDofMap& dofmap0,
                                                   const GenericDofMap& dofmap1)
 {
-  // Create empty graph
-  const std::size_t n = dofmap0.global_dimension();
-  Graph graph(n);
+  // List of edges
+  std::vector<int> edges;
 
   // Build graph
   for (CellIterator cell(mesh); !cell.end(); ++cell)
@@ -56,14 +121,20 @@ Graph GraphBuilder::local_graph(const Mesh& mesh, const GenericDofMap& dofmap0,
       = dofmap0.cell_dofs(cell->index());
     const ArrayView<const dolfin::la_index> dofs1
       = dofmap1.cell_dofs(cell->index());
-    //std::vector<dolfin::la_index>::const_iterator node0, node1;
     for (auto node0 = dofs0.begin(); node0 != dofs0.end(); ++node0)
+    {
       for (auto node1 = dofs1.begin(); node1 != dofs1.end(); ++node1)
+      {
         if (*node0 != *node1)
-          graph[*node0].insert(*node1);
+        {
+          edges.push_back(*node0);
+          edges.push_back(*node1);
+        }
+      }
+    }
   }
 
-  return graph;
+  return local_graph(dofmap0.global_dimension(), edges);
 }
 //-----------------------------------------------------------------------------
 Graph GraphBuilder::local_graph(const Mesh& mesh,
@@ -79,15 +150,18 @@ Graph GraphBuilder::local_graph(const Mesh& mesh,
   dolfin_assert(coloring_type.size() >= 2);
   dolfin_assert(coloring_type.front() == coloring_type.back());
 
-  // Create graph
+  // Graph in compressed form
   const std::size_t num_vertices = mesh.num_entities(coloring_type[0]);
-  Graph graph(num_vertices);
+  std::vector<int> edges;
+  std::vector<int> node_offsets(1, 0);
+  node_offsets.reserve(num_vertices + 1);
 
   // Build graph
   for (MeshEntityIterator vertex_entity(mesh, coloring_type[0]);
        !vertex_entity.end(); ++vertex_entity)
   {
     const std::size_t vertex_entity_index = vertex_entity->index();
+    dolfin_assert(vertex_entity_index == node_offsets.size() - 1);
 
     std::unordered_set<std::size_t> entity_list0;
     std::unordered_set<std::size_t> entity_list1;
@@ -112,11 +186,13 @@ Graph GraphBuilder::local_graph(const Mesh& mesh,
     }
 
     // Add edges to graph
-    graph[vertex_entity_index].insert(entity_list0.begin(),
-                                      entity_list0.end());
+    const std::size_t offset = edges.size();
+    edges.insert(edges.end(), entity_list0.begin(), entity_list0.end());
+    std::sort(edges.begin() + offset, edges.end());
+    node_offsets.push_back(edges.size());
   }
 
-  return graph;
+  return Graph(MPI_COMM_SELF, edges, node_offsets);
 }
 //-----------------------------------------------------------------------------
 Graph GraphBuilder::local_graph(const Mesh& mesh,
@@ -127,15 +203,21 @@ Graph GraphBuilder::local_graph(const Mesh& mesh,
   mesh.init(dim0, dim1);
   mesh.init(dim1, dim0);
 
-  // Create graph
+  // Graph in compressed form
   const std::size_t num_vertices = mesh.num_entities(dim0);
-  Graph graph(num_vertices);
+  std::vector<int> edges;
+  std::vector<int> node_offsets(1, 0);
+  node_offsets.reserve(num_vertices + 1);
 
   // Build graph
   for (MeshEntityIterator colored_entity(mesh, dim0); !colored_entity.end();
        ++colored_entity)
   {
     const std::size_t colored_entity_index = colored_entity->index();
+    dolfin_assert(colored_entity_index == node_offsets.size() - 1);
+
+    // Collect neighbours, then sort and remove duplicates
+    const std::size_t offset = edges.size();
     for (MeshEntityIterator entity(*colored_entity, dim1); !entity.end();
          ++entity)
     {
@@ -143,36 +225,50 @@ Graph GraphBuilder::local_graph(const Mesh& mesh,
            ++neighbor)
       {
         if (colored_entity_index != neighbor->index())
-          graph[colored_entity_index].insert(neighbor->index());
+          edges.push_back(neighbor->index());
       }
     }
+    std::sort(edges.begin() + offset, edges.end());
+    edges.erase(std::unique(edges.begin() + offset, edges.end()),
+                edges.end());
+    node_offsets.push_back(edges.size());
   }
 
-  return graph;
+  return Graph(MPI_COMM_SELF, edges, node_offsets);
 }
 //-----------------------------------------------------------------------------
-void GraphBuilder::compute_dual_graph(
-  const MPI_Comm mpi_comm,
-  const LocalMeshData& mesh_data,
-  std::vector<std::set<std::size_t>>& local_graph,
-  std::set<std::size_t>& ghost_vertices)
+Graph GraphBuilder::local_graph(std::size_t num_nodes,
+                                const std::vector<int>& edges)
 {
-  FacetCellMap facet_cell_map;
+  return build_csr_graph<int>(MPI_COMM_SELF, num_nodes, edges);
+}
+//-----------------------------------------------------------------------------
+template<typename T>
+CSRGraph<T> GraphBuilder::compute_dual_graph(const MPI_Comm mpi_comm,
+                                             const LocalMeshData& mesh_data,
+                                             std::size_t& num_ghost_nodes)
+{
+  FacetCellList unmatched_facets;
+  std::vector<std::size_t> edges;
 
-#ifdef HAS_MPI
-  compute_local_dual_graph(mpi_comm, mesh_data, local_graph, facet_cell_map);
-  compute_nonlocal_dual_graph(mpi_comm, mesh_data, local_graph, facet_cell_map,
-                              ghost_vertices);
+  compute_local_dual_graph(mpi_comm, mesh_data, edges, unmatched_facets);
+  #ifdef HAS_MPI
+  num_ghost_nodes = compute_nonlocal_dual_graph(mpi_comm, mesh_data, edges,
+                                                unmatched_facets);
   #else
-  compute_local_dual_graph(mpi_comm, mesh_data, local_graph, facet_cell_map);
+  num_ghost_nodes = 0;
   #endif
+
+  // Build graph
+  const std::size_t num_local_cells = mesh_data.global_cell_indices.size();
+  return build_csr_graph<T>(mpi_comm, num_local_cells, edges);
 }
 //-----------------------------------------------------------------------------
 void GraphBuilder::compute_local_dual_graph(
   const MPI_Comm mpi_comm,
   const LocalMeshData& mesh_data,
-  std::vector<std::set<std::size_t>>& local_graph,
-  FacetCellMap& facet_cell_map)
+  std::vector<std::size_t>& edges,
+  FacetCellList& unmatched_facets)
 {
   Timer timer("Compute local dual graph");
 
@@ -181,13 +277,19 @@ void GraphBuilder::compute_local_dual_graph(
     = mesh_data.cell_vertices;
   const std::size_t num_local_cells = mesh_data.global_cell_indices.size();
   const std::size_t num_vertices_per_cell = mesh_data.num_vertices_per_cell;
-  const std::size_t num_vertices_per_facet = num_vertices_per_cell - 1;
 
   dolfin_assert(num_local_cells == cell_vertices.shape()[0]);
   dolfin_assert(num_vertices_per_cell == cell_vertices.shape()[1]);
 
-  local_graph.resize(num_local_cells);
-  facet_cell_map.clear();
+  if (num_vertices_per_cell - 1 > std::tuple_size<FacetKey>::value)
+  {
+    dolfin_error("GraphBuilder.cpp",
+                 "compute dual graph of mesh",
+                 "Only simplex cells are supported");
+  }
+
+  edges.clear();
+  unmatched_facets.clear();
 
   // Compute local edges (cell-cell connections) using global
   // (internal to this function, not the user numbering) numbering
@@ -196,105 +298,171 @@ void GraphBuilder::compute_local_dual_graph(
   const std::size_t cell_offset = MPI::global_offset(mpi_comm, num_local_cells,
                                                      true);
 
-  // Create map from facet (list of vertex indices) to cells
-  facet_cell_map.rehash((facet_cell_map.size()
-                     + num_local_cells)/facet_cell_map.max_load_factor() + 1);
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads
+    = std::max((int) parameters["num_threads"], 1);
+  #else
+  const std::size_t num_threads = 1;
+  #endif
 
-  // Iterate over all cells
-  std::vector<std::size_t> cellvtx(num_vertices_per_cell);
-  std::pair<std::vector<std::size_t>, std::size_t>
-    map_entry(std::vector<std::size_t>(num_vertices_per_facet), 0);
-  for (std::size_t i = 0; i < num_local_cells; ++i)
+  // Edges and unmatched facets found by each thread
+  std::vector<std::vector<std::size_t>> thread_edges(num_threads);
+  std::vector<FacetCellList> thread_unmatched_facets(num_threads);
+
+  // Facets of the cells of each thread, grouped by the thread owning
+  // the facet (by hash): facets[owner][thread]
+  std::vector<std::vector<FacetCellList>>
+    facets(num_threads, std::vector<FacetCellList>(num_threads));
+
+  // Each thread first computes the (sorted) facets of its range of
+  // cells and passes them to the thread owning their hash, then
+  // matches the facets it owns, so that no facet is seen by more
+  // than one thread and no locking is required. With a single
+  // thread, facets are matched directly.
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_threads)
+  #endif
   {
-    // Copy cell vertices and sort into order, taking a subset (minus
-    // one vertex) to form a set of facet vertices
-    std::copy(cell_vertices[i].begin(), cell_vertices[i].end(),
-              cellvtx.begin());
-    std::sort(cellvtx.begin(), cellvtx.end());
-
-    // Copy data to map_entry
-    std::copy(cellvtx.begin() + 1, cellvtx.end(), map_entry.first.begin());
-    map_entry.second = i;
-
-    // Iterate over facets in cell
-    for (std::size_t j = 0; j < num_vertices_per_cell; ++j)
+    #ifdef HAS_OPENMP
+    const std::size_t thread = omp_get_thread_num();
+    #else
+    const std::size_t thread = 0;
+    #endif
+
+    // Map from facet (sorted list of vertex indices) to cell
+    boost::unordered_map<FacetKey, std::size_t, FacetHash> facet_cell_map;
+    facet_cell_map.rehash(num_local_cells/num_threads
+                          /facet_cell_map.max_load_factor() + 1);
+
+    // Match facet of cell i against facets in map
+    std::vector<std::size_t>& local_edges = thread_edges[thread];
+    auto match_facet = [&](const FacetKey& facet, std::size_t i)
     {
       // Map lookup/insert
-      std::pair<FacetCellMap::iterator, bool> map_lookup
-        = facet_cell_map.insert(map_entry);
+      std::pair<boost::unordered_map<FacetKey, std::size_t,
+                                     FacetHash>::iterator, bool>
+        map_lookup = facet_cell_map.insert(std::make_pair(facet, i));
 
       // If facet was already in the map
       if (!map_lookup.second)
       {
         // Already in map. Connect cells and delete facet from map
-        // Add offset to cell index when inserting into local_graph
-        local_graph[i].insert(map_lookup.first->second + cell_offset);
-        local_graph[map_lookup.first->second].insert(i + cell_offset);
+        // Add offset to cell index of connected cell
+        const std::size_t other = map_lookup.first->second;
+        local_edges.push_back(i);
+        local_edges.push_back(other + cell_offset);
+        local_edges.push_back(other);
+        local_edges.push_back(i + cell_offset);
 
         // Save memory and search time by erasing
         facet_cell_map.erase(map_lookup.first);
       }
+    };
 
-      // Change facet by one entry, cycling from [1,2,3] -> [0,2,3]- >
-      // [0,1,3] -> [0,1,2] (for tetrahedron)
-      if (j != num_vertices_per_facet)
-        map_entry.first[j] = cellvtx[j];
+    // Compute facets of cells of this thread
+    const std::size_t cell_begin = thread*num_local_cells/num_threads;
+    const std::size_t cell_end = (thread + 1)*num_local_cells/num_threads;
+    if (num_threads > 1)
+    {
+      for (std::size_t owner = 0; owner < num_threads; ++owner)
+      {
+        facets[owner][thread].reserve(num_vertices_per_cell
+                                      *(cell_end - cell_begin)/num_threads);
+      }
+    }
+    std::vector<std::size_t> cellvtx(num_vertices_per_cell);
+    FacetKey facet;
+    facet.fill(0);
+    for (std::size_t i = cell_begin; i < cell_end; ++i)
+    {
+      // Copy cell vertices and sort into order
+      std::copy(cell_vertices[i].begin(), cell_vertices[i].end(),
+                cellvtx.begin());
+      std::sort(cellvtx.begin(), cellvtx.end());
+
+      // Iterate over facets in cell, facet j being the cell without
+      // its jth (sorted) vertex
+      for (std::size_t j = 0; j < num_vertices_per_cell; ++j)
+      {
+        std::copy(cellvtx.begin(), cellvtx.begin() + j, facet.begin());
+        std::copy(cellvtx.begin() + j + 1, cellvtx.end(), facet.begin() + j);
+        if (num_threads == 1)
+          match_facet(facet, i);
+        else
+        {
+          const std::size_t owner = FacetHash()(facet) % num_threads;
+          facets[owner][thread].push_back(std::make_pair(facet, i));
+        }
+      }
     }
+
+    // Match facets owned by this thread (from all threads, in order
+    // of cells)
+    if (num_threads > 1)
+    {
+      #ifdef HAS_OPENMP
+      #pragma omp barrier
+      #endif
+      for (std::size_t t = 0; t < num_threads; ++t)
+      {
+        for (const auto& facet_cell : facets[thread][t])
+          match_facet(facet_cell.first, facet_cell.second);
+        FacetCellList().swap(facets[thread][t]);
+      }
+    }
+
+    // Remaining facets are on process or exterior boundaries
+    thread_unmatched_facets[thread].assign(facet_cell_map.begin(),
+                                           facet_cell_map.end());
+  }
+
+  // Concatenate thread data
+  for (std::size_t t = 0; t < num_threads; ++t)
+  {
+    edges.insert(edges.end(), thread_edges[t].begin(),
+                 thread_edges[t].end());
+    unmatched_facets.insert(unmatched_facets.end(),
+                            thread_unmatched_facets[t].begin(),
+                            thread_unmatched_facets[t].end());
   }
 }
 //-----------------------------------------------------------------------------
-void GraphBuilder::compute_nonlocal_dual_graph(
+std::size_t GraphBuilder::compute_nonlocal_dual_graph(
   const MPI_Comm mpi_comm,
   const LocalMeshData& mesh_data,
-  std::vector<std::set<std::size_t>>& local_graph,
-  FacetCellMap& facet_cell_map,
-  std::set<std::size_t>& ghost_vertices)
+  std::vector<std::size_t>& edges,
+  const FacetCellList& unmatched_facets)
 {
   Timer timer("Compute non-local dual graph");
 
-  // At this stage facet_cell map only contains facets->cells with
+  // At this stage unmatched_facets only contains facets->cells with
   // edge facets either interprocess or external boundaries
 
-  // List of cell vertices
-  const boost::multi_array<std::size_t, 2>& cell_vertices
-    = mesh_data.cell_vertices;
   const std::size_t num_local_cells = mesh_data.global_cell_indices.size();
-  const std::size_t num_vertices_per_cell = mesh_data.num_vertices_per_cell;
-  const std::size_t num_vertices_per_facet = num_vertices_per_cell - 1;
-
-  dolfin_assert(num_local_cells == cell_vertices.shape()[0]);
-  dolfin_assert(num_vertices_per_cell == cell_vertices.shape()[1]);
-
-  // Compute local edges (cell-cell connections) using global
-  // (internal to this function, not the user numbering) numbering
+  const std::size_t num_vertices_per_facet
+    = mesh_data.num_vertices_per_cell - 1;
 
   // Get offset for this process
   const std::size_t offset = MPI::global_offset(mpi_comm, num_local_cells,
                                                 true);
   const std::size_t num_processes = MPI::size(mpi_comm);
 
-  // Send facet-cell map to intermediary match-making processes
+  // Send unmatched facets to intermediary match-making processes,
+  // chosen by hashing the facet vertices (which balances the facets
+  // evenly between processes, independently of the vertex numbering)
   std::vector<std::vector<std::size_t>> send_buffer(num_processes);
   std::vector<std::vector<std::size_t>> received_buffer(num_processes);
-
-  // Pack map data and send to match-maker process
-  boost::unordered_map<std::vector<std::size_t>,
-                     std::size_t>::const_iterator it;
-  for (it = facet_cell_map.begin(); it != facet_cell_map.end(); ++it)
+  for (auto it = unmatched_facets.begin(); it != unmatched_facets.end(); ++it)
   {
-    // FIXME: Could use a better index? First vertex is slightly skewed
-    //        towards low values - may not be important
-
-    // Use first vertex of facet to partition into blocks
-    std::size_t dest_proc = MPI::index_owner(mpi_comm, (it->first)[0],
-                                             mesh_data.num_global_vertices);
+    const std::size_t dest_proc = FacetHash()(it->first) % num_processes;
 
-    // Pack map into vectors to send
-    for (std::size_t i = 0; i < num_vertices_per_facet; ++i)
-      send_buffer[dest_proc].push_back((it->first)[i]);
+    // Pack facet into vectors to send
+    std::vector<std::size_t>& send_p = send_buffer[dest_proc];
+    send_p.insert(send_p.end(), it->first.begin(),
+                  it->first.begin() + num_vertices_per_facet);
 
     // Add offset to cell numbers sent off process
-    send_buffer[dest_proc].push_back(it->second + offset);
+    send_p.push_back(it->second + offset);
   }
 
   // Send data
@@ -304,14 +472,18 @@ void GraphBuilder::compute_nonlocal_dual_graph(
   send_buffer = std::vector<std::vector<std::size_t>>(num_processes);
 
   // Map to connect processes and cells, using facet as key
-  typedef boost::unordered_map<std::vector<std::size_t>,
-              std::pair<std::size_t, std::size_t>> MatchMap;
+  typedef boost::unordered_map<FacetKey, std::pair<std::size_t, std::size_t>,
+                               FacetHash> MatchMap;
   MatchMap matchmap;
+  std::size_t num_received_facets = 0;
+  for (std::size_t p = 0; p < num_processes; ++p)
+    num_received_facets += received_buffer[p].size();
+  num_received_facets /= (num_vertices_per_facet + 1);
+  matchmap.rehash(num_received_facets/matchmap.max_load_factor() + 1);
 
   // Look for matches to send back to other processes
-  std::pair<std::vector<std::size_t>,
-            std::pair<std::size_t, std::size_t>> key;
-  key.first.resize(num_vertices_per_facet);
+  std::pair<FacetKey, std::pair<std::size_t, std::size_t>> key;
+  key.first.fill(0);
   for (std::size_t p = 0; p < num_processes; ++p)
   {
     // Unpack into map
@@ -351,21 +523,37 @@ void GraphBuilder::compute_nonlocal_dual_graph(
   // Send matches to other processes
   MPI::all_to_all(mpi_comm, send_buffer, received_buffer);
 
-  // Clear ghost vertices
-  ghost_vertices.clear();
-
-  // Flatten received data and insert connected cells into local map
+  // Flatten received data and append connected cells to list of
+  // edges, collecting off-process cells
+  std::vector<std::size_t> ghost_nodes;
   for (std::size_t p = 0; p < received_buffer.size(); ++p)
   {
     const std::vector<std::size_t>& cell_list = received_buffer[p];
     for (std::size_t i = 0; i < cell_list.size(); i += 2)
     {
       dolfin_assert(cell_list[i] >= offset);
-      dolfin_assert(cell_list[i] - offset < local_graph.size());
+      dolfin_assert(cell_list[i] - offset < num_local_cells);
 
-      local_graph[cell_list[i] - offset].insert(cell_list[i + 1]);
-      ghost_vertices.insert(cell_list[i + 1]);
+      edges.push_back(cell_list[i] - offset);
+      edges.push_back(cell_list[i + 1]);
+      ghost_nodes.push_back(cell_list[i + 1]);
     }
   }
+
+  // Count distinct off-process cells
+  std::sort(ghost_nodes.begin(), ghost_nodes.end());
+  return std::unique(ghost_nodes.begin(), ghost_nodes.end())
+    - ghost_nodes.begin();
 }
 //-----------------------------------------------------------------------------
+// Explicit instantiation for the index types used by graph libraries
+template CSRGraph<std::int32_t>
+GraphBuilder::compute_dual_graph(const MPI_Comm, const LocalMeshData&,
+                                 std::size_t&);
+template CSRGraph<std::int64_t>
+GraphBuilder::compute_dual_graph(const MPI_Comm, const LocalMeshData&,
+                                 std::size_t&);
+template CSRGraph<std::size_t>
+GraphBuilder::compute_dual_graph(const MPI_Comm, const LocalMeshData&,
+                                 std::size_t&);
+//-----------------------------------------------------------------------------
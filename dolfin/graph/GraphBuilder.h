@@ -16,16 +16,18 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2010-02-19
-// Last changed: 2013-01-16
+// Last changed: 2015-06-12
 
 #ifndef __GRAPH_BUILDER_H
 #define __GRAPH_BUILDER_H
 
+#include <array>
 #include <set>
-#include <boost/unordered_map.hpp>
+#include <utility>
 #include <vector>
 #include <boost/multi_array.hpp>
 #include <dolfin/common/MPI.h>
+#include "CSRGraph.h"
 #include "Graph.h"
 
 namespace dolfin
@@ -55,36 +57,54 @@ namespace dolfin
     static Graph local_graph(const Mesh& mesh, std::size_t dim0,
                                                std::size_t dim1);
 
-    /// Build distributed dual graph (cell-cell connections) for from
-    /// LocalMeshData
-    static void
-      compute_dual_graph(const MPI_Comm mpi_comm,
-                         const LocalMeshData& mesh_data,
-                         std::vector<std::set<std::size_t> >& local_graph,
-                         std::set<std::size_t>& ghost_vertices);
+    /// Build local graph with num_nodes nodes from a list of directed
+    /// edges [i0, j0, i1, j1, ...]. Duplicate edges are removed.
+    static Graph local_graph(std::size_t num_nodes,
+                             const std::vector<int>& edges);
+
+    /// Build distributed dual graph (cell-cell connections) from
+    /// LocalMeshData. Nodes are numbered globally, i.e. offset by the
+    /// number of cells on lower rank processes. On return,
+    /// num_ghost_nodes is the number of off-process cells connected
+    /// to cells on this process.
+    template<typename T>
+      static CSRGraph<T> compute_dual_graph(const MPI_Comm mpi_comm,
+                                            const LocalMeshData& mesh_data,
+                                            std::size_t& num_ghost_nodes);
 
   private:
 
     friend class MeshPartitioning;
 
-    typedef boost::unordered_map<std::vector<std::size_t>, std::size_t>
-      FacetCellMap;
+    // Facet as sorted list of global vertex indices (simplex cells
+    // have at most three vertices per facet, unused entries are zero)
+    typedef std::array<std::size_t, 3> FacetKey;
+
+    // List of facets and the local index of a cell containing the
+    // facet
+    typedef std::vector<std::pair<FacetKey, std::size_t>> FacetCellList;
 
-    // Build local part of dual graph for mesh
+    // Build local part of dual graph for mesh as a list of directed
+    // edges [i0, j0, i1, j1, ...] from local cell i to global cell j
+    // (local cell index plus offset). Facets are matched in parallel
+    // by threads, each thread matching the facets whose hash it
+    // owns. Facets that are not matched locally are returned in
+    // unmatched_facets.
     static void
       compute_local_dual_graph(const MPI_Comm mpi_comm,
                                const LocalMeshData& mesh_data,
-                               std::vector<std::set<std::size_t> >& local_graph,
-                               FacetCellMap& facet_cell_map);
-
-    // Build nonlocal part of dual graph for mesh.
-    // GraphBuilder::compute_local_dual_graph should be called first.
-    static void
+                               std::vector<std::size_t>& edges,
+                               FacetCellList& unmatched_facets);
+
+    // Build nonlocal part of dual graph for mesh, appending edges
+    // to off-process cells to edges. Unmatched facets are sent to
+    // the process given by the facet hash for matching. Returns
+    // number of distinct off-process cells.
+    static std::size_t
       compute_nonlocal_dual_graph(const MPI_Comm mpi_comm,
                                   const LocalMeshData& mesh_data,
-                                  std::vector<std::set<std::size_t> >& local_graph,
-                                  FacetCellMap& facet_cell_map,
-                                  std::set<std::size_t>& ghost_vertices);
+                                  std::vector<std::size_t>& edges,
+                                  const FacetCellList& unmatched_facets);
 
   };
 
@@ -19,13 +19,14 @@
 // Modified by Chris Richardson 2013
 //
 // First added:  2010-02-10
-// Last changed: 2014-01-09
+// Last changed: 2015-06-12
 
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/log/log.h>
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/mesh/LocalMeshData.h>
+#include "CSRGraph.h"
 #include "ParMETIS.h"
 #include "GraphBuilder.h"
 
@@ -48,13 +49,15 @@ namespace dolfin
     // Constructor
     ParMETISDualGraph(MPI_Comm mpi_comm, const LocalMeshData& mesh_data);
 
-    // Destructor
-    ~ParMETISDualGraph();
+    // Number of ghost nodes (off-process cells) in dual graph
+    std::size_t num_ghost_nodes;
 
-    // ParMETIS data
+    // Distributed dual graph (compressed sparse row format)
+    const CSRGraph<idx_t> graph;
+
+    // ParMETIS data (xadj and adjncy point into graph, which ParMETIS
+    // does not modify)
     std::vector<idx_t> elmdist;
-    std::vector<idx_t> eptr;
-    std::vector<idx_t> eind;
     idx_t numflag;
     idx_t* xadj;
     idx_t* adjncy;
@@ -90,7 +93,7 @@ void ParMETIS::compute_partition(
   // Build dual graph
   ParMETISDualGraph g(mpi_comm, mesh_data);
 
-  dolfin_assert(g.eptr.size() - 1 == mesh_data.cell_vertices.size());
+  dolfin_assert(g.graph.size() == mesh_data.cell_vertices.size());
 
   // Partition graph
   if (mode == "partition")
@@ -129,7 +132,7 @@ void ParMETIS::partition(
   dolfin_assert(!g.ubvec.empty());
 
   // Call ParMETIS to partition graph
-  const std::size_t num_local_cells = g.eptr.size() - 1;
+  const std::size_t num_local_cells = g.graph.size();
   std::vector<idx_t> part(num_local_cells);
   dolfin_assert(!part.empty());
   int err = ParMETIS_V3_PartKway(g.elmdist.data(), g.xadj, g.adjncy, g.elmwgt,
@@ -264,7 +267,7 @@ void ParMETIS::adaptive_repartition(MPI_Comm mpi_comm,
   // Call ParMETIS to partition graph
   const double itr = parameters["ParMETIS_repartitioning_weight"];
   real_t _itr = itr;
-  std::vector<idx_t> part(g.eptr.size() - 1);
+  std::vector<idx_t> part(g.graph.size());
   std::vector<idx_t> vsize(part.size(), 1);
   dolfin_assert(!part.empty());
   int err = ParMETIS_V3_AdaptiveRepart(g.elmdist.data(), g.xadj, g.adjncy,
@@ -305,7 +308,7 @@ void ParMETIS::refine(MPI_Comm mpi_comm,
 
   // Partitioning array to be computed by ParMETIS. Prefill with
   // process_number.
-  const std::size_t num_local_cells = g.eptr.size() - 1;
+  const std::size_t num_local_cells = g.graph.size();
   std::vector<idx_t> part(num_local_cells, process_number);
   dolfin_assert(!part.empty());
 
@@ -323,61 +326,26 @@ void ParMETIS::refine(MPI_Comm mpi_comm,
 //-----------------------------------------------------------------------------
 ParMETISDualGraph::ParMETISDualGraph(MPI_Comm mpi_comm,
                                      const LocalMeshData& mesh_data)
+  : num_ghost_nodes(0),
+    graph(GraphBuilder::compute_dual_graph<idx_t>(mpi_comm, mesh_data,
+                                                  num_ghost_nodes))
 {
   // Get number of processes and process number
   const std::size_t num_processes = MPI::size(mpi_comm);
 
-  // Get dimensions of local mesh_data
-  const std::size_t num_local_cells = mesh_data.cell_vertices.size();
-  const std::size_t num_cell_vertices = mesh_data.num_vertices_per_cell;
-
   // Check that number of local graph nodes (cells) is > 0
-  if (num_local_cells == 0)
+  if (graph.size() == 0)
   {
     dolfin_error("ParMETIS.cpp",
                  "compute mesh partitioning using ParMETIS",
                  "ParMETIS cannot be used if a process has no cells (graph nodes). Use SCOTCH to perform partitioning instead");
   }
 
-  // Communicate number of cells between all processors
-  std::vector<std::size_t> num_cells;
-  MPI::all_gather(mpi_comm, num_local_cells, num_cells);
-
-  // Build elmdist array with cell offsets for all processors
-  elmdist.assign(num_processes + 1, 0);
-  for (std::size_t i = 1; i < num_processes + 1; ++i)
-    elmdist[i] = elmdist[i - 1] + num_cells[i - 1];
-
-  eptr.resize(num_local_cells + 1);
-  eind.assign(num_local_cells*num_cell_vertices, 0);
-  for (std::size_t i = 0; i < num_local_cells; i++)
-  {
-    dolfin_assert(mesh_data.cell_vertices[i].size() == num_cell_vertices);
-    eptr[i] = i*num_cell_vertices;
-    for (std::size_t j = 0; j < num_cell_vertices; j++)
-      eind[eptr[i] + j] = mesh_data.cell_vertices[i][j];
-  }
-  eptr[num_local_cells] = num_local_cells*num_cell_vertices;
-
-  dolfin_assert(!eptr.empty());
-  dolfin_assert(!eind.empty());
-
-  // Number of nodes shared for dual graph (partition along facets)
-  idx_t ncommonnodes = num_cell_vertices - 1;
+  // Cell offsets for all processes, and pointers to graph data
+  elmdist = graph.node_distribution();
   numflag = 0;
-  xadj = 0;
-  adjncy = 0;
-
-  dolfin_assert(!eptr.empty());
-  dolfin_assert(!eind.empty());
-
-  // Could use GraphBuilder::compute_dual_graph() instead
-  int err = ParMETIS_V3_Mesh2Dual(elmdist.data(), eptr.data(), eind.data(),
-                                  &numflag, &ncommonnodes,
-                                  &xadj, &adjncy,
-                                  &mpi_comm);
-  dolfin_assert(err == METIS_OK);
-
+  xadj = const_cast<idx_t*>(graph.nodes().data());
+  adjncy = const_cast<idx_t*>(graph.edges().data());
 
   // Number of partitions (one for each process)
   nparts = num_processes;
@@ -393,13 +361,6 @@ ParMETISDualGraph::ParMETISDualGraph(MPI_Comm mpi_comm,
   edgecut = 0;
 }
 //-----------------------------------------------------------------------------
-ParMETISDualGraph::~ParMETISDualGraph()
-{
-  // Free metis data structures
-  METIS_Free(xadj);
-  METIS_Free(adjncy);
-}
-//-----------------------------------------------------------------------------
 #else
 void ParMETIS::compute_partition(
   const MPI_Comm mpi_comm,
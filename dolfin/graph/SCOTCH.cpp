@@ -19,7 +19,7 @@
 // Modified by Chris Richardson 2013
 //
 // First added:  2010-02-10
-// Last changed: 2014-09-09
+// Last changed: 2015-06-12
 
 #include <algorithm>
 #include <map>
@@ -55,19 +55,15 @@ void SCOTCH::compute_partition(
   std::map<std::size_t, dolfin::Set<unsigned int>>& ghost_procs,
   const LocalMeshData& mesh_data)
 {
-  // Create data structures to hold graph
-  std::vector<std::set<std::size_t>> local_graph;
-  std::set<std::size_t> ghost_vertices;
-
   // Compute local dual graph
-  GraphBuilder::compute_dual_graph(mpi_comm, mesh_data, local_graph,
-                                   ghost_vertices);
+  std::size_t num_ghost_nodes = 0;
+  const CSRGraph<SCOTCH_Num> local_graph
+    = GraphBuilder::compute_dual_graph<SCOTCH_Num>(mpi_comm, mesh_data,
+                                                   num_ghost_nodes);
 
   // Compute partitions
-  partition(mpi_comm, local_graph, mesh_data.cell_weight,
-            ghost_vertices, mesh_data.global_cell_indices,
-            mesh_data.num_global_cells, cell_partition, ghost_procs);
-
+  partition(mpi_comm, local_graph, mesh_data.cell_weight, num_ghost_nodes,
+            cell_partition, ghost_procs);
 }
 //-----------------------------------------------------------------------------
 std::vector<int> SCOTCH::compute_gps(const Graph& graph,
@@ -98,25 +94,11 @@ void SCOTCH::compute_reordering(const Graph& graph,
   // Number of local graph vertices (cells)
   const SCOTCH_Num vertnbr = graph.size();
 
-  // Data structures for graph input to SCOTCH (add 1 for case that
-  // graph size is zero)
-  std::vector<SCOTCH_Num> verttab;
-  verttab.reserve(vertnbr + 1);
-  std::vector<SCOTCH_Num> edgetab;
-  edgetab.reserve(20*vertnbr);
-
-  // Build local graph input for SCOTCH
-  // (number of local + ghost graph vertices (cells),
-  // number of local edges + edges connecting to ghost vertices)
-  SCOTCH_Num edgenbr = 0;
-  verttab.push_back(0);
-  Graph::const_iterator vertex;
-  for (vertex = graph.begin(); vertex != graph.end(); ++vertex)
-  {
-    edgenbr += vertex->size();
-    verttab.push_back(verttab.back() + vertex->size());
-    edgetab.insert(edgetab.end(), vertex->begin(), vertex->end());
-  }
+  // Graph input for SCOTCH (copied from compressed graph since
+  // SCOTCH_Num may differ from the graph index type)
+  std::vector<SCOTCH_Num> verttab(graph.nodes().begin(), graph.nodes().end());
+  std::vector<SCOTCH_Num> edgetab(graph.edges().begin(), graph.edges().end());
+  const SCOTCH_Num edgenbr = edgetab.size();
 
   // Create SCOTCH graph
   SCOTCH_Graph scotch_graph;
@@ -135,7 +117,7 @@ void SCOTCH::compute_reordering(const Graph& graph,
   // Build SCOTCH graph
   if (SCOTCH_graphBuild(&scotch_graph, baseval,
                         vertnbr, &verttab[0], &verttab[1], NULL, NULL,
-                        edgenbr, &edgetab[0], NULL))
+                        edgenbr, edgetab.data(), NULL))
   {
     dolfin_error("SCOTCH.cpp",
                  "partition mesh using SCOTCH",
@@ -194,13 +176,12 @@ void SCOTCH::compute_reordering(const Graph& graph,
             inverse_permutation_indices.end(), inverse_permutation.begin());
 }
 //-----------------------------------------------------------------------------
+template<typename T>
 void SCOTCH::partition(
   const MPI_Comm mpi_comm,
-  const std::vector<std::set<std::size_t>>& local_graph,
+  const CSRGraph<T>& local_graph,
   const std::vector<std::size_t>& node_weights,
-  const std::set<std::size_t>& ghost_vertices,
-  const std::vector<std::size_t>& global_cell_indices,
-  const std::size_t num_global_vertices,
+  const std::size_t num_ghost_nodes,
   std::vector<std::size_t>& cell_partition,
   std::map<std::size_t, dolfin::Set<unsigned int>>& ghost_procs)
 {
@@ -219,30 +200,21 @@ void SCOTCH::partition(
 
   // Number of local graph vertices (cells)
   const SCOTCH_Num vertlocnbr = local_graph.size();
-  const std::size_t vertgstnbr = vertlocnbr + ghost_vertices.size();
-
-  // Data structures for graph input to SCOTCH (add 1 for case that
-  // local graph size is zero)
-  std::vector<SCOTCH_Num> vertloctab;
-  vertloctab.reserve(local_graph.size() + 1);
-  std::vector<SCOTCH_Num> edgeloctab;
-
-  // Build local graph input for SCOTCH
-  // (number of local + ghost graph vertices (cells),
-  // number of local edges + edges connecting to ghost vertices)
-  SCOTCH_Num edgelocnbr = 0;
-  vertloctab.push_back((SCOTCH_Num) 0);
-  std::vector<std::set<std::size_t>>::const_iterator vertex;
-  for(vertex = local_graph.begin(); vertex != local_graph.end(); ++vertex)
-  {
-    edgelocnbr += vertex->size();
-    vertloctab.push_back(vertloctab.back() + vertex->size());
-    edgeloctab.insert(edgeloctab.end(), vertex->begin(), vertex->end());
-  }
+  const std::size_t vertgstnbr = vertlocnbr + num_ghost_nodes;
+
+  // Local graph input for SCOTCH, used in place (SCOTCH does not
+  // modify the graph arrays). The edges include edges connecting to
+  // ghost vertices (cells).
+  SCOTCH_Num* vertloctab
+    = const_cast<SCOTCH_Num*>(local_graph.nodes().data());
+  SCOTCH_Num* edgeloctab
+    = const_cast<SCOTCH_Num*>(local_graph.edges().data());
+  const SCOTCH_Num edgelocnbr = local_graph.num_edges();
 
   // Handle case that local graph size is zero
-  if (edgeloctab.empty())
-    edgeloctab.resize(1);
+  SCOTCH_Num edgeloctab_dummy = 0;
+  if (edgelocnbr == 0)
+    edgeloctab = &edgeloctab_dummy;
 
   // Global data ---------------------------------
 
@@ -290,9 +262,9 @@ void SCOTCH::partition(
 
   // Build SCOTCH distributed graph
   if (SCOTCH_dgraphBuild(&dgrafdat, baseval, vertlocnbr, vertlocnbr,
-                              &vertloctab[0], NULL, veloloctab, NULL,
+                              vertloctab, NULL, veloloctab, NULL,
                               edgelocnbr, edgelocnbr,
-                              &edgeloctab[0], NULL, NULL) )
+                              edgeloctab, NULL, NULL) )
   {
     dolfin_error("SCOTCH.cpp",
                  "partition mesh using SCOTCH",
@@ -450,12 +422,11 @@ void SCOTCH::compute_reordering(const Graph& graph,
                "DOLFIN has been configured without support for SCOTCH");
 }
 //-----------------------------------------------------------------------------
+template<typename T>
 void SCOTCH::partition(const MPI_Comm mpi_comm,
-                       const std::vector<std::set<std::size_t>>& local_graph,
+                       const CSRGraph<T>& local_graph,
                        const std::vector<std::size_t>& node_weights,
-                       const std::set<std::size_t>& ghost_vertices,
-                       const std::vector<std::size_t>& global_cell_indices,
-                       const std::size_t num_global_vertices,
+                       const std::size_t num_ghost_nodes,
                        std::vector<std::size_t>& cell_partition,
                        std::map<std::size_t, dolfin::Set<unsigned int>>& ghost_procs)
 {
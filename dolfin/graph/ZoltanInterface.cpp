@@ -166,13 +166,13 @@ void ZoltanInterface::ZoltanGraphInterface::get_all_edges(void* data,
   ZoltanGraphInterface *objs = (ZoltanGraphInterface *)data;
 
   // Get graph
-  const Graph graph = objs->_graph;
+  const Graph& graph = objs->_graph;
 
   unsigned int entry = 0;
   for (unsigned int i = 0; i < graph.size(); ++i)
   {
     dolfin_assert(graph[i].size() == (unsigned int) num_edges[i]);
-    for (std::unordered_set<unsigned int>::value_type edge : graph[i])
+    for (auto edge : graph[i])
       nbor_global_id[entry++] = edge;
   }
 }
@@ -18,6 +18,7 @@
 // First added:  2013-02-13
 // Last changed: 2013-02-26
 
+#include<algorithm>
 #include<set>
 #include<vector>
 #include<boost/lexical_cast.hpp>
@@ -41,13 +42,11 @@ ZoltanPartition::compute_partition_phg(const MPI_Comm mpi_comm,
 {
   Timer timer0("Partition graph (calling Zoltan PHG)");
 
-  // Create data structures to hold graph
-  std::vector<std::set<std::size_t>> local_graph;
-  std::set<std::size_t> ghost_vertices;
-
   // Compute local dual graph
-  GraphBuilder::compute_dual_graph(mpi_comm, mesh_data, local_graph,
-                                   ghost_vertices);
+  std::size_t num_ghost_vertices = 0;
+  const CSRGraph<std::size_t> local_graph
+    = GraphBuilder::compute_dual_graph<std::size_t>(mpi_comm, mesh_data,
+                                                    num_ghost_vertices);
 
   // Initialise Zoltan
   float version;
@@ -258,8 +257,8 @@ void ZoltanPartition::get_number_edges(void *data,
                                        ZOLTAN_ID_PTR local_ids, int *num_edges,
                                        int *ierr)
 {
-  std::vector<std::set<std::size_t>>* local_graph
-    = (std::vector<std::set<std::size_t>>*)data;
+  const CSRGraph<std::size_t>* local_graph
+    = (const CSRGraph<std::size_t>*)data;
 
   dolfin_assert(num_gid_entries == 1);
   dolfin_assert(num_lid_entries == 0);
@@ -281,31 +280,21 @@ void ZoltanPartition::get_all_edges(void* data,
                                  int* nbor_procs, int wgt_dim,
                                  float* ewgts, int* ierr)
 {
-  error("ZoltanPartition::get_all_edges need to be updated for MPI communicator");
-  /*
   // Get graph
-  const std::vector<std::set<std::size_t>>* local_graph
-    = (std::vector<std::set<std::size_t>>*)data;
-
-  // MPI communicate
-  const MPI_Comm mpi_comm = local_graph->mpi_comm();
+  const CSRGraph<std::size_t>* local_graph
+    = (const CSRGraph<std::size_t>*)data;
 
-  std::vector<std::size_t> offsets;
-  std::size_t local_offset = MPI::global_offset(mpi_comm, local_graph->size(),
-                                                true);
-  MPI::all_gather(mpi_comm, local_offset, offsets);
-  offsets.push_back(MPI::sum(mpi_comm, local_graph->size()));
+  // Offsets of nodes on each process
+  const std::vector<std::size_t>& offsets = local_graph->node_distribution();
 
   std::size_t i = 0;
-  for(std::vector<std::set<std::size_t>>::iterator node = local_graph->begin();
-      node != local_graph->end(); ++node)
+  for (std::size_t node = 0; node < local_graph->size(); ++node)
   {
-    for(std::set<std::size_t>::iterator edge = node->begin();
-        edge != node->end(); ++edge)
+    for (auto edge : (*local_graph)[node])
     {
-      nbor_global_id[i] = *edge;
-      nbor_procs[i] = std::upper_bound(offsets.begin(), offsets.end(), *edge)
-        - offsets.begin()-1;
+      nbor_global_id[i] = edge;
+      nbor_procs[i] = std::upper_bound(offsets.begin(), offsets.end(), edge)
+        - offsets.begin() - 1;
       i++;
     }
   }
@@ -313,7 +302,6 @@ void ZoltanPartition::get_all_edges(void* data,
   dolfin_assert(wgt_dim == 0);
   ewgts = NULL;
   *ierr = ZOLTAN_OK;
-  */
 }
 //-----------------------------------------------------------------------------
 int ZoltanPartition::get_geom(void* data, int* ierr)
@@ -3,6 +3,7 @@
 
 // DOLFIN graph interface
 
+#include <dolfin/graph/CSRGraph.h>
 #include <dolfin/graph/Graph.h>
 #include <dolfin/graph/GraphBuilder.h>
 #include <dolfin/graph/BoostGraphOrdering.h>
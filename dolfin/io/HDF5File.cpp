@@ -23,6 +23,7 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <boost/container/flat_map.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
@@ -385,13 +386,12 @@ void HDF5File::write(const Mesh& mesh, std::size_t cell_dim,
     // ---------- Markers
     for (std::size_t d = 0; d <= mesh.domains().max_dim(); d++)
     {
-      const std::map<std::size_t, std::size_t>& domain
+      const boost::container::flat_map<std::size_t, std::size_t>& domain
         = mesh.domains().markers(d);
 
       MeshValueCollection<std::size_t> collection(mesh, d);
-      std::map<std::size_t, std::size_t>::const_iterator it;
-      for (it = domain.begin(); it != domain.end(); ++it)
-        collection.set_value(it->first, it->second);
+      collection.set_values(std::vector<std::pair<std::size_t, std::size_t>>(
+                              domain.begin(), domain.end()));
       const std::string marker_dataset
         = name + "/domain_" + boost::lexical_cast<std::string>(d);
       write_mesh_value_collection(collection, marker_dataset);
@@ -1079,15 +1079,11 @@ void HDF5File::write(const MeshValueCollection<bool>& mesh_values,
   // HDF5 does not implement bool, use int and copy
 
   MeshValueCollection<int> mvc_int(mesh_values.mesh(), mesh_values.dim());
-  const std::map<std::pair<std::size_t, std::size_t>, bool>& values
-    = mesh_values.values();
-  for (std::map<std::pair<std::size_t, std::size_t>,
-                bool>::const_iterator mesh_value_it = values.begin();
-       mesh_value_it != values.end(); ++mesh_value_it)
-  {
-    mvc_int.set_value(mesh_value_it->first.first, mesh_value_it->first.second,
-                      mesh_value_it->second ? 1 : 0);
-  }
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, int>> values;
+  values.reserve(mesh_values.size());
+  for (auto& mesh_value : mesh_values.values())
+    values.push_back(std::make_pair(mesh_value.first, mesh_value.second ? 1 : 0));
+  mvc_int.set_values(values);
 
   write_mesh_value_collection(mvc_int, name);
 }
@@ -1100,24 +1096,18 @@ void HDF5File::read(MeshValueCollection<bool>& mesh_values,
   MeshValueCollection<int> mvc_int(mesh_values.mesh(), mesh_values.dim());
   read_mesh_value_collection(mvc_int, name);
 
-  const std::map<std::pair<std::size_t, std::size_t>, int>& values
-    = mvc_int.values();
-  for (std::map<std::pair<std::size_t, std::size_t>,
-                int>::const_iterator mesh_value_it = values.begin();
-      mesh_value_it != values.end(); ++mesh_value_it)
-  {
-    mesh_values.set_value(mesh_value_it->first.first,
-                          mesh_value_it->first.second,
-                          (mesh_value_it->second != 0));
-  }
-
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, bool>> values;
+  values.reserve(mvc_int.size());
+  for (auto& mesh_value : mvc_int.values())
+    values.push_back(std::make_pair(mesh_value.first, mesh_value.second != 0));
+  mesh_values.set_values(values);
 }
 //-----------------------------------------------------------------------------
 template <typename T>
 void HDF5File::write_mesh_value_collection(const MeshValueCollection<T>& mesh_values, const std::string name)
 {
-  const std::map<std::pair<std::size_t, std::size_t>, T>& values
-    = mesh_values.values();
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+    values = mesh_values.values();
 
   const Mesh& mesh = *mesh_values.mesh();
   const std::vector<std::size_t>& global_cell_index
@@ -1127,9 +1117,10 @@ void HDF5File::write_mesh_value_collection(const MeshValueCollection<T>& mesh_va
   std::vector<std::size_t> entities;
   std::vector<std::size_t> cells;
 
-  for (typename std::map<std::pair<std::size_t, std::size_t>,
-         T>::const_iterator
-         p = values.begin(); p != values.end(); ++p)
+  cells.reserve(values.size());
+  entities.reserve(values.size());
+  data_values.reserve(values.size());
+  for (auto p = values.begin(); p != values.end(); ++p)
   {
     cells.push_back(global_cell_index[p->first.first]);
     entities.push_back(p->first.second);
@@ -1231,9 +1222,9 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
     const std::vector<std::size_t>& global_cell_index
       = mesh.topology().global_indices(mesh.topology().dim());
 
-    // Reference to actual map of MeshValueCollection
-    std::map<std::pair<std::size_t, std::size_t>, T>& mvc_map
-      = mesh_vc.values();
+    // Values found on this process, inserted into the
+    // MeshValueCollection in one pass
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
 
     // Find cells which are on this process,
     // under the assumption that global_cell_index is ordered.
@@ -1274,10 +1265,12 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
         // Here we do not increment j because cells_data_index is ordered
         // but not *strictly* ordered.
         std::size_t lidx = i - global_cell_index.begin();
-        mvc_map[std::make_pair(lidx, entities_data[*j])] = values_data[*j];
+        values.push_back(std::make_pair(std::make_pair(lidx, entities_data[*j]),
+                                        values_data[*j]));
         ++j;
       }
     }
+    mesh_vc.set_values(values);
   }
   else
   {
@@ -1324,10 +1317,9 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
     MPI::all_to_all(_mpi_comm, send_local, recv_local);
     MPI::all_to_all(_mpi_comm, send_values, recv_values);
 
-    // Reference to actual map of MeshValueCollection
-    std::map<std::pair<std::size_t, std::size_t>, T>& mvc_map
-      = mesh_vc.values();
-
+    // Collect received values and insert into MeshValueCollection in
+    // one pass
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
     for (std::size_t i = 0; i < num_processes; ++i)
     {
       const std::vector<std::size_t>& local_index = recv_local[i];
@@ -1338,11 +1330,12 @@ void HDF5File::read_mesh_value_collection(MeshValueCollection<T>& mesh_vc,
 
       for (std::size_t j = 0; j < local_index.size(); ++j)
       {
-        mvc_map[std::make_pair(local_index[j], local_entities[j])]
-          = local_values[j];
+        values.push_back(std::make_pair(std::make_pair(local_index[j],
+                                                       local_entities[j]),
+                                        local_values[j]));
       }
     }
-
+    mesh_vc.set_values(values);
   }
 }
 //-----------------------------------------------------------------------------
@@ -1494,33 +1487,32 @@ void HDF5File::read(Mesh& input_mesh, const std::string mesh_name,
     read_mesh_value_collection(mvc, marker_dataset);
 
     // Get mesh value collection data
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>&
-      values = mvc.values();
-
-    // Get mesh domain data and fill
-    std::map<std::size_t, std::size_t>& markers
-      = input_mesh.domains().markers(d);
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator entry;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                      std::size_t>& values = mvc.values();
+
+    // Collect mesh domain data and fill
+    std::vector<std::pair<std::size_t, std::size_t>> markers;
+    markers.reserve(values.size());
     if (d != input_mesh.topology().dim())
     {
       input_mesh.init(d);
-      for (entry = values.begin(); entry != values.end(); ++entry)
+      input_mesh.init(input_mesh.topology().dim(), d);
+      for (auto entry = values.begin(); entry != values.end(); ++entry)
       {
         const Cell cell(input_mesh, entry->first.first);
         const std::size_t entity_index
           = cell.entities(d)[entry->first.second];
-        markers[entity_index] = entry->second;
+        markers.push_back(std::make_pair(entity_index, entry->second));
       }
     }
     else
     {
       // Special case for cells
-      for (entry = values.begin(); entry != values.end(); ++entry)
-        markers[entry->first.first] = entry->second;
+      for (auto entry = values.begin(); entry != values.end(); ++entry)
+        markers.push_back(std::make_pair(entry->first.first, entry->second));
     }
+    input_mesh.domains().set_markers(markers, d);
   }
-
 }
 //-----------------------------------------------------------------------------
 bool HDF5File::has_dataset(const std::string dataset_name) const
@@ -18,13 +18,14 @@
 // Modified by Anders Logg 2011
 //
 // First added:  2002-12-06
-// Last changed: 2014-02-06
+// Last changed: 2015-06-12
 
 #include <map>
 #include <memory>
 #include <iomanip>
 #include <iostream>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -290,30 +291,29 @@ void XMLMesh::read_domains(MeshDomains& domains, const Mesh& mesh,
     XMLMeshValueCollection::read(mvc, type, *it);
 
     // Get mesh value collection data
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>&
-      values = mvc.values();
-
-    // Get mesh domain data and fill
-    std::map<std::size_t, std::size_t>& markers
-      = domains.markers(dim);
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator entry;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                      std::size_t>& values = mvc.values();
+
+    // Collect mesh domain data and fill
+    std::vector<std::pair<std::size_t, std::size_t>> markers;
+    markers.reserve(values.size());
     if (dim != mesh.topology().dim())
     {
-      for (entry = values.begin(); entry != values.end(); ++entry)
+      for (auto entry = values.begin(); entry != values.end(); ++entry)
       {
         const Cell cell(mesh, entry->first.first);
         const std::size_t entity_index
           = cell.entities(dim)[entry->first.second];
-        markers[entity_index] = entry->second;
+        markers.push_back(std::make_pair(entity_index, entry->second));
       }
     }
     else
     {
       // Special case for cells
-      for (entry = values.begin(); entry != values.end(); ++entry)
-        markers[entry->first.first] = entry->second;
+      for (auto entry = values.begin(); entry != values.end(); ++entry)
+        markers.push_back(std::make_pair(entry->first.first, entry->second));
     }
+    domains.set_markers(markers, dim);
   }
 }
 //-----------------------------------------------------------------------------
@@ -564,12 +564,12 @@ void XMLMesh::write_domains(const Mesh& mesh, const MeshDomains& domains,
   {
     if (!domains.markers(d).empty())
     {
-      const std::map<std::size_t, std::size_t>& domain = domains.markers(d);
+      const boost::container::flat_map<std::size_t, std::size_t>& domain
+        = domains.markers(d);
 
       MeshValueCollection<std::size_t> collection(mesh, d);
-      std::map<std::size_t, std::size_t>::const_iterator it;
-      for (it = domain.begin(); it != domain.end(); ++it)
-        collection.set_value(it->first, it->second);
+      collection.set_values(std::vector<std::pair<std::size_t, std::size_t>>(
+                              domain.begin(), domain.end()));
       XMLMeshValueCollection::write(collection, "uint", domains_node);
     }
   }
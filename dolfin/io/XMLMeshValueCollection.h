@@ -16,11 +16,14 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2011-06-30
-// Last changed: 2011-11-15
+// Last changed: 2015-06-12
 
 #ifndef __XML_MESH_VALUE_COLLECTION_H
 #define __XML_MESH_VALUE_COLLECTION_H
 
+#include <utility>
+#include <vector>
+#include <boost/container/flat_map.hpp>
 #include <boost/lexical_cast.hpp>
 #include <dolfin/mesh/MeshValueCollection.h>
 #include "pugixml.hpp"
@@ -83,6 +86,9 @@ namespace dolfin
     // Clear old values
     mesh_value_collection.clear();
 
+    // Values are read into a list and inserted in bulk
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
+
     // Choose data type
     if (type == "uint")
     {
@@ -93,7 +99,8 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const std::size_t value = it->attribute("value").as_uint();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        values.push_back(std::make_pair(std::make_pair(cell_index,
+                                                       local_entity), value));
       }
     }
     else if (type == "int")
@@ -105,7 +112,8 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const int value = it->attribute("value").as_int();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        values.push_back(std::make_pair(std::make_pair(cell_index,
+                                                       local_entity), value));
       }
     }
     else if (type == "double")
@@ -117,7 +125,8 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const double value = it->attribute("value").as_double();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        values.push_back(std::make_pair(std::make_pair(cell_index,
+                                                       local_entity), value));
       }
     }
     else if (type == "bool")
@@ -129,7 +138,8 @@ namespace dolfin
         const std::size_t local_entity
           = it->attribute("local_entity").as_uint();
         const bool value = it->attribute("value").as_bool();
-        mesh_value_collection.set_value(cell_index, local_entity, value);
+        values.push_back(std::make_pair(std::make_pair(cell_index,
+                                                       local_entity), value));
       }
     }
     else
@@ -138,6 +148,9 @@ namespace dolfin
                    "read mesh value collection from XML file",
                    "Unhandled value type \"%s\"", type.c_str());
     }
+
+    // Insert values
+    mesh_value_collection.set_values(values);
   }
   //---------------------------------------------------------------------------
   template<typename T>
@@ -158,9 +171,9 @@ namespace dolfin
       = (unsigned int) mesh_value_collection.size();
 
     // Add data
-    const std::map<std::pair<std::size_t, std::size_t>, T>&
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
       values = mesh_value_collection.values();
-    typename std::map<std::pair<std::size_t,
+    typename boost::container::flat_map<std::pair<std::size_t,
       std::size_t>, T>::const_iterator it;
     for (it = values.begin(); it != values.end(); ++it)
     {
@@ -19,21 +19,195 @@
 // Modified by Garth N. Wells 2011
 //
 // First added:  2008-08-25
-// Last changed: 2012-03-15
+// Last changed: 2015-06-12
 
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/NoDeleter.h>
 #include "dolfin/common/utils.h"
 #include "BlockVector.h"
 #include "DefaultFactory.h"
+#include "EigenMatrix.h"
+#include "EigenVector.h"
 #include "GenericVector.h"
 #include "Matrix.h"
+#include "uBLASMatrix.h"
+#include "uBLASVector.h"
 #include "BlockMatrix.h"
 
 using namespace dolfin;
 
+namespace
+{
+  typedef boost::multi_array<std::shared_ptr<GenericMatrix>, 2> block_array;
+
+  // Product of row i of matrix with x
+  inline double row_product(const EigenMatrix& A, std::size_t i,
+                            const double* x)
+  {
+    double s = 0.0;
+    for (eigen_matrix_type::InnerIterator it(A.mat(), i); it; ++it)
+      s += it.value()*x[it.col()];
+    return s;
+  }
+
+  inline double row_product(const uBLASMatrix<ublas_sparse_matrix>& A,
+                            std::size_t i, const double* x)
+  {
+    const ublas_sparse_matrix& _A = A.mat();
+    double s = 0.0;
+    for (std::size_t k = _A.index1_data()[i]; k < _A.index1_data()[i + 1]; ++k)
+      s += _A.value_data()[k]*x[_A.index2_data()[k]];
+    return s;
+  }
+
+  // Pointers to local entries of vector
+  inline const double* local_data(const EigenVector& x)
+  { return x.vec().data(); }
+  inline double* local_data(EigenVector& x)
+  { return x.vec().data(); }
+  inline const double* local_data(const uBLASVector& x)
+  { return x.data(); }
+  inline double* local_data(uBLASVector& x)
+  { return x.data(); }
+
+  // Check that all non-empty blocks are of type Mat
+  template<typename Mat>
+  bool has_block_type(const block_array& matrices)
+  {
+    for (std::size_t i = 0; i < matrices.shape()[0]; i++)
+    {
+      for (std::size_t j = 0; j < matrices.shape()[1]; j++)
+      {
+        dolfin_assert(matrices[i][j]);
+        if (!matrices[i][j]->empty() && !has_type<const Mat>(*matrices[i][j]))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Compute y = Ax with x[j] and y[i] pointing to the entries of
+  // block j of x and block i of y. Each entry of y is computed in a
+  // single pass over the corresponding row of all blocks.
+  template<typename Mat>
+  void fused_mult(const block_array& matrices,
+                  const std::vector<const double*>& x,
+                  const std::vector<double*>& y,
+                  const std::vector<std::size_t>& num_rows)
+  {
+    const std::size_t n = matrices.shape()[1];
+    std::vector<const Mat*> blocks;
+    std::vector<const double*> _x;
+    for (std::size_t row = 0; row < matrices.shape()[0]; row++)
+    {
+      // Non-empty blocks of block row
+      blocks.clear();
+      _x.clear();
+      for (std::size_t col = 0; col < n; col++)
+      {
+        if (!matrices[row][col]->empty())
+        {
+          blocks.push_back(&as_type<const Mat>(*matrices[row][col]));
+          _x.push_back(x[col]);
+        }
+      }
+
+      double* _y = y[row];
+      for (std::size_t i = 0; i < num_rows[row]; i++)
+      {
+        double s = 0.0;
+        for (std::size_t k = 0; k < blocks.size(); k++)
+          s += row_product(*blocks[k], i, _x[k]);
+        _y[i] = s;
+      }
+    }
+  }
+
+  // Compute y = Ax for block vectors if blocks are of type Mat and
+  // vectors of type Vec. Returns false otherwise.
+  template<typename Mat, typename Vec>
+  bool fused_mult(const block_array& matrices, const BlockVector& x,
+                  BlockVector& y)
+  {
+    if (!has_block_type<Mat>(matrices))
+      return false;
+
+    std::vector<const double*> _x(x.size());
+    for (std::size_t i = 0; i < x.size(); i++)
+    {
+      if (!has_type<const Vec>(*x.get_block(i)))
+        return false;
+      _x[i] = local_data(as_type<const Vec>(*x.get_block(i)));
+    }
+
+    std::vector<double*> _y(y.size());
+    std::vector<std::size_t> num_rows(y.size());
+    for (std::size_t i = 0; i < y.size(); i++)
+    {
+      if (!has_type<Vec>(*y.get_block(i)))
+        return false;
+      _y[i] = local_data(as_type<Vec>(*y.get_block(i)));
+      num_rows[i] = y.get_block(i)->local_size();
+    }
+
+    // Check sizes of blocks
+    for (std::size_t i = 0; i < y.size(); i++)
+    {
+      for (std::size_t j = 0; j < x.size(); j++)
+      {
+        const GenericMatrix& A = *matrices[i][j];
+        if (!A.empty() && (A.size(0) != y.get_block(i)->size()
+                           || A.size(1) != x.get_block(j)->size()))
+        {
+          dolfin_error("BlockMatrix.cpp",
+                       "compute matrix-vector product with block matrix",
+                       "Size of block (%d, %d) does not match vector blocks",
+                       i, j);
+        }
+      }
+    }
+
+    fused_mult<Mat>(matrices, _x, _y, num_rows);
+    return true;
+  }
+
+  // Compute y = Ax for concatenated vectors if blocks are of type Mat
+  // and vectors of type Vec. Returns false otherwise.
+  template<typename Mat, typename Vec>
+  bool fused_mult(const block_array& matrices, const GenericVector& x,
+                  GenericVector& y, const std::vector<std::size_t>& num_rows,
+                  const std::vector<std::size_t>& num_cols)
+  {
+    if (!has_block_type<Mat>(matrices) || !has_type<const Vec>(x)
+        || !has_type<Vec>(y))
+    {
+      return false;
+    }
+
+    const double* x0 = local_data(as_type<const Vec>(x));
+    std::vector<const double*> _x(num_cols.size());
+    for (std::size_t i = 0, offset = 0; i < num_cols.size(); i++)
+    {
+      _x[i] = x0 + offset;
+      offset += num_cols[i];
+    }
+
+    double* y0 = local_data(as_type<Vec>(y));
+    std::vector<double*> _y(num_rows.size());
+    for (std::size_t i = 0, offset = 0; i < num_rows.size(); i++)
+    {
+      _y[i] = y0 + offset;
+      offset += num_rows[i];
+    }
+
+    fused_mult<Mat>(matrices, _x, _y, num_rows);
+    return true;
+  }
+}
+
 //-----------------------------------------------------------------------------
 BlockMatrix::BlockMatrix(std::size_t m, std::size_t n)
   : matrices(boost::extents[m][n])
@@ -74,7 +248,7 @@ std::shared_ptr<GenericMatrix> BlockMatrix::get_block(std::size_t i,
 //-----------------------------------------------------------------------------
 std::size_t BlockMatrix::size(std::size_t dim) const
 {
-  dolfin_assert(dim < 1);
+  dolfin_assert(dim < 2);
   return matrices.shape()[dim];
 }
 //-----------------------------------------------------------------------------
@@ -119,6 +293,28 @@ std::string BlockMatrix::str(bool verbose) const
   return s.str();
 }
 //-----------------------------------------------------------------------------
+void BlockMatrix::init_vector(BlockVector& z, std::size_t dim) const
+{
+  dolfin_assert(dim < 2);
+  dolfin_assert(z.size() == matrices.shape()[dim]);
+  for (std::size_t i = 0; i < matrices.shape()[dim]; i++)
+  {
+    // Find non-empty block in block row/column i
+    for (std::size_t k = 0; k < matrices.shape()[1 - dim]; k++)
+    {
+      const GenericMatrix& A
+        = (dim == 0) ? *matrices[i][k] : *matrices[k][i];
+      if (!A.empty())
+      {
+        std::shared_ptr<GenericVector> _z = A.factory().create_vector();
+        A.init_vector(*_z, dim);
+        z.set_block(i, _z);
+        break;
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void BlockMatrix::mult(const BlockVector& x, BlockVector& y,
                        bool transposed) const
 {
@@ -129,33 +325,121 @@ void BlockMatrix::mult(const BlockVector& x, BlockVector& y,
                  "Not implemented for block matrices");
   }
 
-  // Create temporary vector
-  dolfin_assert(matrices[0][0]);
+  dolfin_assert(x.size() == matrices.shape()[1]);
+  dolfin_assert(y.size() == matrices.shape()[0]);
+
+  // Initialize blocks of y if necessary
+  for (std::size_t row = 0; row < matrices.shape()[0]; row++)
+  {
+    if (y.get_block(row)->empty())
+    {
+      for (std::size_t col = 0; col < matrices.shape()[1]; col++)
+      {
+        if (!matrices[row][col]->empty())
+        {
+          matrices[row][col]->init_vector(*y.get_block(row), 0);
+          break;
+        }
+      }
+    }
+  }
+
+  // Compute product in a single pass for Eigen and uBLAS matrices
+  if (fused_mult<EigenMatrix, EigenVector>(matrices, x, y))
+    return;
+  if (fused_mult<uBLASMatrix<ublas_sparse_matrix>, uBLASVector>(matrices, x, y))
+    return;
 
   // Loop over block rows
-  for(std::size_t row = 0; row < matrices.shape()[0]; row++)
+  _work.resize(matrices.shape()[0]);
+  for (std::size_t row = 0; row < matrices.shape()[0]; row++)
   {
     // RHS sub-vector
     GenericVector& _y = *(y.get_block(row));
 
-    const GenericMatrix& _matA = *matrices[row][0];
-
-    // Resize y and zero
-    if (_y.empty())
-      _matA.init_vector(_y, 0);
-    _y.zero();
-
-    // Loop over block columns
-    std::shared_ptr<GenericVector>
-      z_tmp = _matA.factory().create_vector();
-    for(std::size_t col = 0; col < matrices.shape()[1]; ++col)
+    // Loop over block columns (first non-empty block is multiplied
+    // directly into y, other blocks using the work vector of the
+    // block row)
+    bool initialized = false;
+    for (std::size_t col = 0; col < matrices.shape()[1]; ++col)
     {
-      const GenericVector& _x = *(x.get_block(col));
       dolfin_assert(matrices[row][col]);
-      matrices[row][col]->mult(_x, *z_tmp);
-      _y += *z_tmp;
+      const GenericMatrix& A = *matrices[row][col];
+      if (A.empty())
+        continue;
+
+      const GenericVector& _x = *(x.get_block(col));
+      if (!initialized)
+      {
+        A.mult(_x, _y);
+        initialized = true;
+      }
+      else
+      {
+        if (!_work[row] || _work[row]->size() != _y.size())
+        {
+          _work[row] = A.factory().create_vector();
+          A.init_vector(*_work[row], 0);
+        }
+        A.mult(_x, *_work[row]);
+        _y += *_work[row];
+      }
     }
+
+    if (!initialized)
+      _y.zero();
+  }
+}
+//-----------------------------------------------------------------------------
+void BlockMatrix::mult(const GenericVector& x, GenericVector& y) const
+{
+  std::vector<std::size_t> num_rows(matrices.shape()[0]);
+  std::vector<std::size_t> num_cols(matrices.shape()[1]);
+  for (std::size_t i = 0; i < num_rows.size(); i++)
+    num_rows[i] = block_size(i, 0);
+  for (std::size_t j = 0; j < num_cols.size(); j++)
+    num_cols[j] = block_size(j, 1);
+
+  const std::size_t M = std::accumulate(num_rows.begin(), num_rows.end(),
+                                        std::size_t(0));
+  const std::size_t N = std::accumulate(num_cols.begin(), num_cols.end(),
+                                        std::size_t(0));
+  if (x.size() != N || y.size() != M)
+  {
+    dolfin_error("BlockMatrix.cpp",
+                 "compute matrix-vector product with block matrix",
+                 "Vector sizes do not match sum of block sizes");
+  }
+
+  if (fused_mult<EigenMatrix, EigenVector>(matrices, x, y, num_rows,
+                                           num_cols))
+  {
+    return;
+  }
+  if (fused_mult<uBLASMatrix<ublas_sparse_matrix>, uBLASVector>(matrices, x, y,
+                                                               num_rows,
+                                                               num_cols))
+  {
+    return;
+  }
+
+  dolfin_error("BlockMatrix.cpp",
+               "compute matrix-vector product with block matrix",
+               "Concatenated vectors are only supported for Eigen and uBLAS "
+               "sparse matrices");
+}
+//-----------------------------------------------------------------------------
+std::size_t BlockMatrix::block_size(std::size_t i, std::size_t dim) const
+{
+  dolfin_assert(dim < 2);
+  dolfin_assert(i < matrices.shape()[dim]);
+  for (std::size_t k = 0; k < matrices.shape()[1 - dim]; k++)
+  {
+    const GenericMatrix& A = (dim == 0) ? *matrices[i][k] : *matrices[k][i];
+    if (!A.empty())
+      return A.size(dim);
   }
+  return 0;
 }
 //-----------------------------------------------------------------------------
 std::shared_ptr<GenericMatrix> BlockMatrix::schur_approximation(bool symmetry) const
@@ -19,19 +19,22 @@
 // Modified by Garth N. Wells, 2011.
 //
 // First added:  2008-08-25
-// Last changed: 2011-01-22
+// Last changed: 2015-06-12
 
 #ifndef __BLOCKMATRIX_H
 #define __BLOCKMATRIX_H
 
 #include <boost/multi_array.hpp>
 #include <memory>
+#include <vector>
 
 namespace dolfin
 {
 
   /// Forward declarations
+  class BlockVector;
   class GenericMatrix;
+  class GenericVector;
 
   class BlockMatrix
   {
@@ -66,10 +69,22 @@ namespace dolfin
     /// Return informal string representation (pretty-print)
     std::string str(bool verbose) const;
 
-    /// Matrix-vector product, y = Ax
+    /// Initialize each block of vector z to be compatible with the
+    /// rows (dim = 0) or columns (dim = 1) of the block matrix
+    void init_vector(BlockVector& z, std::size_t dim) const;
+
+    /// Matrix-vector product, y = Ax. Blocks which are empty are
+    /// treated as zero. For Eigen and uBLAS (sparse) matrices, each
+    /// block of y is computed in a single pass over the block row
+    /// without temporary vectors.
     void mult(const BlockVector& x, BlockVector& y,
               bool transposed=false) const;
 
+    /// Matrix-vector product, y = Ax, with x and y the concatenation
+    /// of the blocks of the block vectors (supported for Eigen and
+    /// uBLAS sparse matrices and vectors)
+    void mult(const GenericVector& x, GenericVector& y) const;
+
     /// Create a crude explicit Schur approximation  of S = D - C A^-1
     /// B of  (A B; C  D) If symmetry !=  0, then the  caller promises
     /// that B = symmetry * transpose(C).
@@ -78,8 +93,16 @@ namespace dolfin
 
   private:
 
+    // Return size of block row (dim = 0) or column (dim = 1) i (0 if
+    // all blocks are empty)
+    std::size_t block_size(std::size_t i, std::size_t dim) const;
+
     boost::multi_array<std::shared_ptr<GenericMatrix>, 2> matrices;
 
+    // Work vectors (one per block row) for products with blocks of
+    // other backends
+    mutable std::vector<std::shared_ptr<GenericVector>> _work;
+
   };
 
 }
@@ -0,0 +1,216 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <dolfin/log/log.h>
+#include "BlockMatrix.h"
+#include "BlockVector.h"
+#include "GenericLinearAlgebraFactory.h"
+#include "GenericLinearSolver.h"
+#include "GenericMatrix.h"
+#include "GenericVector.h"
+#include "uBLASVector.h"
+#include "BlockPreconditioner.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+BlockPreconditioner::BlockPreconditioner(std::string type)
+  : _type(type), _matP(NULL)
+{
+  if (type != "jacobi" && type != "upper triangular"
+      && type != "lower triangular")
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "create block preconditioner",
+                 "Unknown block preconditioner type \"%s\"", type.c_str());
+  }
+}
+//-----------------------------------------------------------------------------
+BlockPreconditioner::~BlockPreconditioner()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+void BlockPreconditioner::set_block_solver(std::size_t i,
+                                  std::shared_ptr<GenericLinearSolver> solver)
+{
+  if (i >= _solvers.size())
+    _solvers.resize(i + 1);
+  _solvers[i] = solver;
+}
+//-----------------------------------------------------------------------------
+void BlockPreconditioner::init(const BlockMatrix& P)
+{
+  if (P.size(0) != P.size(1))
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "initialize block preconditioner",
+                 "Block matrix must have the same number of block rows "
+                 "and columns");
+  }
+
+  _matP = &P;
+  _r.clear();
+  _w.clear();
+  _r.resize(P.size(0));
+  _w.resize(P.size(0));
+
+  // Block vectors for concatenated vectors
+  _x.reset(new BlockVector(P.size(1)));
+  P.init_vector(*_x, 1);
+  _b.reset(new BlockVector(P.size(0)));
+  P.init_vector(*_b, 0);
+}
+//-----------------------------------------------------------------------------
+void BlockPreconditioner::solve(BlockVector& x, const BlockVector& b) const
+{
+  if (!_matP)
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "apply block preconditioner",
+                 "Preconditioner has not been initialized with a block "
+                 "matrix");
+  }
+
+  const BlockMatrix& P = *_matP;
+  const std::size_t n = P.size(0);
+  dolfin_assert(x.size() == n);
+  dolfin_assert(b.size() == n);
+
+  // Initialize blocks of x if necessary
+  for (std::size_t i = 0; i < n; i++)
+  {
+    if (x.get_block(i)->empty())
+    {
+      P.init_vector(x, 1);
+      break;
+    }
+  }
+
+  if (_type == "jacobi")
+  {
+    for (std::size_t i = 0; i < n; i++)
+      solve_block(i, *x.get_block(i), *b.get_block(i));
+    return;
+  }
+
+  // Block substitution (backward for upper, forward for lower
+  // triangular)
+  const bool upper = (_type == "upper triangular");
+  for (std::size_t k = 0; k < n; k++)
+  {
+    const std::size_t i = upper ? n - 1 - k : k;
+    const GenericVector& b_i = *b.get_block(i);
+
+    // Compute r_i = b_i - sum_j A_ij x_j over solved blocks j
+    std::shared_ptr<GenericVector>& r = _r[i];
+    if (!r || r->size() != b_i.size())
+      r = b_i.copy();
+    else
+      *r = b_i;
+
+    const std::size_t j0 = upper ? i + 1 : 0;
+    const std::size_t j1 = upper ? n : i;
+    for (std::size_t j = j0; j < j1; j++)
+    {
+      std::shared_ptr<const GenericMatrix> A = P.get_block(i, j);
+      dolfin_assert(A);
+      if (A->empty())
+        continue;
+
+      std::shared_ptr<GenericVector>& w = _w[i];
+      if (!w || w->size() != b_i.size())
+      {
+        w = A->factory().create_vector();
+        A->init_vector(*w, 0);
+      }
+      A->mult(*x.get_block(j), *w);
+      *r -= *w;
+    }
+
+    solve_block(i, *x.get_block(i), *r);
+  }
+}
+//-----------------------------------------------------------------------------
+void BlockPreconditioner::solve(uBLASVector& x, const uBLASVector& b) const
+{
+  if (!_matP)
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "apply block preconditioner",
+                 "Preconditioner has not been initialized with a block "
+                 "matrix");
+  }
+  dolfin_assert(_x);
+  dolfin_assert(_b);
+
+  // Copy blocks of b
+  const double* _b0 = b.data();
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < _b->size(); i++)
+  {
+    GenericVector& b_i = *_b->get_block(i);
+    const std::size_t m = b_i.local_size();
+    if (offset + m > b.size())
+    {
+      dolfin_error("BlockPreconditioner.cpp",
+                   "apply block preconditioner",
+                   "Vector size does not match sum of block sizes");
+    }
+    _values.assign(_b0 + offset, _b0 + offset + m);
+    b_i.set_local(_values);
+    b_i.apply("insert");
+    offset += m;
+  }
+  if (offset != b.size())
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "apply block preconditioner",
+                 "Vector size does not match sum of block sizes");
+  }
+
+  solve(*_x, *_b);
+
+  // Copy blocks of x
+  if (x.size() != b.size())
+    x.resize(b.size());
+  double* _x0 = x.data();
+  offset = 0;
+  for (std::size_t i = 0; i < _x->size(); i++)
+  {
+    _x->get_block(i)->get_local(_values);
+    std::copy(_values.begin(), _values.end(), _x0 + offset);
+    offset += _values.size();
+  }
+}
+//-----------------------------------------------------------------------------
+void BlockPreconditioner::solve_block(std::size_t i, GenericVector& x,
+                                      const GenericVector& b) const
+{
+  if (i >= _solvers.size() || !_solvers[i])
+  {
+    dolfin_error("BlockPreconditioner.cpp",
+                 "apply block preconditioner",
+                 "Solver for diagonal block %d has not been set", i);
+  }
+  _solvers[i]->solve(x, b);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __BLOCK_PRECONDITIONER_H
+#define __BLOCK_PRECONDITIONER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "ublas.h"
+#include "uBLASPreconditioner.h"
+
+namespace dolfin
+{
+
+  /// Forward declarations
+  class BlockMatrix;
+  class BlockVector;
+  class GenericLinearSolver;
+  class GenericVector;
+
+  /// This class implements block preconditioners for block matrices
+  /// (A_00 ... A_0n; ... ; A_n0 ... A_nn). Each diagonal block is
+  /// approximately inverted by a given linear solver, e.g. an LU
+  /// solver for A_00 and a solver for an approximate Schur complement
+  /// (see BlockMatrix::schur_approximation) for A_11 of a saddle
+  /// point problem.
+  ///
+  /// The following types are supported:
+  ///
+  ///   "jacobi"            (block diagonal, x_i = P_i^-1 b_i)
+  ///   "upper triangular"  (block backward substitution,
+  ///                        x_i = P_i^-1 (b_i - sum_{j > i} A_ij x_j))
+  ///   "lower triangular"  (block forward substitution,
+  ///                        x_i = P_i^-1 (b_i - sum_{j < i} A_ij x_j))
+  ///
+  /// The preconditioner may be applied to block vectors, or used with
+  /// the uBLAS Krylov solver for concatenated vectors (see
+  /// uBLASKrylovSolver::solve).
+
+  class BlockPreconditioner : public uBLASPreconditioner
+  {
+  public:
+
+    /// Create block preconditioner of given type
+    explicit BlockPreconditioner(std::string type="jacobi");
+
+    /// Destructor
+    ~BlockPreconditioner();
+
+    /// Set solver for diagonal block i
+    void set_block_solver(std::size_t i,
+                          std::shared_ptr<GenericLinearSolver> solver);
+
+    /// Initialise preconditioner with block matrix (which must
+    /// outlive any calls to solve)
+    void init(const BlockMatrix& P);
+
+    /// Solve linear system Px = b approximately for block vectors
+    void solve(BlockVector& x, const BlockVector& b) const;
+
+    /// Solve linear system Px = b approximately for concatenated
+    /// vectors
+    void solve(uBLASVector& x, const uBLASVector& b) const;
+
+  private:
+
+    // Apply solver for diagonal block i
+    void solve_block(std::size_t i, GenericVector& x,
+                     const GenericVector& b) const;
+
+    // Preconditioner type
+    std::string _type;
+
+    // Solvers for diagonal blocks
+    std::vector<std::shared_ptr<GenericLinearSolver>> _solvers;
+
+    // Block matrix
+    const BlockMatrix* _matP;
+
+    // Work vectors (one per block) for residuals and products with
+    // off-diagonal blocks
+    mutable std::vector<std::shared_ptr<GenericVector>> _r, _w;
+
+    // Block vectors and buffer for concatenated vectors
+    std::shared_ptr<BlockVector> _x, _b;
+    mutable std::vector<double> _values;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,372 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <dolfin/log/log.h>
+#include "GenericMatrix.h"
+#include "GenericSparsityPattern.h"
+#include "TensorLayout.h"
+#include "CSRMatrixBuffer.h"
+
+#ifdef HAS_PETSC
+#include <petscmat.h>
+#include "PETScMatrix.h"
+#endif
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+CSRMatrixBuffer::CSRMatrixBuffer(const TensorLayout& tensor_layout)
+  : _mpi_comm(tensor_layout.mpi_comm()), _sending(false)
+{
+  if (!supported(tensor_layout))
+  {
+    dolfin_error("CSRMatrixBuffer.cpp",
+                 "create matrix buffer",
+                 "Tensor layout must be of rank 2 with a row-wise sparsity pattern");
+  }
+
+  const GenericSparsityPattern& pattern = *tensor_layout.sparsity_pattern();
+  const std::pair<std::size_t, std::size_t> row_range
+    = tensor_layout.local_range(0);
+  _row_offset = row_range.first;
+  _num_owned_rows = row_range.second - row_range.first;
+
+  // Get ownership ranges of all processes
+  MPI::all_gather(_mpi_comm, row_range.second, _row_range_ends);
+
+  // Copy local-to-global maps (identity if not set)
+  if (tensor_layout.local_to_global_map.size() == 2
+      && !tensor_layout.local_to_global_map[0].empty())
+  {
+    _row_map.assign(tensor_layout.local_to_global_map[0].begin(),
+                    tensor_layout.local_to_global_map[0].end());
+    _col_map.assign(tensor_layout.local_to_global_map[1].begin(),
+                    tensor_layout.local_to_global_map[1].end());
+  }
+  else
+  {
+    _row_map.resize(tensor_layout.size(0));
+    _col_map.resize(tensor_layout.size(1));
+    for (std::size_t i = 0; i < _row_map.size(); ++i)
+      _row_map[i] = i;
+    for (std::size_t i = 0; i < _col_map.size(); ++i)
+      _col_map[i] = i;
+  }
+
+  // Build compressed row storage of locally owned rows from diagonal
+  // and off-diagonal sparsity patterns
+  const std::vector<std::vector<std::size_t>> diagonal
+    = pattern.diagonal_pattern(GenericSparsityPattern::unsorted);
+  const std::vector<std::vector<std::size_t>> off_diagonal
+    = pattern.off_diagonal_pattern(GenericSparsityPattern::unsorted);
+  dolfin_assert(diagonal.size() == _num_owned_rows);
+
+  _offsets.assign(_num_owned_rows + 1, 0);
+  for (std::size_t i = 0; i < _num_owned_rows; ++i)
+  {
+    _offsets[i + 1] = _offsets[i] + diagonal[i].size();
+    if (!off_diagonal.empty())
+      _offsets[i + 1] += off_diagonal[i].size();
+  }
+
+  _columns.resize(_offsets.back());
+  for (std::size_t i = 0; i < _num_owned_rows; ++i)
+  {
+    auto row = _columns.begin() + _offsets[i];
+    row = std::copy(diagonal[i].begin(), diagonal[i].end(), row);
+    if (!off_diagonal.empty())
+      std::copy(off_diagonal[i].begin(), off_diagonal[i].end(), row);
+    std::sort(_columns.begin() + _offsets[i],
+              _columns.begin() + _offsets[i + 1]);
+  }
+  _values.assign(_columns.size(), 0.0);
+
+  _nonlocal_offsets.push_back(0);
+}
+//-----------------------------------------------------------------------------
+CSRMatrixBuffer::~CSRMatrixBuffer()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+bool CSRMatrixBuffer::supported(const TensorLayout& tensor_layout)
+{
+  return tensor_layout.rank() == 2 && tensor_layout.sparsity_pattern()
+    && tensor_layout.sparsity_pattern()->primary_dim() == 0;
+}
+//-----------------------------------------------------------------------------
+void CSRMatrixBuffer::add_local(
+  const double* block,
+  const std::vector<ArrayView<const dolfin::la_index>>& rows)
+{
+  dolfin_assert(rows.size() == 2);
+  const ArrayView<const dolfin::la_index>& block_rows = rows[0];
+  const ArrayView<const dolfin::la_index>& block_cols = rows[1];
+  const std::size_t n = block_cols.size();
+
+  // Map columns to global indices
+  _block_columns.resize(n);
+  for (std::size_t j = 0; j < n; ++j)
+    _block_columns[j] = _col_map[block_cols[j]];
+
+  for (std::size_t i = 0; i < block_rows.size(); ++i)
+  {
+    const double* block_row = block + i*n;
+    const std::size_t row
+      = static_cast<std::size_t>(_row_map[block_rows[i]]) - _row_offset;
+    if (row < _num_owned_rows)
+      add_to_owned_row(row, _block_columns.data(), n, block_row);
+    else
+    {
+      // Store row owned by other process
+      _nonlocal_rows.push_back(_row_map[block_rows[i]]);
+      _nonlocal_columns.insert(_nonlocal_columns.end(),
+                               _block_columns.begin(), _block_columns.end());
+      _nonlocal_values.insert(_nonlocal_values.end(), block_row,
+                              block_row + n);
+      _nonlocal_offsets.push_back(_nonlocal_values.size());
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void CSRMatrixBuffer::send_nonlocal_begin()
+{
+  dolfin_assert(!_sending);
+  _sending = true;
+
+  #ifdef HAS_MPI
+  const std::size_t num_processes = MPI::size(_mpi_comm);
+
+  // Pack rows by owning process
+  _send_indices.assign(num_processes, std::vector<std::int64_t>());
+  _send_values.assign(num_processes, std::vector<double>());
+  for (std::size_t i = 0; i < _nonlocal_rows.size(); ++i)
+  {
+    const std::size_t row = _nonlocal_rows[i];
+    const std::size_t owner
+      = std::upper_bound(_row_range_ends.begin(), _row_range_ends.end(), row)
+      - _row_range_ends.begin();
+    dolfin_assert(owner < num_processes);
+
+    const std::size_t offset = _nonlocal_offsets[i];
+    const std::size_t n = _nonlocal_offsets[i + 1] - offset;
+    _send_indices[owner].push_back(row);
+    _send_indices[owner].push_back(n);
+    _send_indices[owner].insert(_send_indices[owner].end(),
+                                _nonlocal_columns.begin() + offset,
+                                _nonlocal_columns.begin() + offset + n);
+    _send_values[owner].insert(_send_values[owner].end(),
+                               _nonlocal_values.begin() + offset,
+                               _nonlocal_values.begin() + offset + n);
+  }
+  _nonlocal_rows.clear();
+  _nonlocal_offsets.assign(1, 0);
+  _nonlocal_columns.clear();
+  _nonlocal_values.clear();
+
+  // Exchange message sizes
+  std::vector<int> send_sizes(2*num_processes), recv_sizes(2*num_processes);
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    send_sizes[2*p] = _send_indices[p].size();
+    send_sizes[2*p + 1] = _send_values[p].size();
+  }
+  MPI_Alltoall(send_sizes.data(), 2, MPI_INT, recv_sizes.data(), 2, MPI_INT,
+               _mpi_comm);
+
+  // Post receives and sends
+  _recv_indices.assign(num_processes, std::vector<std::int64_t>());
+  _recv_values.assign(num_processes, std::vector<double>());
+  _requests.clear();
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    if (recv_sizes[2*p] == 0)
+      continue;
+    _recv_indices[p].resize(recv_sizes[2*p]);
+    _recv_values[p].resize(recv_sizes[2*p + 1]);
+    _requests.push_back(MPI_Request());
+    MPI_Irecv(_recv_indices[p].data(), recv_sizes[2*p], MPI_INT64_T, p, 0,
+              _mpi_comm, &_requests.back());
+    _requests.push_back(MPI_Request());
+    MPI_Irecv(_recv_values[p].data(), recv_sizes[2*p + 1], MPI_DOUBLE, p, 1,
+              _mpi_comm, &_requests.back());
+  }
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    if (send_sizes[2*p] == 0)
+      continue;
+    _requests.push_back(MPI_Request());
+    MPI_Isend(_send_indices[p].data(), send_sizes[2*p], MPI_INT64_T, p, 0,
+              _mpi_comm, &_requests.back());
+    _requests.push_back(MPI_Request());
+    MPI_Isend(_send_values[p].data(), send_sizes[2*p + 1], MPI_DOUBLE, p, 1,
+              _mpi_comm, &_requests.back());
+  }
+  #endif
+}
+//-----------------------------------------------------------------------------
+void CSRMatrixBuffer::send_nonlocal_end()
+{
+  dolfin_assert(_sending);
+  _sending = false;
+
+  #ifdef HAS_MPI
+  // Wait for communication to complete
+  MPI_Waitall(_requests.size(), _requests.data(), MPI_STATUSES_IGNORE);
+  _requests.clear();
+
+  // Add received values to locally owned rows
+  for (std::size_t p = 0; p < _recv_indices.size(); ++p)
+  {
+    const std::vector<std::int64_t>& indices = _recv_indices[p];
+    const double* values = _recv_values[p].data();
+    std::size_t pos = 0;
+    while (pos < indices.size())
+    {
+      const std::size_t row = indices[pos] - _row_offset;
+      const std::size_t n = indices[pos + 1];
+      dolfin_assert(row < _num_owned_rows);
+      _block_columns.assign(indices.begin() + pos + 2,
+                            indices.begin() + pos + 2 + n);
+      add_to_owned_row(row, _block_columns.data(), n, values);
+      pos += 2 + n;
+      values += n;
+    }
+  }
+
+  _send_indices.clear();
+  _send_values.clear();
+  _recv_indices.clear();
+  _recv_values.clear();
+  #endif
+}
+//-----------------------------------------------------------------------------
+void CSRMatrixBuffer::flush(GenericMatrix& A)
+{
+  // Add values received from other processes
+  if (_sending)
+    send_nonlocal_end();
+
+  // Add locally owned rows (in bulk if supported by the backend,
+  // otherwise row by row)
+  if (!insert_owned_rows(A))
+  {
+    for (std::size_t i = 0; i < _num_owned_rows; ++i)
+    {
+      const std::size_t num_entries = _offsets[i + 1] - _offsets[i];
+      if (num_entries == 0)
+        continue;
+      const dolfin::la_index row = i + _row_offset;
+      A.add(_values.data() + _offsets[i], 1, &row,
+            num_entries, _columns.data() + _offsets[i]);
+    }
+  }
+
+  // Add rows owned by other processes
+  for (std::size_t i = 0; i < _nonlocal_rows.size(); ++i)
+  {
+    const std::size_t offset = _nonlocal_offsets[i];
+    A.add(_nonlocal_values.data() + offset, 1, &_nonlocal_rows[i],
+          _nonlocal_offsets[i + 1] - offset, _nonlocal_columns.data() + offset);
+  }
+
+  // Clear buffer
+  std::vector<double>().swap(_values);
+  std::vector<dolfin::la_index>().swap(_columns);
+  std::vector<std::size_t>(_offsets.size(), 0).swap(_offsets);
+  std::vector<dolfin::la_index>().swap(_nonlocal_rows);
+  std::vector<std::size_t>(1, 0).swap(_nonlocal_offsets);
+  std::vector<dolfin::la_index>().swap(_nonlocal_columns);
+  std::vector<double>().swap(_nonlocal_values);
+}
+//-----------------------------------------------------------------------------
+bool CSRMatrixBuffer::insert_owned_rows(GenericMatrix& A) const
+{
+  #ifdef HAS_PETSC
+  if (!has_type<PETScMatrix>(A))
+    return false;
+  Mat mat = as_type<PETScMatrix>(A).mat();
+
+  // Only AIJ matrices can be filled from compressed row storage
+  PetscBool is_seqaij = PETSC_FALSE, is_mpiaij = PETSC_FALSE;
+  PetscObjectTypeCompare((PetscObject) mat, MATSEQAIJ, &is_seqaij);
+  PetscObjectTypeCompare((PetscObject) mat, MATMPIAIJ, &is_mpiaij);
+  if (!is_seqaij && !is_mpiaij)
+    return false;
+
+  // Set nonzero structure and values of locally owned rows. Note
+  // that this assembles the matrix.
+  PetscErrorCode ierr;
+  const std::vector<PetscInt> offsets(_offsets.begin(), _offsets.end());
+  if (is_seqaij)
+  {
+    ierr = MatSeqAIJSetPreallocationCSR(mat, offsets.data(), _columns.data(),
+                                        _values.data());
+    if (ierr != 0)
+    {
+      PETScObject::petsc_error(ierr, __FILE__,
+                               "MatSeqAIJSetPreallocationCSR");
+    }
+  }
+  else
+  {
+    ierr = MatMPIAIJSetPreallocationCSR(mat, offsets.data(), _columns.data(),
+                                        _values.data());
+    if (ierr != 0)
+    {
+      PETScObject::petsc_error(ierr, __FILE__,
+                               "MatMPIAIJSetPreallocationCSR");
+    }
+  }
+
+  // Set options of PETScMatrix again, since the preallocation
+  // may reset them
+  ierr = MatSetOption(mat, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_TRUE);
+  if (ierr != 0) PETScObject::petsc_error(ierr, __FILE__, "MatSetOption");
+  ierr = MatSetOption(mat, MAT_KEEP_NONZERO_PATTERN, PETSC_TRUE);
+  if (ierr != 0) PETScObject::petsc_error(ierr, __FILE__, "MatSetOption");
+
+  return true;
+  #else
+  return false;
+  #endif
+}
+//-----------------------------------------------------------------------------
+void CSRMatrixBuffer::add_to_owned_row(std::size_t row,
+                                       const dolfin::la_index* columns,
+                                       std::size_t n, const double* values)
+{
+  const auto begin = _columns.begin() + _offsets[row];
+  const auto end = _columns.begin() + _offsets[row + 1];
+  for (std::size_t j = 0; j < n; ++j)
+  {
+    const auto pos = std::lower_bound(begin, end, columns[j]);
+    if (pos == end || *pos != columns[j])
+    {
+      dolfin_error("CSRMatrixBuffer.cpp",
+                   "add values to matrix buffer",
+                   "Entry (%d, %d) is not in sparsity pattern",
+                   row + _row_offset, columns[j]);
+    }
+    _values[pos - _columns.begin()] += values[j];
+  }
+}
+//-----------------------------------------------------------------------------
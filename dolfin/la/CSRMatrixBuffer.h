@@ -0,0 +1,150 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __CSR_MATRIX_BUFFER_H
+#define __CSR_MATRIX_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <dolfin/common/ArrayView.h>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/types.h>
+
+namespace dolfin
+{
+
+  class GenericMatrix;
+  class TensorLayout;
+
+  /// This class accumulates element matrices during assembly of a
+  /// newly created matrix. Values of locally owned rows are added to
+  /// a value array in compressed row storage, with the nonzero
+  /// structure taken from the sparsity pattern of the matrix. Values
+  /// of rows owned by other processes are stored row by row.
+  ///
+  /// Calling flush() inserts the accumulated values into the matrix,
+  /// which avoids the overhead of inserting each element matrix into
+  /// the linear algebra backend. Locally owned rows of PETSc AIJ
+  /// matrices are inserted in bulk from the compressed row storage.
+  /// For other matrices, values are inserted with one call per row.
+  ///
+  /// Values of rows owned by other processes may be sent to the
+  /// owning processes ahead of flush() by calling
+  /// send_nonlocal_begin(), such that the communication overlaps with
+  /// further assembly. The received values are added by
+  /// send_nonlocal_end() (called by flush() if needed). Values of rows
+  /// owned by other processes added after send_nonlocal_begin() are
+  /// inserted into the matrix by flush().
+
+  class CSRMatrixBuffer
+  {
+  public:
+
+    /// Create buffer for matrix with given layout
+    ///
+    /// *Arguments*
+    ///     tensor_layout (_TensorLayout_)
+    ///         The layout of the matrix (including a sparsity
+    ///         pattern with primary dimension 0).
+    explicit CSRMatrixBuffer(const TensorLayout& tensor_layout);
+
+    /// Destructor
+    ~CSRMatrixBuffer();
+
+    /// Check whether a buffer can be created for matrix with given
+    /// layout (rank 2 with row-wise sparsity pattern)
+    static bool supported(const TensorLayout& tensor_layout);
+
+    /// Add block of values using local indices
+    void add_local(const double* block,
+                   const std::vector<ArrayView<const dolfin::la_index>>& rows);
+
+    /// Start sending values of rows owned by other processes to the
+    /// owning processes (collective, non-blocking)
+    void send_nonlocal_begin();
+
+    /// Complete sending values started by send_nonlocal_begin() and
+    /// add received values (collective)
+    void send_nonlocal_end();
+
+    /// Add accumulated values to matrix (using global indices) and
+    /// clear buffer. Note that the matrix must be finalized by
+    /// calling GenericMatrix::apply("add") afterwards.
+    void flush(GenericMatrix& A);
+
+  private:
+
+    // Insert locally owned rows into matrix in bulk if supported by
+    // the backend (returns false if not supported)
+    bool insert_owned_rows(GenericMatrix& A) const;
+
+    // Add values to locally owned row (local row index, global column
+    // indices)
+    void add_to_owned_row(std::size_t row, const dolfin::la_index* columns,
+                          std::size_t n, const double* values);
+
+    // MPI communicator
+    MPI_Comm _mpi_comm;
+
+    // End of ownership range of rows for each process
+    std::vector<std::size_t> _row_range_ends;
+
+    // Local-to-global maps for rows and columns
+    std::vector<dolfin::la_index> _row_map, _col_map;
+
+    // Number of locally owned rows and global index of first
+    // locally owned row
+    std::size_t _num_owned_rows, _row_offset;
+
+    // Locally owned rows in compressed row storage (global column
+    // indices, sorted by row)
+    std::vector<std::size_t> _offsets;
+    std::vector<dolfin::la_index> _columns;
+    std::vector<double> _values;
+
+    // Rows owned by other processes (global row indices, offsets into
+    // column and value arrays for each row)
+    std::vector<dolfin::la_index> _nonlocal_rows;
+    std::vector<std::size_t> _nonlocal_offsets;
+    std::vector<dolfin::la_index> _nonlocal_columns;
+    std::vector<double> _nonlocal_values;
+
+    // Work array for global column indices of a block
+    std::vector<dolfin::la_index> _block_columns;
+
+    // True if values are being sent by send_nonlocal_begin()
+    bool _sending;
+
+    // Send and receive buffers for each process (rows stored as
+    // global row index, number of entries and global column indices)
+    std::vector<std::vector<std::int64_t>> _send_indices, _recv_indices;
+    std::vector<std::vector<double>> _send_values, _recv_values;
+
+    #ifdef HAS_MPI
+    // Requests of non-blocking sends and receives
+    std::vector<MPI_Request> _requests;
+    #endif
+
+  };
+
+}
+
+#endif
@@ -242,6 +242,69 @@ double EigenVector::inner(const GenericVector& y) const
   return _x->dot(as_type<const EigenVector>(y).vec());
 }
 //-----------------------------------------------------------------------------
+void EigenVector::multi_inner(const std::vector<const GenericVector*>& y,
+                              std::vector<double>& values) const
+{
+  dolfin_assert(_x);
+  const std::size_t m = y.size();
+  const std::size_t n = size();
+  std::vector<const double*> _y(m);
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    dolfin_assert(y[i]);
+    const EigenVector& yi = as_type<const EigenVector>(*y[i]);
+    if (yi.size() != n)
+    {
+      dolfin_error("EigenVector.cpp",
+                   "compute inner products with Eigen vector",
+                   "Vectors are not of the same size");
+    }
+    _y[i] = yi.vec().data();
+  }
+
+  // Compute all inner products in one pass over this vector
+  values.assign(m, 0.0);
+  const double* x = _x->data();
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    const double xk = x[k];
+    for (std::size_t i = 0; i < m; ++i)
+      values[i] += xk*_y[i][k];
+  }
+}
+//-----------------------------------------------------------------------------
+void EigenVector::multi_axpy(const std::vector<double>& a,
+                             const std::vector<const GenericVector*>& y)
+{
+  dolfin_assert(_x);
+  dolfin_assert(a.size() == y.size());
+  const std::size_t m = y.size();
+  const std::size_t n = size();
+  std::vector<const double*> _y(m);
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    dolfin_assert(y[i]);
+    const EigenVector& yi = as_type<const EigenVector>(*y[i]);
+    if (yi.size() != n)
+    {
+      dolfin_error("EigenVector.cpp",
+                   "perform axpy operation with Eigen vector",
+                   "Vectors are not of the same size");
+    }
+    _y[i] = yi.vec().data();
+  }
+
+  // Add linear combination in one pass over this vector
+  double* x = _x->data();
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    double s = 0.0;
+    for (std::size_t i = 0; i < m; ++i)
+      s += a[i]*_y[i][k];
+    x[k] += s;
+  }
+}
+//-----------------------------------------------------------------------------
 const GenericVector& EigenVector::operator= (const GenericVector& v)
 {
   *this = as_type<const EigenVector>(v);
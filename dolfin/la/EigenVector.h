@@ -212,6 +212,14 @@ namespace dolfin
     /// Return inner product with given vector
     virtual double inner(const GenericVector& x) const;
 
+    /// Compute inner products with given vectors (single pass)
+    virtual void multi_inner(const std::vector<const GenericVector*>& y,
+                             std::vector<double>& values) const;
+
+    /// Add linear combination of given vectors (single pass)
+    virtual void multi_axpy(const std::vector<double>& a,
+                            const std::vector<const GenericVector*>& y);
+
     /// Compute norm of vector
     virtual double norm(std::string norm_type) const;
 
@@ -18,7 +18,7 @@
 // Modified by Mikael Mortensen 2011
 //
 // First added:  2010-02-23
-// Last changed: 2013-02-19
+// Last changed: 2015-06-12
 
 #include <dolfin/common/constants.h>
 #include <dolfin/common/Timer.h>
@@ -29,6 +29,24 @@
 
 using namespace dolfin;
 
+//-----------------------------------------------------------------------------
+void GenericMatrix::add_local_blocked(const double* block, std::size_t bs,
+                                      std::size_t m,
+                                      const dolfin::la_index* rows,
+                                      std::size_t n,
+                                      const dolfin::la_index* cols)
+{
+  // Expand block indices
+  std::vector<dolfin::la_index> _rows(m*bs), _cols(n*bs);
+  for (std::size_t i = 0; i < m; ++i)
+    for (std::size_t c = 0; c < bs; ++c)
+      _rows[i*bs + c] = rows[i]*bs + c;
+  for (std::size_t j = 0; j < n; ++j)
+    for (std::size_t c = 0; c < bs; ++c)
+      _cols[j*bs + c] = cols[j]*bs + c;
+
+  add_local(block, _rows.size(), _rows.data(), _cols.size(), _cols.data());
+}
 //-----------------------------------------------------------------------------
 void GenericMatrix::ident_zeros()
 {
@@ -23,7 +23,7 @@
 // Modified by Mikael Mortensen 2011
 //
 // First added:  2006-04-24
-// Last changed: 2012-08-20
+// Last changed: 2015-06-12
 
 #ifndef __GENERIC_MATRIX_H
 #define __GENERIC_MATRIX_H
@@ -157,6 +157,23 @@ namespace dolfin
                            std::size_t m, const dolfin::la_index* rows,
                            std::size_t n, const dolfin::la_index* cols) = 0;
 
+    /// Return block size of matrix (1 if the matrix does not support
+    /// insertion of blocks of values using block indices)
+    virtual std::size_t block_size() const
+    { return 1; }
+
+    /// Add block of values using local block indices. Block row i
+    /// (column j) covers the rows rows[i]*bs, ..., rows[i]*bs + bs - 1,
+    /// where bs is the block size, and the values are stored row-wise
+    /// for the (m*bs) x (n*bs) rows and columns in this order. The
+    /// default implementation expands the block indices and calls
+    /// add_local.
+    virtual void add_local_blocked(const double* block, std::size_t bs,
+                                   std::size_t m,
+                                   const dolfin::la_index* rows,
+                                   std::size_t n,
+                                   const dolfin::la_index* cols);
+
     /// Add multiple of given matrix (AXPY operation)
     virtual void axpy(double a, const GenericMatrix& A,
                       bool same_nonzero_pattern) = 0;
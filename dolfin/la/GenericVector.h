@@ -22,7 +22,7 @@
 // Modified by Johan Hake 2009-2010
 //
 // First added:  2006-04-25
-// Last changed: 2011-11-11
+// Last changed: 2015-06-12
 
 #ifndef __GENERIC_VECTOR_H
 #define __GENERIC_VECTOR_H
@@ -130,6 +130,17 @@ namespace dolfin
 
     //--- Vector interface ---
 
+    /// Start update of ghost values (if any) from the processes
+    /// owning them, such that the communication may overlap with
+    /// computation. The update must be completed by calling
+    /// update_ghost_values_end() before the vector is accessed or
+    /// modified. Does nothing for vectors without ghost values.
+    virtual void update_ghost_values_begin() const {}
+
+    /// Complete update of ghost values started by
+    /// update_ghost_values_begin()
+    virtual void update_ghost_values_end() const {}
+
     /// Return copy of vector
     virtual std::shared_ptr<GenericVector> copy() const = 0;
 
@@ -214,6 +225,33 @@ namespace dolfin
     /// Return inner product with given vector
     virtual double inner(const GenericVector& x) const = 0;
 
+    /// Compute inner products with given vectors, values[i] = (this,
+    /// y[i]). Backends may compute all inner products in a single
+    /// pass over the vectors with a single global reduction.
+    virtual void multi_inner(const std::vector<const GenericVector*>& y,
+                             std::vector<double>& values) const
+    {
+      values.resize(y.size());
+      for (std::size_t i = 0; i < y.size(); ++i)
+      {
+        dolfin_assert(y[i]);
+        values[i] = inner(*y[i]);
+      }
+    }
+
+    /// Add linear combination of given vectors (this += sum_i a[i]
+    /// y[i]). Backends may update this vector in a single pass.
+    virtual void multi_axpy(const std::vector<double>& a,
+                            const std::vector<const GenericVector*>& y)
+    {
+      dolfin_assert(a.size() == y.size());
+      for (std::size_t i = 0; i < y.size(); ++i)
+      {
+        dolfin_assert(y[i]);
+        axpy(a[i], *y[i]);
+      }
+    }
+
     /// Return norm of vector
     virtual double norm(std::string norm_type) const = 0;
 
@@ -20,7 +20,7 @@
 // Modified by Martin Sandve Alnes, 2008.
 //
 // First added:  2006-05-15
-// Last changed: 2009-09-08
+// Last changed: 2015-06-12
 
 #ifndef __MATRIX_H
 #define __MATRIX_H
@@ -143,6 +143,18 @@ namespace dolfin
                            std::size_t n, const dolfin::la_index* cols)
     { matrix->add_local(block, m, rows, n, cols); }
 
+    /// Return block size of matrix
+    virtual std::size_t block_size() const
+    { return matrix->block_size(); }
+
+    /// Add block of values using local block indices
+    virtual void add_local_blocked(const double* block, std::size_t bs,
+                                   std::size_t m,
+                                   const dolfin::la_index* rows,
+                                   std::size_t n,
+                                   const dolfin::la_index* cols)
+    { matrix->add_local_blocked(block, bs, m, rows, n, cols); }
+
     /// Add multiple of given matrix (AXPY operation)
     virtual void axpy(double a, const GenericMatrix& A,
                       bool same_nonzero_pattern)
@@ -25,6 +25,7 @@
 
 #ifdef HAS_PETSC
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -32,6 +33,7 @@
 #include <dolfin/log/log.h>
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/MPI.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "PETScVector.h"
 #include "PETScMatrix.h"
 #include "GenericSparsityPattern.h"
@@ -47,6 +49,33 @@ const std::map<std::string, NormType> PETScMatrix::norm_types
     {"linf",      NORM_INFINITY},
     {"frobenius", NORM_FROBENIUS} };
 
+namespace
+{
+  // Compute number of nonzero blocks per block row from sparsity
+  // pattern (bs consecutive rows form a block row, and bs consecutive
+  // columns a block column)
+  std::vector<PetscInt>
+  block_nonzeros(const std::vector<std::vector<std::size_t>>& pattern,
+                 std::size_t bs)
+  {
+    std::vector<PetscInt> num_blocks(pattern.size()/bs, 0);
+    std::vector<std::size_t> block_columns;
+    for (std::size_t i = 0; i < num_blocks.size(); ++i)
+    {
+      block_columns.clear();
+      for (std::size_t j = i*bs; j < (i + 1)*bs; ++j)
+      {
+        for (std::size_t k = 0; k < pattern[j].size(); ++k)
+          block_columns.push_back(pattern[j][k]/bs);
+      }
+      std::sort(block_columns.begin(), block_columns.end());
+      num_blocks[i] = std::unique(block_columns.begin(), block_columns.end())
+        - block_columns.begin();
+    }
+    return num_blocks;
+  }
+}
+
 //-----------------------------------------------------------------------------
 PETScMatrix::PETScMatrix(bool use_gpu) : PETScBaseMatrix(NULL),
                                          _use_gpu(use_gpu)
@@ -116,6 +145,17 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
     MatDestroy(&_matA);
   }
 
+  // Use block (BAIJ) storage if requested and block size > 1. Block
+  // storage requires a blocked local-to-global map, which is used for
+  // PETSc > 3.4 only.
+  bool use_block_storage = false;
+  #if PETSC_VERSION_MAJOR == 3 && PETSC_VERSION_MINOR > 4
+  const bool use_block_matrices
+    = dolfin::parameters["use_petsc_block_matrices"];
+  use_block_storage = use_block_matrices && tensor_layout.block_size > 1
+    && !_use_gpu;
+  #endif
+
   // Initialize matrix
   if (dolfin::MPI::size(sparsity_pattern.mpi_comm()) == 1)
   {
@@ -132,7 +172,12 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
     if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetSizes");
 
     // Set matrix type according to chosen architecture
-    if (!_use_gpu)
+    if (use_block_storage)
+    {
+      ierr = MatSetType(_matA, MATSEQBAIJ);
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetType");
+    }
+    else if (!_use_gpu)
     {
       ierr = MatSetType(_matA, MATSEQAIJ);
       if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetType");
@@ -156,11 +201,24 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
 
     // Allocate space (using data from sparsity pattern)
 
-    // Copy number of non-zeros to PetscInt type
-    const std::vector<PetscInt> _num_nonzeros(num_nonzeros.begin(),
-                                              num_nonzeros.end());
-    ierr = MatSeqAIJSetPreallocation(_matA, 0, _num_nonzeros.data());
-    if (ierr != 0) petsc_error(ierr, __FILE__, "MatSeqAIJSetPreallocation");
+    if (use_block_storage)
+    {
+      // Number of non-zero blocks per block row
+      const std::size_t bs = tensor_layout.block_size;
+      const std::vector<PetscInt> _num_nonzeros
+        = block_nonzeros(sparsity_pattern.diagonal_pattern(
+                           GenericSparsityPattern::unsorted), bs);
+      ierr = MatSeqBAIJSetPreallocation(_matA, bs, 0, _num_nonzeros.data());
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatSeqBAIJSetPreallocation");
+    }
+    else
+    {
+      // Copy number of non-zeros to PetscInt type
+      const std::vector<PetscInt> _num_nonzeros(num_nonzeros.begin(),
+                                                num_nonzeros.end());
+      ierr = MatSeqAIJSetPreallocation(_matA, 0, _num_nonzeros.data());
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatSeqAIJSetPreallocation");
+    }
 
     ISLocalToGlobalMapping petsc_local_to_global0, petsc_local_to_global1;
     dolfin_assert(tensor_layout.local_to_global_map.size() == 2);
@@ -236,7 +294,7 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
     if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetSizes");
 
     // Set matrix type
-    ierr = MatSetType(_matA, MATMPIAIJ);
+    ierr = MatSetType(_matA, use_block_storage ? MATMPIBAIJ : MATMPIAIJ);
     if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetType");
 
     // Set block size
@@ -246,15 +304,33 @@ void PETScMatrix::init(const TensorLayout& tensor_layout)
       if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetBlockSize");
     }
     // Allocate space (using data from sparsity pattern)
-    const std::vector<PetscInt>
-      _num_nonzeros_diagonal(num_nonzeros_diagonal.begin(),
-                             num_nonzeros_diagonal.end());
-    const std::vector<PetscInt>
-      _num_nonzeros_off_diagonal(num_nonzeros_off_diagonal.begin(),
-                                 num_nonzeros_off_diagonal.end());
-    ierr = MatMPIAIJSetPreallocation(_matA, 0, _num_nonzeros_diagonal.data(),
-                                     0, _num_nonzeros_off_diagonal.data());
-    if (ierr != 0) petsc_error(ierr, __FILE__, "MatMPIAIJSetPreallocation");
+    if (use_block_storage)
+    {
+      // Number of non-zero blocks per block row
+      const std::size_t bs = tensor_layout.block_size;
+      const std::vector<PetscInt> _num_nonzeros_diagonal
+        = block_nonzeros(sparsity_pattern.diagonal_pattern(
+                           GenericSparsityPattern::unsorted), bs);
+      const std::vector<PetscInt> _num_nonzeros_off_diagonal
+        = block_nonzeros(sparsity_pattern.off_diagonal_pattern(
+                           GenericSparsityPattern::unsorted), bs);
+      ierr = MatMPIBAIJSetPreallocation(_matA, bs,
+                                        0, _num_nonzeros_diagonal.data(),
+                                        0, _num_nonzeros_off_diagonal.data());
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatMPIBAIJSetPreallocation");
+    }
+    else
+    {
+      const std::vector<PetscInt>
+        _num_nonzeros_diagonal(num_nonzeros_diagonal.begin(),
+                               num_nonzeros_diagonal.end());
+      const std::vector<PetscInt>
+        _num_nonzeros_off_diagonal(num_nonzeros_off_diagonal.begin(),
+                                   num_nonzeros_off_diagonal.end());
+      ierr = MatMPIAIJSetPreallocation(_matA, 0, _num_nonzeros_diagonal.data(),
+                                       0, _num_nonzeros_off_diagonal.data());
+      if (ierr != 0) petsc_error(ierr, __FILE__, "MatMPIAIJSetPreallocation");
+    }
 
 
     ISLocalToGlobalMapping petsc_local_to_global0, petsc_local_to_global1;
@@ -365,6 +441,36 @@ void PETScMatrix::add_local(const double* block,
   if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetValuesLocal");
 }
 //-----------------------------------------------------------------------------
+std::size_t PETScMatrix::block_size() const
+{
+  dolfin_assert(_matA);
+  PetscInt bs = 1;
+  PetscErrorCode ierr = MatGetBlockSize(_matA, &bs);
+  if (ierr != 0) petsc_error(ierr, __FILE__, "MatGetBlockSize");
+  return bs;
+}
+//-----------------------------------------------------------------------------
+void PETScMatrix::add_local_blocked(const double* block, std::size_t bs,
+                                    std::size_t m,
+                                    const dolfin::la_index* rows,
+                                    std::size_t n,
+                                    const dolfin::la_index* cols)
+{
+  // The local-to-global map is blocked for PETSc > 3.4 only
+  #if PETSC_VERSION_MAJOR == 3 && PETSC_VERSION_MINOR > 4
+  if (bs == block_size())
+  {
+    dolfin_assert(_matA);
+    PetscErrorCode ierr = MatSetValuesBlockedLocal(_matA, m, rows, n, cols,
+                                                   block, ADD_VALUES);
+    if (ierr != 0) petsc_error(ierr, __FILE__, "MatSetValuesBlockedLocal");
+    return;
+  }
+  #endif
+
+  GenericMatrix::add_local_blocked(block, bs, m, rows, n, cols);
+}
+//-----------------------------------------------------------------------------
 void PETScMatrix::axpy(double a, const GenericMatrix& A,
                        bool same_nonzero_pattern)
 {
@@ -22,7 +22,7 @@
 // Modified by Fredrik Valdmanis 2011
 //
 // First added:  2004-01-01
-// Last changed: 2012-08-22
+// Last changed: 2015-06-12
 
 #ifndef __PETSC_MATRIX_H
 #define __PETSC_MATRIX_H
@@ -144,6 +144,16 @@ namespace dolfin
                            std::size_t m, const dolfin::la_index* rows,
                            std::size_t n, const dolfin::la_index* cols);
 
+    /// Return block size of matrix
+    virtual std::size_t block_size() const;
+
+    /// Add block of values using local block indices
+    virtual void add_local_blocked(const double* block, std::size_t bs,
+                                   std::size_t m,
+                                   const dolfin::la_index* rows,
+                                   std::size_t n,
+                                   const dolfin::la_index* cols);
+
     /// Add multiple of given matrix (AXPY operation)
     virtual void axpy(double a, const GenericMatrix& A,
                       bool same_nonzero_pattern);
@@ -21,7 +21,7 @@
 // Modified by Fredrik Valdmanis 2011-2012
 //
 // First added:  2004
-// Last changed: 2012-08-22
+// Last changed: 2015-06-12
 
 #ifdef HAS_PETSC
 
@@ -44,7 +44,8 @@ const std::map<std::string, NormType> PETScVector::norm_types
 = { {"l1",   NORM_1}, {"l2",   NORM_2},  {"linf", NORM_INFINITY} };
 
 //-----------------------------------------------------------------------------
-PETScVector::PETScVector() : _x(NULL), _use_gpu(false)
+PETScVector::PETScVector() : _x(NULL), _ghost_update_started(false),
+  _ghost_update_pending(false), _use_gpu(false)
 {
 #ifndef HAS_PETSC_CUSP
   if (_use_gpu)
@@ -57,7 +58,8 @@ PETScVector::PETScVector() : _x(NULL), _use_gpu(false)
 }
 //-----------------------------------------------------------------------------
 PETScVector::PETScVector(MPI_Comm comm, std::size_t N, bool use_gpu)
-  : _x(NULL), _use_gpu(use_gpu)
+  : _x(NULL), _ghost_update_started(false), _ghost_update_pending(false),
+    _use_gpu(use_gpu)
 {
   #ifndef HAS_PETSC_CUSP
   if (_use_gpu)
@@ -78,7 +80,8 @@ PETScVector::PETScVector(MPI_Comm comm, std::size_t N, bool use_gpu)
 }
 //-----------------------------------------------------------------------------
 PETScVector::PETScVector(const GenericSparsityPattern& sparsity_pattern)
-  : _x(NULL), _use_gpu(false)
+  : _x(NULL), _ghost_update_started(false), _ghost_update_pending(false),
+    _use_gpu(false)
 {
   std::vector<la_index> ghost_indices;
   std::vector<std::size_t> local_to_global_map;
@@ -86,13 +89,16 @@ PETScVector::PETScVector(const GenericSparsityPattern& sparsity_pattern)
         local_to_global_map, ghost_indices);
 }
 //-----------------------------------------------------------------------------
-PETScVector::PETScVector(Vec x): _x(x), _use_gpu(false)
+PETScVector::PETScVector(Vec x) : _x(x), _ghost_update_started(false),
+  _ghost_update_pending(false), _use_gpu(false)
 {
   // Increase reference count
   PetscObjectReference((PetscObject)_x);
 }
 //-----------------------------------------------------------------------------
-PETScVector::PETScVector(const PETScVector& v) : _x(NULL), _use_gpu(false)
+PETScVector::PETScVector(const PETScVector& v)
+  : _x(NULL), _ghost_update_started(false), _ghost_update_pending(false),
+    _use_gpu(false)
 {
   PetscErrorCode ierr;
 
@@ -107,14 +113,19 @@ PETScVector::PETScVector(const PETScVector& v) : _x(NULL), _use_gpu(false)
   // Copy ghost data
   ghost_global_to_local = v.ghost_global_to_local;
 
-  // Update ghost values
-  update_ghost_values();
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
 }
 //-----------------------------------------------------------------------------
 PETScVector::~PETScVector()
 {
   if (_x)
+  {
+    // Complete pending update of ghost values (local operation)
+    if (_ghost_update_pending)
+      VecGhostUpdateEnd(_x, INSERT_VALUES, SCATTER_FORWARD);
     VecDestroy(&_x);
+  }
 }
 //-----------------------------------------------------------------------------
 bool PETScVector::distributed() const
@@ -262,6 +273,23 @@ void PETScVector::get_local(double* block, std::size_t m,
   dolfin_assert(_x);
   PetscErrorCode ierr;
 
+  // Complete pending update of ghost values only if ghost values are
+  // requested, such that owned values can be read during the update
+  if (_ghost_update_pending)
+  {
+    PetscInt local_size = 0;
+    ierr = VecGetLocalSize(_x, &local_size);
+    if (ierr != 0) petsc_error(ierr, __FILE__, "VecGetLocalSize");
+    for (std::size_t i = 0; i < m; ++i)
+    {
+      if (rows[i] >= local_size)
+      {
+        update_ghost_values_end();
+        break;
+      }
+    }
+  }
+
   Vec xg;
   ierr = VecGhostGetLocalForm(_x, &xg);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostGetLocalForm");
@@ -354,8 +382,8 @@ void PETScVector::apply(std::string mode)
   ierr = VecAssemblyEnd(_x);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecAssemblyEnd");
 
-  // Update any ghost values
-  update_ghost_values();
+  // Start update of any ghost values (completed when accessed)
+  start_ghost_update();
 }
 //-----------------------------------------------------------------------------
 MPI_Comm PETScVector::mpi_comm() const
@@ -454,8 +482,8 @@ const PETScVector& PETScVector::operator= (const PETScVector& v)
     PetscErrorCode ierr = VecCopy(v._x, _x);
     if (ierr != 0) petsc_error(ierr, __FILE__, "VecCopy");
 
-    // Update ghost values
-    update_ghost_values();
+    // Start update of ghost values (completed when accessed)
+    start_ghost_update();
   }
   return *this;
 }
@@ -470,31 +498,70 @@ const PETScVector& PETScVector::operator= (double a)
 }
 //-----------------------------------------------------------------------------
 void PETScVector::update_ghost_values()
+{
+  start_ghost_update();
+  update_ghost_values_end();
+}
+//-----------------------------------------------------------------------------
+void PETScVector::update_ghost_values_begin() const
+{
+  // Nothing to do if an update has been started before, since all
+  // collective operations modifying the vector start an update (the
+  // decision is local, but the same on all processes)
+  if (_ghost_update_started || !ghosted())
+    return;
+
+  start_ghost_update();
+}
+//-----------------------------------------------------------------------------
+void PETScVector::update_ghost_values_end() const
+{
+  if (!_ghost_update_pending)
+    return;
+
+  PetscErrorCode ierr = VecGhostUpdateEnd(_x, INSERT_VALUES, SCATTER_FORWARD);
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostUpdateEnd");
+  _ghost_update_pending = false;
+}
+//-----------------------------------------------------------------------------
+bool PETScVector::ghost_update_pending() const
+{
+  return _ghost_update_pending;
+}
+//-----------------------------------------------------------------------------
+void PETScVector::start_ghost_update() const
+{
+  if (!ghosted())
+    return;
+
+  // Complete previous update (if any) before starting a new one
+  update_ghost_values_end();
+
+  PetscErrorCode ierr = VecGhostUpdateBegin(_x, INSERT_VALUES,
+                                            SCATTER_FORWARD);
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostUpdateBegin");
+  _ghost_update_pending = true;
+  _ghost_update_started = true;
+}
+//-----------------------------------------------------------------------------
+bool PETScVector::ghosted() const
 {
   dolfin_assert(_x);
-  PetscErrorCode ierr;
 
   #if PETSC_VERSION_MAJOR == 3 && PETSC_VERSION_MINOR <= 3
-  if (dolfin::MPI::size(mpi_comm()) > 1)
+  if (dolfin::MPI::size(mpi_comm()) == 1)
+    return false;
   #endif
-  {
-    // Check of vector is ghosted
-    Vec xg;
-    ierr = VecGhostGetLocalForm(_x, &xg);
-    if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostGetLocalForm");
 
-    // If ghosted, update
-    if (xg)
-    {
-      ierr = VecGhostUpdateBegin(_x, INSERT_VALUES, SCATTER_FORWARD);
-      if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostUpdateBegin");
-      ierr = VecGhostUpdateEnd(_x, INSERT_VALUES, SCATTER_FORWARD);
-      if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostUpdateEnd");
-    }
+  // Check if vector is ghosted
+  Vec xg;
+  PetscErrorCode ierr = VecGhostGetLocalForm(_x, &xg);
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostGetLocalForm");
+  const bool is_ghosted = xg ? true : false;
+  ierr = VecGhostRestoreLocalForm(_x, &xg);
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostRestoreLocalForm");
 
-    ierr = VecGhostRestoreLocalForm(_x, &xg);
-    if (ierr != 0) petsc_error(ierr, __FILE__, "VecGhostRestoreLocalForm");
-  }
+  return is_ghosted;
 }
 //-----------------------------------------------------------------------------
 const PETScVector& PETScVector::operator+= (const GenericVector& x)
@@ -509,8 +576,8 @@ const PETScVector& PETScVector::operator+= (double a)
   PetscErrorCode ierr = VecShift(_x, a);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecShift");
 
-  // Update any ghost values
-  update_ghost_values();
+  // Start update of any ghost values (completed when accessed)
+  start_ghost_update();
 
   return *this;
 }
@@ -534,8 +601,8 @@ const PETScVector& PETScVector::operator*= (const double a)
   PetscErrorCode ierr = VecScale(_x, a);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecScale");
 
-  // Update ghost values
-  update_ghost_values();
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
 
   return *this;
 }
@@ -555,8 +622,8 @@ const PETScVector& PETScVector::operator*= (const GenericVector& y)
   PetscErrorCode ierr = VecPointwiseMult(_x, _x, v._x);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecPointwiseMult");
 
-  // Update ghost values
-  update_ghost_values();
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
 
   return *this;
 }
@@ -597,8 +664,59 @@ void PETScVector::axpy(double a, const GenericVector& y)
   PetscErrorCode ierr = VecAXPY(_x, a, _y._x);
   if (ierr != 0) petsc_error(ierr, __FILE__, "VecAXPY");
 
-  // Update ghost values
-  update_ghost_values();
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
+}
+//-----------------------------------------------------------------------------
+void PETScVector::multi_inner(const std::vector<const GenericVector*>& y,
+                              std::vector<double>& values) const
+{
+  dolfin_assert(_x);
+  std::vector<Vec> _y(y.size());
+  for (std::size_t i = 0; i < y.size(); ++i)
+  {
+    dolfin_assert(y[i]);
+    _y[i] = as_type<const PETScVector>(*y[i])._x;
+    dolfin_assert(_y[i]);
+  }
+
+  values.resize(y.size());
+  if (y.empty())
+    return;
+
+  // Inner products with a single reduction
+  PetscErrorCode ierr = VecMDot(_x, _y.size(), _y.data(), values.data());
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecMDot");
+}
+//-----------------------------------------------------------------------------
+void PETScVector::multi_axpy(const std::vector<double>& a,
+                             const std::vector<const GenericVector*>& y)
+{
+  dolfin_assert(_x);
+  dolfin_assert(a.size() == y.size());
+  std::vector<Vec> _y(y.size());
+  for (std::size_t i = 0; i < y.size(); ++i)
+  {
+    dolfin_assert(y[i]);
+    const PETScVector& yi = as_type<const PETScVector>(*y[i]);
+    dolfin_assert(yi._x);
+    if (size() != yi.size())
+    {
+      dolfin_error("PETScVector.cpp",
+                   "perform axpy operation with PETSc vector",
+                   "Vectors are not of the same size");
+    }
+    _y[i] = yi._x;
+  }
+
+  if (y.empty())
+    return;
+
+  PetscErrorCode ierr = VecMAXPY(_x, _y.size(), a.data(), _y.data());
+  if (ierr != 0) petsc_error(ierr, __FILE__, "VecMAXPY");
+
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
 }
 //-----------------------------------------------------------------------------
 void PETScVector::abs()
@@ -606,8 +724,8 @@ void PETScVector::abs()
   dolfin_assert(_x);
   VecAbs(_x);
 
-  // Update ghost values
-  update_ghost_values();
+  // Start update of ghost values (completed when accessed)
+  start_ghost_update();
 }
 //-----------------------------------------------------------------------------
 double PETScVector::norm(std::string norm_type) const
@@ -918,6 +1036,9 @@ void PETScVector::_init(MPI_Comm comm,
 //-----------------------------------------------------------------------------
 Vec PETScVector::vec() const
 {
+  // Complete pending update of ghost values (if any), since the Vec
+  // may be accessed directly
+  update_ghost_values_end();
   return _x;
 }
 //-----------------------------------------------------------------------------
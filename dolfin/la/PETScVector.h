@@ -22,7 +22,7 @@
 // Modified by Fredrik Valdmanis, 2011.
 //
 // First added:  2004-01-01
-// Last changed: 2011-09-29
+// Last changed: 2015-06-12
 
 #ifndef __PETSC_VECTOR_H
 #define __PETSC_VECTOR_H
@@ -183,6 +183,14 @@ namespace dolfin
     /// Return inner product with given vector
     virtual double inner(const GenericVector& v) const;
 
+    /// Compute inner products with given vectors (VecMDot)
+    virtual void multi_inner(const std::vector<const GenericVector*>& y,
+                             std::vector<double>& values) const;
+
+    /// Add linear combination of given vectors (VecMAXPY)
+    virtual void multi_axpy(const std::vector<double>& a,
+                            const std::vector<const GenericVector*>& y);
+
     /// Return norm of vector
     virtual double norm(std::string norm_type) const;
 
@@ -225,8 +233,21 @@ namespace dolfin
     /// Assignment operator
     virtual const PETScVector& operator= (double a);
 
+    /// Update ghost values from the processes owning them
     virtual void update_ghost_values();
 
+    /// Start update of ghost values (non-blocking). Functions
+    /// modifying the vector collectively (e.g. apply and axpy) start
+    /// an update of the ghost values, which is completed when the
+    /// ghost values are accessed, so this function does nothing
+    /// unless no update has been started before. Use
+    /// update_ghost_values() if the vector has been modified
+    /// otherwise.
+    virtual void update_ghost_values_begin() const;
+
+    /// Complete update of ghost values (if started)
+    virtual void update_ghost_values_end() const;
+
     //--- Special functions ---
 
     /// Return linear algebra backend factory
@@ -237,6 +258,10 @@ namespace dolfin
     /// Return pointer to PETSc Vec object
     Vec vec() const;
 
+    /// Return true if an update of ghost values has been started but
+    /// not completed
+    bool ghost_update_pending() const;
+
     /// Assignment operator
     const PETScVector& operator= (const PETScVector& x);
 
@@ -253,12 +278,27 @@ namespace dolfin
     // Return true if vector is distributed
     bool distributed() const;
 
+    // Start update of ghost values (if any) unconditionally,
+    // completing previous update first (collective)
+    void start_ghost_update() const;
+
+    // Return true if vector has ghost values
+    bool ghosted() const;
+
     // PETSc Vec pointer
     Vec _x;
 
     // Global-to-local map for ghost values
     std::unordered_map<std::size_t, std::size_t> ghost_global_to_local;
 
+    // True if an update of ghost values has been started since the
+    // vector was created
+    mutable bool _ghost_update_started;
+
+    // True if an update of ghost values has been started but not
+    // completed
+    mutable bool _ghost_update_pending;
+
     // PETSc norm types
     static const std::map<std::string, NormType> norm_types;
 
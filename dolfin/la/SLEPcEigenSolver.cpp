@@ -22,7 +22,10 @@
 
 #ifdef HAS_SLEPC
 
+#include <algorithm>
+#include <cmath>
 #include <slepcversion.h>
+#include <dolfin/common/constants.h>
 #include <dolfin/log/log.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/NoDeleter.h>
@@ -32,9 +35,28 @@
 
 using namespace dolfin;
 
+namespace
+{
+  // Return PETSc object state of matrix (increased by PETSc when the
+  // matrix is modified)
+  std::int64_t object_state(Mat A)
+  {
+    #if PETSC_VERSION_MAJOR == 3 && PETSC_VERSION_MINOR <= 4
+    PetscInt state = 0;
+    PetscObjectStateQuery((PetscObject) A, &state);
+    #else
+    PetscObjectState state = 0;
+    PetscObjectStateGet((PetscObject) A, &state);
+    #endif
+    return state;
+  }
+}
+
 //-----------------------------------------------------------------------------
 SLEPcEigenSolver::SLEPcEigenSolver(const PETScMatrix& A)
-  : _matA(reference_to_no_delete_pointer(const_cast<PETScMatrix&>(A)))
+  : _matA(reference_to_no_delete_pointer(const_cast<PETScMatrix&>(A))),
+    _eps_A(NULL), _eps_B(NULL), _eps_A_state(0), _eps_B_state(0),
+    _multishift(false)
 {
   dolfin_assert(A.size(0) == A.size(1));
 
@@ -46,7 +68,9 @@ SLEPcEigenSolver::SLEPcEigenSolver(const PETScMatrix& A)
 }
 //-----------------------------------------------------------------------------
 SLEPcEigenSolver::SLEPcEigenSolver(const PETScMatrix& A, const PETScMatrix& B)
-  : _matA(reference_to_no_delete_pointer(A)), _matB(reference_to_no_delete_pointer(B))
+  : _matA(reference_to_no_delete_pointer(A)), _matB(reference_to_no_delete_pointer(B)),
+    _eps_A(NULL), _eps_B(NULL), _eps_A_state(0), _eps_B_state(0),
+    _multishift(false)
 {
   dolfin_assert(A.size(0) == A.size(1));
   dolfin_assert(B.size(0) == A.size(0));
@@ -60,7 +84,9 @@ SLEPcEigenSolver::SLEPcEigenSolver(const PETScMatrix& A, const PETScMatrix& B)
 }
 //-----------------------------------------------------------------------------
 SLEPcEigenSolver::SLEPcEigenSolver(std::shared_ptr<const PETScMatrix> A)
-  : _matA(A)
+  : _matA(A),
+    _eps_A(NULL), _eps_B(NULL), _eps_A_state(0), _eps_B_state(0),
+    _multishift(false)
 {
   dolfin_assert(A->size(0) == A->size(1));
 
@@ -73,8 +99,9 @@ SLEPcEigenSolver::SLEPcEigenSolver(std::shared_ptr<const PETScMatrix> A)
 //-----------------------------------------------------------------------------
 SLEPcEigenSolver::SLEPcEigenSolver(std::shared_ptr<const PETScMatrix> A,
                                    std::shared_ptr<const PETScMatrix> B)
-  : _matA(A), _matB(B)
-
+  : _matA(A), _matB(B),
+    _eps_A(NULL), _eps_B(NULL), _eps_A_state(0), _eps_B_state(0),
+    _multishift(false)
 {
   dolfin_assert(A->size(0) == A->size(1));
   dolfin_assert(B->size(0) == A->size(0));
@@ -100,26 +127,163 @@ void SLEPcEigenSolver::solve()
 }
 //-----------------------------------------------------------------------------
 void SLEPcEigenSolver::solve(std::size_t n)
+{
+  // Clear eigenpairs of multi-shift solve
+  _multishift = false;
+  _eigenvalues.clear();
+  _eigenvectors_r.clear();
+  _eigenvectors_c.clear();
+
+  solve_eps(n, NULL, parameters["warm_start"]);
+}
+//-----------------------------------------------------------------------------
+void SLEPcEigenSolver::solve(std::size_t n, const std::vector<double>& shifts)
 {
   dolfin_assert(_matA);
 
-  // Associate matrix (matrices) with eigenvalue solver
+  // Clear eigenpairs of previous solve
+  _multishift = true;
+  _eigenvalues.clear();
+  _eigenvectors_r.clear();
+  _eigenvectors_c.clear();
+
+  // Eigenvectors of previous shifts are deflated for Hermitian
+  // problems
+  const std::string problem_type = parameters["problem_type"];
+  const bool deflate = (problem_type == "hermitian"
+                        || problem_type == "gen_hermitian");
+  std::vector<Vec> deflation_space;
+
+  // Warm start is only used for the first shift if eigenvectors are
+  // deflated
+  const bool warm_start = parameters["warm_start"];
+
+  for (std::size_t k = 0; k < shifts.size(); ++k)
+  {
+    EPSSetDeflationSpace(_eps, deflation_space.size(),
+                         deflation_space.data());
+    solve_eps(n, &shifts[k], warm_start && (k == 0 || !deflate));
+
+    // Collect converged eigenpairs not found for previous shifts
+    dolfin::la_index num_computed_eigenvalues;
+    EPSGetConverged(_eps, &num_computed_eigenvalues);
+    for (dolfin::la_index i = 0; i < num_computed_eigenvalues; ++i)
+    {
+      double lr, lc;
+      EPSGetEigenvalue(_eps, i, &lr, &lc);
+
+      bool found = false;
+      for (std::size_t j = 0; j < _eigenvalues.size(); ++j)
+      {
+        const double scale = std::max(1.0, std::abs(lr) + std::abs(lc));
+        if (std::abs(lr - _eigenvalues[j].first) < DOLFIN_SQRT_EPS*scale
+            && std::abs(lc - _eigenvalues[j].second) < DOLFIN_SQRT_EPS*scale)
+        {
+          found = true;
+          break;
+        }
+      }
+      if (found)
+        continue;
+
+      std::shared_ptr<PETScVector> r(new PETScVector);
+      std::shared_ptr<PETScVector> c(new PETScVector);
+      _matA->init_vector(*r, 0);
+      _matA->init_vector(*c, 0);
+      EPSGetEigenpair(_eps, i, &lr, &lc, r->vec(), c->vec());
+
+      _eigenvalues.push_back(std::make_pair(lr, lc));
+      _eigenvectors_r.push_back(r);
+      _eigenvectors_c.push_back(c);
+      if (deflate)
+        deflation_space.push_back(r->vec());
+    }
+  }
+
+  // Remove deflation space
+  EPSSetDeflationSpace(_eps, 0, NULL);
+}
+//-----------------------------------------------------------------------------
+void SLEPcEigenSolver::solve_eps(std::size_t n, const double* shift,
+                                 bool warm_start)
+{
+  dolfin_assert(_matA);
   dolfin_assert(_matA->size(0) == _matA->size(1));
+  Mat B = NULL;
   if (_matB)
   {
     dolfin_assert(_matB->size(0) == _matB->size(1)
                   && _matB->size(0) == _matA->size(0));
-    EPSSetOperators(_eps, _matA->mat(), _matB->mat());
+    B = _matB->mat();
+  }
+
+  // Extract eigenvectors of previous solve to be used as initial
+  // space. This must be done before the operators are passed again,
+  // since EPSSetOperators resets the solver and discards them.
+  std::vector<PETScVector> initial_space;
+  if (warm_start && _eps_A)
+  {
+    PetscInt M0 = 0, N0 = 0;
+    MatGetSize(_eps_A, &M0, &N0);
+    if ((std::size_t) M0 == _matA->size(0))
+    {
+      dolfin::la_index num_computed_eigenvalues = 0;
+      EPSGetConverged(_eps, &num_computed_eigenvalues);
+      const std::size_t num_vectors
+        = std::min((std::size_t) num_computed_eigenvalues, n);
+
+      PETScVector c;
+      _matA->init_vector(c, 0);
+      initial_space.resize(num_vectors);
+      for (std::size_t i = 0; i < num_vectors; ++i)
+      {
+        _matA->init_vector(initial_space[i], 0);
+        EPSGetEigenvector(_eps, i, initial_space[i].vec(), c.vec());
+      }
+    }
+  }
+
+  // Associate matrix (matrices) with eigenvalue solver. This resets
+  // the spectral transform, so it is only done if the matrices have
+  // changed since the previous solve.
+  const std::int64_t A_state = object_state(_matA->mat());
+  const std::int64_t B_state = B ? object_state(B) : 0;
+  if (_matA->mat() != _eps_A || B != _eps_B
+      || A_state != _eps_A_state || B_state != _eps_B_state)
+  {
+    EPSSetOperators(_eps, _matA->mat(), B);
+    _eps_A = _matA->mat();
+    _eps_B = B;
+    _eps_A_state = A_state;
+    _eps_B_state = B_state;
+  }
+
+  // Use eigenvectors of previous solve as initial space
+  if (!initial_space.empty())
+  {
+    std::vector<Vec> vecs(initial_space.size());
+    for (std::size_t i = 0; i < initial_space.size(); ++i)
+      vecs[i] = initial_space[i].vec();
+    EPSSetInitialSpace(_eps, vecs.size(), vecs.data());
   }
-  else
-    EPSSetOperators(_eps, _matA->mat(), NULL);
 
   // Set number of eigenpairs to compute
   dolfin_assert(n <= _matA->size(0));
   EPSSetDimensions(_eps, n, PETSC_DECIDE, PETSC_DECIDE);
 
-  // Set parameters from local parameters
-  read_parameters();
+  // Set parameters from local parameters (with shift-and-invert
+  // transform and target if shift is given)
+  if (shift)
+  {
+    set_problem_type(parameters["problem_type"]);
+    set_solver(parameters["solver"]);
+    set_tolerance(parameters["tolerance"], parameters["maximum_iterations"]);
+    set_spectral_transform("shift-and-invert", *shift);
+    EPSSetWhichEigenpairs(_eps, EPS_TARGET_MAGNITUDE);
+    EPSSetTarget(_eps, *shift);
+  }
+  else
+    read_parameters();
 
   // Set parameters from PETSc parameter database
   std::string prefix = std::string(parameters["options_prefix"]);
@@ -194,10 +358,14 @@ void SLEPcEigenSolver::get_eigenvalue(double& lr, double& lc,
   const dolfin::la_index ii = static_cast<dolfin::la_index>(i);
 
   // Get number of computed values
-  dolfin::la_index num_computed_eigenvalues;
-  EPSGetConverged(_eps, &num_computed_eigenvalues);
+  const dolfin::la_index num_computed_eigenvalues = get_number_converged();
 
-  if (ii < num_computed_eigenvalues)
+  if (ii < num_computed_eigenvalues && _multishift)
+  {
+    lr = _eigenvalues[i].first;
+    lc = _eigenvalues[i].second;
+  }
+  else if (ii < num_computed_eigenvalues)
     EPSGetEigenvalue(_eps, ii, &lr, &lc);
   else
   {
@@ -223,8 +391,7 @@ void SLEPcEigenSolver::get_eigenpair(double& lr, double& lc,
   const dolfin::la_index ii = static_cast<dolfin::la_index>(i);
 
   // Get number of computed eigenvectors/values
-  dolfin::la_index num_computed_eigenvalues;
-  EPSGetConverged(_eps, &num_computed_eigenvalues);
+  const dolfin::la_index num_computed_eigenvalues = get_number_converged();
 
   if (ii < num_computed_eigenvalues)
   {
@@ -234,7 +401,15 @@ void SLEPcEigenSolver::get_eigenpair(double& lr, double& lc,
 
     dolfin_assert(r.vec());
     dolfin_assert(c.vec());
-    EPSGetEigenpair(_eps, ii, &lr, &lc, r.vec(), c.vec());
+    if (_multishift)
+    {
+      lr = _eigenvalues[i].first;
+      lc = _eigenvalues[i].second;
+      VecCopy(_eigenvectors_r[i]->vec(), r.vec());
+      VecCopy(_eigenvectors_c[i]->vec(), c.vec());
+    }
+    else
+      EPSGetEigenpair(_eps, ii, &lr, &lc, r.vec(), c.vec());
   }
   else
   {
@@ -246,6 +421,9 @@ void SLEPcEigenSolver::get_eigenpair(double& lr, double& lc,
 //-----------------------------------------------------------------------------
 std::size_t SLEPcEigenSolver::get_number_converged() const
 {
+  if (_multishift)
+    return _eigenvalues.size();
+
   dolfin::la_index num_conv;
   EPSGetConverged(_eps, &num_conv);
   return num_conv;
@@ -303,7 +481,13 @@ void SLEPcEigenSolver::set_spectral_transform(std::string transform,
   if (transform == "shift-and-invert")
   {
     STSetType(st, STSINVERT);
-    STSetShift(st, shift);
+
+    // Setting the shift triggers a new factorization, so keep the
+    // shift if unchanged
+    PetscScalar current_shift;
+    STGetShift(st, &current_shift);
+    if (current_shift != shift)
+      STSetShift(st, shift);
   }
   else
   {
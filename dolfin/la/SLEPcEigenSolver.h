@@ -24,8 +24,11 @@
 
 #ifdef HAS_SLEPC
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <slepceps.h>
 #include "dolfin/common/types.h"
 #include "PETScObject.h"
@@ -125,6 +128,18 @@ namespace dolfin
   /// transform and must be provided if a spectral transform is given. The
   /// possible values are real numbers.
   ///
+  /// 8. "warm_start"
+  ///
+  /// If true, the eigenvectors computed by the previous call to solve
+  /// are used as initial space for the next call to solve, which
+  /// reduces the number of iterations for a sequence of closely
+  /// related problems. The default is false.
+  ///
+  /// The operators and the spectral transform are kept between calls
+  /// to solve. Unless the matrices have been modified, the
+  /// factorization of the shifted operator (A - sigma B) computed by
+  /// the shift-and-invert transform is reused by subsequent solves
+  /// with the same shift.
 
   class SLEPcEigenSolver : public Variable, public PETScObject
   {
@@ -152,6 +167,16 @@ namespace dolfin
     /// Compute the n first eigenpairs of the matrix A (solve Ax = \lambda x)
     void solve(std::size_t n);
 
+    /// Compute n eigenpairs closest to each of the given shifts using
+    /// the shift-and-invert spectral transform. The factorizations of
+    /// all shifted operators are computed by the same linear solver,
+    /// such that the symbolic factorization is reused. For
+    /// (generalized) Hermitian problems, the eigenvectors found for
+    /// previous shifts are deflated. Eigenpairs found for more than
+    /// one shift are returned once. Note that this replaces any
+    /// deflation space set by set_deflation_space.
+    void solve(std::size_t n, const std::vector<double>& shifts);
+
     /// Get the first eigenvalue
     void get_eigenvalue(double& lr, double& lc) const;
 
@@ -198,6 +223,7 @@ namespace dolfin
       p.add("maximum_iterations", 10000);
       p.add("spectral_transform", "default");
       p.add("spectral_shift",     0.0);
+      p.add("warm_start",         false);
       p.add("verbose",            false);
       p.add("options_prefix",     "default");
 
@@ -209,6 +235,10 @@ namespace dolfin
     /// Callback for changes in parameter values
     void read_parameters();
 
+    // Compute n eigenpairs (around given shift if shift is not NULL,
+    // starting from previous eigenvectors if warm_start is true)
+    void solve_eps(std::size_t n, const double* shift, bool warm_start);
+
     // Set problem type (used for SLEPc internals)
     void set_problem_type(std::string type);
 
@@ -231,6 +261,17 @@ namespace dolfin
     // SLEPc solver pointer
     EPS _eps;
 
+    // Operators last passed to the EPS and their PETSc object states
+    // (operators are only passed again when modified, which would
+    // reset the spectral transform)
+    Mat _eps_A, _eps_B;
+    std::int64_t _eps_A_state, _eps_B_state;
+
+    // Eigenpairs computed by multi-shift solve
+    bool _multishift;
+    std::vector<std::pair<double, double>> _eigenvalues;
+    std::vector<std::shared_ptr<PETScVector>> _eigenvectors_r, _eigenvectors_c;
+
   };
 
 }
@@ -59,7 +59,10 @@ namespace dolfin
     /// Create empty tensor layout
     std::shared_ptr<TensorLayout> create_layout(std::size_t rank) const
     {
-      std::shared_ptr<TensorLayout> pattern(new TensorLayout(0, false));
+      // Request sparsity pattern for matrices (used to preallocate
+      // compressed storage)
+      const bool sparsity = rank > 1;
+      std::shared_ptr<TensorLayout> pattern(new TensorLayout(0, sparsity));
       return pattern;
     }
 
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2012-02-21
-// Last changed:
+// Last changed: 2015-06-12
 
 #ifndef __DOLFIN_STL_FACTORY_CSC_H
 #define __DOLFIN_STL_FACTORY_CSC_H
@@ -38,7 +38,10 @@ namespace dolfin
     /// Create empty tensor layout
     virtual std::shared_ptr<TensorLayout> create_layout(std::size_t rank) const
     {
-      std::shared_ptr<TensorLayout> pattern(new TensorLayout(1, false));
+      // Request sparsity pattern for matrices (used to preallocate
+      // compressed storage)
+      const bool sparsity = rank > 1;
+      std::shared_ptr<TensorLayout> pattern(new TensorLayout(1, sparsity));
       return pattern;
     }
 
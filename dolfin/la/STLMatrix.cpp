@@ -19,7 +19,7 @@
 // Modified by Ilmar Wilbers 2008
 //
 // First added:  2007-01-17
-// Last changed: 2012-03-15
+// Last changed: 2015-06-12
 
 #include <algorithm>
 #include <iomanip>
@@ -31,21 +31,13 @@
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/types.h>
+#include "GenericSparsityPattern.h"
 #include "STLFactory.h"
 #include "STLFactoryCSC.h"
 #include "STLMatrix.h"
 
 using namespace dolfin;
 
-struct CompareIndex
-{
-  CompareIndex(std::size_t index) : _index(index) {}
-  bool operator()(const std::pair<std::size_t, double>& entry) const
-  { return _index == entry.first; }
-  private:
-    const std::size_t _index;
-};
-
 //-----------------------------------------------------------------------------
 void STLMatrix::init(const TensorLayout& tensor_layout)
 {
@@ -74,14 +66,95 @@ void STLMatrix::init(const TensorLayout& tensor_layout)
   const std::size_t num_primary_entiries = _local_range.second
     - _local_range.first;
 
-  _values.resize(num_primary_entiries);
+  _offsets.assign(num_primary_entiries + 1, 0);
+  _columns.clear();
+  _values.clear();
+  _new_entries.clear();
+  off_processs_data.clear();
+
+  // Preallocate compressed storage from sparsity pattern (entries
+  // not in the pattern are inserted by apply())
+  std::shared_ptr<const GenericSparsityPattern> pattern
+    = tensor_layout.sparsity_pattern();
+  if (pattern && pattern->rank() == 2)
+  {
+    const std::vector<std::vector<std::size_t>> diagonal
+      = pattern->diagonal_pattern(GenericSparsityPattern::unsorted);
+    const std::vector<std::vector<std::size_t>> off_diagonal
+      = pattern->off_diagonal_pattern(GenericSparsityPattern::unsorted);
+
+    if (pattern->primary_dim() == _primary_dim)
+    {
+      dolfin_assert(diagonal.size() == num_primary_entiries);
+      for (std::size_t i = 0; i < num_primary_entiries; ++i)
+      {
+        _offsets[i + 1] = _offsets[i] + diagonal[i].size();
+        if (i < off_diagonal.size())
+          _offsets[i + 1] += off_diagonal[i].size();
+      }
+
+      _columns.resize(_offsets.back());
+      for (std::size_t i = 0; i < num_primary_entiries; ++i)
+      {
+        std::vector<std::size_t>::iterator entry
+          = std::copy(diagonal[i].begin(), diagonal[i].end(),
+                      _columns.begin() + _offsets[i]);
+        if (i < off_diagonal.size())
+        {
+          std::copy(off_diagonal[i].begin(), off_diagonal[i].end(),
+                    entry);
+        }
+      }
+    }
+    else
+    {
+      // Transpose pattern stored along the other dimension. Only
+      // entries with local primary index are known to this process,
+      // others are inserted by apply().
+      const std::size_t offset
+        = pattern->local_range(pattern->primary_dim()).first;
+      std::vector<std::size_t> counts(num_primary_entiries, 0);
+      for (std::size_t pass = 0; pass < 2; ++pass)
+      {
+        for (std::size_t i = 0; i < diagonal.size(); ++i)
+        {
+          for (std::size_t k = 0; k < 2; ++k)
+          {
+            if (k == 1 && i >= off_diagonal.size())
+              break;
+            const std::vector<std::size_t>& entries
+              = k == 0 ? diagonal[i] : off_diagonal[i];
+            for (std::size_t j = 0; j < entries.size(); ++j)
+            {
+              const std::size_t J = entries[j];
+              if (J < _local_range.first || J >= _local_range.second)
+                continue;
+              const std::size_t J_local = J - _local_range.first;
+              if (pass == 0)
+                ++counts[J_local];
+              else
+                _columns[_offsets[J_local] + counts[J_local]++] = offset + i;
+            }
+          }
+        }
+
+        if (pass == 0)
+        {
+          for (std::size_t i = 0; i < num_primary_entiries; ++i)
+            _offsets[i + 1] = _offsets[i] + counts[i];
+          _columns.resize(_offsets.back());
+          std::fill(counts.begin(), counts.end(), 0);
+        }
+      }
+    }
 
-  // FIXME: Add function to sparsity pattern to get nnz per row to
-  //        to reserve space for vectors
-  //if (tensor_layout.sparsity_pattern()
-  //{
-  //  Reserve space here
-  //}
+    for (std::size_t i = 0; i < num_primary_entiries; ++i)
+    {
+      std::sort(_columns.begin() + _offsets[i],
+                _columns.begin() + _offsets[i + 1]);
+    }
+    _values.assign(_columns.size(), 0.0);
+  }
 }
 //-----------------------------------------------------------------------------
 std::size_t STLMatrix::size(std::size_t dim) const
@@ -137,19 +210,17 @@ STLMatrix::local_range(std::size_t dim) const
 //-----------------------------------------------------------------------------
 void STLMatrix::zero()
 {
-  std::vector<std::vector<std::pair<std::size_t, double>>>::iterator slice;
-  std::vector<std::pair<std::size_t, double>>::iterator entry;
-  for (slice = _values.begin(); slice != _values.end(); ++slice)
-    for (entry = slice->begin(); entry != slice->end(); ++entry)
-      entry->second = 0.0;
+  // Keep structure of entries added outside sparsity pattern
+  insert_new_entries();
+  std::fill(_values.begin(), _values.end(), 0.0);
 }
 //-----------------------------------------------------------------------------
 void STLMatrix::add(const double* block,
                     std::size_t m, const dolfin::la_index* rows,
                     std::size_t n, const dolfin::la_index* cols)
 {
-  // Perform a simple linear search along each column. Otherwise,
-  // append the value (calling push_back).
+  // Perform a binary search for each entry in the (sorted)
+  // row/column. Entries not found are inserted by apply().
 
   const dolfin::la_index* primary_slice = rows;
   const dolfin::la_index* secondary_slice = cols;
@@ -176,31 +247,19 @@ void STLMatrix::add(const double* block,
     if (I < _local_range.second && I >= _local_range.first)
     {
       const std::size_t I_local = I - _local_range.first;
-
-      assert(I_local < _values.size());
-      std::vector<std::pair<std::size_t, double>>& slice = _values[I_local];
+      dolfin_assert(I_local + 1 < _offsets.size());
 
       // Iterate over co-dimension
       for (std::size_t j = 0; j < codim; j++)
       {
         const std::size_t pos = i*map1 + j*map0;
-
-        // Global index
-        const std::size_t J = secondary_slice[j];
-
-        // Check if entry exists and insert
-        std::vector<std::pair<std::size_t, double>>::iterator entry
-              = std::find_if(slice.begin(), slice.end(), CompareIndex(J));
-        if (entry != slice.end())
-          entry->second += block[pos];
-        else
-          slice.push_back(std::make_pair(J, block[pos]));
+        add_entry(I_local, secondary_slice[j], block[pos]);
       }
     }
     else
     {
-      // Iterate over columns
-      for (std::size_t j = 0; j < n; j++)
+      // Iterate over co-dimension
+      for (std::size_t j = 0; j < codim; j++)
       {
         // Global column, coordinate
         const std::size_t J = secondary_slice[j];
@@ -298,22 +357,64 @@ void STLMatrix::apply(std::string mode)
                     && received_non_local_rows_p[i] >= _local_range.first);
       const std::size_t I_local
         = received_non_local_rows_p[i] - _local_range.first;
-      dolfin_assert(I_local < _values.size());
-
-      const std::size_t J = received_non_local_cols_p[i];
-      std::vector<std::pair<std::size_t, double>>::iterator e
-            = std::find_if(_values[I_local].begin(), _values[I_local].end(),
-                           CompareIndex(J));
-      if (e != _values[I_local].end())
-        e->second += received_non_local_vals_p[i];
+      dolfin_assert(I_local + 1 < _offsets.size());
+      add_entry(I_local, received_non_local_cols_p[i],
+                received_non_local_vals_p[i]);
+    }
+  }
+  off_processs_data.clear();
+
+  // Insert entries outside compressed storage
+  insert_new_entries();
+}
+//-----------------------------------------------------------------------------
+void STLMatrix::insert_new_entries()
+{
+  if (_new_entries.empty())
+    return;
+
+  // Sort new entries by row (column) and column (row)
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, double>>
+    entries(_new_entries.begin(), _new_entries.end());
+  std::sort(entries.begin(), entries.end());
+  _new_entries.clear();
+
+  // Merge new entries with compressed storage
+  std::vector<std::size_t> offsets(_offsets.size(), 0);
+  std::vector<std::size_t> columns;
+  std::vector<double> values;
+  columns.reserve(_columns.size() + entries.size());
+  values.reserve(_values.size() + entries.size());
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>,
+                        double>>::const_iterator e = entries.begin();
+  for (std::size_t i = 0; i + 1 < _offsets.size(); ++i)
+  {
+    std::size_t k = _offsets[i];
+    while (k < _offsets[i + 1] || (e != entries.end() && e->first.first == i))
+    {
+      const bool existing = k < _offsets[i + 1]
+        && (e == entries.end() || e->first.first != i
+            || _columns[k] < e->first.second);
+      if (existing)
+      {
+        columns.push_back(_columns[k]);
+        values.push_back(_values[k]);
+        ++k;
+      }
       else
-        _values[I_local].push_back(std::make_pair(J,
-                                               received_non_local_vals_p[i]));
+      {
+        columns.push_back(e->first.second);
+        values.push_back(e->second);
+        ++e;
+      }
     }
+    offsets[i + 1] = columns.size();
   }
+  dolfin_assert(e == entries.end());
 
-  // Sort columns (csr)/rows (csc)
-  sort();
+  _offsets.swap(offsets);
+  _columns.swap(columns);
+  _values.swap(values);
 }
 //-----------------------------------------------------------------------------
 double STLMatrix::norm(std::string norm_type) const
@@ -323,10 +424,7 @@ double STLMatrix::norm(std::string norm_type) const
 
   double _norm = 0.0;
   for (std::size_t i = 0; i < _values.size(); ++i)
-  {
-    for (std::size_t j = 0; j < _values[i].size(); ++j)
-      _norm += _values[i][j].second*_values[i][j].second;
-  }
+    _norm += _values[i]*_values[i];
   return std::sqrt(dolfin::MPI::sum(_mpi_comm, _norm));
 }
 //-----------------------------------------------------------------------------
@@ -342,16 +440,13 @@ void STLMatrix::getrow(std::size_t row, std::vector<std::size_t>& columns,
 
   dolfin_assert(row < _local_range.second && row >= _local_range.first);
   const std::size_t local_row = row - _local_range.first;
-  dolfin_assert(local_row < _values.size());
+  dolfin_assert(local_row + 1 < _offsets.size());
 
   // Copy row values
-  columns.resize(_values[local_row].size());
-  values.resize(_values[local_row].size());
-  for (std::size_t i = 0; i < _values[local_row].size(); ++i)
-  {
-    columns[i] = _values[local_row][i].first;
-    values[i]  = _values[local_row][i].second;
-  }
+  columns.assign(_columns.begin() + _offsets[local_row],
+                 _columns.begin() + _offsets[local_row + 1]);
+  values.assign(_values.begin() + _offsets[local_row],
+                _values.begin() + _offsets[local_row + 1]);
 }
 //-----------------------------------------------------------------------------
 void STLMatrix::ident(std::size_t m, const dolfin::la_index* rows)
@@ -370,30 +465,32 @@ void STLMatrix::ident(std::size_t m, const dolfin::la_index* rows)
     if (global_row >= row_range.first && global_row < row_range.second)
     {
       const std::size_t local_row = global_row - row_range.first;
-      dolfin_assert(local_row < _values.size());
-      for (std::size_t j = 0; j < _values[local_row].size(); ++j)
-        _values[local_row][j].second = 0.0;
+      dolfin_assert(local_row + 1 < _offsets.size());
+      std::fill(_values.begin() + _offsets[local_row],
+                _values.begin() + _offsets[local_row + 1], 0.0);
 
       // Place one on diagonal
-      std::vector<std::pair<std::size_t, double>>::iterator diagonal
-          = std::find_if(_values[local_row].begin(), _values[local_row].end(),
-                         CompareIndex(global_row));
-
-      if (diagonal != _values[local_row].end())
-        diagonal->second = 1.0;
-      else
-        _values[local_row].push_back(std::make_pair(global_row, 1.0));
+      add_entry(local_row, global_row, 1.0);
     }
   }
+
+  // Insert diagonal entries outside compressed storage
+  insert_new_entries();
 }
 //-----------------------------------------------------------------------------
 const STLMatrix& STLMatrix::operator*= (double a)
 {
-  std::vector<std::vector<std::pair<std::size_t, double>>>::iterator row;
-  std::vector<std::pair<std::size_t, double>>::iterator entry;
-  for (row = _values.begin(); row != _values.end(); ++row)
-    for (entry = row->begin(); entry != row->end(); ++entry)
-      entry->second *=a;
+  std::vector<double>::iterator entry;
+  for (entry = _values.begin(); entry != _values.end(); ++entry)
+    *entry *= a;
+
+  boost::unordered_map<std::pair<std::size_t, std::size_t>,
+                       double>::iterator new_entry;
+  for (new_entry = _new_entries.begin(); new_entry != _new_entries.end();
+       ++new_entry)
+  {
+    new_entry->second *= a;
+  }
 
   return *this;
 }
@@ -417,12 +514,8 @@ std::string STLMatrix::str(bool verbose) const
     }
 
     s << str(false) << std::endl << std::endl;
-    for (std::size_t i = 0; i < _local_range.second - _local_range.first; i++)
+    for (std::size_t i = 0; i + 1 < _offsets.size(); i++)
     {
-      // Sort row data by column index
-      std::vector<std::pair<std::size_t, double>> data = _values[i];
-      std::sort(data.begin(), data.end());
-
       // Set precision
       std::stringstream line;
       line << std::setiosflags(std::ios::scientific);
@@ -430,10 +523,9 @@ std::string STLMatrix::str(bool verbose) const
 
       // Format matrix
       line << "|";
-      std::vector<std::pair<std::size_t, double>>::const_iterator entry;
-      for (entry = data.begin(); entry != data.end(); ++entry)
+      for (std::size_t k = _offsets[i]; k < _offsets[i + 1]; ++k)
       {
-        line << " (" << i << ", " << entry->first << ", " << entry->second
+        line << " (" << i << ", " << _columns[k] << ", " << _values[k]
              << ")";
       }
       line << " |";
@@ -447,6 +539,16 @@ std::string STLMatrix::str(bool verbose) const
   return s.str();
 }
 //-----------------------------------------------------------------------------
+boost::tuples::tuple<const std::size_t*, const std::size_t*, const double*,
+                     int> STLMatrix::data() const
+{
+  return boost::tuples::tuple<const std::size_t*, const std::size_t*,
+                              const double*, int>(_offsets.data(),
+                                                  _columns.data(),
+                                                  _values.data(),
+                                                  _values.size());
+}
+//-----------------------------------------------------------------------------
 GenericLinearAlgebraFactory& STLMatrix::factory() const
 {
   if (_primary_dim == 0)
@@ -462,9 +564,6 @@ std::size_t STLMatrix::nnz() const
 //-----------------------------------------------------------------------------
 std::size_t STLMatrix::local_nnz() const
 {
-  std::size_t _nnz = 0;
-  for (std::size_t i = 0; i < _values.size(); ++i)
-    _nnz += _values[i].size();
-  return _nnz;
+  return _values.size();
 }
 //-----------------------------------------------------------------------------
@@ -20,11 +20,12 @@
 // Modified by Ilmar Wilbers 2008
 //
 // First added:  2007-01-17
-// Last changed: 2012-08-20
+// Last changed: 2015-06-12
 
 #ifndef __DOLFIN_STL_MATRIX_H
 #define __DOLFIN_STL_MATRIX_H
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <boost/unordered_map.hpp>
@@ -42,13 +43,19 @@ namespace dolfin
   class GenericVector;
 
   /// Simple STL-based implementation of the GenericMatrix interface.
-  /// The sparse matrix is stored as a pair of std::vector of
-  /// std::vector, one for the columns and one for the values.
+  /// The locally owned rows (columns for column-wise storage) of the
+  /// sparse matrix are stored in compressed storage, i.e. in one
+  /// array of offsets and one array each of (global) indices and
+  /// values, with the indices of each row sorted. The arrays are
+  /// preallocated from the sparsity pattern of the tensor layout, and
+  /// values are added by binary search within a row.
+  ///
+  /// Entries outside the preallocated structure are collected
+  /// separately and merged into the compressed storage by apply().
   ///
   /// Historically, this class has undergone a number of different
   /// incarnations, based on various combinations of std::vector,
-  /// std::set and std::map. The current implementation has proven to
-  /// be the fastest.
+  /// std::set and std::map.
 
   class STLMatrix : public GenericMatrix
   {
@@ -69,7 +76,7 @@ namespace dolfin
 
     /// Return true if empty
     virtual bool empty() const
-    { return _values.empty(); }
+    { return _offsets.empty(); }
 
     /// Return size of given dimension
     virtual std::size_t size(std::size_t dim) const;
@@ -196,6 +203,14 @@ namespace dolfin
 
     ///--- Specialized matrix functions ---
 
+    /// Return pointers to underlying compressed storage data (without
+    /// copying). For row-wise storage, data = (row_pointer[#local
+    /// rows + 1], column_index[#nz], matrix_values[#nz], nz), with
+    /// global column indices sorted within each row. For column-wise
+    /// storage, the roles of rows and columns are exchanged.
+    virtual boost::tuples::tuple<const std::size_t*, const std::size_t*,
+                                 const double*, int> data() const;
+
     /// Return linear algebra backend factory
     virtual GenericLinearAlgebraFactory& factory() const;
 
@@ -210,17 +225,13 @@ namespace dolfin
     {
       _local_range = std::pair<std::size_t, std::size_t>(0, 0);
       num_codim_entities = 0;
+      _offsets.clear();
+      _columns.clear();
       _values.clear();
+      _new_entries.clear();
       off_processs_data.clear();
     }
 
-    void sort()
-    {
-      std::vector<std::vector<std::pair<std::size_t, double> > >::iterator row;
-      for (row = _values.begin(); row < _values.end(); ++row)
-        std::sort(row->begin(), row->end());
-    }
-
     /// Return matrix in CSR format
     template<typename T>
     void csr(std::vector<double>& vals, std::vector<T>& cols,
@@ -248,6 +259,26 @@ namespace dolfin
     // MPI communicator
     MPI_Comm _mpi_comm;
 
+    // Add value to entry (local primary index, global secondary
+    // index), and collect entry as new entry if not present in
+    // compressed storage
+    void add_entry(std::size_t i, std::size_t j, double value)
+    {
+      const std::vector<std::size_t>::const_iterator begin
+        = _columns.begin() + _offsets[i];
+      const std::vector<std::size_t>::const_iterator end
+        = _columns.begin() + _offsets[i + 1];
+      const std::vector<std::size_t>::const_iterator entry
+        = std::lower_bound(begin, end, j);
+      if (entry != end && *entry == j)
+        _values[entry - _columns.begin()] += value;
+      else
+        _new_entries[std::make_pair(i, j)] += value;
+    }
+
+    // Merge new entries into compressed storage
+    void insert_new_entries();
+
     /// Return matrix in compressed format
     template<typename T>
     void compressed_storage(std::vector<double>& vals,
@@ -271,8 +302,17 @@ namespace dolfin
     // storage)
     std::size_t num_codim_entities;
 
-    // Storage of non-zero matrix values
-    std::vector<std::vector<std::pair<std::size_t, double> > > _values;
+    // Compressed storage of non-zero matrix values (offsets into
+    // _columns and _values for each local row/column, global indices
+    // sorted within each row/column)
+    std::vector<std::size_t> _offsets;
+    std::vector<std::size_t> _columns;
+    std::vector<double> _values;
+
+    // Entries not present in compressed storage ([local i, global j],
+    // value)
+    boost::unordered_map<std::pair<std::size_t, std::size_t>, double>
+      _new_entries;
 
     // Off-process data ([i, j], value)
     boost::unordered_map<std::pair<std::size_t, std::size_t>, double>
@@ -331,9 +371,13 @@ namespace dolfin
     row_ptr.clear();
     local_to_global_row.clear();
 
+    // Number of local rows (columns)
+    const std::size_t num_local_rows
+      = _offsets.empty() ? 0 : _offsets.size() - 1;
+
     // Reserve memory
-    row_ptr.reserve(_values.size() + 1);
-    local_to_global_row.reserve(_values.size());
+    row_ptr.reserve(num_local_rows/_block_size + 1);
+    local_to_global_row.reserve(num_local_rows/_block_size);
 
     // Build CSR data structures
     row_ptr.push_back(0);
@@ -341,30 +385,29 @@ namespace dolfin
     // Number of local non-zero entries
     const std::size_t _local_nnz = local_nnz();
 
-    // Number of local rows (columns)
-    const std::size_t num_local_rows = _values.size();
-
     if (!symmetric)
     {
       // Reserve memory
       vals.reserve(_local_nnz);
-      cols.reserve(_local_nnz);
+      cols.reserve(_local_nnz/(_block_size*_block_size));
 
       // Build data structures
       for (std::size_t local_row = 0; local_row < num_local_rows;
            local_row += _block_size)
       {
-        for (std::size_t column = 0; column < _values[local_row].size();
+        const std::size_t row_size
+          = _offsets[local_row + 1] - _offsets[local_row];
+        for (std::size_t column = 0; column < row_size;
              column += _block_size)
         {
-          cols.push_back(_values[local_row][column].first/_block_size);
+          cols.push_back(_columns[_offsets[local_row] + column]/_block_size);
           for (std::size_t b0 = 0; b0 < _block_size; ++b0)
             for (std::size_t b1 = 0; b1 < _block_size; ++b1)
-              vals.push_back(_values[local_row + b0][column + b1].second);
+              vals.push_back(_values[_offsets[local_row + b0] + column + b1]);
         }
         local_to_global_row.push_back((_local_range.first
                                        + local_row)/_block_size);
-        row_ptr.push_back(row_ptr.back()+_values[local_row].size()/_block_size);
+        row_ptr.push_back(row_ptr.back() + row_size/_block_size);
       }
     }
     else
@@ -374,23 +417,28 @@ namespace dolfin
       cols.reserve((_local_nnz - num_local_rows)/2 + num_local_rows);
 
       // Build data structures
-      for (std::size_t local_row = 0; local_row < _values.size();
+      for (std::size_t local_row = 0; local_row < num_local_rows;
            local_row += _block_size)
       {
         const std::size_t global_row_index
           = (local_row + _local_range.first)/_block_size;
+        const std::size_t row_size
+          = _offsets[local_row + 1] - _offsets[local_row];
         std::size_t counter = 0;
-        for (std::size_t column = 0; column < _values[local_row].size();
+        for (std::size_t column = 0; column < row_size;
              column += _block_size)
         {
           const std::size_t index
-            = _values[local_row][column].first/_block_size;
+            = _columns[_offsets[local_row] + column]/_block_size;
           if (index >= global_row_index)
           {
             cols.push_back(index);
             for (std::size_t b0 = 0; b0 < _block_size; ++b0)
               for (std::size_t b1 = 0; b1 < _block_size; ++b1)
-                vals.push_back(_values[local_row + b0][column + b1].second);
+              {
+                vals.push_back(_values[_offsets[local_row + b0]
+                                       + column + b1]);
+              }
             ++counter;
           }
         }
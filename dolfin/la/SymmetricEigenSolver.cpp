@@ -0,0 +1,680 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <Eigen/Eigenvalues>
+#include <dolfin/common/constants.h>
+#include <dolfin/log/log.h>
+#include "GenericLUSolver.h"
+#include "GenericLinearAlgebraFactory.h"
+#include "GenericLinearOperator.h"
+#include "GenericLinearSolver.h"
+#include "GenericMatrix.h"
+#include "GenericVector.h"
+#include "SymmetricEigenSolver.h"
+
+using namespace dolfin;
+
+namespace
+{
+  // Return pseudo-random value in [-0.5, 0.5) for global index i and
+  // column j (independent of the parallel partition)
+  double random_value(std::size_t i, std::size_t j)
+  {
+    std::uint64_t z = i*0x9E3779B97F4A7C15ULL + j + 1;
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return double(z >> 11)/double(1ULL << 53) - 0.5;
+  }
+
+  // Return symmetric part of square matrix
+  Eigen::MatrixXd symmetric_part(const Eigen::MatrixXd& A)
+  {
+    return 0.5*(A + A.transpose());
+  }
+}
+
+//-----------------------------------------------------------------------------
+SymmetricEigenSolver::SymmetricEigenSolver(
+  std::shared_ptr<const GenericLinearOperator> A)
+  : _A(A), _num_iterations(0)
+{
+  dolfin_assert(A);
+  dolfin_assert(A->size(0) == A->size(1));
+
+  // Set default parameter values
+  parameters = default_parameters();
+}
+//-----------------------------------------------------------------------------
+SymmetricEigenSolver::SymmetricEigenSolver(
+  std::shared_ptr<const GenericLinearOperator> A,
+  std::shared_ptr<const GenericLinearOperator> B)
+  : _A(A), _B(B), _num_iterations(0)
+{
+  dolfin_assert(A);
+  dolfin_assert(B);
+  dolfin_assert(A->size(0) == A->size(1));
+  dolfin_assert(B->size(0) == A->size(0));
+  dolfin_assert(B->size(1) == A->size(1));
+
+  // Set default parameter values
+  parameters = default_parameters();
+}
+//-----------------------------------------------------------------------------
+SymmetricEigenSolver::~SymmetricEigenSolver()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+void
+SymmetricEigenSolver::set_preconditioner(std::shared_ptr<GenericLinearSolver> P)
+{
+  _P = P;
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::set_initial_space(
+  const std::vector<std::shared_ptr<const GenericVector>>& x)
+{
+  _initial_space = x;
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::solve(std::size_t n)
+{
+  dolfin_assert(_A);
+  if (n == 0 || n > _A->size(0))
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "compute eigenpairs",
+                 "Number of requested eigenpairs (%d) must be between 1 and the size of the operator",
+                 n);
+  }
+
+  // Create work vectors
+  _x = create_vector();
+  _y = _x->copy();
+  _mpi_comm = _x->mpi_comm();
+
+  _eigenvalues.clear();
+  _eigenvectors.resize(0, 0);
+  _num_iterations = 0;
+
+  const std::string solver = parameters["solver"];
+  if (solver == "lobpcg")
+    solve_lobpcg(n);
+  else if (solver == "lanczos")
+    solve_lanczos(n);
+  else
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "compute eigenpairs",
+                 "Unknown solver type (\"%s\")", solver.c_str());
+  }
+
+  if (_eigenvalues.size() < n)
+  {
+    warning("Eigenvalue solver converged %d of %d eigenpairs",
+            _eigenvalues.size(), n);
+  }
+  log(PROGRESS, "Eigenvalue solver (%s) converged in %d iterations.",
+      solver.c_str(), _num_iterations);
+}
+//-----------------------------------------------------------------------------
+double SymmetricEigenSolver::get_eigenvalue(std::size_t i) const
+{
+  if (i >= _eigenvalues.size())
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "extract eigenvalue from symmetric eigenvalue solver",
+                 "Requested eigenvalue (%d) has not been computed", i);
+  }
+  return _eigenvalues[i];
+}
+//-----------------------------------------------------------------------------
+double SymmetricEigenSolver::get_eigenpair(GenericVector& x,
+                                           std::size_t i) const
+{
+  const double lambda = get_eigenvalue(i);
+
+  dolfin_assert(_x);
+  if (x.empty())
+    x.init(_mpi_comm, _x->local_range());
+
+  std::vector<double> values(_eigenvectors.col(i).data(),
+                             _eigenvectors.col(i).data()
+                             + _eigenvectors.rows());
+  x.set_local(values);
+  x.apply("insert");
+
+  return lambda;
+}
+//-----------------------------------------------------------------------------
+std::size_t SymmetricEigenSolver::get_iteration_number() const
+{
+  return _num_iterations;
+}
+//-----------------------------------------------------------------------------
+std::size_t SymmetricEigenSolver::get_number_converged() const
+{
+  return _eigenvalues.size();
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::solve_lobpcg(std::size_t n)
+{
+  // Largest eigenvalues are computed as smallest eigenvalues of -A
+  const std::string spectrum = parameters["spectrum"];
+  const double sign = (spectrum == "largest real") ? -1.0 : 1.0;
+  const double tolerance = parameters["tolerance"];
+  const std::size_t maxiter = parameters["maximum_iterations"];
+
+  // B-orthonormalize block X with BX = B X (and update AX = A X if
+  // given) from eigendecomposition of Gram matrix (applied twice for
+  // stability), dropping linearly dependent directions
+  auto orthonormalize = [this](Eigen::MatrixXd& X, Eigen::MatrixXd& BX,
+                               Eigen::MatrixXd* AX)
+  {
+    for (std::size_t pass = 0; pass < 2 && X.cols() > 0; ++pass)
+    {
+      Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>
+        eig(symmetric_part(inner(X, BX)));
+      const Eigen::VectorXd& d = eig.eigenvalues();
+      std::vector<std::size_t> kept;
+      for (std::size_t i = 0; i < (std::size_t) d.size(); ++i)
+      {
+        if (d(i) > DOLFIN_SQRT_EPS*DOLFIN_SQRT_EPS*d.maxCoeff())
+          kept.push_back(i);
+      }
+
+      Eigen::MatrixXd Q(X.cols(), kept.size());
+      for (std::size_t i = 0; i < kept.size(); ++i)
+        Q.col(i) = eig.eigenvectors().col(kept[i])/std::sqrt(d(kept[i]));
+      X = X*Q;
+      BX = BX*Q;
+      if (AX)
+        *AX = (*AX)*Q;
+    }
+  };
+
+  // B-orthogonalize block Y (with BY = B Y and AY = A Y if given)
+  // against B-orthonormal block Q (with BQ = B Q and AQ = A Q)
+  auto project = [this](Eigen::MatrixXd& Y, Eigen::MatrixXd& BY,
+                        Eigen::MatrixXd* AY, const Eigen::MatrixXd& Q,
+                        const Eigen::MatrixXd& BQ, const Eigen::MatrixXd* AQ)
+  {
+    if (Y.cols() == 0 || Q.cols() == 0)
+      return;
+    const Eigen::MatrixXd c = inner(BQ, Y);
+    Y -= Q*c;
+    BY -= BQ*c;
+    if (AY)
+      *AY -= (*AQ)*c;
+  };
+
+  // Update estimates of norms of A and B from block Y
+  double a_scale = 0.0, b_scale = 0.0;
+  auto update_scale = [&](const Eigen::MatrixXd& Y, const Eigen::MatrixXd& AY,
+                          const Eigen::MatrixXd& BY)
+  {
+    const Eigen::VectorXd y_norm = norms(Y);
+    const Eigen::VectorXd ay_norm = norms(AY);
+    const Eigen::VectorXd by_norm = norms(BY);
+    for (std::size_t j = 0; j < (std::size_t) Y.cols(); ++j)
+    {
+      if (y_norm(j) > 0.0)
+      {
+        a_scale = std::max(a_scale, ay_norm(j)/y_norm(j));
+        b_scale = std::max(b_scale, by_norm(j)/y_norm(j));
+      }
+    }
+  };
+
+  const std::size_t m = _x->local_size();
+
+  // Initial block
+  Eigen::MatrixXd X(m, n), AX, BX;
+  initial_block(X);
+  if (_B)
+    apply(*_B, X, BX);
+  else
+    BX = X;
+  orthonormalize(X, BX, NULL);
+  if ((std::size_t) X.cols() < n)
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "compute eigenpairs by LOBPCG",
+                 "Initial block is linearly dependent");
+  }
+  apply(*_A, X, AX);
+  AX *= sign;
+  update_scale(X, AX, BX);
+
+  // Rayleigh-Ritz on initial block
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>
+    eig(symmetric_part(inner(X, AX)));
+  Eigen::VectorXd theta = eig.eigenvalues();
+  X = X*eig.eigenvectors();
+  AX = AX*eig.eigenvectors();
+  BX = BX*eig.eigenvectors();
+
+  // Search directions
+  Eigen::MatrixXd P, AP, BP;
+
+  std::vector<bool> converged(n, false);
+  for (_num_iterations = 0; ; ++_num_iterations)
+  {
+    // Compute residuals and select active (not converged) eigenpairs.
+    // The residual is measured relative to estimates of the norms of
+    // A and B (backward error), which is also meaningful for
+    // eigenvalues close to zero
+    const Eigen::MatrixXd R = AX - BX*theta.asDiagonal();
+    const Eigen::VectorXd r_norm = norms(R);
+    const Eigen::VectorXd x_norm = norms(X);
+    std::vector<std::size_t> active;
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      converged[j] = r_norm(j) <= tolerance*(a_scale
+                                             + std::abs(theta(j))*b_scale)*x_norm(j);
+      if (!converged[j])
+        active.push_back(j);
+    }
+    if (active.empty() || _num_iterations == maxiter)
+      break;
+
+    // Preconditioned residuals of active eigenpairs
+    Eigen::MatrixXd W(m, active.size()), AW, BW;
+    for (std::size_t i = 0; i < active.size(); ++i)
+      W.col(i) = R.col(active[i]);
+    if (_P)
+    {
+      Eigen::MatrixXd PW;
+      apply(*_P, W, PW);
+      W = PW;
+    }
+
+    // B-orthogonalize against current eigenvectors (twice) and
+    // orthonormalize
+    W -= X*inner(BX, W);
+    if (_B)
+      apply(*_B, W, BW);
+    else
+      BW = W;
+    project(W, BW, NULL, X, BX, NULL);
+    orthonormalize(W, BW, NULL);
+    if (W.cols() == 0)
+    {
+      warning("LOBPCG stagnated (residual block is linearly dependent)");
+      break;
+    }
+    apply(*_A, W, AW);
+    AW *= sign;
+    update_scale(W, AW, BW);
+
+    // B-orthogonalize search directions against current eigenvectors
+    // and residuals (twice) and orthonormalize, such that the basis
+    // S = [X, W, P] is B-orthonormal
+    for (std::size_t pass = 0; pass < 2; ++pass)
+    {
+      project(P, BP, &AP, X, BX, &AX);
+      project(P, BP, &AP, W, BW, &AW);
+    }
+    orthonormalize(P, BP, &AP);
+
+    // Rayleigh-Ritz on subspace S = [X, W, P] (dropping P if the
+    // projected B is not positive definite)
+    Eigen::GeneralizedSelfAdjointEigenSolver<Eigen::MatrixXd> ges;
+    Eigen::MatrixXd S, AS, BS;
+    for (std::size_t attempt = 0; attempt < 2; ++attempt)
+    {
+      const std::size_t nw = W.cols();
+      const std::size_t np = P.cols();
+      S.resize(m, n + nw + np);
+      AS.resize(m, n + nw + np);
+      BS.resize(m, n + nw + np);
+      S.leftCols(n) = X;
+      AS.leftCols(n) = AX;
+      BS.leftCols(n) = BX;
+      S.middleCols(n, nw) = W;
+      AS.middleCols(n, nw) = AW;
+      BS.middleCols(n, nw) = BW;
+      if (np > 0)
+      {
+        S.rightCols(np) = P;
+        AS.rightCols(np) = AP;
+        BS.rightCols(np) = BP;
+      }
+
+      ges.compute(symmetric_part(inner(S, AS)), symmetric_part(inner(S, BS)));
+      if (ges.info() == Eigen::Success || np == 0)
+        break;
+
+      P.resize(m, 0);
+      AP.resize(m, 0);
+      BP.resize(m, 0);
+    }
+    if (ges.info() != Eigen::Success)
+    {
+      warning("LOBPCG stagnated (Rayleigh-Ritz projection failed)");
+      break;
+    }
+
+    // Update eigenvectors and search directions
+    const Eigen::MatrixXd C = ges.eigenvectors().leftCols(n);
+    theta = ges.eigenvalues().head(n);
+    const std::size_t nd = S.cols() - n;
+    P = S.rightCols(nd)*C.bottomRows(nd);
+    AP = AS.rightCols(nd)*C.bottomRows(nd);
+    BP = BS.rightCols(nd)*C.bottomRows(nd);
+    X = S*C;
+    AX = AS*C;
+    BX = BS*C;
+  }
+
+  // Store converged eigenpairs
+  std::vector<std::size_t> columns;
+  for (std::size_t j = 0; j < n; ++j)
+  {
+    if (converged[j])
+    {
+      columns.push_back(j);
+      _eigenvalues.push_back(sign*theta(j));
+    }
+  }
+  _eigenvectors.resize(m, columns.size());
+  for (std::size_t i = 0; i < columns.size(); ++i)
+    _eigenvectors.col(i) = X.col(columns[i]);
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::solve_lanczos(std::size_t n)
+{
+  // Largest eigenvalues are computed as smallest eigenvalues of -A
+  const std::string spectrum = parameters["spectrum"];
+  const double sign = (spectrum == "largest real") ? -1.0 : 1.0;
+  const double tolerance = parameters["tolerance"];
+  const std::size_t maxiter = parameters["maximum_iterations"];
+
+  // Dimension of Krylov subspace
+  const std::size_t N = _A->size(0);
+  std::size_t dim = parameters["krylov_dimension"];
+  if (dim == 0)
+    dim = std::max(2*n, n + 20);
+  dim = std::min(dim, N);
+  if (dim <= n && dim < N)
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "compute eigenpairs by Lanczos",
+                 "Krylov dimension (%d) must be larger than number of requested eigenpairs (%d)",
+                 dim, n);
+  }
+
+  // Generalized problems are transformed to B^{-1}A, which is
+  // symmetric in the B inner product
+  std::shared_ptr<GenericLinearSolver> solver_B;
+  if (_B)
+  {
+    const GenericMatrix* B = dynamic_cast<const GenericMatrix*>(_B.get());
+    if (!B)
+    {
+      dolfin_error("SymmetricEigenSolver.cpp",
+                   "compute eigenpairs by Lanczos",
+                   "Generalized problems require B to be a matrix");
+    }
+    solver_B = B->factory().create_lu_solver("default");
+    solver_B->set_operator(_B);
+  }
+
+  const std::size_t m = _x->local_size();
+
+  // Basis (and B times basis for generalized problems) and projected
+  // operator
+  Eigen::MatrixXd V(m, dim + 1), BV;
+  if (_B)
+    BV.resize(m, dim + 1);
+  Eigen::MatrixXd T = Eigen::MatrixXd::Zero(dim, dim);
+
+  // Start vector (sum of initial space)
+  Eigen::MatrixXd X0(m, std::max<std::size_t>(1, _initial_space.size()));
+  initial_block(X0);
+  Eigen::MatrixXd v = X0.rowwise().sum(), Bv;
+  if (_B)
+    apply(*_B, v, Bv);
+  else
+    Bv = v;
+  const double norm_v = std::sqrt(inner(v, Bv)(0, 0));
+  V.col(0) = v/norm_v;
+  if (_B)
+    BV.col(0) = Bv/norm_v;
+
+  // Number of kept Ritz vectors after restart
+  std::size_t l = 0;
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig;
+  std::size_t size = dim;
+  for (_num_iterations = 0; ; ++_num_iterations)
+  {
+    // Extend basis
+    double beta = 0.0;
+    for (std::size_t j = l; j < dim; ++j)
+    {
+      // Apply operator: w = B^{-1}Av_j
+      Eigen::MatrixXd w;
+      apply(*_A, V.col(j), w);
+      w *= sign;
+      if (_B)
+      {
+        const Eigen::MatrixXd Av = w;
+        apply(*solver_B, Av, w);
+      }
+
+      // B-orthogonalize against basis (twice), which also gives
+      // column j of projected operator
+      const Eigen::MatrixXd& BV_basis = _B ? BV : V;
+      Eigen::VectorXd h = Eigen::VectorXd::Zero(j + 1);
+      for (std::size_t pass = 0; pass < 2; ++pass)
+      {
+        const Eigen::MatrixXd c = inner(BV_basis.leftCols(j + 1), w);
+        w -= V.leftCols(j + 1)*c;
+        h += c.col(0);
+      }
+      T.col(j).head(j + 1) = h;
+      T.row(j).head(j + 1) = h.transpose();
+
+      // Compute Bw explicitly (rather than updating B^{-1}Av_j) such
+      // that errors of the solver for B do not accumulate
+      Eigen::MatrixXd Bw;
+      if (_B)
+        apply(*_B, w, Bw);
+      else
+        Bw = w;
+      beta = std::sqrt(std::max(0.0, inner(w, Bw)(0, 0)));
+      if (beta <= DOLFIN_EPS*std::max(1.0, T.topLeftCorner(j + 1, j + 1).norm()))
+      {
+        // Invariant subspace found
+        size = j + 1;
+        beta = 0.0;
+        break;
+      }
+      V.col(j + 1) = w/beta;
+      if (_B)
+        BV.col(j + 1) = Bw/beta;
+    }
+
+    // Ritz pairs and residual estimates
+    eig.compute(T.topLeftCorner(size, size));
+    const Eigen::VectorXd theta = eig.eigenvalues();
+    const Eigen::MatrixXd& Y = eig.eigenvectors();
+    const double scale = theta.cwiseAbs().maxCoeff();
+    std::size_t num_converged = 0;
+    const std::size_t num_wanted = std::min(n, size);
+    for (std::size_t i = 0; i < num_wanted; ++i)
+    {
+      const double residual = beta*std::abs(Y(size - 1, i));
+      if (residual <= tolerance*std::max(std::abs(theta(i)),
+                                         DOLFIN_EPS*scale))
+      {
+        ++num_converged;
+      }
+      else
+        break;
+    }
+
+    if (num_converged == num_wanted || beta == 0.0
+        || _num_iterations == maxiter)
+    {
+      _eigenvectors = V.leftCols(size)*Y.leftCols(num_converged);
+      for (std::size_t i = 0; i < num_converged; ++i)
+        _eigenvalues.push_back(sign*theta(i));
+      break;
+    }
+
+    // Thick restart, keeping the wanted and nearby Ritz vectors
+    l = std::min(n + (size - n)/2, size - 1);
+    const Eigen::MatrixXd V_kept = V.leftCols(size)*Y.leftCols(l);
+    V.leftCols(l) = V_kept;
+    V.col(l) = V.col(size);
+    if (_B)
+    {
+      const Eigen::MatrixXd BV_kept = BV.leftCols(size)*Y.leftCols(l);
+      BV.leftCols(l) = BV_kept;
+      BV.col(l) = BV.col(size);
+    }
+    T.setZero();
+    T.topLeftCorner(l, l).diagonal() = theta.head(l);
+  }
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<GenericVector> SymmetricEigenSolver::create_vector() const
+{
+  const GenericMatrix* A = dynamic_cast<const GenericMatrix*>(_A.get());
+  const GenericMatrix* B = dynamic_cast<const GenericMatrix*>(_B.get());
+
+  std::shared_ptr<GenericVector> x;
+  if (A)
+  {
+    x = A->factory().create_vector();
+    A->init_vector(*x, 1);
+  }
+  else if (B)
+  {
+    x = B->factory().create_vector();
+    B->init_vector(*x, 1);
+  }
+  else if (!_initial_space.empty())
+  {
+    dolfin_assert(_initial_space[0]);
+    x = _initial_space[0]->copy();
+  }
+  else
+  {
+    dolfin_error("SymmetricEigenSolver.cpp",
+                 "create vector for symmetric eigenvalue solver",
+                 "Operators are not matrices and no initial space has been set");
+  }
+
+  return x;
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::initial_block(Eigen::MatrixXd& X) const
+{
+  dolfin_assert(_x);
+  const std::size_t offset = _x->local_range().first;
+  std::vector<double> values;
+  for (std::size_t j = 0; j < (std::size_t) X.cols(); ++j)
+  {
+    if (j < _initial_space.size())
+    {
+      _initial_space[j]->get_local(values);
+      dolfin_assert(values.size() == (std::size_t) X.rows());
+      std::copy(values.begin(), values.end(), X.col(j).data());
+    }
+    else
+    {
+      for (std::size_t i = 0; i < (std::size_t) X.rows(); ++i)
+        X(i, j) = random_value(offset + i, j);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::apply(const GenericLinearOperator& A,
+                                 const Eigen::Ref<const Eigen::MatrixXd>& X,
+                                 Eigen::MatrixXd& Y)
+{
+  dolfin_assert(_x && _y);
+  Y.resize(X.rows(), X.cols());
+  _values.resize(X.rows());
+  for (std::size_t j = 0; j < (std::size_t) X.cols(); ++j)
+  {
+    std::copy(X.col(j).data(), X.col(j).data() + X.rows(), _values.begin());
+    _x->set_local(_values);
+    _x->apply("insert");
+    A.mult(*_x, *_y);
+    _y->get_local(_values);
+    std::copy(_values.begin(), _values.end(), Y.col(j).data());
+  }
+}
+//-----------------------------------------------------------------------------
+void SymmetricEigenSolver::apply(GenericLinearSolver& P,
+                                 const Eigen::Ref<const Eigen::MatrixXd>& X,
+                                 Eigen::MatrixXd& Y)
+{
+  dolfin_assert(_x && _y);
+  Y.resize(X.rows(), X.cols());
+  _values.resize(X.rows());
+  for (std::size_t j = 0; j < (std::size_t) X.cols(); ++j)
+  {
+    std::copy(X.col(j).data(), X.col(j).data() + X.rows(), _values.begin());
+    _x->set_local(_values);
+    _x->apply("insert");
+    _y->zero();
+    P.solve(*_y, *_x);
+    _y->get_local(_values);
+    std::copy(_values.begin(), _values.end(), Y.col(j).data());
+  }
+}
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd
+SymmetricEigenSolver::inner(const Eigen::Ref<const Eigen::MatrixXd>& X,
+                            const Eigen::Ref<const Eigen::MatrixXd>& Y) const
+{
+  Eigen::MatrixXd G = X.transpose()*Y;
+  if (MPI::size(_mpi_comm) > 1)
+  {
+    std::vector<double> values(G.data(), G.data() + G.size());
+    values = MPI::sum(_mpi_comm, values);
+    std::copy(values.begin(), values.end(), G.data());
+  }
+  return G;
+}
+//-----------------------------------------------------------------------------
+Eigen::VectorXd SymmetricEigenSolver::norms(const Eigen::MatrixXd& X) const
+{
+  const Eigen::VectorXd squared_norms = X.colwise().squaredNorm().transpose();
+  std::vector<double> values(squared_norms.data(),
+                             squared_norms.data() + squared_norms.size());
+  if (MPI::size(_mpi_comm) > 1)
+    values = MPI::sum(_mpi_comm, values);
+
+  Eigen::VectorXd r(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    r(i) = std::sqrt(values[i]);
+  return r;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,203 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __SYMMETRIC_EIGEN_SOLVER_H
+#define __SYMMETRIC_EIGEN_SOLVER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Variable.h>
+
+namespace dolfin
+{
+
+  /// Forward declarations
+  class GenericLinearOperator;
+  class GenericLinearSolver;
+  class GenericVector;
+
+  /// This class provides an eigenvalue solver for symmetric problems
+  /// Ax = \lambda x or Ax = \lambda Bx (with B symmetric positive
+  /// definite) which works with any linear algebra backend. The
+  /// operators may be matrices or matrix-free linear operators.
+  ///
+  /// Blocks of vectors are stored contiguously (locally owned
+  /// entries, one column per vector), such that orthogonalization
+  /// and Rayleigh-Ritz projections are performed as dense
+  /// matrix-matrix products.
+  ///
+  /// The following parameters may be specified to control the solver.
+  ///
+  /// 1. "solver"
+  ///
+  ///   "lobpcg"    (locally optimal block preconditioned conjugate
+  ///                gradient, see set_preconditioner)
+  ///   "lanczos"   (thick-restart Lanczos with full
+  ///                reorthogonalization; generalized problems require
+  ///                an LU solver for B)
+  ///
+  /// The default is "lobpcg".
+  ///
+  /// 2. "spectrum"
+  ///
+  ///   "smallest real"  (smallest eigenvalues)
+  ///   "largest real"   (largest eigenvalues)
+  ///
+  /// The default is "smallest real".
+  ///
+  /// 3. "tolerance"
+  ///
+  /// Tolerance for convergence of an eigenpair. LOBPCG uses the
+  /// backward error ||Ax - \lambda Bx|| / ((||A|| + |\lambda| ||B||)
+  /// ||x||), with the norms of A and B estimated from the search
+  /// space, which is also meaningful for eigenvalues close to
+  /// zero. Lanczos uses the residual estimate relative to
+  /// |\lambda|. The default is 1e-8.
+  ///
+  /// 4. "maximum_iterations"
+  ///
+  /// Maximum number of iterations (LOBPCG) or restarts (Lanczos).
+  ///
+  /// 5. "krylov_dimension"
+  ///
+  /// Dimension of the Krylov subspace used by Lanczos before
+  /// restarting. The default (0) is max(2n, n + 20) for n requested
+  /// eigenpairs.
+  ///
+  /// Vectors are created from A (or B) if it is a matrix. Otherwise,
+  /// an initial space must be given by set_initial_space.
+
+  class SymmetricEigenSolver : public Variable
+  {
+  public:
+
+    /// Create eigenvalue solver for Ax = \lambda x
+    explicit SymmetricEigenSolver(std::shared_ptr<const GenericLinearOperator> A);
+
+    /// Create eigenvalue solver for Ax = \lambda Bx
+    SymmetricEigenSolver(std::shared_ptr<const GenericLinearOperator> A,
+                         std::shared_ptr<const GenericLinearOperator> B);
+
+    /// Destructor
+    ~SymmetricEigenSolver();
+
+    /// Set preconditioner for LOBPCG. The residuals r are
+    /// preconditioned by solving Pw = r, e.g. by an iterative solver
+    /// for A (or A - \sigma B) with a loose tolerance.
+    void set_preconditioner(std::shared_ptr<GenericLinearSolver> P);
+
+    /// Set initial space (e.g. eigenvectors of a previous solve)
+    void set_initial_space(const std::vector<std::shared_ptr<const GenericVector>>& x);
+
+    /// Compute the n first eigenpairs (in the part of the spectrum
+    /// given by the parameter "spectrum")
+    void solve(std::size_t n);
+
+    /// Get eigenvalue i
+    double get_eigenvalue(std::size_t i) const;
+
+    /// Get eigenpair i (returns eigenvalue, sets eigenvector x)
+    double get_eigenpair(GenericVector& x, std::size_t i) const;
+
+    /// Get the number of iterations used by the solver
+    std::size_t get_iteration_number() const;
+
+    /// Get the number of converged eigenpairs
+    std::size_t get_number_converged() const;
+
+    /// Default parameter values
+    static Parameters default_parameters()
+    {
+      Parameters p("symmetric_eigen_solver");
+
+      p.add("solver",             "lobpcg");
+      p.add("spectrum",           "smallest real");
+      p.add("tolerance",          1e-8);
+      p.add("maximum_iterations", 1000);
+      p.add("krylov_dimension",   0);
+
+      return p;
+    }
+
+  private:
+
+    // Compute eigenpairs by LOBPCG
+    void solve_lobpcg(std::size_t n);
+
+    // Compute eigenpairs by thick-restart Lanczos
+    void solve_lanczos(std::size_t n);
+
+    // Create vector compatible with operators
+    std::shared_ptr<GenericVector> create_vector() const;
+
+    // Fill block with initial vectors (initial space, completed by
+    // pseudo-random vectors)
+    void initial_block(Eigen::MatrixXd& X) const;
+
+    // Apply operator to each column of block: Y = AX
+    void apply(const GenericLinearOperator& A,
+               const Eigen::Ref<const Eigen::MatrixXd>& X,
+               Eigen::MatrixXd& Y);
+
+    // Apply linear solver to each column of block: solve PY = X
+    void apply(GenericLinearSolver& P,
+               const Eigen::Ref<const Eigen::MatrixXd>& X,
+               Eigen::MatrixXd& Y);
+
+    // Compute X^T Y (summed over processes)
+    Eigen::MatrixXd inner(const Eigen::Ref<const Eigen::MatrixXd>& X,
+                          const Eigen::Ref<const Eigen::MatrixXd>& Y) const;
+
+    // Compute residual norms of block (summed over processes)
+    Eigen::VectorXd norms(const Eigen::MatrixXd& X) const;
+
+    // Operators (Ax = \lambda x or Ax = \lambda Bx)
+    std::shared_ptr<const GenericLinearOperator> _A;
+    std::shared_ptr<const GenericLinearOperator> _B;
+
+    // Preconditioner (LOBPCG)
+    std::shared_ptr<GenericLinearSolver> _P;
+
+    // Initial space
+    std::vector<std::shared_ptr<const GenericVector>> _initial_space;
+
+    // Work vectors for applying operators
+    std::shared_ptr<GenericVector> _x, _y;
+    std::vector<double> _values;
+
+    // MPI communicator
+    MPI_Comm _mpi_comm;
+
+    // Converged eigenvalues and eigenvectors (locally owned entries,
+    // one column per eigenvector)
+    std::vector<double> _eigenvalues;
+    Eigen::MatrixXd _eigenvectors;
+
+    // Number of iterations of last solve
+    std::size_t _num_iterations;
+
+  };
+
+}
+
+#endif
@@ -21,7 +21,7 @@
 // Modified by Martin Sandve Alnes, 2008.
 //
 // First added:  2007-07-03
-// Last changed: 2011-01-14
+// Last changed: 2015-06-12
 
 #ifndef __DOLFIN_VECTOR_H
 #define __DOLFIN_VECTOR_H
@@ -93,6 +93,14 @@ namespace dolfin
 
     //--- Implementation of the GenericVector interface ---
 
+    /// Start update of ghost values (non-blocking)
+    virtual void update_ghost_values_begin() const
+    { vector->update_ghost_values_begin(); }
+
+    /// Complete update of ghost values
+    virtual void update_ghost_values_end() const
+    { vector->update_ghost_values_end(); }
+
     /// Initialize vector to size N
     virtual void init(MPI_Comm comm, std::size_t N)
     { vector->init(comm, N); }
@@ -202,6 +210,16 @@ namespace dolfin
     virtual double inner(const GenericVector& x) const
     { return vector->inner(x); }
 
+    /// Compute inner products with given vectors
+    virtual void multi_inner(const std::vector<const GenericVector*>& y,
+                             std::vector<double>& values) const
+    { vector->multi_inner(y, values); }
+
+    /// Add linear combination of given vectors
+    virtual void multi_axpy(const std::vector<double>& a,
+                            const std::vector<const GenericVector*>& y)
+    { vector->multi_axpy(a, y); }
+
     /// Return norm of vector
     virtual double norm(std::string norm_type) const
     { return vector->norm(norm_type); }
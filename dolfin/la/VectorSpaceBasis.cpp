@@ -16,9 +16,11 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-05-29
-// Last changed: 2013-05-29
+// Last changed: 2015-06-12
 
+#include <cmath>
 #include <dolfin/common/constants.h>
+#include <dolfin/log/log.h>
 #include "VectorSpaceBasis.h"
 
 using namespace dolfin;
@@ -32,15 +34,23 @@ VectorSpaceBasis::VectorSpaceBasis(const std::vector<std::shared_ptr<
 //-----------------------------------------------------------------------------
 bool VectorSpaceBasis::is_orthonormal() const
 {
+  // Compute each row of the Gram matrix with a single reduction
+  std::vector<const GenericVector*> basis(_basis.size());
   for (std::size_t i = 0; i < _basis.size(); i++)
   {
+    dolfin_assert(_basis[i]);
+    basis[i] = _basis[i].get();
+  }
+
+  std::vector<double> dots;
+  for (std::size_t i = 0; i < _basis.size(); i++)
+  {
+    const std::vector<const GenericVector*> y(basis.begin() + i, basis.end());
+    _basis[i]->multi_inner(y, dots);
     for (std::size_t j = i; j < _basis.size(); j++)
     {
-      dolfin_assert(_basis[i]);
-      dolfin_assert(_basis[j]);
       const double delta_ij = (i == j) ? 1.0 : 0.0;
-      const double dot_ij = _basis[i]->inner(*_basis[j]);
-      if (std::abs(delta_ij - dot_ij) > DOLFIN_EPS)
+      if (std::abs(delta_ij - dots[j - i]) > DOLFIN_EPS)
         return false;
     }
   }
@@ -50,32 +60,97 @@ bool VectorSpaceBasis::is_orthonormal() const
 //-----------------------------------------------------------------------------
 bool VectorSpaceBasis::is_orthogonal() const
 {
+  std::vector<const GenericVector*> basis(_basis.size());
   for (std::size_t i = 0; i < _basis.size(); i++)
   {
-    for (std::size_t j = i; j < _basis.size(); j++)
+    dolfin_assert(_basis[i]);
+    basis[i] = _basis[i].get();
+  }
+
+  std::vector<double> dots;
+  for (std::size_t i = 0; i + 1 < _basis.size(); i++)
+  {
+    const std::vector<const GenericVector*> y(basis.begin() + i + 1,
+                                              basis.end());
+    _basis[i]->multi_inner(y, dots);
+    for (std::size_t j = 0; j < dots.size(); j++)
     {
-      dolfin_assert(_basis[i]);
-      dolfin_assert(_basis[j]);
-      if (i != j)
-      {
-        const double dot_ij = _basis[i]->inner(*_basis[j]);
-        if (std::abs(dot_ij) > DOLFIN_EPS)
-          return false;
-      }
+      if (std::abs(dots[j]) > DOLFIN_EPS)
+        return false;
     }
   }
 
   return true;
 }
 //-----------------------------------------------------------------------------
-void VectorSpaceBasis::orthogonalize(GenericVector& x) const
+void VectorSpaceBasis::orthonormalize(double tol)
 {
   for (std::size_t i = 0; i < _basis.size(); i++)
   {
     dolfin_assert(_basis[i]);
-    const double dot = _basis[i]->inner(x);
-    x.axpy(-dot, *_basis[i]);
+    const double norm0 = orthogonalize(*_basis[i], i);
+    const double norm = _basis[i]->norm("l2");
+    if (norm <= tol*norm0)
+    {
+      dolfin_error("VectorSpaceBasis.cpp",
+                   "orthonormalize vector space basis",
+                   "Basis vector %d is linearly dependent on previous "
+                   "basis vectors", i);
+    }
+    *_basis[i] /= norm;
+  }
+}
+//-----------------------------------------------------------------------------
+void VectorSpaceBasis::orthogonalize(GenericVector& x) const
+{
+  orthogonalize(x, _basis.size());
+}
+//-----------------------------------------------------------------------------
+double VectorSpaceBasis::orthogonalize(GenericVector& x, std::size_t n) const
+{
+  dolfin_assert(n <= _basis.size());
+
+  // Compute inner products with basis vectors and with x itself
+  // (for the norm of x) with a single reduction
+  std::vector<const GenericVector*> y(n + 1);
+  for (std::size_t i = 0; i < n; i++)
+  {
+    dolfin_assert(_basis[i]);
+    y[i] = _basis[i].get();
   }
+  y[n] = &x;
+
+  std::vector<double> dots;
+  x.multi_inner(y, dots);
+  const double norm0 = std::sqrt(dots[n]);
+  y.pop_back();
+
+  for (std::size_t pass = 0; pass < 2 && n > 0; pass++)
+  {
+    // Subtract projection onto basis
+    double projected = 0.0;
+    std::vector<double> a(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      a[i] = -dots[i];
+      projected += dots[i]*dots[i];
+    }
+    x.multi_axpy(a, y);
+
+    // Norm of orthogonalized x follows from orthonormality of
+    // basis. Repeat once if most of x was cancelled, since rounding
+    // errors of the projection are then significant relative to the
+    // result.
+    const double norm2 = dots[n] - projected;
+    if (pass == 1 || norm2 > 0.5*dots[n])
+      break;
+
+    y.push_back(&x);
+    x.multi_inner(y, dots);
+    y.pop_back();
+  }
+
+  return norm0;
 }
 //-----------------------------------------------------------------------------
 std::size_t VectorSpaceBasis::dim() const
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-05-29
-// Last changed: 2013-05-29
+// Last changed: 2015-06-12
 
 #ifndef __VECTOR_SPACE_BASIS_H
 #define __VECTOR_SPACE_BASIS_H
@@ -48,7 +48,15 @@ namespace dolfin
     /// Test if basis is orthogonal
     bool is_orthogonal() const;
 
-    /// Orthogonalize x with respect to basis
+    /// Orthonormalize basis by block Gram-Schmidt with
+    /// reorthogonalization. An error is raised if the basis vectors
+    /// are linearly dependent (to within relative tolerance tol).
+    void orthonormalize(double tol=1.0e-10);
+
+    /// Orthogonalize x with respect to (orthonormal) basis. The inner
+    /// products with all basis vectors are computed with a single
+    /// reduction, and the projection is repeated once if it cancels
+    /// most of x.
     void orthogonalize(GenericVector& x) const;
 
     /// Dimension of the basis
@@ -59,6 +67,11 @@ namespace dolfin
 
   private:
 
+    // Orthogonalize x with respect to the first n basis vectors
+    // (classical Gram-Schmidt, repeated if needed). Returns the norm
+    // of x before orthogonalization.
+    double orthogonalize(GenericVector& x, std::size_t n) const;
+
     // Basis vectors
     const std::vector<std::shared_ptr<GenericVector> > _basis;
 
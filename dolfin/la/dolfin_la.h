@@ -59,6 +59,7 @@
 #include <dolfin/la/PETScCuspFactory.h>
 #include <dolfin/la/STLFactory.h>
 #include <dolfin/la/SLEPcEigenSolver.h>
+#include <dolfin/la/SymmetricEigenSolver.h>
 #include <dolfin/la/uBLASSparseMatrix.h>
 #include <dolfin/la/uBLASDenseMatrix.h>
 #include <dolfin/la/uBLASPreconditioner.h>
@@ -74,6 +75,7 @@
 #include <dolfin/la/test_nullspace.h>
 #include <dolfin/la/BlockVector.h>
 #include <dolfin/la/BlockMatrix.h>
+#include <dolfin/la/BlockPreconditioner.h>
 #include <dolfin/la/LinearOperator.h>
 
 #endif
@@ -18,18 +18,79 @@
 // Modified by Anders Logg, 2006-2010.
 //
 // First added:  2006-06-23
-// Last changed: 2010-08-31
+// Last changed: 2015-06-12
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
 #include <dolfin/common/constants.h>
+#include "uBLASKernels.h"
 #include "uBLASVector.h"
 #include "uBLASSparseMatrix.h"
 #include "uBLASILUPreconditioner.h"
 
+#ifdef HAS_OPENMP
+#include <omp.h>
+#endif
+
 using namespace dolfin;
 
+namespace
+{
+  // Group rows of matrix by level, such that each row only depends
+  // on rows in previous levels through its strictly lower (lower =
+  // true) or upper (lower = false) triangular part
+  void compute_levels(const ublas_sparse_matrix& A, bool lower,
+                      std::vector<std::size_t>& offsets,
+                      std::vector<std::size_t>& rows)
+  {
+    const std::size_t n = A.size1();
+    const std::size_t* row_ptr = A.index1_data().begin();
+    const std::size_t* cols = A.index2_data().begin();
+
+    std::vector<std::size_t> level(n, 0);
+    std::size_t num_levels = 0;
+    for (std::size_t k = 0; k < n; ++k)
+    {
+      const std::size_t i = lower ? k : n - 1 - k;
+      std::size_t l = 0;
+      for (std::size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p)
+      {
+        const std::size_t j = cols[p];
+        if ((lower && j < i) || (!lower && j > i))
+          l = std::max(l, level[j] + 1);
+      }
+      level[i] = l;
+      num_levels = std::max(num_levels, l + 1);
+    }
+
+    // Sort rows by level
+    offsets.assign(num_levels + 1, 0);
+    for (std::size_t i = 0; i < n; ++i)
+      ++offsets[level[i] + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<std::size_t> position(offsets.begin(), offsets.end() - 1);
+    rows.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      rows[position[level[i]]++] = i;
+  }
+
+  // Number of threads for processing levels (a single thread if
+  // levels are smaller than min_level_size on average)
+  int level_threads(const std::vector<std::size_t>& offsets,
+                    std::size_t min_level_size)
+  {
+    const std::size_t num_levels = offsets.size() - 1;
+    if (num_levels == 0 || offsets.back()/num_levels < min_level_size)
+      return 1;
+    return uBLASKernels::num_threads();
+  }
+}
+
 //-----------------------------------------------------------------------------
 uBLASILUPreconditioner::uBLASILUPreconditioner(const Parameters& krylov_parameters)
-  : parameters(krylov_parameters)
+  : num_solve_threads(1), parameters(krylov_parameters)
 {
   // Do nothing
 }
@@ -96,89 +157,161 @@ void uBLASILUPreconditioner::init(const uBLASMatrix<ublas_sparse_matrix>& P)
 
   // The below algorithm is based on that in the book
   // Y. Saad, "Iterative Methods for Sparse Linear Systems", p.276-278.
-  // It is specific to compressed row storage
+  // It is specific to compressed row storage. Row k only depends on
+  // the rows of its strictly lower triangular part, so the rows of
+  // each level of the lower triangular factor are factorized
+  // concurrently.
+  compute_levels(_matM, true, lower_level_offsets, lower_level_rows);
+  compute_levels(_matM, false, upper_level_offsets, upper_level_rows);
+
+  const std::size_t* row_ptr = _matM.index1_data().begin();
+  const std::size_t* cols = _matM.index2_data().begin();
+  double* values = _matM.value_data().begin();
 
-  // Initialise some data
-  diagonal.resize(size);
-  diagonal[0] = 0;
+  diagonal.assign(size, 0);
 
-  std::vector<std::size_t> iw(size);
-  for(std::size_t i=0; i< size; ++i)
-    iw[i] = 0;
+  // Number of threads for factorization and solves (computed once
+  // per factorization)
+  const int min_level_size = parameters("preconditioner")["minimum_level_size"];
+  const int num_threads = level_threads(lower_level_offsets, min_level_size);
+  num_solve_threads = std::min(num_threads,
+                               level_threads(upper_level_offsets,
+                                             min_level_size));
 
-  std::size_t j0=0, j1=0, j=0, jrow=0, jw=0;
-  double t1;
+  std::vector<std::int64_t> zero_pivot(num_threads, -1);
 
-  for (std::size_t k = 0; k < size ; ++k)        // i (rows)
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_threads)
+  #endif
   {
-    j0 = _matM.index1_data () [k];    // ia
-    j1 = _matM.index1_data () [k+1]-1;
+    #ifdef HAS_OPENMP
+    const int thread = omp_get_thread_num();
+    #else
+    const int thread = 0;
+    #endif
 
-    // Initialise working array iw
-    for (std::size_t i = j0;  i <= j1; ++i)
-      iw[ _matM.index2_data () [i] ] = i;  // ja
+    // Working array (position + 1 of entries of current row, 0 if
+    // not in row)
+    std::vector<std::size_t> iw(size, 0);
 
-    // Move along row looking for diagonal
-    j=j0;
-    while(j <= j1)
+    for (std::size_t l = 0; l + 1 < lower_level_offsets.size(); ++l)
     {
-      jrow = _matM.index2_data () [j];  // ja
-
-      if( jrow >= k ) // passed or found diagonal, therefore break
-        break;
+      const std::int64_t begin = lower_level_offsets[l];
+      const std::int64_t end = lower_level_offsets[l + 1];
 
-      t1 = (_matM.value_data() [j])/(_matM.value_data() [ diagonal[jrow] ]);  //M(k,j) = M(k,j)/M(j,j)
-      _matM.value_data() [j] = t1;
-      for(std::size_t jj = diagonal[jrow]+1; jj <= _matM.index1_data () [jrow+1]-1; ++jj)
+      #ifdef HAS_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (std::int64_t r = begin; r < end; ++r)
       {
-        jw = iw[ _matM.index2_data () [jj] ];
-        if(jw != 0)
-          _matM.value_data() [jw] = _matM.value_data() [jw] -t1*(_matM.value_data() [jj]);
-      } // jj
-      ++j;
+        const std::size_t k = lower_level_rows[r];
+        const std::size_t j0 = row_ptr[k];
+        const std::size_t j1 = row_ptr[k + 1];
+
+        // Initialise working array iw
+        for (std::size_t i = j0; i < j1; ++i)
+          iw[cols[i]] = i + 1;
+
+        // Move along row looking for diagonal
+        std::size_t j = j0;
+        std::size_t jrow = size;
+        while (j < j1)
+        {
+          jrow = cols[j];
+          if (jrow >= k) // passed or found diagonal, therefore break
+            break;
+
+          // M(k,j) = M(k,j)/M(j,j)
+          const double t1 = values[j]/values[diagonal[jrow]];
+          values[j] = t1;
+          for (std::size_t jj = diagonal[jrow] + 1; jj < row_ptr[jrow + 1]; ++jj)
+          {
+            const std::size_t jw = iw[cols[jj]];
+            if (jw != 0)
+              values[jw - 1] -= t1*values[jj];
+          }
+          ++j;
+        }
+        diagonal[k] = j;
+
+        if (jrow != k || std::abs(values[j]) < DOLFIN_EPS)
+          zero_pivot[thread] = k;
+
+        for (std::size_t i = j0; i < j1; ++i)
+          iw[cols[i]] = 0;
+      }
     }
-    diagonal[k] = j;
+  }
 
-    if (jrow != k || fabs( _matM.value_data() [j] ) < DOLFIN_EPS)
+  for (std::size_t i = 0; i < zero_pivot.size(); ++i)
+  {
+    if (zero_pivot[i] >= 0)
     {
       dolfin_error("uBLASILUPreconditioner.cpp",
                    "initialize uBLAS ILU preconditioner",
-                   "Zero pivot detected in row %u", k);
+                   "Zero pivot detected in row %u",
+                   (unsigned int) zero_pivot[i]);
     }
-
-    for(std::size_t i=j0; i <= j1; ++i)
-      iw[ _matM.index2_data () [i] ] = 0;
-  } // k
+  }
 }
 //-----------------------------------------------------------------------------
 void uBLASILUPreconditioner::solve(uBLASVector& x, const uBLASVector& b) const
 {
   // Get underlying uBLAS matrices and vectors
-  ublas_vector& _x = x.vec();
-  const ublas_vector& _b = b.vec();
   const ublas_sparse_matrix & _matM = M.mat();
 
   dolfin_assert(_matM.size1() > 0 && _matM.size2() > 0);
-  dolfin_assert( _x.size() == _matM.size1() );
-  dolfin_assert( _x.size() == _b.size());
+  dolfin_assert(x.size() == _matM.size1());
+  dolfin_assert(x.size() == b.size());
+
+  const std::size_t* row_ptr = _matM.index1_data().begin();
+  const std::size_t* cols = _matM.index2_data().begin();
+  const double* values = _matM.value_data().begin();
 
   // Solve in-place
-  _x.assign(_b);
+  double* _x = x.data();
+  const double* _b = b.data();
 
-  // Perform substitutions for compressed row storage. This is the fastest.
-  const std::size_t size = _matM.size1();
-  for(std::size_t i =0; i < size; ++i)
+  // Perform substitutions for compressed row storage, level by level
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_solve_threads)
+  #endif
   {
-    std::size_t k;
-    for(k = _matM.index1_data () [i]; k < diagonal[i]; ++k)
-      _x(i) -= ( _matM.value_data () [k] )*x[ _matM.index2_data () [k] ];
-  }
-  for(int i =size-1; i >= 0; --i)
-  {
-    std::size_t k;
-    for(k = _matM.index1_data () [i+1]-1; k > diagonal[i]; --k)
-      _x(i) -= ( _matM.value_data () [k] )*x[ _matM.index2_data () [k] ];
-    _x(i) /= ( _matM.value_data () [k] );
+    for (std::size_t l = 0; l + 1 < lower_level_offsets.size(); ++l)
+    {
+      const std::int64_t begin = lower_level_offsets[l];
+      const std::int64_t end = lower_level_offsets[l + 1];
+
+      #ifdef HAS_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (std::int64_t r = begin; r < end; ++r)
+      {
+        const std::size_t i = lower_level_rows[r];
+        double s = _b[i];
+        for (std::size_t k = row_ptr[i]; k < diagonal[i]; ++k)
+          s -= values[k]*_x[cols[k]];
+        _x[i] = s;
+      }
+    }
+
+    for (std::size_t l = 0; l + 1 < upper_level_offsets.size(); ++l)
+    {
+      const std::int64_t begin = upper_level_offsets[l];
+      const std::int64_t end = upper_level_offsets[l + 1];
+
+      #ifdef HAS_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (std::int64_t r = begin; r < end; ++r)
+      {
+        const std::size_t i = upper_level_rows[r];
+        double s = _x[i];
+        for (std::size_t k = diagonal[i] + 1; k < row_ptr[i + 1]; ++k)
+          s -= values[k]*_x[cols[k]];
+        _x[i] = s/values[diagonal[i]];
+      }
+    }
   }
 }
 //-----------------------------------------------------------------------------
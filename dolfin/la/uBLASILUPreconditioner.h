@@ -18,7 +18,7 @@
 // Modified by Anders Logg 2006.
 //
 // First added:  2006-06-23
-// Last changed: 2009-07-03
+// Last changed: 2015-06-12
 
 #ifndef __UBLAS_ILU_PRECONDITIONER_H
 #define __UBLAS_ILU_PRECONDITIONER_H
@@ -35,6 +35,14 @@ namespace dolfin
 
   /// This class implements an incomplete LU factorization (ILU)
   /// preconditioner for the uBLAS Krylov solver.
+  ///
+  /// The factorization and the triangular solves are level
+  /// scheduled: rows are grouped in levels such that rows in the same
+  /// level do not depend on each other, and each level is processed
+  /// by the number of threads given by the global parameter
+  /// "num_threads" (when DOLFIN is built with OpenMP), unless the
+  /// levels are smaller than the Krylov solver parameter
+  /// "preconditioner.minimum_level_size" on average.
 
   class uBLASILUPreconditioner : public uBLASPreconditioner
   {
@@ -60,6 +68,14 @@ namespace dolfin
     // Diagonal
     std::vector<std::size_t> diagonal;
 
+    // Rows grouped by level for the lower (forward) and upper
+    // (backward) triangular solves
+    std::vector<std::size_t> lower_level_offsets, lower_level_rows;
+    std::vector<std::size_t> upper_level_offsets, upper_level_rows;
+
+    // Number of threads for the triangular solves
+    int num_solve_threads;
+
     const Parameters& parameters;
 
   };
@@ -0,0 +1,132 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <cstdint>
+#include <dolfin/parameter/GlobalParameters.h>
+#include "uBLASKernels.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+std::size_t uBLASKernels::num_threads()
+{
+  #ifdef HAS_OPENMP
+  return std::max((int) parameters["num_threads"], 1);
+  #else
+  return 1;
+  #endif
+}
+//-----------------------------------------------------------------------------
+std::size_t uBLASKernels::num_threads(std::size_t n,
+                                      std::size_t min_size_per_thread)
+{
+  return num_threads(n, num_threads(), min_size_per_thread);
+}
+//-----------------------------------------------------------------------------
+std::size_t uBLASKernels::num_threads(std::size_t n, std::size_t max_threads,
+                                      std::size_t min_size_per_thread)
+{
+  const std::size_t max_size_threads
+    = n/std::max(min_size_per_thread, (std::size_t) 1);
+  return std::max(std::min(max_threads, max_size_threads), (std::size_t) 1);
+}
+//-----------------------------------------------------------------------------
+void uBLASKernels::mult(const ublas_sparse_matrix& A, const double* x,
+                        double* y, std::size_t num_threads)
+{
+  const std::int64_t m = A.size1();
+  const std::size_t* row_ptr = A.index1_data().begin();
+  const std::size_t* cols = A.index2_data().begin();
+  const double* values = A.value_data().begin();
+
+  // Empty matrix (no row pointers stored)
+  if (A.filled1() < (std::size_t) m + 1)
+  {
+    std::fill(y, y + m, 0.0);
+    for (std::int64_t i = 0; i + 1 < (std::int64_t) A.filled1(); ++i)
+    {
+      for (std::size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k)
+        y[i] += values[k]*x[cols[k]];
+    }
+    return;
+  }
+
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads) schedule(static)
+  #endif
+  for (std::int64_t i = 0; i < m; ++i)
+  {
+    double s = 0.0;
+    for (std::size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k)
+      s += values[k]*x[cols[k]];
+    y[i] = s;
+  }
+}
+//-----------------------------------------------------------------------------
+double uBLASKernels::inner(const double* x, const double* y, std::size_t n,
+                           std::size_t num_threads)
+{
+  const std::int64_t _n = n;
+  double s = 0.0;
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads) reduction(+:s)
+  #endif
+  for (std::int64_t i = 0; i < _n; ++i)
+    s += x[i]*y[i];
+  return s;
+}
+//-----------------------------------------------------------------------------
+void uBLASKernels::copy(double* w, const double* x, std::size_t n,
+                        std::size_t num_threads)
+{
+  const std::int64_t _n = n;
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < _n; ++i)
+    w[i] = x[i];
+}
+//-----------------------------------------------------------------------------
+void uBLASKernels::lincomb(double* w, double a, const double* x,
+                           double b, const double* y, std::size_t n,
+                           std::size_t num_threads)
+{
+  const std::int64_t _n = n;
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < _n; ++i)
+    w[i] = a*x[i] + b*y[i];
+}
+//-----------------------------------------------------------------------------
+void uBLASKernels::lincomb(double* w, double a, const double* x,
+                           double b, const double* y,
+                           double c, const double* z, std::size_t n,
+                           std::size_t num_threads)
+{
+  const std::int64_t _n = n;
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < _n; ++i)
+    w[i] = a*x[i] + b*y[i] + c*z[i];
+}
+//-----------------------------------------------------------------------------
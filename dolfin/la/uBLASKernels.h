@@ -0,0 +1,83 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __UBLAS_KERNELS_H
+#define __UBLAS_KERNELS_H
+
+#include <cstddef>
+#include "ublas.h"
+
+namespace dolfin
+{
+
+  /// This class provides the sparse matrix-vector product and vector
+  /// operations used by the uBLAS backend and Krylov solver. The
+  /// loops are distributed over the given number of threads when
+  /// DOLFIN is built with OpenMP. Callers in inner loops should
+  /// compute the number of threads once, see num_threads().
+
+  class uBLASKernels
+  {
+  public:
+
+    /// Return number of threads given by the global parameter
+    /// "num_threads" (1 when DOLFIN is built without OpenMP). The
+    /// parameter is looked up on every call.
+    static std::size_t num_threads();
+
+    /// Return number of threads to use for loops of length n, such
+    /// that each thread processes at least min_size_per_thread
+    /// entries (short loops are processed by a single thread)
+    static std::size_t num_threads(std::size_t n,
+                                   std::size_t min_size_per_thread=4096);
+
+    /// Same as above, but for given number of available threads
+    /// (does not access parameters)
+    static std::size_t num_threads(std::size_t n, std::size_t max_threads,
+                                   std::size_t min_size_per_thread);
+
+    /// Compute y = Ax for compressed row matrix
+    static void mult(const ublas_sparse_matrix& A, const double* x,
+                     double* y, std::size_t num_threads);
+
+    /// Return inner product (x, y)
+    static double inner(const double* x, const double* y, std::size_t n,
+                        std::size_t num_threads);
+
+    /// Compute w = x
+    static void copy(double* w, const double* x, std::size_t n,
+                     std::size_t num_threads);
+
+    /// Compute w = a x + b y (w may be equal to x or y)
+    static void lincomb(double* w, double a, const double* x,
+                        double b, const double* y, std::size_t n,
+                        std::size_t num_threads);
+
+    /// Compute w = a x + b y + c z (w may be equal to x, y or z)
+    static void lincomb(double* w, double a, const double* x,
+                        double b, const double* y,
+                        double c, const double* z, std::size_t n,
+                        std::size_t num_threads);
+
+  };
+
+}
+
+#endif
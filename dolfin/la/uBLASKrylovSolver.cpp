@@ -18,17 +18,42 @@
 // Modified by Anders Logg 2006-2012
 //
 // First added:  2006-05-31
-// Last changed: 2012-05-07
+// Last changed: 2015-06-12
 
 #include <dolfin/common/NoDeleter.h>
 #include <dolfin/log/LogStream.h>
 #include "uBLASILUPreconditioner.h"
 #include "uBLASDummyPreconditioner.h"
 #include "uBLASKrylovSolver.h"
+#include "BlockMatrix.h"
 #include "KrylovSolver.h"
 
 using namespace dolfin;
 
+namespace
+{
+  // Block matrix acting on concatenated vectors
+  class uBLASBlockOperator
+  {
+  public:
+
+    uBLASBlockOperator(const BlockMatrix& A, std::size_t M, std::size_t N)
+      : _A(A), _M(M), _N(N) {}
+
+    std::size_t size(std::size_t dim) const
+    { return dim == 0 ? _M : _N; }
+
+    void mult(const uBLASVector& x, uBLASVector& y) const
+    { _A.mult(x, y); }
+
+  private:
+
+    const BlockMatrix& _A;
+    const std::size_t _M, _N;
+
+  };
+}
+
 //-----------------------------------------------------------------------------
 std::map<std::string, std::string> uBLASKrylovSolver::methods()
 {
@@ -49,6 +74,14 @@ Parameters uBLASKrylovSolver::default_parameters()
 {
   Parameters p(KrylovSolver::default_parameters());
   p.rename("ublas_krylov_solver");
+
+  // Minimum vector length per thread for threaded vector operations
+  p.add("minimum_size_per_thread", 4096);
+
+  // Minimum average number of rows per level for threaded ILU
+  // factorization and triangular solves
+  p("preconditioner").add("minimum_level_size", 256);
+
   return p;
 }
 //-----------------------------------------------------------------------------
@@ -60,7 +93,15 @@ uBLASKrylovSolver::uBLASKrylovSolver(std::string method,
   div_tol(0.0),
   max_it(0),
   restart(0),
-  report(false)
+  min_size_per_thread(0),
+  report(false),
+  num_threads(1),
+  _rtol(parameters, "relative_tolerance"),
+  _atol(parameters, "absolute_tolerance"),
+  _div_tol(parameters, "divergence_limit"),
+  _max_it(parameters, "maximum_iterations"),
+  _min_size_per_thread(parameters, "minimum_size_per_thread"),
+  _report(parameters, "report")
 {
   // Set parameter values
   parameters = default_parameters();
@@ -72,7 +113,13 @@ uBLASKrylovSolver::uBLASKrylovSolver(std::string method,
 uBLASKrylovSolver::uBLASKrylovSolver(uBLASPreconditioner& pc)
   : _method("default"), _pc(reference_to_no_delete_pointer(pc)),
   rtol(0.0), atol(0.0), div_tol(0.0), max_it(0), restart(0),
-  report(false)
+  min_size_per_thread(0), report(false), num_threads(1),
+  _rtol(parameters, "relative_tolerance"),
+  _atol(parameters, "absolute_tolerance"),
+  _div_tol(parameters, "divergence_limit"),
+  _max_it(parameters, "maximum_iterations"),
+  _min_size_per_thread(parameters, "minimum_size_per_thread"),
+  _report(parameters, "report")
 {
   // Set parameter values
   parameters = default_parameters();
@@ -82,7 +129,13 @@ uBLASKrylovSolver::uBLASKrylovSolver(std::string method,
                                      uBLASPreconditioner& pc)
   : _method(method), _pc(reference_to_no_delete_pointer(pc)),
   rtol(0.0), atol(0.0), div_tol(0.0), max_it(0), restart(0),
-  report(false)
+  min_size_per_thread(0), report(false), num_threads(1),
+  _rtol(parameters, "relative_tolerance"),
+  _atol(parameters, "absolute_tolerance"),
+  _div_tol(parameters, "divergence_limit"),
+  _max_it(parameters, "maximum_iterations"),
+  _min_size_per_thread(parameters, "minimum_size_per_thread"),
+  _report(parameters, "report")
 {
   // Set parameter values
   parameters = default_parameters();
@@ -144,6 +197,14 @@ std::size_t uBLASKrylovSolver::solve(const GenericLinearOperator& A,
   return solve(as_type<uBLASVector>(x), as_type<const uBLASVector>(b));
 }
 //-----------------------------------------------------------------------------
+std::size_t uBLASKrylovSolver::solve(const BlockMatrix& A, uBLASVector& x,
+                                     const uBLASVector& b)
+{
+  // Block matrix must be square, with size given by right-hand side
+  const uBLASBlockOperator _A(A, b.size(), b.size());
+  return solve_krylov(_A, x, b, A);
+}
+//-----------------------------------------------------------------------------
 void uBLASKrylovSolver::select_preconditioner(std::string preconditioner)
 {
   if (preconditioner == "none")
@@ -162,11 +223,12 @@ void uBLASKrylovSolver::select_preconditioner(std::string preconditioner)
 void uBLASKrylovSolver::read_parameters()
 {
   // Set tolerances and other parameters
-  rtol    = parameters["relative_tolerance"];
-  atol    = parameters["absolute_tolerance"];
-  div_tol = parameters["divergence_limit"];
-  max_it  = parameters["maximum_iterations"];
+  rtol    = _rtol.value();
+  atol    = _atol.value();
+  div_tol = _div_tol.value();
+  max_it  = _max_it.value();
   restart = parameters("gmres")["restart"];
-  report  = parameters["report"];
+  report  = _report.value();
+  min_size_per_thread = _min_size_per_thread.value();
 }
 //-----------------------------------------------------------------------------
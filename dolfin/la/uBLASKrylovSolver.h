@@ -18,18 +18,21 @@
 // Modified by Anders Logg 2006-2012
 //
 // First added:  2006-05-31
-// Last changed: 2012-08-20
+// Last changed: 2015-06-12
 
 #ifndef __UBLAS_KRYLOV_SOLVER_H
 #define __UBLAS_KRYLOV_SOLVER_H
 
+#include <cmath>
 #include <set>
 #include <string>
 #include <memory>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/types.h>
+#include <dolfin/parameter/CachedParameter.h>
 #include "ublas.h"
 #include "GenericLinearSolver.h"
+#include "uBLASKernels.h"
 #include "uBLASLinearOperator.h"
 #include "uBLASMatrix.h"
 #include "uBLASVector.h"
@@ -38,6 +41,7 @@
 namespace dolfin
 {
 
+  class BlockMatrix;
   class GenericLinearOperator;
   class GenericVector;
 
@@ -91,6 +95,13 @@ namespace dolfin
     std::size_t solve(const GenericLinearOperator& A, GenericVector& x,
                       const GenericVector& b);
 
+    /// Solve block linear system Ax = b, with x and b the
+    /// concatenation of the blocks of the solution and right-hand
+    /// side, and return number of iterations. The preconditioner must
+    /// support block matrices (see BlockPreconditioner).
+    std::size_t solve(const BlockMatrix& A, uBLASVector& x,
+                      const uBLASVector& b);
+
     /// Return a list of available solver methods
     static std::map<std::string, std::string> methods();
 
@@ -140,9 +151,17 @@ namespace dolfin
 
     /// Solver parameters
     double rtol, atol, div_tol;
-    std::size_t max_it, restart;
+    std::size_t max_it, restart, min_size_per_thread;
     bool report;
 
+    /// Number of threads for vector operations
+    std::size_t num_threads;
+
+    /// Parameters read in every solve
+    CachedParameter<double> _rtol, _atol, _div_tol;
+    CachedParameter<std::size_t> _max_it, _min_size_per_thread;
+    CachedParameter<bool> _report;
+
     /// Operator (the matrix)
     std::shared_ptr<const GenericLinearOperator> _matA;
 
@@ -179,6 +198,11 @@ namespace dolfin
     // Read parameters if not done
     read_parameters();
 
+    // Number of threads for vector operations (computed once per
+    // solve and passed to the kernels)
+    num_threads = uBLASKernels::num_threads(N, uBLASKernels::num_threads(),
+                                            min_size_per_thread);
+
     // Write a message
     if (report)
       info("Solving linear system of size %ld x %ld (uBLAS Krylov solver).", M, N);
@@ -238,16 +262,11 @@ namespace dolfin
                                               const uBLASVector& b,
                                               bool& converged) const
   {
-    // Get underlying uBLAS vectors
-    ublas_vector& _x = x.vec();
-    const ublas_vector& _b = b.vec();
-
     // Get size of system
     const std::size_t size = A.size(0);
 
     // Create residual vector
     uBLASVector r(size);
-    ublas_vector& _r = r.vec();
 
     // Create H matrix and h vector
     ublas_matrix_cmajor_tri H(restart, restart);
@@ -256,12 +275,12 @@ namespace dolfin
     // Create gamma vector
     ublas_vector _gamma(restart + 1);
 
-    // Matrix containing v_k as columns.
+    // Matrix containing v_k as columns (stored contiguously)
     ublas_matrix_cmajor V(size, restart + 1);
+    double* _V = &V.data()[0];
 
     // w vector
     uBLASVector w(size);
-    ublas_vector& _w = w.vec();
 
     // Givens vectors
     ublas_vector _c(restart), _s(restart);
@@ -274,18 +293,18 @@ namespace dolfin
     while (iteration < max_it && !converged)
     {
       // Compute residual r = b -A*x
-      //noalias(r) = b;
-      //axpy_prod(A, -x, r, false);
       A.mult(x, r);
-      _r *= -1.0;
-      noalias(_r) += _b;
+      uBLASKernels::lincomb(r.data(), 1.0, b.data(), -1.0, r.data(), size,
+                            num_threads);
 
       // Apply preconditioner (use w for temporary storage)
-      _w.assign(_r);
+      uBLASKernels::copy(w.data(), r.data(), size, num_threads);
       _pc->solve(r, w);
 
       // L2 norm of residual (for most recent restart)
-      const double beta = norm_2(_r);
+      const double beta
+        = std::sqrt(uBLASKernels::inner(r.data(), r.data(), size,
+                                        num_threads));
 
      // Save initial residual (from restart 0)
      if(iteration == 0)
@@ -302,7 +321,8 @@ namespace dolfin
       _gamma(0) = beta;
 
       // Create first column of V
-      noalias(column(V, 0)) = _r/beta;
+      uBLASKernels::lincomb(_V, 1.0/beta, r.data(), 0.0, r.data(), size,
+                            num_threads);
 
       // Modified Gram-Schmidt procedure
       std::size_t subiteration = 0;
@@ -311,23 +331,27 @@ namespace dolfin
              && r_norm/beta < div_tol)
       {
         // Compute product w = A*V_j (use r for temporary storage)
-        //axpy_prod(A, column(V, j), w, true);
-        noalias(_r) = column(V, j);
+        const double* _Vj = _V + j*size;
+        uBLASKernels::copy(r.data(), _Vj, size, num_threads);
         A.mult(r, w);
 
         // Apply preconditioner (use r for temporary storage)
-        _r.assign(_w);
+        uBLASKernels::copy(r.data(), w.data(), size, num_threads);
         _pc->solve(w, r);
 
         for (std::size_t i=0; i <= j; ++i)
         {
-          _h(i)= inner_prod(_w, column(V,i));
-          noalias(_w) -= _h(i)*column(V,i);
+          const double* _Vi = _V + i*size;
+          _h(i) = uBLASKernels::inner(w.data(), _Vi, size, num_threads);
+          uBLASKernels::lincomb(w.data(), 1.0, w.data(), -_h(i), _Vi, size,
+                                num_threads);
         }
-        _h(j+1) = norm_2(_w);
+        _h(j+1) = std::sqrt(uBLASKernels::inner(w.data(), w.data(), size,
+                                                num_threads));
 
         // Insert column of V (inserting v_(j+1)
-        noalias(column(V,j+1)) = _w/_h(j+1);
+        uBLASKernels::lincomb(_V + (j + 1)*size, 1.0/_h(j+1), w.data(),
+                              0.0, w.data(), size, num_threads);
 
         // Apply previous Givens rotations to the "new" column (this
         // could be improved? - use more uBLAS functions.  The below
@@ -388,9 +412,11 @@ namespace dolfin
       ublas::inplace_solve(Htrunc, _g, ublas::upper_tag ());
 
       // x_m = x_0 + V*y
-      ublas_matrix_cmajor_range _v( V, ublas::range(0,V.size1()),
-                                    ublas::range(0,subiteration) );
-      axpy_prod(_v, _g, _x, false);
+      for (std::size_t i = 0; i < subiteration; ++i)
+      {
+        uBLASKernels::lincomb(x.data(), 1.0, x.data(), _g(i), _V + i*size,
+                              size, num_threads);
+      }
     }
     return iteration;
   }
@@ -401,36 +427,24 @@ namespace dolfin
                                                  const uBLASVector& b,
                                                  bool& converged) const
   {
-    // Get underlying uBLAS vectors
-    ublas_vector& _x = x.vec();
-    const ublas_vector& _b = b.vec();
-
    // Get size of system
     const std::size_t size = A.size(0);
 
     // Allocate vectors
     uBLASVector r(size), rstar(size), p(size), s(size), v(size), t(size),
       y(size), z(size);
-    ublas_vector& _r = r.vec();
-    ublas_vector& _rstar = rstar.vec();
-    ublas_vector& _p = p.vec();
-    ublas_vector& _s = s.vec();
-    ublas_vector& _v = v.vec();
-    ublas_vector& _t = t.vec();
-    ublas_vector& _y = y.vec();
-    ublas_vector& _z = z.vec();
 
     double alpha = 1.0, beta = 0.0, omega = 1.0, r_norm = 0.0;
     double rho_old = 1.0, rho = 1.0;
 
     // Compute residual r = b -A*x
-    //r.assign(b);
-    //axpy_prod(A, -x, r, false);
     A.mult(x, r);
-    r *= -1.0;
-    noalias(_r) += _b;
+    uBLASKernels::lincomb(r.data(), 1.0, b.data(), -1.0, r.data(), size,
+                          num_threads);
 
-    const double r0_norm = norm_2(_r);
+    const double r0_norm
+      = std::sqrt(uBLASKernels::inner(r.data(), r.data(), size,
+                                      num_threads));
     if( r0_norm < atol )
     {
       converged = true;
@@ -438,9 +452,9 @@ namespace dolfin
     }
 
     // Initialise r^star, v and p
-    _rstar.assign(_r);
-    _v.clear();
-    _p.clear();
+    uBLASKernels::copy(rstar.data(), r.data(), size, num_threads);
+    v.zero();
+    p.zero();
 
     // Apply preconditioner to r^start. This is a trick to avoid
     // problems in which (r^start, r) = 0 after the first iteration
@@ -459,7 +473,7 @@ namespace dolfin
       rho_old = rho;
 
       // Compute new rho
-      rho = ublas::inner_prod(_r, _rstar);
+      rho = uBLASKernels::inner(r.data(), rstar.data(), size, num_threads);
       if( fabs(rho) < 1e-25 )
       {
         dolfin_error("uBLASKrylovSolver.h",
@@ -470,40 +484,44 @@ namespace dolfin
       beta = (rho/rho_old)*(alpha/omega);
 
       // p = r1 + beta*p - beta*omega*A*p
-      p *= beta;
-      noalias(_p) += _r - beta*omega*_v;
+      uBLASKernels::lincomb(p.data(), 1.0, r.data(), beta, p.data(),
+                            -beta*omega, v.data(), size, num_threads);
 
       // My = p
       _pc->solve(y, p);
 
       // v = A*y
-      //axpy_prod(A, y, v, true);
       A.mult(y, v);
 
       // alpha = (r, rstart) / (v, rstar)
-      alpha = rho/ublas::inner_prod(_v, _rstar);
+      alpha = rho/uBLASKernels::inner(v.data(), rstar.data(), size,
+                                      num_threads);
 
       // s = r - alpha*v
-      noalias(_s) = _r - alpha*_v;
+      uBLASKernels::lincomb(s.data(), 1.0, r.data(), -alpha, v.data(), size,
+                            num_threads);
 
       // Mz = s
       _pc->solve(z, s);
 
       // t = A*z
-      //axpy_prod(A, z, t, true);
       A.mult(z, t);
 
       // omega = (t, s) / (t,t)
-      omega = ublas::inner_prod(_t, _s)/ublas::inner_prod(_t, _t);
+      omega = uBLASKernels::inner(t.data(), s.data(), size, num_threads)
+        /uBLASKernels::inner(t.data(), t.data(), size, num_threads);
 
       // x = x + alpha*p + omega*s
-      noalias(_x) += alpha*_y + omega*_z;
+      uBLASKernels::lincomb(x.data(), 1.0, x.data(), alpha, y.data(),
+                            omega, z.data(), size, num_threads);
 
       // r = s - omega*t
-      noalias(_r) = _s - omega*_t;
+      uBLASKernels::lincomb(r.data(), 1.0, s.data(), -omega, t.data(), size,
+                            num_threads);
 
       // Compute norm of the residual and check for convergence
-      r_norm = norm_2(_r);
+      r_norm = std::sqrt(uBLASKernels::inner(r.data(), r.data(), size,
+                                             num_threads));
       if( r_norm/r0_norm < rtol || r_norm < atol)
         converged = true;
 
@@ -22,7 +22,7 @@
 // Modified by Dag Lindbo 2008
 //
 // First added:  2006-07-05
-// Last changed: 2012-08-20
+// Last changed: 2015-06-12
 
 #ifndef __UBLAS_MATRIX_H
 #define __UBLAS_MATRIX_H
@@ -37,6 +37,7 @@
 #include "TensorLayout.h"
 #include "ublas.h"
 #include "uBLASFactory.h"
+#include "uBLASKernels.h"
 #include "uBLASVector.h"
 
 namespace dolfin
@@ -755,6 +756,39 @@ namespace dolfin
                  &_matA.value_data()[0], _matA.nnz());
   }
   //---------------------------------------------------------------------------
+  template <>
+  inline void uBLASMatrix<ublas_sparse_matrix>::mult(const GenericVector& x,
+                                                     GenericVector& y) const
+  {
+    const uBLASVector& xx = as_type<const uBLASVector>(x);
+    uBLASVector& yy = as_type<uBLASVector>(y);
+
+    if (size(1) != xx.size())
+    {
+      dolfin_error("uBLASMatrix.h",
+                   "compute matrix-vector product with uBLAS matrix",
+                   "Non-matching dimensions for matrix-vector product");
+    }
+
+    // Resize RHS if empty
+    if (yy.empty())
+      init_vector(yy, 0);
+
+    if (size(0) != yy.size())
+    {
+      dolfin_error("uBLASMatrix.h",
+                   "compute matrix-vector product with uBLAS matrix",
+                   "Vector for matrix-vector result has wrong size");
+    }
+
+    // Compressed row product (threaded)
+    if (size(0) > 0 && size(1) > 0)
+    {
+      uBLASKernels::mult(_matA, xx.data(), yy.data(),
+                         uBLASKernels::num_threads(_matA.nnz()));
+    }
+  }
+  //---------------------------------------------------------------------------
   template <typename Mat>
   inline boost::tuples::tuple<const std::size_t*, const std::size_t*,
     const double*, int> uBLASMatrix<Mat>::data() const
@@ -18,7 +18,7 @@
 // Modified by Anders Logg 2006-2011
 //
 // First added:  2006-06-23
-// Last changed: 2011-11-11
+// Last changed: 2015-06-12
 
 #ifndef __UBLAS_PRECONDITIONER_H
 #define __UBLAS_PRECONDITIONER_H
@@ -28,6 +28,7 @@
 namespace dolfin
 {
 
+  class BlockMatrix;
   class uBLASVector;
   class uBLASLinearOperator;
   template<typename Mat> class uBLASMatrix;
@@ -69,6 +70,14 @@ namespace dolfin
                    "No init() function for preconditioner uBLASLinearOperator");
     }
 
+    /// Initialise preconditioner (block matrix)
+    virtual void init(const BlockMatrix& P)
+    {
+      dolfin_error("uBLASPreconditioner",
+                   "initialize uBLAS preconditioner",
+                   "No init() function for preconditioner BlockMatrix");
+    }
+
     /// Solve linear system (M^-1)Ax = y
     virtual void solve(uBLASVector& x, const uBLASVector& b) const = 0;
 
@@ -20,9 +20,10 @@
 // Modified by Martin Sandve Alnes 2008
 //
 // First added:  2006-04-04
-// Last changed: 2012-03-15
+// Last changed: 2015-06-12
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -35,6 +36,7 @@
 #include <dolfin/common/Array.h>
 #include "uBLASVector.h"
 #include "uBLASFactory.h"
+#include "uBLASKernels.h"
 #include "GenericLinearAlgebraFactory.h"
 
 #ifdef HAS_PETSC
@@ -188,7 +190,10 @@ double uBLASVector::norm(std::string norm_type) const
   if (norm_type == "l1")
     return norm_1(*_x);
   else if (norm_type == "l2")
-    return norm_2(*_x);
+  {
+    return std::sqrt(uBLASKernels::inner(data(), data(), size(),
+                                         uBLASKernels::num_threads(size())));
+  }
   else if (norm_type == "linf")
     return norm_inf(*_x);
   else
@@ -244,7 +249,9 @@ void uBLASVector::axpy(double a, const GenericVector& y)
                  "Vectors are not of the same size");
   }
 
-  (*_x) += a * as_type<const uBLASVector>(y).vec();
+  double* x = data();
+  uBLASKernels::lincomb(x, 1.0, x, a, as_type<const uBLASVector>(y).data(),
+                        size(), uBLASKernels::num_threads(size()));
 }
 //-----------------------------------------------------------------------------
 void uBLASVector::abs()
@@ -257,7 +264,73 @@ void uBLASVector::abs()
 //-----------------------------------------------------------------------------
 double uBLASVector::inner(const GenericVector& y) const
 {
-  return ublas::inner_prod(*_x, as_type<const uBLASVector>(y).vec());
+  const uBLASVector& _y = as_type<const uBLASVector>(y);
+  dolfin_assert(_y.size() == size());
+  return uBLASKernels::inner(data(), _y.data(), size(),
+                             uBLASKernels::num_threads(size()));
+}
+//-----------------------------------------------------------------------------
+void uBLASVector::multi_inner(const std::vector<const GenericVector*>& y,
+                              std::vector<double>& values) const
+{
+  dolfin_assert(_x);
+  const std::size_t m = y.size();
+  const std::size_t n = size();
+  std::vector<const double*> _y(m);
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    dolfin_assert(y[i]);
+    const uBLASVector& yi = as_type<const uBLASVector>(*y[i]);
+    if (yi.size() != n)
+    {
+      dolfin_error("uBLASVector.cpp",
+                   "compute inner products with uBLAS vector",
+                   "Vectors are not of the same size");
+    }
+    _y[i] = yi.data();
+  }
+
+  // Compute all inner products in one pass over this vector
+  values.assign(m, 0.0);
+  const double* x = data();
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    const double xk = x[k];
+    for (std::size_t i = 0; i < m; ++i)
+      values[i] += xk*_y[i][k];
+  }
+}
+//-----------------------------------------------------------------------------
+void uBLASVector::multi_axpy(const std::vector<double>& a,
+                             const std::vector<const GenericVector*>& y)
+{
+  dolfin_assert(_x);
+  dolfin_assert(a.size() == y.size());
+  const std::size_t m = y.size();
+  const std::size_t n = size();
+  std::vector<const double*> _y(m);
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    dolfin_assert(y[i]);
+    const uBLASVector& yi = as_type<const uBLASVector>(*y[i]);
+    if (yi.size() != n)
+    {
+      dolfin_error("uBLASVector.cpp",
+                   "perform axpy operation with uBLAS vector",
+                   "Vectors are not of the same size");
+    }
+    _y[i] = yi.data();
+  }
+
+  // Add linear combination in one pass over this vector
+  double* x = data();
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    double s = 0.0;
+    for (std::size_t i = 0; i < m; ++i)
+      s += a[i]*_y[i][k];
+    x[k] += s;
+  }
 }
 //-----------------------------------------------------------------------------
 const GenericVector& uBLASVector::operator= (const GenericVector& v)
@@ -291,6 +291,28 @@ void Logger::register_timing(std::string task,
   }
 }
 //-----------------------------------------------------------------------------
+void Logger::register_counters(std::string task,
+                               std::array<double, 4> counters)
+{
+  // Store values for summary, unavailable counters are negative
+  auto it = _counters.find(task);
+  if (it == _counters.end())
+  {
+    _counters[task] = std::make_pair(std::size_t(1), counters);
+  }
+  else
+  {
+    it->second.first += 1;
+    for (std::size_t i = 0; i < counters.size(); ++i)
+    {
+      if (it->second.second[i] < 0.0 || counters[i] < 0.0)
+        it->second.second[i] = -1.0;
+      else
+        it->second.second[i] += counters[i];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void Logger::list_timings(bool reset)
 {
   deprecation("dolfin::list_timings(bool)", "1.6.0", "1.7.0",
@@ -321,8 +343,14 @@ void Logger::list_timings(TimingClear clear, std::set<TimingType> type)
 //-----------------------------------------------------------------------------
 void Logger::dump_timings_to_xml(std::string filename, TimingClear clear)
 {
-  Table t = timings(clear,
-    { TimingType::wall, TimingType::user, TimingType::system });
+  std::set<TimingType> type
+    = { TimingType::wall, TimingType::user, TimingType::system };
+  if (!_counters.empty())
+  {
+    type.insert({ TimingType::cycles, TimingType::instructions,
+                  TimingType::cache_misses, TimingType::flops });
+  }
+  Table t = timings(clear, type);
 
   Table t_max = MPI::max(MPI_COMM_WORLD, t);
   Table t_min = MPI::min(MPI_COMM_WORLD, t);
@@ -340,7 +368,11 @@ void Logger::dump_timings_to_xml(std::string filename, TimingClear clear)
 std::map<TimingType, std::string> Logger::_TimingType_descr
   = { { TimingType::wall,   "wall" },
       { TimingType::user,   "usr"  },
-      { TimingType::system, "sys"  } };
+      { TimingType::system, "sys"  },
+      { TimingType::cycles, "cycles" },
+      { TimingType::instructions, "instr" },
+      { TimingType::cache_misses, "LLC miss" },
+      { TimingType::flops, "flops" } };
 //-----------------------------------------------------------------------------
 Table Logger::timings(TimingClear clear,
                       std::set<TimingType> type)
@@ -357,17 +389,40 @@ Table Logger::timings(TimingClear clear,
     table(task, "reps") = num_timings;
     for (const auto& t : type)
     {
-      const double total_time = times[static_cast<int>(t)];
+      const int i = static_cast<int>(t);
+      if (i > static_cast<int>(TimingType::system))
+        continue;
+      const double total_time = times[i];
       const double average_time = total_time / static_cast<double>(num_timings);
       table(task, Logger::_TimingType_descr[t] + " avg") = average_time;
       table(task, Logger::_TimingType_descr[t] + " tot") = total_time;
     }
 
+    // Add hardware counters (-1 if not available for task)
+    auto c = _counters.find(task);
+    for (const auto& t : type)
+    {
+      const int i = static_cast<int>(t) - static_cast<int>(TimingType::cycles);
+      if (i < 0)
+        continue;
+      double total = -1.0;
+      double average = -1.0;
+      if (c != _counters.end() && c->second.second[i] >= 0.0)
+      {
+        total = c->second.second[i];
+        average = total/static_cast<double>(c->second.first);
+      }
+      table(task, Logger::_TimingType_descr[t] + " avg") = average;
+      table(task, Logger::_TimingType_descr[t] + " tot") = total;
+    }
   }
 
   // Clear timings
   if (static_cast<bool>(clear))
+  {
     _timings.clear();
+    _counters.clear();
+  }
 
   return table;
 }
@@ -390,7 +445,10 @@ std::tuple<std::size_t, double, double, double>
 
   // Clear timing
   if (static_cast<bool>(clear))
+  {
     _timings.erase(it);
+    _counters.erase(task);
+  }
 
   return result;
 }
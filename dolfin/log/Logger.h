@@ -25,6 +25,7 @@
 #ifndef __LOGGER_H
 #define __LOGGER_H
 
+#include <array>
 #include <map>
 #include <memory>
 #include <ostream>
@@ -108,6 +109,10 @@ namespace dolfin
     void register_timing(std::string task,
                          std::tuple<double, double, double> elapsed);
 
+    /// Register hardware counter values (cycles, instructions, cache
+    /// misses, flops) for task (for later summary)
+    void register_counters(std::string task, std::array<double, 4> counters);
+
     /// Return a summary of timings and tasks as a Table, optionally
     /// clearing stored timings
     Table timings(TimingClear clear, std::set<TimingType> type);
@@ -169,6 +174,11 @@ namespace dolfin
     std::map<std::string, std::tuple<std::size_t, double, double, double> >
        _timings;
 
+    // Accumulated hardware counters for tasks, map from string to
+    // (num_samples, cycles, instructions, cache_misses, flops)
+    std::map<std::string, std::pair<std::size_t, std::array<double, 4> > >
+       _counters;
+
     // Thread used for monitoring memory usage
     std::unique_ptr<boost::thread> _thread_monitor_memory_usage;
 
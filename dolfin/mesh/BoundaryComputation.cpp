@@ -21,13 +21,19 @@
 // Modified by Oeyvind Evju, 2013
 //
 // First added:  2006-06-21
-// Last changed: 2014-02-06
+// Last changed: 2015-06-12
+
+#include <algorithm>
+#include <cstdint>
+#include <boost/unordered_map.hpp>
 
 #include <dolfin/log/log.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "BoundaryMesh.h"
 #include "Cell.h"
 #include "Facet.h"
 #include "Mesh.h"
+#include "MeshConnectivity.h"
 #include "MeshData.h"
 #include "MeshEditor.h"
 #include "MeshEntity.h"
@@ -75,12 +81,6 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   // Generate facet - cell connectivity if not generated
   mesh.init(D - 1, D);
 
-  // Temporary arrays for assignment of indices to vertices on the boundary
-  std::map<std::size_t, std::size_t> boundary_vertices;
-
-  // Map of index "owners" (process responsible for assigning global index)
-  std::map< std::size_t, std::size_t > global_index_owner;
-
   // Shared vertices for full mesh
   // FIXME: const_cast
   const std::map<unsigned int, std::set<unsigned int>> &
@@ -170,95 +170,89 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     shared_boundary_vertices = shared_vertices;
   }
 
-  // Determine boundary facet, count boundary vertices and facets, and
-  // assign vertex indices
-  std::size_t num_boundary_vertices = 0;
-  std::size_t num_owned_vertices = 0;
-  std::size_t num_boundary_cells = 0;
-
-  MeshFunction<bool> boundary_facet(mesh, D - 1, false);
-  for (FacetIterator f(mesh); !f.end(); ++f)
+  // Generate facet - vertex connectivity if not generated (the
+  // facets of an interval mesh are its vertices)
+  if (D > 1)
+    mesh.init(D - 1, 0);
+  const MeshConnectivity& facet_cells = mesh.topology()(D - 1, D);
+  const std::size_t num_facet_vertices = mesh.type().num_vertices(D - 1);
+  auto facet_vertex = [&mesh, D](std::size_t facet, std::size_t i)
+    -> std::size_t
+  { return D > 1 ? mesh.topology()(D - 1, 0)(facet)[i] : facet; };
+
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) parameters["num_threads"], 1);
+  #endif
+
+  // Mark boundary facets. Boundary facets are connected to exactly
+  // one cell.
+  const std::int64_t num_facets = mesh.num_facets();
+  std::vector<char> boundary_facet(num_facets, false);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t f = 0; f < num_facets; f++)
   {
-    // Boundary facets are connected to exactly one cell
-    if (f->num_entities(D) == 1)
+    if (facet_cells.size(f) == 1)
     {
-      const bool global_exterior_facet =  (f->num_global_entities(D) == 1);
-      if (global_exterior_facet && exterior)
-        boundary_facet[*f] = true;
-      else if (!global_exterior_facet && interior)
-        boundary_facet[*f] = true;
+      const bool global_exterior_facet = (facet_cells.size_global(f) == 1);
+      boundary_facet[f] = (global_exterior_facet && exterior)
+        || (!global_exterior_facet && interior);
+    }
+  }
 
-      if (boundary_facet[*f])
+  // Build list of boundary facets (cells of the boundary mesh)
+  std::vector<std::size_t> facets;
+  for (std::int64_t f = 0; f < num_facets; f++)
+  {
+    if (boundary_facet[f])
+      facets.push_back(f);
+  }
+  const std::int64_t num_boundary_cells = facets.size();
+
+  // Number boundary vertices in the order they are first seen from
+  // the boundary facets. The flat map from mesh vertices to boundary
+  // vertices holds -1 for vertices not on the boundary.
+  std::vector<int> boundary_vertices(mesh.num_vertices(), -1);
+  std::vector<std::size_t> parent_vertices;
+  for (std::int64_t c = 0; c < num_boundary_cells; c++)
+  {
+    for (std::size_t i = 0; i < num_facet_vertices; i++)
+    {
+      const std::size_t v = facet_vertex(facets[c], i);
+      if (boundary_vertices[v] < 0)
       {
-        // Count boundary vertices and assign indices
-        for (VertexIterator v(*f); !v.end(); ++v)
-        {
-          const std::size_t local_mesh_index = v->index();
-
-          if (boundary_vertices.find(local_mesh_index)
-              == boundary_vertices.end())
-          {
-            const std::size_t local_boundary_index = num_boundary_vertices;
-            boundary_vertices[local_mesh_index] = local_boundary_index;
-
-            // Determine "owner" of global_mesh_index
-            std::size_t owner = my_rank;
-
-            std::map<unsigned int, std::set<unsigned int>>::const_iterator
-              other_processes_it
-              = shared_boundary_vertices.find(local_mesh_index);
-            if (other_processes_it != shared_boundary_vertices.end() && D > 1)
-            {
-              const std::set<unsigned int>& other_processes
-                = other_processes_it->second;
-              const std::size_t min_process
-                = *std::min_element(other_processes.begin(),
-                                    other_processes.end());
-              boundary.topology().shared_entities(0)[local_boundary_index]
-                = other_processes;
-
-              // FIXME: More sophisticated ownership determination
-              if (min_process < owner)
-                owner = min_process;
-            }
-            const std::size_t global_mesh_index
-              = mesh.topology().global_indices(0)[local_mesh_index];
-            global_index_owner[global_mesh_index] = owner;
-
-            // Update counts
-            if (owner == my_rank)
-              num_owned_vertices++;
-            num_boundary_vertices++;
-          }
-        }
-
-        // Count boundary cells (facets of the mesh)
-        num_boundary_cells++;
+        boundary_vertices[v] = parent_vertices.size();
+        parent_vertices.push_back(v);
       }
     }
   }
-
-  // Initiate boundary topology
-  /*
-  boundary.topology().init(0, num_boundary_vertices,
-                           MPI::sum(mesh.mpi_comm(), num_owned_vertices));
-  boundary.topology().init(D - 1, num_boundary_cells,
-                           MPI::sum(mesh.mpi_comm(), num_boundary_cells));
-  */
-
-  // Specify number of vertices and cells
-  editor.init_vertices_global(num_boundary_vertices, MPI::sum(mesh.mpi_comm(),
-                                                              num_owned_vertices));
-  editor.init_cells_global(num_boundary_cells, MPI::sum(mesh.mpi_comm(),
-                                                        num_boundary_cells));
-
-  // Write vertex map
-  MeshFunction<std::size_t>& vertex_map = boundary.entity_map(0);
-  if (num_boundary_vertices > 0)
-    vertex_map.init(boundary, 0, num_boundary_vertices);
-  std::map<std::size_t, std::size_t>::const_iterator it;
-  for (it = boundary_vertices.begin(); it != boundary_vertices.end(); ++it)
-    vertex_map[it->second] = it->first;
+  const std::int64_t num_boundary_vertices = parent_vertices.size();
+
+  // Determine "owner" of boundary vertices (process responsible for
+  // assigning the global index). Shared vertices are owned by the
+  // lowest ranked sharing process.
+  // FIXME: More sophisticated ownership determination
+  std::vector<std::size_t> owner(num_boundary_vertices, my_rank);
+  std::map<unsigned int, std::set<unsigned int>> shared_boundary_entities;
+  if (D > 1)
+  {
+    for (auto sv = shared_boundary_vertices.begin();
+         sv != shared_boundary_vertices.end(); ++sv)
+    {
+      const int local_boundary_index = boundary_vertices[sv->first];
+      if (local_boundary_index < 0)
+        continue;
+
+      const std::set<unsigned int>& other_processes = sv->second;
+      shared_boundary_entities[local_boundary_index] = other_processes;
+      owner[local_boundary_index]
+        = std::min(owner[local_boundary_index],
+                   (std::size_t) *other_processes.begin());
+    }
+  }
+  const std::size_t num_owned_vertices
+    = std::count(owner.begin(), owner.end(), my_rank);
 
   // Get vertex ownership distribution, and find index to start global
   // numbering from
@@ -270,22 +264,28 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
 
   // Set global indices of owned vertices, request global indices for
   // vertices owned elsewhere
-  std::map<std::size_t, std::size_t> global_indices;
+  const std::vector<std::size_t>& global_vertex_indices
+    = mesh.topology().global_indices(0);
+  std::vector<std::size_t> global_indices(num_boundary_vertices);
+  boost::unordered_map<std::size_t, std::size_t> shared_global_indices;
   std::vector<std::vector<std::size_t>> request_global_indices(num_processes);
-
+  std::vector<std::vector<std::size_t>> request_local_indices(num_processes);
   std::size_t current_index = start_index;
-  for (std::size_t local_boundary_index = 0;
-       local_boundary_index<num_boundary_vertices; local_boundary_index++)
+  for (std::int64_t i = 0; i < num_boundary_vertices; i++)
   {
-    const std::size_t local_mesh_index = vertex_map[local_boundary_index];
     const std::size_t global_mesh_index
-      = mesh.topology().global_indices(0)[local_mesh_index];
-
-    const std::size_t owner = global_index_owner[global_mesh_index];
-    if (owner != my_rank)
-      request_global_indices[owner].push_back(global_mesh_index);
+      = global_vertex_indices[parent_vertices[i]];
+    if (owner[i] != my_rank)
+    {
+      request_global_indices[owner[i]].push_back(global_mesh_index);
+      request_local_indices[owner[i]].push_back(i);
+    }
     else
-      global_indices[global_mesh_index] = current_index++;
+    {
+      global_indices[i] = current_index++;
+      if (shared_vertices.find(parent_vertices[i]) != shared_vertices.end())
+        shared_global_indices[global_mesh_index] = global_indices[i];
+    }
   }
 
   // Send and receive requests from other processes
@@ -301,8 +301,12 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     respond_global_indices[i].resize(N);
 
     for (std::size_t j = 0; j < N; j++)
+    {
+      dolfin_assert(shared_global_indices.find(global_index_requests[i][j])
+                    != shared_global_indices.end());
       respond_global_indices[i][j]
-        = global_indices[global_index_requests[i][j]];
+        = shared_global_indices[global_index_requests[i][j]];
+    }
   }
 
   // Scatter responses back to requesting processes
@@ -310,7 +314,7 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   MPI::all_to_all(mesh.mpi_comm(), respond_global_indices,
                   global_index_responses);
 
-  // Update global_indices
+  // Update global indices
   for (std::size_t i = 0; i < num_processes; i++)
   {
     const std::size_t N = global_index_responses[i].size();
@@ -318,68 +322,88 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     dolfin_assert(global_index_responses[i].size()
                   == request_global_indices[i].size());
     for (std::size_t j = 0; j < N; j++)
-    {
-      const std::size_t global_mesh_index = request_global_indices[i][j];
-      const std::size_t global_boundary_index = global_index_responses[i][j];
-      global_indices[global_mesh_index] = global_boundary_index;
-    }
-  }
-
-  // Create vertices
-  for (std::size_t local_boundary_index = 0;
-       local_boundary_index < num_boundary_vertices; local_boundary_index++)
-  {
-    const std::size_t local_mesh_index = vertex_map[local_boundary_index];
-    const std::size_t global_mesh_index
-      = mesh.topology().global_indices(0)[local_mesh_index];
-    const std::size_t global_boundary_index = global_indices[global_mesh_index];
-
-    Vertex v(mesh, local_mesh_index);
-
-    editor.add_vertex_global(local_boundary_index, global_boundary_index,
-                             v.point());
+      global_indices[request_local_indices[i][j]] = global_index_responses[i][j];
   }
 
   // Find global index to start cell numbering from for current process
   std::vector<std::size_t> cell_distribution(num_processes);
-  MPI::all_gather(mesh.mpi_comm(), num_boundary_cells, cell_distribution);
+  MPI::all_gather(mesh.mpi_comm(), (std::size_t) num_boundary_cells,
+                  cell_distribution);
   std::size_t start_cell_index = 0;
   for (std::size_t i = 0; i < my_rank; i++)
     start_cell_index += cell_distribution[i];
 
-  // Create cells (facets) and map between boundary mesh cells and facets parent
+  // Specify number of vertices and cells
+  editor.init_vertices_global(num_boundary_vertices,
+                              MPI::sum(mesh.mpi_comm(), num_owned_vertices));
+  editor.init_cells_global(num_boundary_cells,
+                           MPI::sum(mesh.mpi_comm(),
+                                    (std::size_t) num_boundary_cells));
+  boundary.topology().shared_entities(0) = shared_boundary_entities;
+
+  // Write vertex map and cell map (boundary mesh cells to mesh facets)
+  MeshFunction<std::size_t>& vertex_map = boundary.entity_map(0);
+  if (num_boundary_vertices > 0)
+    vertex_map.init(boundary, 0, num_boundary_vertices);
   MeshFunction<std::size_t>& cell_map = boundary.entity_map(D - 1);
   if (num_boundary_cells > 0)
     cell_map.init(boundary, D - 1, num_boundary_cells);
-  std::vector<std::size_t>
-    cell(boundary.type().num_vertices(boundary.topology().dim()));
-  std::size_t current_cell = 0;
-  for (FacetIterator f(mesh); !f.end(); ++f)
+
+  // Fill vertex coordinates and global indices directly, bypassing
+  // the (sequential) MeshEditor insertion
+  const std::size_t gdim = mesh.geometry().dim();
+  MeshGeometry& geometry = boundary.geometry();
+  MeshTopology& topology = boundary.topology();
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_threads)
+  #endif
   {
-    if (boundary_facet[*f])
+    std::vector<double> x(gdim);
+
+    #ifdef HAS_OPENMP
+    #pragma omp for
+    #endif
+    for (std::int64_t i = 0; i < num_boundary_vertices; i++)
+    {
+      const double* _x = mesh.geometry().x(parent_vertices[i]);
+      std::copy(_x, _x + gdim, x.begin());
+      geometry.set(i, x);
+      topology.set_global_index(0, i, global_indices[i]);
+      vertex_map[i] = parent_vertices[i];
+    }
+  }
+
+  // Fill cells (facets) with renumbered vertices
+  MeshConnectivity& cell_vertices = topology(D - 1, 0);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_threads)
+  #endif
+  {
+    std::vector<std::size_t> cell(num_facet_vertices);
+
+    #ifdef HAS_OPENMP
+    #pragma omp for
+    #endif
+    for (std::int64_t c = 0; c < num_boundary_cells; c++)
     {
       // Compute new vertex numbers for cell
-      const unsigned int* vertices = f->entities(0);
-      for (std::size_t i = 0; i < cell.size(); i++)
-        cell[i] = boundary_vertices[vertices[i]];
+      for (std::size_t i = 0; i < num_facet_vertices; i++)
+        cell[i] = boundary_vertices[facet_vertex(facets[c], i)];
 
       // Reorder vertices so facet is right-oriented w.r.t. facet
       // normal
-      reorder(cell, *f);
-
-      // Create mapping from boundary cell to mesh facet if requested
-      if (!cell_map.empty())
-        cell_map[current_cell] = f->index();
+      if (D > 1)
+        reorder(cell, Facet(mesh, facets[c]));
 
-      // Add cell
-      editor.add_cell(current_cell, start_cell_index+current_cell, cell);
-      current_cell++;
+      cell_vertices.set(c, cell);
+      topology.set_global_index(D - 1, c, start_cell_index + c);
+      cell_map[c] = facets[c];
     }
   }
 
   // Close mesh editor. Note the argument order=false to prevent
   // ordering from destroying the orientation of facets accomplished
-  // by calling reorder() below.
+  // by calling reorder() above.
   editor.close(false);
 }
 //-----------------------------------------------------------------------------
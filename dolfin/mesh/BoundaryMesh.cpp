@@ -19,11 +19,14 @@
 // Modified by Joachim B Haga 2012.
 //
 // First added:  2006-06-21
-// Last changed: 2012-09-05
+// Last changed: 2015-06-12
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 
 #include <dolfin/log/log.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "BoundaryComputation.h"
 #include "BoundaryMesh.h"
 
@@ -88,3 +91,36 @@ const MeshFunction<std::size_t>& BoundaryMesh::entity_map(std::size_t d) const
   return _cell_map;
 }
 //-----------------------------------------------------------------------------
+void BoundaryMesh::update_coordinates(const Mesh& mesh)
+{
+  const std::int64_t num_vertices = this->num_vertices();
+  const std::size_t gdim = geometry().dim();
+  const std::size_t* vertex_map = _vertex_map.values();
+
+  // Check that mesh is compatible with vertex map
+  bool compatible = (mesh.geometry().dim() == gdim
+                     && _vertex_map.size() == (std::size_t) num_vertices);
+  if (compatible && num_vertices > 0)
+  {
+    compatible = *std::max_element(vertex_map, vertex_map + num_vertices)
+      < mesh.num_vertices();
+  }
+  if (!compatible)
+  {
+    dolfin_error("BoundaryMesh.cpp",
+                 "update coordinates of boundary mesh",
+                 "Mesh does not match the mesh the boundary was computed from");
+  }
+
+  // Copy coordinates of parent vertices
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) dolfin::parameters["num_threads"], 1);
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_vertices; i++)
+  {
+    const double* x = mesh.geometry().x(vertex_map[i]);
+    std::copy(x, x + gdim, geometry().x(i));
+  }
+}
+//-----------------------------------------------------------------------------
@@ -19,7 +19,7 @@
 // Modified by Joachim B Haga 2012.
 //
 // First added:  2006-06-21
-// Last changed: 2012-10-30
+// Last changed: 2015-06-12
 
 #ifndef __BOUNDARY_MESH_H
 #define __BOUNDARY_MESH_H
@@ -71,6 +71,16 @@ namespace dolfin
     /// to the entity in the original full mesh (const version)
     const MeshFunction<std::size_t>& entity_map(std::size_t d) const;
 
+    /// Update the vertex coordinates of the boundary mesh from the
+    /// (moved) mesh it was created from. This is much cheaper than
+    /// recomputing the boundary mesh and may be used when only the
+    /// coordinates of the mesh have changed, not its topology.
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh from which the boundary mesh was created.
+    void update_coordinates(const Mesh& mesh);
+
   private:
 
     BoundaryMesh() {}
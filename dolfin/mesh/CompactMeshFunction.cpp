@@ -0,0 +1,252 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include "Mesh.h"
+#include "CompactMeshFunction.h"
+
+using namespace dolfin;
+
+namespace
+{
+  // Return number of bytes needed to store value
+  std::size_t width(std::size_t value)
+  {
+    if (value <= std::numeric_limits<std::uint8_t>::max())
+      return 1;
+    else if (value <= std::numeric_limits<std::uint16_t>::max())
+      return 2;
+    else if (value <= std::numeric_limits<std::uint32_t>::max())
+      return 4;
+    else
+      return 8;
+  }
+
+  // Append value to packed array of given width
+  void append(std::vector<std::uint8_t>& values, std::size_t value,
+              std::size_t width)
+  {
+    const std::size_t pos = values.size();
+    values.resize(pos + width);
+    switch (width)
+    {
+    case 1:
+      values[pos] = value;
+      break;
+    case 2:
+    {
+      const std::uint16_t v = value;
+      std::memcpy(values.data() + pos, &v, 2);
+      break;
+    }
+    case 4:
+    {
+      const std::uint32_t v = value;
+      std::memcpy(values.data() + pos, &v, 4);
+      break;
+    }
+    default:
+    {
+      const std::uint64_t v = value;
+      std::memcpy(values.data() + pos, &v, 8);
+    }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+CompactMeshFunction::CompactMeshFunction(
+  const MeshFunction<std::size_t>& mesh_function, std::string storage)
+  : Variable("f", "unnamed CompactMeshFunction"),
+    _mesh(mesh_function.mesh()), _dim(mesh_function.dim()),
+    _size(mesh_function.size()), _width(1), _format(dense),
+    _default_value(0)
+{
+  const std::size_t* values = mesh_function.values();
+
+  // Count occurrences of each value
+  std::unordered_map<std::size_t, std::size_t> counts;
+  std::size_t max_value = 0;
+  for (std::size_t i = 0; i < _size; ++i)
+  {
+    ++counts[values[i]];
+    max_value = std::max(max_value, values[i]);
+  }
+
+  // Take most frequent value as default value for sparse storage
+  std::size_t num_default = 0;
+  for (auto& count : counts)
+  {
+    if (count.second > num_default)
+    {
+      _default_value = count.first;
+      num_default = count.second;
+    }
+  }
+
+  // Find largest non-default value
+  std::size_t max_marked_value = 0;
+  for (auto& count : counts)
+  {
+    if (count.first != _default_value)
+      max_marked_value = std::max(max_marked_value, count.first);
+  }
+
+  // Count runs of entities with the same value
+  std::size_t num_runs = 0;
+  for (std::size_t i = 0; i < _size; ++i)
+  {
+    if (i == 0 || values[i] != values[i - 1])
+      ++num_runs;
+  }
+
+  // Choose storage format
+  const std::size_t num_words = (_size + 63)/64;
+  const std::size_t bit_bytes
+    = num_words*(sizeof(std::uint64_t) + sizeof(std::uint32_t));
+  if (storage == "auto")
+  {
+    const std::size_t dense_bytes = _size*width(max_value);
+    const std::size_t sparse_bytes
+      = bit_bytes + (_size - num_default)*width(max_marked_value);
+    const std::size_t runlength_bytes = bit_bytes + num_runs*width(max_value);
+    if (sparse_bytes < dense_bytes && sparse_bytes <= runlength_bytes)
+      storage = "sparse";
+    else if (runlength_bytes < dense_bytes)
+      storage = "runlength";
+    else
+      storage = "dense";
+  }
+
+  if (storage == "sparse")
+  {
+    _format = sparse;
+    _width = width(max_marked_value);
+  }
+  else if (storage == "runlength")
+  {
+    _format = runlength;
+    _width = width(max_value);
+  }
+  else if (storage == "dense")
+    _width = width(max_value);
+  else
+  {
+    if (storage == "uint8")
+      _width = 1;
+    else if (storage == "uint16")
+      _width = 2;
+    else if (storage == "uint32")
+      _width = 4;
+    else if (storage == "uint64")
+      _width = 8;
+    else
+    {
+      dolfin_error("CompactMeshFunction.cpp",
+                   "create compact mesh function",
+                   "Unknown storage format \"%s\"", storage.c_str());
+    }
+
+    if (width(max_value) > _width)
+    {
+      dolfin_error("CompactMeshFunction.cpp",
+                   "create compact mesh function",
+                   "Value %d cannot be stored in storage format \"%s\"",
+                   max_value, storage.c_str());
+    }
+  }
+
+  // Store values
+  if (_format == dense)
+  {
+    _values.reserve(_size*_width);
+    for (std::size_t i = 0; i < _size; ++i)
+      append(_values, values[i], _width);
+    return;
+  }
+
+  // Mark entities with non-default value (sparse storage) or entities
+  // starting a run (run-length storage), and store their values
+  _bits.assign(num_words, 0);
+  _rank.assign(num_words, 0);
+  const std::size_t num_stored
+    = _format == sparse ? _size - num_default : num_runs;
+  _values.reserve(num_stored*_width);
+  std::size_t num_set = 0;
+  for (std::size_t i = 0; i < _size; ++i)
+  {
+    if (i % 64 == 0)
+      _rank[i/64] = num_set;
+
+    const bool set = _format == sparse ? values[i] != _default_value
+      : (i == 0 || values[i] != values[i - 1]);
+    if (set)
+    {
+      _bits[i/64] |= std::uint64_t(1) << (i % 64);
+      append(_values, values[i], _width);
+      ++num_set;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+CompactMeshFunction::~CompactMeshFunction()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::string CompactMeshFunction::storage() const
+{
+  if (_format == sparse)
+    return "sparse";
+  else if (_format == runlength)
+    return "runlength";
+
+  std::stringstream s;
+  s << "uint" << 8*_width;
+  return s.str();
+}
+//-----------------------------------------------------------------------------
+std::size_t CompactMeshFunction::num_bytes() const
+{
+  return _values.size() + _bits.size()*sizeof(std::uint64_t)
+    + _rank.size()*sizeof(std::uint32_t);
+}
+//-----------------------------------------------------------------------------
+void CompactMeshFunction::get_values(MeshFunction<std::size_t>& mesh_function)
+  const
+{
+  dolfin_assert(_mesh);
+  mesh_function.init(_mesh, _dim, _size);
+  for (std::size_t i = 0; i < _size; ++i)
+    mesh_function[i] = (*this)[i];
+}
+//-----------------------------------------------------------------------------
+std::string CompactMeshFunction::str(bool verbose) const
+{
+  std::stringstream s;
+  s << "<CompactMeshFunction of topological dimension " << _dim
+    << " containing " << _size << " values (" << storage() << ", "
+    << num_bytes() << " bytes)>";
+  return s.str();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,204 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __COMPACT_MESH_FUNCTION_H
+#define __COMPACT_MESH_FUNCTION_H
+
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <dolfin/common/Variable.h>
+#include <dolfin/log/log.h>
+#include "MeshEntity.h"
+#include "MeshFunction.h"
+
+namespace dolfin
+{
+
+  class Mesh;
+
+  /// This class provides a compact, read-only copy of a
+  /// MeshFunction<std::size_t>, typically subdomain markers that
+  /// take only a handful of distinct values.
+  ///
+  /// The values are stored in one of the following formats:
+  ///
+  ///   "uint8", "uint16", "uint32", "uint64": one unsigned integer of
+  ///   the given width per entity.
+  ///
+  ///   "sparse": a default value, a bit per entity marking the
+  ///   entities with another value, and the values of these entities
+  ///   (using the smallest sufficient width).
+  ///
+  ///   "runlength": a bit per entity marking the entities where the
+  ///   value differs from the value of the previous entity, and the
+  ///   value of each such run of entities (using the smallest
+  ///   sufficient width).
+  ///
+  /// Reading a value costs O(1) for all formats. With the default
+  /// format "auto", the format requiring the least memory is chosen.
+  ///
+  /// A CompactMeshFunction may be used in place of a MeshFunction to
+  /// specify the boundary of a DirichletBC.
+
+  class CompactMeshFunction : public Variable
+  {
+  public:
+
+    /// Create compact copy of mesh function
+    ///
+    /// *Arguments*
+    ///     mesh_function (_MeshFunction_ <std::size_t>)
+    ///         The mesh function to copy.
+    ///     storage (std::string)
+    ///         The storage format ("auto", "uint8", "uint16",
+    ///         "uint32", "uint64", "sparse" or "runlength").
+    explicit CompactMeshFunction(const MeshFunction<std::size_t>& mesh_function,
+                                 std::string storage="auto");
+
+    /// Destructor
+    ~CompactMeshFunction();
+
+    /// Return mesh associated with mesh function
+    std::shared_ptr<const Mesh> mesh() const
+    { return _mesh; }
+
+    /// Return topological dimension
+    std::size_t dim() const
+    { return _dim; }
+
+    /// Return size (number of entities)
+    std::size_t size() const
+    { return _size; }
+
+    /// Return storage format
+    std::string storage() const;
+
+    /// Return number of bytes used to store the values
+    std::size_t num_bytes() const;
+
+    /// Return value at given entity
+    std::size_t operator[] (const MeshEntity& entity) const
+    {
+      dolfin_assert(entity.dim() == _dim);
+      return (*this)[entity.index()];
+    }
+
+    /// Return value at given index
+    std::size_t operator[] (std::size_t index) const
+    {
+      dolfin_assert(index < _size);
+      if (_format == dense)
+        return get(index);
+
+      const std::uint64_t word = _bits[index/64];
+      const std::uint64_t bit = std::uint64_t(1) << (index % 64);
+      if (_format == sparse)
+      {
+        // Look up position of value among entities with non-default
+        // value
+        if (!(word & bit))
+          return _default_value;
+        return get(_rank[index/64]
+                   + std::bitset<64>(word & (bit - 1)).count());
+      }
+      else
+      {
+        // Look up run containing entity (the last run starting at or
+        // before the entity)
+        return get(_rank[index/64]
+                   + std::bitset<64>(word & (bit | (bit - 1))).count() - 1);
+      }
+    }
+
+    /// Copy values to mesh function
+    void get_values(MeshFunction<std::size_t>& mesh_function) const;
+
+    /// Return informal string representation (pretty-print)
+    std::string str(bool verbose) const;
+
+  private:
+
+    // Read value at given position in value array
+    std::size_t get(std::size_t i) const
+    {
+      switch (_width)
+      {
+      case 1:
+        return _values[i];
+      case 2:
+      {
+        std::uint16_t v;
+        std::memcpy(&v, _values.data() + 2*i, 2);
+        return v;
+      }
+      case 4:
+      {
+        std::uint32_t v;
+        std::memcpy(&v, _values.data() + 4*i, 4);
+        return v;
+      }
+      default:
+      {
+        std::uint64_t v;
+        std::memcpy(&v, _values.data() + 8*i, 8);
+        return v;
+      }
+      }
+    }
+
+    // Mesh
+    std::shared_ptr<const Mesh> _mesh;
+
+    // Topological dimension and number of entities
+    std::size_t _dim, _size;
+
+    // Width (in bytes) of stored values
+    std::size_t _width;
+
+    // Values (packed unsigned integers of given width)
+    std::vector<std::uint8_t> _values;
+
+    // Storage formats (dense arrays of given width, or bit per entity
+    // with rank table)
+    enum Format {dense, sparse, runlength};
+
+    // Storage format
+    Format _format;
+
+    // Default value (sparse storage)
+    std::size_t _default_value;
+
+    // Bit per entity, set if entity has non-default value (sparse
+    // storage) or if entity starts a run of entities with the same
+    // value (run-length storage)
+    std::vector<std::uint64_t> _bits;
+
+    // Number of set bits before each 64-bit word of _bits
+    std::vector<std::uint32_t> _rank;
+
+  };
+
+}
+
+#endif
@@ -18,7 +18,7 @@
 // Modified by Anders Logg, 2008-2009.
 //
 // First added:  2008-11-28
-// Last changed: 2011-03-25
+// Last changed: 2015-06-12
 //
 // Modified by Anders Logg, 2008-2009.
 // Modified by Kent-Andre Mardal, 2011.
@@ -27,9 +27,9 @@
 #ifndef __LOCAL_MESH_VALUE_COLLECTION_H
 #define __LOCAL_MESH_VALUE_COLLECTION_H
 
-#include <map>
 #include <utility>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/MPI.h>
 #include <dolfin/log/log.h>
 
@@ -95,21 +95,22 @@ namespace dolfin
       send_indices.resize(num_processes);
       send_v.resize(num_processes);
 
-      const std::map<std::pair<std::size_t, std::size_t>, T>& vals
-        = values.values();
+      // Values are stored contiguously, so the range for each
+      // process is accessed directly
+      const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                       T>& vals = values.values();
       for (std::size_t p = 0; p < num_processes; p++)
       {
         const std::pair<std::size_t, std::size_t> local_range
           = MPI::local_range(_mpi_comm, p, vals.size());
-        typename std::map<std::pair<std::size_t,
-          std::size_t>, T>::const_iterator it = vals.begin();
-        std::advance(it, local_range.first);
+        send_indices[p].reserve(2*(local_range.second - local_range.first));
+        send_v[p].reserve(local_range.second - local_range.first);
         for (std::size_t i = local_range.first; i < local_range.second; ++i)
         {
+          const auto it = vals.begin() + i;
           send_indices[p].push_back(it->first.first);
           send_indices[p].push_back(it->first.second);
           send_v[p].push_back(it->second);
-          std::advance(it, 1);
         }
       }
     }
@@ -122,6 +123,7 @@ namespace dolfin
     dolfin_assert(2*v.size() == indices.size());
 
     // Unpack
+    _values.reserve(v.size());
     for (std::size_t i = 0; i < v.size(); ++i)
     {
       const std::size_t cell_index = indices[2*i];
@@ -109,11 +109,9 @@ std::size_t MeshColoring::compute_colors(const Mesh& mesh,
   }
 
   // Create graph
-  Graph graph;
-  if (coloring_type.size() == 3)
-    graph = GraphBuilder::local_graph(mesh, coloring_type[0], coloring_type[1]);
-  else
-    graph = GraphBuilder::local_graph(mesh, coloring_type);
+  const Graph graph = (coloring_type.size() == 3)
+    ? GraphBuilder::local_graph(mesh, coloring_type[0], coloring_type[1])
+    : GraphBuilder::local_graph(mesh, coloring_type);
 
   // Color graph
   return GraphColoring::compute_local_vertex_coloring(graph, colors);
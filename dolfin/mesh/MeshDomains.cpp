@@ -18,8 +18,9 @@
 // Modified by Garth N. Wells, 2012
 //
 // First added:  2011-08-29
-// Last changed: 2011-04-03
+// Last changed: 2015-06-12
 
+#include <algorithm>
 #include <limits>
 #include <dolfin/log/log.h>
 #include "MeshDomains.h"
@@ -59,13 +60,14 @@ bool MeshDomains::is_empty() const
   return size == 0;
 }
 //-----------------------------------------------------------------------------
-std::map<std::size_t, std::size_t>& MeshDomains::markers(std::size_t dim)
+boost::container::flat_map<std::size_t, std::size_t>&
+MeshDomains::markers(std::size_t dim)
 {
   dolfin_assert(dim < _markers.size());
   return _markers[dim];
 }
 //-----------------------------------------------------------------------------
-const std::map<std::size_t, std::size_t>&
+const boost::container::flat_map<std::size_t, std::size_t>&
 MeshDomains::markers(std::size_t dim) const
 {
   dolfin_assert(dim < _markers.size());
@@ -79,11 +81,36 @@ bool MeshDomains::set_marker(std::pair<std::size_t, std::size_t> marker,
   return _markers[dim].insert(marker).second;
 }
 //-----------------------------------------------------------------------------
+void MeshDomains::set_markers(
+  std::vector<std::pair<std::size_t, std::size_t>>& markers, std::size_t dim)
+{
+  dolfin_assert(dim < _markers.size());
+
+  // Put existing markers first and sort by entity index, keeping the
+  // order of markers for the same entity
+  markers.insert(markers.begin(), _markers[dim].begin(), _markers[dim].end());
+  std::stable_sort(markers.begin(), markers.end(),
+                   [](const std::pair<std::size_t, std::size_t>& a,
+                      const std::pair<std::size_t, std::size_t>& b)
+                   { return a.first < b.first; });
+
+  // Keep first marker for each entity
+  markers.erase(std::unique(markers.begin(), markers.end(),
+                            [](const std::pair<std::size_t, std::size_t>& a,
+                               const std::pair<std::size_t, std::size_t>& b)
+                            { return a.first == b.first; }),
+                markers.end());
+
+  // Build sorted array of markers
+  _markers[dim] = boost::container::flat_map<std::size_t, std::size_t>(
+    boost::container::ordered_unique_range, markers.begin(), markers.end());
+}
+//-----------------------------------------------------------------------------
 std::size_t MeshDomains::get_marker(std::size_t entity_index,
                                     std::size_t dim) const
 {
   dolfin_assert(dim < _markers.size());
-  std::map<std::size_t, std::size_t>::const_iterator it
+  boost::container::flat_map<std::size_t, std::size_t>::const_iterator it
     = _markers[dim].find(entity_index);
   if (it == _markers[dim].end())
   {
@@ -19,7 +19,7 @@
 // Modified by Garth N. Wells, 2010-2013
 //
 // First added:  2006-05-22
-// Last changed: 2013-05-10
+// Last changed: 2015-06-12
 
 #ifndef __MESH_FUNCTION_H
 #define __MESH_FUNCTION_H
@@ -29,7 +29,7 @@
 
 #include <boost/scoped_array.hpp>
 #include <memory>
-#include <boost/unordered_set.hpp>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/Hierarchical.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/NoDeleter.h>
@@ -224,6 +224,20 @@ namespace dolfin
     ///         The size.
     std::size_t size() const;
 
+    /// Return modification counter. The counter is increased by
+    /// initialisation, assignment, set_value, set_values, set_all
+    /// and non-const access to values(), so a changed counter implies
+    /// possibly changed values. Modification through operator[] or
+    /// through a pointer (or array view) obtained earlier by values()
+    /// is not counted, so an unchanged counter does not imply
+    /// unchanged values.
+    ///
+    /// *Returns*
+    ///     std::size_t
+    ///         The modification counter.
+    std::size_t state() const
+    { return _state; }
+
     /// Return array of values (const. version)
     ///
     /// *Returns*
@@ -398,6 +412,9 @@ namespace dolfin
 
     // Number of mesh entities
     std::size_t _size;
+
+    // Modification counter
+    std::size_t _state;
   };
 
   template<> std::string MeshFunction<double>::str(bool verbose) const;
@@ -409,7 +426,7 @@ namespace dolfin
   template <typename T>
     MeshFunction<T>::MeshFunction() : Variable("f", "unnamed MeshFunction"),
     Hierarchical<MeshFunction<T> >(*this), _values(0), _dim(0),
-    _size(0)
+    _size(0), _state(0)
   {
     // Do nothing
   }
@@ -418,7 +435,7 @@ namespace dolfin
     MeshFunction<T>::MeshFunction(const Mesh& mesh)
     : Variable("f", "unnamed MeshFunction"),
     Hierarchical<MeshFunction<T> >(*this),
-    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0)
+    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0), _state(0)
   {
     // Do nothing
   }
@@ -426,7 +443,7 @@ namespace dolfin
   template <typename T>
     MeshFunction<T>::MeshFunction(std::shared_ptr<const Mesh> mesh)
     : Variable("f", "unnamed MeshFunction"),
-    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0)
+    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0), _state(0)
   {
     // Do nothing
   }
@@ -435,7 +452,7 @@ namespace dolfin
   MeshFunction<T>::MeshFunction(const Mesh& mesh, std::size_t dim)
     : Variable("f", "unnamed MeshFunction"),
     Hierarchical<MeshFunction<T> >(*this),
-    _mesh(reference_to_no_delete_pointer(mesh)) , _dim(0), _size(0)
+    _mesh(reference_to_no_delete_pointer(mesh)) , _dim(0), _size(0), _state(0)
   {
     init(dim);
   }
@@ -444,7 +461,7 @@ namespace dolfin
     MeshFunction<T>::MeshFunction(std::shared_ptr<const Mesh> mesh,
                                   std::size_t dim)
     : Variable("f", "unnamed MeshFunction"),
-    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0)
+    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0), _state(0)
   {
     init(dim);
   }
@@ -454,7 +471,7 @@ namespace dolfin
                                 const T& value)
     : Variable("f", "unnamed MeshFunction"),
     Hierarchical<MeshFunction<T> >(*this),
-    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0)
+    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0), _state(0)
   {
     init(dim);
     set_all(value);
@@ -464,7 +481,7 @@ namespace dolfin
     MeshFunction<T>::MeshFunction(std::shared_ptr<const Mesh> mesh,
                                    std::size_t dim, const T& value)
   : Variable("f", "unnamed MeshFunction"),
-    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0)
+    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0), _state(0)
   {
     init(dim);
     set_all(value);
@@ -474,7 +491,7 @@ namespace dolfin
   MeshFunction<T>::MeshFunction(const Mesh& mesh, const std::string filename)
     : Variable("f", "unnamed MeshFunction"),
     Hierarchical<MeshFunction<T> >(*this),
-    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0)
+    _mesh(reference_to_no_delete_pointer(mesh)), _dim(0), _size(0), _state(0)
   {
     File file(filename);
     file >> *this;
@@ -484,7 +501,7 @@ namespace dolfin
     MeshFunction<T>::MeshFunction(std::shared_ptr<const Mesh> mesh,
                                   const std::string filename)
     : Variable("f", "unnamed MeshFunction"),
-    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0)
+    Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0), _state(0)
   {
     File file(filename);
     file >> *this;
@@ -496,7 +513,7 @@ namespace dolfin
     Variable("f", "unnamed MeshFunction"),
       Hierarchical<MeshFunction<T> >(*this),
       _mesh(reference_to_no_delete_pointer(mesh)),
-      _dim(value_collection.dim()), _size(0)
+      _dim(value_collection.dim()), _size(0), _state(0)
   {
     *this = value_collection;
   }
@@ -506,7 +523,7 @@ namespace dolfin
                                   const MeshValueCollection<T>& value_collection)
     : Variable("f", "unnamed MeshFunction"),
       Hierarchical<MeshFunction<T> >(*this), _mesh(mesh),
-      _dim(value_collection.dim()), _size(0)
+      _dim(value_collection.dim()), _size(0), _state(0)
   {
     *this = value_collection;
   }
@@ -515,7 +532,7 @@ namespace dolfin
     MeshFunction<T>::MeshFunction(std::shared_ptr<const Mesh> mesh,
                                   std::size_t dim, const MeshDomains& domains)
     : Variable("f", "unnamed MeshFunction"),
-      Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0)
+      Hierarchical<MeshFunction<T> >(*this), _mesh(mesh), _dim(0), _size(0), _state(0)
   {
     dolfin_assert(_mesh);
 
@@ -533,10 +550,11 @@ namespace dolfin
     dolfin_assert(dim <= D);
 
     // Get domain data
-    const std::map<std::size_t, std::size_t>& data = domains.markers(dim);
+    const boost::container::flat_map<std::size_t, std::size_t>& data
+      = domains.markers(dim);
 
     // Iterate over all values and copy into MeshFunctions
-    std::map<std::size_t, std::size_t>::const_iterator it;
+    boost::container::flat_map<std::size_t, std::size_t>::const_iterator it;
     for (it = data.begin(); it != data.end(); ++it)
     {
       // Get value collection entry data
@@ -551,7 +569,7 @@ namespace dolfin
   template <typename T>
   MeshFunction<T>::MeshFunction(const MeshFunction<T>& f) :
     Variable("f", "unnamed MeshFunction"),
-    Hierarchical<MeshFunction<T> >(*this), _dim(0), _size(0)
+    Hierarchical<MeshFunction<T> >(*this), _dim(0), _size(0), _state(0)
   {
     *this = f;
   }
@@ -565,6 +583,7 @@ namespace dolfin
     _dim  = f._dim;
     _size = f._size;
     std::copy(f._values.get(), f._values.get() + _size, _values.get());
+    ++_state;
 
     Hierarchical<MeshFunction<T> >::operator=(f);
 
@@ -592,10 +611,12 @@ namespace dolfin
     set_all(std::numeric_limits<T>::max());
 
     // Iterate over all values
-    boost::unordered_set<std::size_t> entities_values_set;
-    typename std::map<std::pair<std::size_t, std::size_t>, T>::const_iterator it;
-    const std::map<std::pair<std::size_t, std::size_t>, T>& values
-      = mesh_value_collection.values();
+    std::vector<bool> entity_has_value(_size, false);
+    std::size_t num_entities_with_value = 0;
+    typename boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                        T>::const_iterator it;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values = mesh_value_collection.values();
     for (it = values.begin(); it != values.end(); ++it)
     {
       // Get value collection entry data
@@ -620,12 +641,16 @@ namespace dolfin
       dolfin_assert(entity_index < _size);
       _values[entity_index] = value;
 
-      // Add entity index to set (used to check that all values are set)
-      entities_values_set.insert(entity_index);
+      // Mark entity as set (used to check that all values are set)
+      if (!entity_has_value[entity_index])
+      {
+        entity_has_value[entity_index] = true;
+        ++num_entities_with_value;
+      }
     }
 
     // Check that all values have been set, if not issue a debug message
-    if (entities_values_set.size() != _size)
+    if (num_entities_with_value != _size)
       dolfin_debug("Mesh value collection does not contain all values for all entities");
 
     return *this;
@@ -665,6 +690,7 @@ namespace dolfin
   template <typename T>
     T* MeshFunction<T>::values()
   {
+    ++_state;
     return _values.get();
   }
   //---------------------------------------------------------------------------
@@ -769,6 +795,7 @@ namespace dolfin
     _mesh = reference_to_no_delete_pointer(mesh);
     _dim = dim;
     _size = size;
+    ++_state;
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -787,6 +814,7 @@ namespace dolfin
     _mesh = mesh;
     _dim = dim;
     _size = size;
+    ++_state;
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -795,6 +823,7 @@ namespace dolfin
     dolfin_assert(_values);
     dolfin_assert(index < _size);
     _values[index] = value;
+    ++_state;
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -803,6 +832,7 @@ namespace dolfin
     dolfin_assert(_values);
     dolfin_assert(_size == values.size());
     std::copy(values.begin(), values.end(), _values.get());
+    ++_state;
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -810,6 +840,7 @@ namespace dolfin
   {
     dolfin_assert(_values);
     std::fill(_values.get(), _values.get() + _size, value);
+    ++_state;
   }
   //---------------------------------------------------------------------------
   template <typename T>
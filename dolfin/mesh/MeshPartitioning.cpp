@@ -134,6 +134,18 @@ void MeshPartitioning::build_distributed_mesh(Mesh& mesh,
                  "Ghost cell information not available");
   }
 
+  // Build mesh from local mesh data and provided cell partition
+  build_distributed_mesh(mesh, local_data, cell_partition, ghost_procs);
+}
+//-----------------------------------------------------------------------------
+void MeshPartitioning::build_distributed_mesh(Mesh& mesh,
+  const LocalMeshData& local_data,
+  const std::vector<std::size_t>& cell_partition,
+  const std::map<std::size_t, dolfin::Set<unsigned int>>& ghost_procs)
+{
+  dolfin_assert(cell_partition.size()
+                == local_data.global_cell_indices.size());
+
   // Build mesh from local mesh data and provided cell partition
   build(mesh, local_data, cell_partition, ghost_procs);
 
@@ -295,37 +307,35 @@ void MeshPartitioning::reorder_cells_gps(
 
   // Make dual graph from vertex indices, using GraphBuilder
   // FIXME: this should be reused later to add the facet-cell topology
-  std::vector<std::set<std::size_t>> local_graph;
-  GraphBuilder::FacetCellMap facet_cell_map;
+  std::vector<std::size_t> dual_edges;
+  GraphBuilder::FacetCellList unmatched_facets;
   GraphBuilder::compute_local_dual_graph(mpi_comm,
                                          new_mesh_data,
-                                         local_graph,
-                                         facet_cell_map);
+                                         dual_edges,
+                                         unmatched_facets);
   const std::size_t num_all_cells
     = new_mesh_data.cell_vertices.shape()[0];
 
   const std::size_t local_cell_offset
     = MPI::global_offset(mpi_comm, num_all_cells, true);
 
-  // Convert between graph types, removing offset
-  // FIXME: make all graphs the same type
-  Graph g_dual;
-  // Ignore the ghost cells - they will not be reordered
+  // Remove offset and ignore the ghost cells - they will not be
+  // reordered
   // FIXME: reorder ghost cells too
-  for (unsigned int i = 0; i != num_regular_cells; ++i)
+  std::vector<int> edges;
+  edges.reserve(dual_edges.size());
+  for (std::size_t e = 0; e < dual_edges.size(); e += 2)
   {
-    dolfin::Set<int> conn_set;
-    for (auto q = local_graph[i].begin();
-         q != local_graph[i].end(); ++q)
+    dolfin_assert(dual_edges[e + 1] >= local_cell_offset);
+    const std::size_t i = dual_edges[e];
+    const std::size_t j = dual_edges[e + 1] - local_cell_offset;
+    if (i < num_regular_cells && j < num_regular_cells)
     {
-      dolfin_assert(*q >= local_cell_offset);
-      const int local_index = *q - local_cell_offset;
-      // Ignore ghost cells in connectivity
-      if (local_index < (int)num_regular_cells)
-        conn_set.insert(local_index);
+      edges.push_back(i);
+      edges.push_back(j);
     }
-    g_dual.push_back(conn_set);
   }
+  const Graph g_dual = GraphBuilder::local_graph(num_regular_cells, edges);
   std::vector<int> remap = SCOTCH::compute_gps(g_dual);
 
   boost::multi_array<std::size_t, 2>
@@ -370,7 +380,7 @@ void MeshPartitioning::reorder_vertices_gps(MPI_Comm mpi_comm,
     = new_mesh_data.num_vertices_per_cell;
 
   // Make local real graph (vertices are nodes, edges are edges)
-  Graph g(num_regular_vertices);
+  std::vector<int> edges;
   for (unsigned int i = 0; i != num_regular_cells; ++i)
   {
     for (unsigned int j = 0; j != num_cell_vertices; ++j)
@@ -385,13 +395,16 @@ void MeshPartitioning::reorder_vertices_gps(MPI_Comm mpi_comm,
             = vertex_global_to_local[new_mesh_data.cell_vertices[i][k]];
           if (vk < num_regular_vertices)
           {
-            g[vj].insert(vk);
-            g[vk].insert(vj);
+            edges.push_back(vj);
+            edges.push_back(vk);
+            edges.push_back(vk);
+            edges.push_back(vj);
           }
         }
       }
     }
   }
+  const Graph g = GraphBuilder::local_graph(num_regular_vertices, edges);
 
   std::vector<int> remap = SCOTCH::compute_gps(g);
 
@@ -1113,28 +1126,31 @@ void MeshPartitioning::build_mesh_domains(Mesh& mesh,
     }
 
     // Get data from mesh value collection
-    const std::map<std::pair<std::size_t, std::size_t>, std::size_t>& values
-      = mvc.values();
-
-    // Get map from mesh domains
-    std::map<std::size_t, std::size_t>& markers = mesh.domains().markers(d);
-
-    std::map<std::pair<std::size_t, std::size_t>,
-             std::size_t>::const_iterator it;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                                     std::size_t>& values = mvc.values();
+
+    // Build list of markers for mesh domains
+    std::vector<std::pair<std::size_t, std::size_t>> markers;
+    markers.reserve(values.size());
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>,
+                               std::size_t>::const_iterator it;
     for (it = values.begin(); it != values.end(); ++it)
     {
       const std::size_t cell_index = it->first.first;
       const std::size_t local_entity_index = it->first.second;
 
       if (d == D)
-        markers[0] = it->second;
+        markers.push_back(std::make_pair(cell_index, it->second));
       else
       {
         const Cell cell(mesh, cell_index);
-        const MeshEntity e(mesh, d, cell.entities(d)[local_entity_index]);
-        markers[e.index()] = it->second;
+        markers.push_back(std::make_pair(cell.entities(d)[local_entity_index],
+                                         it->second));
       }
     }
+
+    // Set markers in mesh domains
+    mesh.domains().set_markers(markers, d);
   }
 }
 //-----------------------------------------------------------------------------
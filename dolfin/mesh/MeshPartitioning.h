@@ -21,7 +21,7 @@
 // Modified by Chris Richardson, 2013
 //
 // First added:  2008-12-01
-// Last changed: 2014-06-20
+// Last changed: 2015-06-12
 
 #ifndef __MESH_PARTITIONING_H
 #define __MESH_PARTITIONING_H
@@ -73,6 +73,17 @@ namespace dolfin
     /// distributed across processes
     static void build_distributed_mesh(Mesh& mesh, const LocalMeshData& data);
 
+    /// Build a partitioned mesh from local mesh data that is
+    /// distributed across processes, with supplied destination
+    /// process for each local cell and, for cells that are ghosted,
+    /// the sharing processes (owner first). No graph partitioning is
+    /// performed. This is used by mesh generators that can compute
+    /// the partition and the ghost layer directly.
+    static void
+      build_distributed_mesh(Mesh& mesh, const LocalMeshData& data,
+                             const std::vector<std::size_t>& cell_partition,
+        const std::map<std::size_t, dolfin::Set<unsigned int>>& ghost_procs);
+
     /// Build a MeshValueCollection based on LocalMeshValueCollection
     template<typename T>
       static void
@@ -225,6 +236,10 @@ namespace dolfin
     const std::vector<std::size_t> global_entity_indices
       = mesh.topology().global_indices(D);
 
+    // Values to insert into the mesh value collection, inserted in
+    // bulk at the end
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
+
     // Add local (to this process) data to domain marker
     std::vector<std::size_t> off_process_global_cell_entities;
 
@@ -243,7 +258,9 @@ namespace dolfin
         const std::size_t local_cell_index = data->second;
         const std::size_t entity_local_index = ldata[i].first.second;
         const T value = ldata[i].second;
-        markers.set_value(local_cell_index, entity_local_index, value);
+        values.push_back(std::make_pair(std::make_pair(local_cell_index,
+                                                       entity_local_index),
+                                        value));
       }
       else
         off_process_global_cell_entities.push_back(global_cell_index);
@@ -320,9 +337,14 @@ namespace dolfin
         const std::size_t local_entity_index = received_data0[p][2*i + 1];
         const T value = received_data1[p][i];
         dolfin_assert(local_cell_entity < mesh.num_cells());
-        markers.set_value(local_cell_entity, local_entity_index, value);
+        values.push_back(std::make_pair(std::make_pair(local_cell_entity,
+                                                       local_entity_index),
+                                        value));
       }
     }
+
+    // Insert values into mesh value collection
+    markers.set_values(values);
   }
   //---------------------------------------------------------------------------
 
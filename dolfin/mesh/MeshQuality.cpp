@@ -16,10 +16,16 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-10-07
-// Last changed:
+// Last changed: 2015-06-13
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <dolfin/common/MPI.h>
+#include <dolfin/common/constants.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Cell.h"
 #include "Mesh.h"
 #include "MeshFunction.h"
@@ -27,6 +33,205 @@
 
 using namespace dolfin;
 
+namespace
+{
+  // Small vector operations on 3D points
+  inline void subtract(const double* a, const double* b, double* c)
+  {
+    c[0] = a[0] - b[0];
+    c[1] = a[1] - b[1];
+    c[2] = a[2] - b[2];
+  }
+
+  inline double dot(const double* a, const double* b)
+  { return a[0]*b[0] + a[1]*b[1] + a[2]*b[2]; }
+
+  inline void cross(const double* a, const double* b, double* c)
+  {
+    c[0] = a[1]*b[2] - a[2]*b[1];
+    c[1] = a[2]*b[0] - a[0]*b[2];
+    c[2] = a[0]*b[1] - a[1]*b[0];
+  }
+
+  inline double distance(const double* a, const double* b)
+  {
+    double d[3];
+    subtract(a, b, d);
+    return std::sqrt(dot(d, d));
+  }
+
+  // Compute radius ratio, aspect ratio and minimum angle (radians)
+  // of triangle with vertices p[0], p[1], p[2]
+  void triangle_quality(const double p[][3], double& radius_ratio,
+                        double& aspect_ratio, double& min_angle)
+  {
+    double d1[3], d2[3], n[3];
+    subtract(p[1], p[0], d1);
+    subtract(p[2], p[0], d2);
+    cross(d1, d2, n);
+    const double area = 0.5*std::sqrt(dot(n, n));
+
+    // Handle degenerate case
+    if (area == 0.0)
+    {
+      radius_ratio = 0.0;
+      aspect_ratio = std::numeric_limits<double>::infinity();
+      min_angle = 0.0;
+      return;
+    }
+
+    // Side lengths, inradius and diameter (2*circumradius)
+    const double a = distance(p[1], p[2]);
+    const double b = distance(p[0], p[2]);
+    const double c = distance(p[0], p[1]);
+    const double r = 2.0*area/(a + b + c);
+    const double diameter = 0.5*a*b*c/area;
+
+    radius_ratio = 4.0*r/diameter;
+    aspect_ratio = std::max(a, std::max(b, c))/(2.0*std::sqrt(3.0)*r);
+
+    // Interior angles
+    min_angle = DOLFIN_PI;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      subtract(p[(i + 1) % 3], p[i], d1);
+      subtract(p[(i + 2) % 3], p[i], d2);
+      min_angle = std::min(min_angle, std::atan2(2.0*area, dot(d1, d2)));
+    }
+  }
+
+  // Compute radius ratio, aspect ratio and minimum dihedral angle
+  // (radians) of tetrahedron with vertices p[0], ..., p[3]
+  void tetrahedron_quality(const double p[][3], double& radius_ratio,
+                           double& aspect_ratio, double& min_angle)
+  {
+    double d1[3], d2[3], d3[3], n[4][3];
+    subtract(p[1], p[0], d1);
+    subtract(p[2], p[0], d2);
+    subtract(p[3], p[0], d3);
+    cross(d2, d3, n[0]);
+    const double volume = std::abs(dot(d1, n[0]))/6.0;
+
+    // Handle degenerate case
+    if (volume == 0.0)
+    {
+      radius_ratio = 0.0;
+      aspect_ratio = std::numeric_limits<double>::infinity();
+      min_angle = 0.0;
+      return;
+    }
+
+    // Outward normals of facets (facet i is opposite vertex i), with
+    // length twice the facet area
+    double area = 0.0;
+    double norm[4];
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+      const double* q0 = p[(i + 1) % 4];
+      subtract(p[(i + 2) % 4], q0, d1);
+      subtract(p[(i + 3) % 4], q0, d2);
+      cross(d1, d2, n[i]);
+      subtract(p[i], q0, d3);
+      if (dot(n[i], d3) > 0.0)
+      {
+        n[i][0] = -n[i][0];
+        n[i][1] = -n[i][1];
+        n[i][2] = -n[i][2];
+      }
+      norm[i] = std::sqrt(dot(n[i], n[i]));
+      area += 0.5*norm[i];
+    }
+
+    // Side lengths
+    const double a  = distance(p[1], p[2]);
+    const double b  = distance(p[0], p[2]);
+    const double c  = distance(p[0], p[1]);
+    const double aa = distance(p[0], p[3]);
+    const double bb = distance(p[1], p[3]);
+    const double cc = distance(p[2], p[3]);
+
+    // Inradius and diameter (2*circumradius), see
+    // TetrahedronCell::diameter
+    const double r = 3.0*volume/area;
+    const double la = a*aa;
+    const double lb = b*bb;
+    const double lc = c*cc;
+    const double s  = 0.5*(la + lb + lc);
+    const double heron = std::sqrt(std::max(0.0, s*(s - la)*(s - lb)*(s - lc)));
+    const double diameter = heron/(3.0*volume);
+
+    radius_ratio = 6.0*r/diameter;
+    const double hmax = std::max(std::max(std::max(a, b), std::max(c, aa)),
+                                 std::max(bb, cc));
+    aspect_ratio = hmax/(2.0*std::sqrt(6.0)*r);
+
+    // Dihedral angles (angle between facets i and j)
+    double cos_max = -1.0;
+    for (std::size_t i = 0; i < 4; ++i)
+      for (std::size_t j = i + 1; j < 4; ++j)
+        cos_max = std::max(cos_max, -dot(n[i], n[j])/(norm[i]*norm[j]));
+    min_angle = std::acos(std::min(cos_max, 1.0));
+  }
+
+  // Compute quality measures for all cells. The output arrays
+  // aspect_ratio and min_angle may be null, in which case they are
+  // not computed.
+  void compute_cell_quality(const Mesh& mesh, double* radius_ratio,
+                            double* aspect_ratio, double* min_angle)
+  {
+    const std::size_t tdim = mesh.topology().dim();
+    const std::size_t gdim = mesh.geometry().dim();
+    const std::size_t num_vertices_per_cell = tdim + 1;
+    const std::int64_t num_cells = mesh.num_cells();
+    const std::vector<double>& x = mesh.geometry().x();
+    const std::vector<unsigned int>& cells = mesh.cells();
+
+    if (tdim < 1 || tdim > 3 || gdim < tdim
+        || mesh.type().num_entities(0) != num_vertices_per_cell)
+    {
+      dolfin_error("MeshQuality.cpp",
+                   "compute cell quality",
+                   "Cell quality is only implemented for simplicial cells");
+    }
+
+    #ifdef HAS_OPENMP
+    const int num_threads = std::max((int) parameters["num_threads"], 1);
+    #pragma omp parallel for num_threads(num_threads)
+    #endif
+    for (std::int64_t c = 0; c < num_cells; ++c)
+    {
+      // Copy vertex coordinates of cell, padding with zeros
+      double p[4][3] = {{0.0}};
+      for (std::size_t i = 0; i < num_vertices_per_cell; ++i)
+      {
+        const double* xi = x.data() + cells[c*num_vertices_per_cell + i]*gdim;
+        for (std::size_t j = 0; j < std::min(gdim, (std::size_t) 3); ++j)
+          p[i][j] = xi[j];
+      }
+
+      double rr = 1.0, ar = 1.0, angle = DOLFIN_PI;
+      if (tdim == 1)
+      {
+        if (distance(p[0], p[1]) == 0.0)
+        {
+          rr = 0.0;
+          ar = std::numeric_limits<double>::infinity();
+        }
+      }
+      else if (tdim == 2)
+        triangle_quality(p, rr, ar, angle);
+      else
+        tetrahedron_quality(p, rr, ar, angle);
+
+      radius_ratio[c] = rr;
+      if (aspect_ratio)
+        aspect_ratio[c] = ar;
+      if (min_angle)
+        min_angle[c] = angle*180.0/DOLFIN_PI;
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 dolfin::CellFunction<double>
 MeshQuality::radius_ratios(std::shared_ptr<const Mesh> mesh)
@@ -35,21 +240,39 @@ MeshQuality::radius_ratios(std::shared_ptr<const Mesh> mesh)
   CellFunction<double> cf(mesh, 0.0);
 
   // Compute radius ration
-  for (CellIterator cell(*mesh); !cell.end(); ++cell)
-    cf[*cell] = cell->radius_ratio();
+  if (mesh->num_cells() > 0)
+    compute_cell_quality(*mesh, cf.values(), NULL, NULL);
 
   return cf;
 }
 //-----------------------------------------------------------------------------
+void MeshQuality::cell_quality(const Mesh& mesh,
+                               std::vector<double>& radius_ratio,
+                               std::vector<double>& aspect_ratio,
+                               std::vector<double>& min_angle)
+{
+  radius_ratio.resize(mesh.num_cells());
+  aspect_ratio.resize(mesh.num_cells());
+  min_angle.resize(mesh.num_cells());
+  if (mesh.num_cells() > 0)
+  {
+    compute_cell_quality(mesh, radius_ratio.data(), aspect_ratio.data(),
+                         min_angle.data());
+  }
+}
+//-----------------------------------------------------------------------------
 std::pair<double, double> MeshQuality::radius_ratio_min_max(const Mesh& mesh)
 {
-  CellIterator cell(mesh);
-  double qmin = cell->radius_ratio();
-  double qmax = cell->radius_ratio();
-  for (; !cell.end(); ++cell)
+  std::vector<double> ratios(mesh.num_cells());
+  if (!ratios.empty())
+    compute_cell_quality(mesh, ratios.data(), NULL, NULL);
+
+  double qmin = std::numeric_limits<double>::max();
+  double qmax = 0.0;
+  if (!ratios.empty())
   {
-    qmin = std::min(qmin, cell->radius_ratio());
-    qmax = std::max(qmax, cell->radius_ratio());
+    qmin = *std::min_element(ratios.begin(), ratios.end());
+    qmax = *std::max_element(ratios.begin(), ratios.end());
   }
 
   qmin = MPI::min(mesh.mpi_comm(), qmin);
@@ -68,9 +291,12 @@ MeshQuality::radius_ratio_histogram_data(const Mesh& mesh,
   for (std::size_t i = 0; i < num_bins; ++i)
     bins[i] = static_cast<double>(i)*interval + interval/2.0;
 
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  std::vector<double> ratios(mesh.num_cells());
+  if (!ratios.empty())
+    compute_cell_quality(mesh, ratios.data(), NULL, NULL);
+
+  for (auto ratio : ratios)
   {
-    const double ratio = cell->radius_ratio();
 
     // Compute 'bin' index, and handle special case that ratio = 1.0
     const std::size_t slot
@@ -79,8 +305,7 @@ MeshQuality::radius_ratio_histogram_data(const Mesh& mesh,
     values[slot] += 1.0;
   }
 
-  for (std::size_t i = 0; i < values.size(); ++i)
-    values[i] = MPI::sum(mesh.mpi_comm(), values[i]);
+  values = MPI::sum(mesh.mpi_comm(), values);
 
   return std::make_pair(bins, values);
 }
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-10-07
-// Last changed:
+// Last changed: 2015-06-13
 
 #ifndef __MESH_QUALITY_H
 #define __MESH_QUALITY_H
@@ -78,6 +78,28 @@ namespace dolfin
     static std::pair<double, double> radius_ratio_min_max(const Mesh& mesh);
 
 
+    /// Compute the radius ratio, aspect ratio and minimum angle of
+    /// all (local) cells in a single pass over the cells. The pass is
+    /// threaded if DOLFIN is built with OpenMP (see the parameter
+    /// "num_threads").
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh (intervals, triangles or tetrahedra).
+    ///     radius_ratio (std::vector<double>)
+    ///         The radius ratio of each cell (see radius_ratios).
+    ///     aspect_ratio (std::vector<double>)
+    ///         The ratio of the longest edge to the inradius of each
+    ///         cell, normalised to one for an equilateral cell. It
+    ///         is infinite for a degenerate cell.
+    ///     min_angle (std::vector<double>)
+    ///         The minimum interior angle (triangles) or dihedral
+    ///         angle (tetrahedra) of each cell in degrees.
+    static void cell_quality(const Mesh& mesh,
+                             std::vector<double>& radius_ratio,
+                             std::vector<double>& aspect_ratio,
+                             std::vector<double>& min_angle);
+
     /// Create (ratio, number of cells) data for creating a histogram
     /// of cell quality
     static std::pair<std::vector<double>, std::vector<double> >
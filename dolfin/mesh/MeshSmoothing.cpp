@@ -18,11 +18,15 @@
 // Modified by Garth N. Wells, 2010
 //
 // First added:  2008-07-16
-// Last changed: 2011-03-17
+// Last changed: 2015-06-13
 
+#include <cstdint>
 #include <dolfin/ale/ALE.h>
 #include <dolfin/common/Array.h>
 #include <dolfin/common/constants.h>
+#include <dolfin/graph/GraphBuilder.h>
+#include <dolfin/graph/GraphColoring.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Mesh.h"
 #include "BoundaryMesh.h"
 #include "Vertex.h"
@@ -46,6 +50,10 @@ void MeshSmoothing::smooth(Mesh& mesh, std::size_t num_iterations)
   // Make sure we have vertex-edge connectivity
   mesh.init(0, 1);
 
+  // Make sure we have vertex-cell connectivity (connectivity must not
+  // be computed lazily by iterators inside the threaded loop below)
+  mesh.init(0, mesh.topology().dim());
+
   // Make sure the mesh is ordered
   mesh.order();
 
@@ -60,83 +68,107 @@ void MeshSmoothing::smooth(Mesh& mesh, std::size_t num_iterations)
       on_boundary[vertex_map[*v]] = true;
   }
 
+  // Color vertices such that vertices of the same color share no
+  // edge. Vertices of one color do not lie in the star of each other
+  // and can therefore be moved independently (in parallel), giving
+  // the same result as a sequential sweep in color order.
+  std::vector<std::size_t> colors;
+  const Graph graph = GraphBuilder::local_graph(mesh, 0, 1);
+  const std::size_t num_colors
+    = GraphColoring::compute_local_vertex_coloring(graph, colors);
+
+  // Build lists of interior vertices of each color
+  std::vector<std::vector<std::size_t>> color_vertices(num_colors);
+  for (std::size_t v = 0; v < mesh.num_vertices(); ++v)
+  {
+    if (!on_boundary[v])
+      color_vertices[colors[v]].push_back(v);
+  }
+
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) parameters["num_threads"], 1);
+  #endif
+
   // Iterate over all vertices
   const std::size_t d = mesh.geometry().dim();
-  std::vector<double> xx(d);
   for (std::size_t iteration = 0; iteration < num_iterations; iteration++)
   {
-    for (VertexIterator v(mesh); !v.end(); ++v)
+    for (std::size_t color = 0; color < num_colors; ++color)
     {
-      // Skip vertices on the boundary
-      if (on_boundary[*v])
-        continue;
-
-      // Get coordinates of vertex
-      double* x = mesh.geometry().x(v->index());
-      const Point p = v->point();
-
-      // Compute center of mass of neighboring vertices
-      for (std::size_t i = 0; i < d; i++) xx[i] = 0.0;
-      std::size_t num_neighbors = 0;
-      for (EdgeIterator e(*v); !e.end(); ++e)
-      {
-        // Get the other vertex
-        dolfin_assert(e->num_entities(0) == 2);
-        std::size_t other_index = e->entities(0)[0];
-        if (other_index == v->index())
-          other_index = e->entities(0)[1];
+      const std::vector<std::size_t>& vertices = color_vertices[color];
+      const std::int64_t num_color_vertices = vertices.size();
 
-        // Create the vertex
-        Vertex vn(mesh, other_index);
-
-        // Skip the vertex itself
-        if (v->index() == vn.index())
+      #ifdef HAS_OPENMP
+      #pragma omp parallel for num_threads(num_threads)
+      #endif
+      for (std::int64_t k = 0; k < num_color_vertices; ++k)
+      {
+        const Vertex v(mesh, vertices[k]);
+
+        // Get coordinates of vertex
+        double* x = mesh.geometry().x(v.index());
+        const Point p = v.point();
+
+        // Compute center of mass of neighboring vertices
+        double xx[3] = {0.0, 0.0, 0.0};
+        std::size_t num_neighbors = 0;
+        for (EdgeIterator e(v); !e.end(); ++e)
+        {
+          // Get the other vertex
+          dolfin_assert(e->num_entities(0) == 2);
+          std::size_t other_index = e->entities(0)[0];
+          if (other_index == v.index())
+            other_index = e->entities(0)[1];
+
+          // Skip the vertex itself
+          if (v.index() == other_index)
+            continue;
+          num_neighbors += 1;
+
+          // Compute center of mass
+          const double* xn = mesh.geometry().x(other_index);
+          for (std::size_t i = 0; i < d; i++)
+            xx[i] += xn[i];
+        }
+        for (std::size_t i = 0; i < d; i++)
+          xx[i] /= static_cast<double>(num_neighbors);
+
+        // Compute closest distance to boundary of star
+        double rmin = 0.0;
+        for (CellIterator c(v); !c.end(); ++c)
+        {
+          // Get local number of vertex relative to facet
+          const std::size_t local_vertex = c->index(v);
+
+          // Get normal of corresponding facet
+          Point n = c->normal(local_vertex);
+
+          // Get first vertex in facet
+          Facet f(mesh, c->entities(mesh.topology().dim() - 1)[local_vertex]);
+          VertexIterator fv(f);
+
+          // Compute length of projection of v - fv onto normal
+          const double r = std::abs(n.dot(p - fv->point()));
+          if (rmin == 0.0)
+            rmin = r;
+          else
+            rmin = std::min(rmin, r);
+        }
+
+        // Move vertex at most a distance rmin / 2
+        double r = 0.0;
+        for (std::size_t i = 0; i < d; i++)
+        {
+          const double dx = xx[i] - x[i];
+          r += dx*dx;
+        }
+        r = std::sqrt(r);
+        if (r < DOLFIN_EPS)
           continue;
-        num_neighbors += 1;
-
-        // Compute center of mass
-        const double* xn = vn.x();
+        rmin = std::min(0.5*rmin, r);
         for (std::size_t i = 0; i < d; i++)
-          xx[i] += xn[i];
+          x[i] += rmin*(xx[i] - x[i])/r;
       }
-      for (std::size_t i = 0; i < d; i++)
-        xx[i] /= static_cast<double>(num_neighbors);
-
-      // Compute closest distance to boundary of star
-      double rmin = 0.0;
-      for (CellIterator c(*v); !c.end(); ++c)
-      {
-        // Get local number of vertex relative to facet
-        const std::size_t local_vertex = c->index(*v);
-
-        // Get normal of corresponding facet
-        Point n = c->normal(local_vertex);
-
-        // Get first vertex in facet
-        Facet f(mesh, c->entities(mesh.topology().dim() - 1)[local_vertex]);
-        VertexIterator fv(f);
-
-        // Compute length of projection of v - fv onto normal
-        const double r = std::abs(n.dot(p - fv->point()));
-        if (rmin == 0.0)
-          rmin = r;
-        else
-          rmin = std::min(rmin, r);
-      }
-
-      // Move vertex at most a distance rmin / 2
-      double r = 0.0;
-      for (std::size_t i = 0; i < d; i++)
-      {
-        const double dx = xx[i] - x[i];
-        r += dx*dx;
-      }
-      r = std::sqrt(r);
-      if (r < DOLFIN_EPS)
-        continue;
-      rmin = std::min(0.5*rmin, r);
-      for (std::size_t i = 0; i < d; i++)
-        x[i] += rmin*(xx[i] - x[i])/r;
     }
   }
 
@@ -195,10 +227,15 @@ void MeshSmoothing::move_interior_vertices(Mesh& mesh,
     // Use vertex map to update boundary coordinates of original mesh
     const MeshFunction<std::size_t>& vertex_map = boundary.entity_map(0);
     const std::size_t d = mesh.geometry().dim();
-    for (VertexIterator v(boundary); !v.end(); ++v)
+    const std::int64_t num_boundary_vertices = boundary.num_vertices();
+    #ifdef HAS_OPENMP
+    const int num_threads = std::max((int) parameters["num_threads"], 1);
+    #pragma omp parallel for num_threads(num_threads)
+    #endif
+    for (std::int64_t v = 0; v < num_boundary_vertices; ++v)
     {
-      const double* xb = v->x();
-      double* xm = mesh.geometry().x(vertex_map[*v]);
+      const double* xb = boundary.geometry().x(v);
+      double* xm = mesh.geometry().x(vertex_map[v]);
       for (std::size_t i = 0; i < d; i++)
         xm[i] = xb[i];
     }
@@ -18,14 +18,16 @@
 // Modified by Chris Richardson, 2013.
 //
 // First added:  2006-08-30
-// Last changed: 2013-05-22
+// Last changed: 2015-06-12
 
 #ifndef __MESH_VALUE_COLLECTION_H
 #define __MESH_VALUE_COLLECTION_H
 
-#include <map>
+#include <algorithm>
 #include <utility>
 #include <memory>
+#include <vector>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/NoDeleter.h>
 #include <dolfin/common/Variable.h>
 #include <dolfin/log/log.h>
@@ -45,6 +47,12 @@ namespace dolfin
   /// entities through the corresponding cell index and local entity
   /// number (relative to the cell), not by global entity index, which
   /// means that data may be stored robustly to file.
+  ///
+  /// The values are stored in a flat array sorted by (cell index,
+  /// local entity index). Single values are found by binary search.
+  /// Large numbers of values should be inserted in bulk with
+  /// set_values, since each call to set_value may move all stored
+  /// values.
 
   template <typename T>
   class MeshValueCollection : public Variable
@@ -211,6 +219,26 @@ namespace dolfin
     ///         an existing value.
     bool set_value(std::size_t entity_index, const T& value);
 
+    /// Set values for a list of entities defined by a cell index and
+    /// a local entity index. This is much faster than calling
+    /// set_value for each entity. If an entity appears more than
+    /// once, or already has a value, the last value given is used.
+    ///
+    /// *Arguments*
+    ///     values (std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>)
+    ///         List of ((cell index, local entity index), value). The
+    ///         list is reordered by this function.
+    void set_values(std::vector<std::pair<std::pair<std::size_t,
+                                                    std::size_t>, T>>& values);
+
+    /// Set values for a list of entities defined by entity index.
+    /// This is much faster than calling set_value for each entity.
+    ///
+    /// *Arguments*
+    ///     values (std::vector<std::pair<std::size_t, T>>)
+    ///         List of (entity index, value).
+    void set_values(const std::vector<std::pair<std::size_t, T>>& values);
+
     /// Get marker value for given entity defined by a cell index and
     /// a local entity index
     ///
@@ -228,16 +256,18 @@ namespace dolfin
     /// Get all values
     ///
     /// *Returns*
-    ///     std::map<std::pair<std::size_t, std::size_t>, T>
+    ///     boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
     ///         A map from positions to values.
-    std::map<std::pair<std::size_t, std::size_t>, T>& values();
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values();
 
     /// Get all values (const version)
     ///
     /// *Returns*
-    ///     std::map<std::pair<std::size_t, std::size_t>, T>
+    ///     boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
     ///         A map from positions to values.
-    const std::map<std::pair<std::size_t, std::size_t>, T>& values() const;
+    const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
+      values() const;
 
     /// Clear all values
     void clear();
@@ -261,8 +291,12 @@ namespace dolfin
     // Topological dimension
     int _dim;
 
-    // The values
-    std::map<std::pair<std::size_t, std::size_t>, T> _values;
+    // Fill values from mesh function
+    void init_values(const MeshFunction<T>& mesh_function);
+
+    // The values (sorted by position)
+    boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>
+      _values;
 
   };
 
@@ -306,45 +340,7 @@ namespace dolfin
     : Variable("m", "unnamed MeshValueCollection"), _mesh(mesh_function.mesh()),
       _dim(mesh_function.dim())
   {
-    dolfin_assert(_mesh);
-    const std::size_t D = _mesh->topology().dim();
-
-    // Handle cells as a special case
-    if ((int) D == _dim)
-    {
-      for (std::size_t cell_index = 0; cell_index < mesh_function.size();
-           ++cell_index)
-      {
-        const std::pair<std::size_t, std::size_t> key(cell_index, 0);
-        _values.insert(std::make_pair(key, mesh_function[cell_index]));
-      }
-    }
-    else
-    {
-      _mesh->init(_dim, D);
-      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
-      dolfin_assert(!connectivity.empty());
-      for (std::size_t entity_index = 0; entity_index < mesh_function.size();
-           ++entity_index)
-      {
-        // Find the cell
-        dolfin_assert(connectivity.size(entity_index) > 0);
-        const MeshEntity entity(*_mesh, _dim, entity_index);
-        for (std::size_t i = 0; i < entity.num_entities(D) ; ++i)
-        {
-          // Create cell
-          const Cell cell(*_mesh, connectivity(entity_index)[i]);
-
-          // Find the local entity index
-          const std::size_t local_entity = cell.index(entity);
-
-          // Insert into map
-          const std::pair<std::size_t, std::size_t> key(cell.index(),
-                                                        local_entity);
-          _values.insert(std::make_pair(key, mesh_function[entity_index]));
-        }
-      }
-    }
+    init_values(mesh_function);
   }
   //---------------------------------------------------------------------------
   template <typename T>
@@ -365,47 +361,7 @@ namespace dolfin
     _mesh = mesh_function.mesh();
     _dim = mesh_function.dim();
 
-    dolfin_assert(_mesh);
-    const std::size_t D = _mesh->topology().dim();
-
-    // FIXME: Use iterators
-
-    // Handle cells as a special case
-    if ((int) D == _dim)
-    {
-      for (std::size_t cell_index = 0; cell_index < mesh_function.size();
-           ++cell_index)
-      {
-        const std::pair<std::size_t, std::size_t> key(cell_index, 0);
-        _values.insert(std::make_pair(key, mesh_function[cell_index]));
-      }
-    }
-    else
-    {
-      _mesh->init(_dim, D);
-      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
-      dolfin_assert(!connectivity.empty());
-      for (std::size_t entity_index = 0; entity_index < mesh_function.size();
-           ++entity_index)
-      {
-        // Find the cell
-        dolfin_assert(connectivity.size(entity_index) > 0);
-        const MeshEntity entity(*_mesh, _dim, entity_index);
-        for (std::size_t i = 0; i < entity.num_entities(D) ; ++i)
-        {
-          // Create cell
-          const Cell cell(*_mesh, connectivity(entity_index)[i]);
-
-          // Find the local entity index
-          const std::size_t local_entity = cell.index(entity);
-
-          // Insert into map
-          const std::pair<std::size_t, std::size_t> key(cell.index(),
-                                                        local_entity);
-          _values.insert(std::make_pair(key, mesh_function[entity_index]));
-        }
-      }
-    }
+    init_values(mesh_function);
 
     return *this;
   }
@@ -489,8 +445,7 @@ namespace dolfin
     }
 
     const std::pair<std::size_t, std::size_t> pos(cell_index, local_entity);
-    std::pair<typename std::map<std::pair<std::size_t, std::size_t>, T>::iterator, bool>
-      it = _values.insert(std::make_pair(pos, value));
+    auto it = _values.insert(std::make_pair(pos, value));
 
     // If an item with same key already exists the value has not been
     // set and we need to update it
@@ -519,9 +474,7 @@ namespace dolfin
     {
       // Set local entity index to zero when we mark a cell
       const std::pair<std::size_t, std::size_t> pos(entity_index, 0);
-      std::pair<typename std::map<std::pair<std::size_t,
-        std::size_t>, T>::iterator, bool> it;
-      it = _values.insert(std::make_pair(pos, value));
+      auto it = _values.insert(std::make_pair(pos, value));
 
       // If an item with same key already exists the value has not been
       // set and we need to update it
@@ -546,9 +499,7 @@ namespace dolfin
 
     // Add value
     const std::pair<std::size_t, std::size_t> pos(cell.index(), local_entity);
-    std::pair<typename std::map<std::pair<std::size_t,
-      std::size_t>, T>::iterator, bool> it;
-    it = _values.insert(std::make_pair(pos, value));
+    auto it = _values.insert(std::make_pair(pos, value));
 
     // If an item with same key already exists the value has not been
     // set and we need to update it
@@ -559,15 +510,102 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
+  void MeshValueCollection<T>::set_values(
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>& values)
+  {
+    dolfin_assert(_dim >= 0);
+    if (!_mesh)
+    {
+      dolfin_error("MeshValueCollection.h",
+                   "set values",
+                   "A mesh has not been associated with this MeshValueCollection");
+    }
+
+    // Put existing values first and sort by position, keeping the
+    // order of values for the same position
+    values.insert(values.begin(), _values.begin(), _values.end());
+    std::stable_sort(values.begin(), values.end(),
+                     [](const std::pair<std::pair<std::size_t,
+                                                  std::size_t>, T>& a,
+                        const std::pair<std::pair<std::size_t,
+                                                  std::size_t>, T>& b)
+                     { return a.first < b.first; });
+
+    // Keep last value for each position
+    std::size_t num_values = 0;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      if (i + 1 == values.size() || values[i + 1].first != values[i].first)
+        values[num_values++] = values[i];
+    }
+    values.resize(num_values);
+
+    // Build sorted array of values
+    _values = boost::container::flat_map<std::pair<std::size_t,
+                                                   std::size_t>, T>(
+      boost::container::ordered_unique_range, values.begin(), values.end());
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
+  void MeshValueCollection<T>::set_values(
+    const std::vector<std::pair<std::size_t, T>>& values)
+  {
+    dolfin_assert(_dim >= 0);
+    if (!_mesh)
+    {
+      dolfin_error("MeshValueCollection.h",
+                   "set values",
+                   "A mesh has not been associated with this MeshValueCollection");
+    }
+
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>>
+      cell_values;
+    cell_values.reserve(values.size());
+
+    // Special case when d = D
+    const std::size_t D = _mesh->topology().dim();
+    if (_dim == (int) D)
+    {
+      for (auto& value : values)
+      {
+        const std::pair<std::size_t, std::size_t> pos(value.first, 0);
+        cell_values.push_back(std::make_pair(pos, value.second));
+      }
+    }
+    else
+    {
+      // Choose first cell of each entity, as in set_value
+      _mesh->init(_dim, D);
+      _mesh->init(D, _dim);
+      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
+      const MeshConnectivity& cell_entities = _mesh->topology()(D, _dim);
+      for (auto& value : values)
+      {
+        dolfin_assert(connectivity.size(value.first) > 0);
+        const std::size_t cell_index = connectivity(value.first)[0];
+        const unsigned int* entities = cell_entities(cell_index);
+        const std::size_t local_entity
+          = std::find(entities, entities + cell_entities.size(cell_index),
+                      value.first) - entities;
+        dolfin_assert(local_entity < cell_entities.size(cell_index));
+
+        const std::pair<std::size_t, std::size_t> pos(cell_index,
+                                                      local_entity);
+        cell_values.push_back(std::make_pair(pos, value.second));
+      }
+    }
+
+    set_values(cell_values);
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
   T MeshValueCollection<T>::get_value(std::size_t cell_index,
 				      std::size_t local_entity)
   {
     dolfin_assert(_dim >= 0);
 
     const std::pair<std::size_t, std::size_t> pos(cell_index, local_entity);
-    const typename std::map<std::pair<std::size_t,
-      std::size_t>, T>::const_iterator
-      it = _values.find(pos);
+    const auto it = _values.find(pos);
 
     if (it == _values.end())
     {
@@ -581,14 +619,14 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
-  std::map<std::pair<std::size_t, std::size_t>, T>&
+  boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
     MeshValueCollection<T>::values()
   {
     return _values;
   }
   //---------------------------------------------------------------------------
   template <typename T>
-  const std::map<std::pair<std::size_t, std::size_t>, T>&
+  const boost::container::flat_map<std::pair<std::size_t, std::size_t>, T>&
   MeshValueCollection<T>::values() const
   {
     return _values;
@@ -601,6 +639,60 @@ namespace dolfin
   }
   //---------------------------------------------------------------------------
   template <typename T>
+  void MeshValueCollection<T>::init_values(const MeshFunction<T>& mesh_function)
+  {
+    dolfin_assert(_mesh);
+    const std::size_t D = _mesh->topology().dim();
+
+    // Build list of values for all entities
+    std::vector<std::pair<std::pair<std::size_t, std::size_t>, T>> values;
+
+    // Handle cells as a special case
+    if ((int) D == _dim)
+    {
+      values.reserve(mesh_function.size());
+      for (std::size_t cell_index = 0; cell_index < mesh_function.size();
+           ++cell_index)
+      {
+        const std::pair<std::size_t, std::size_t> key(cell_index, 0);
+        values.push_back(std::make_pair(key, mesh_function[cell_index]));
+      }
+    }
+    else
+    {
+      _mesh->init(_dim, D);
+      _mesh->init(D, _dim);
+      const MeshConnectivity& connectivity = _mesh->topology()(_dim, D);
+      const MeshConnectivity& cell_entities = _mesh->topology()(D, _dim);
+      dolfin_assert(!connectivity.empty());
+      for (std::size_t entity_index = 0; entity_index < mesh_function.size();
+           ++entity_index)
+      {
+        // Iterate over cells of entity
+        dolfin_assert(connectivity.size(entity_index) > 0);
+        for (std::size_t i = 0; i < connectivity.size(entity_index); ++i)
+        {
+          // Find the local entity index
+          const std::size_t cell_index = connectivity(entity_index)[i];
+          const unsigned int* entities = cell_entities(cell_index);
+          const std::size_t local_entity
+            = std::find(entities, entities + cell_entities.size(cell_index),
+                        entity_index) - entities;
+          dolfin_assert(local_entity < cell_entities.size(cell_index));
+
+          // Add to list
+          const std::pair<std::size_t, std::size_t> key(cell_index,
+                                                        local_entity);
+          values.push_back(std::make_pair(key, mesh_function[entity_index]));
+        }
+      }
+    }
+
+    // Insert values
+    set_values(values);
+  }
+  //---------------------------------------------------------------------------
+  template <typename T>
   std::string MeshValueCollection<T>::str(bool verbose) const
   {
     std::stringstream s;
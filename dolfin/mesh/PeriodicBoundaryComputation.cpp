@@ -16,15 +16,22 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-01-10
-// Last changed:
+// Last changed: 2015-06-12
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <limits>
 #include <map>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <dolfin/common/Array.h>
+#include <dolfin/common/Timer.h>
 #include <dolfin/log/log.h>
 #include "DistributedMeshTools.h"
 #include "Facet.h"
@@ -35,38 +42,112 @@
 
 using namespace dolfin;
 
-// Comparison operator for hashing coordinates. Note that two
-// coordinates are considered equal if equal to within specified
-// tolerance.
-struct lt_coordinate
+namespace
 {
-  lt_coordinate(double tolerance) : TOL(tolerance) {}
+  // Index of a cell in the spatial hash grid
+  typedef std::array<std::int64_t, 3> GridKey;
 
-  bool operator() (const std::vector<double>& x,
-                   const std::vector<double>& y) const
+  struct GridKeyHash
   {
-    std::size_t n = std::max(x.size(), y.size());
-    for (std::size_t i = 0; i < n; ++i)
+    std::size_t operator() (const GridKey& key) const
+    { return boost::hash_range(key.begin(), key.end()); }
+  };
+
+  // Uniform grid used for spatial hashing of entity midpoints. Each
+  // grid cell is owned by one process (determined by the hash of the
+  // cell index). Indices are clamped to one cell outside the grid, so
+  // points far outside the grid do not overflow the index type.
+  class HashGrid
+  {
+  public:
+
+    HashGrid(const std::vector<double>& x_min, const std::vector<double>& x_max,
+             double tolerance)
+      : _x0(x_min), _h(2.0*tolerance), _n(1)
     {
-      double xx = 0.0;
-      double yy = 0.0;
-      if (i < x.size())
-        xx = x[i];
-      if (i < y.size())
-        yy = y[i];
-
-      if (xx < (yy - TOL))
-        return true;
-      else if (xx > (yy + TOL))
-        return false;
+      // Choose spacing such that a point with tolerance overlaps at
+      // most two cells in each direction, and the number of cells in
+      // each direction is bounded
+      for (std::size_t i = 0; i < _x0.size(); ++i)
+        _h = std::max(_h, (x_max[i] - x_min[i])/max_cells);
+      if (_h <= 0.0)
+        _h = 1.0;
+      for (std::size_t i = 0; i < _x0.size(); ++i)
+      {
+        _n = std::max(_n, (std::int64_t) std::ceil((x_max[i] - x_min[i])/_h));
+      }
     }
-    return false;
-  }
 
-  // Tolerance
-  const double TOL;
+    // Grid index in direction i of coordinate x
+    std::int64_t index(double x, std::size_t i) const
+    {
+      const double j = std::floor((x - _x0[i])/_h);
+      return (std::int64_t) std::max(-1.0, std::min(j, (double) (_n + 1)));
+    }
+
+    // Grid cell containing point x
+    GridKey key(const double* x) const
+    {
+      GridKey k = {{0, 0, 0}};
+      for (std::size_t i = 0; i < _x0.size(); ++i)
+        k[i] = index(x[i], i);
+      return k;
+    }
+
+    // Grid cells overlapped by the box [x - tol, x + tol]
+    void keys(std::vector<GridKey>& k, const double* x, double tol) const
+    {
+      k.assign(1, GridKey({{0, 0, 0}}));
+      for (std::size_t i = 0; i < _x0.size(); ++i)
+      {
+        const std::int64_t lo = index(x[i] - tol, i);
+        const std::int64_t hi = index(x[i] + tol, i);
+        const std::size_t num_keys = k.size();
+        k.reserve(num_keys*(hi - lo + 1));
+        for (std::int64_t j = lo + 1; j <= hi; ++j)
+          for (std::size_t c = 0; c < num_keys; ++c)
+            k.push_back(k[c]);
+        for (std::size_t c = 0; c < k.size(); ++c)
+          k[c][i] = lo + c/num_keys;
+      }
+    }
+
+    // Process owning grid cell
+    static std::size_t owner(const GridKey& key, std::size_t num_processes)
+    { return GridKeyHash()(key) % num_processes; }
+
+  private:
+
+    // Maximum number of cells in each direction
+    static constexpr double max_cells = 1048576.0;
 
-};
+    // Grid origin
+    std::vector<double> _x0;
+
+    // Grid spacing
+    double _h;
+
+    // Number of cells in each direction
+    std::int64_t _n;
+
+  };
+
+  // Cached slave-master pairs
+  struct PeriodicPairs
+  {
+    std::weak_ptr<const SubDomain> sub_domain;
+    std::size_t mesh_hash;
+    std::size_t dim;
+    std::shared_ptr<const std::map<unsigned int,
+                                   std::pair<unsigned int, unsigned int>>> pairs;
+  };
+
+  std::vector<PeriodicPairs>& periodic_pairs_cache()
+  {
+    static std::vector<PeriodicPairs> cache;
+    return cache;
+  }
+}
 
 //-----------------------------------------------------------------------------
 std::map<unsigned int, std::pair<unsigned int, unsigned int>>
@@ -74,13 +155,19 @@ std::map<unsigned int, std::pair<unsigned int, unsigned int>>
                                                       const SubDomain& sub_domain,
                                                       const std::size_t dim)
 {
+  Timer t("Compute periodic pairs");
+
   // MPI communication
   const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
 
   // Get geometric and topological dimensions
   const std::size_t gdim = mesh.geometry().dim();
   const std::size_t tdim = mesh.topology().dim();
 
+  // Tolerance for matching coordinates
+  const double tol = sub_domain.map_tolerance;
+
   // Arrays used for mapping coordinates
   std::vector<double> x(gdim);
   std::vector<double> y(gdim);
@@ -89,16 +176,16 @@ std::map<unsigned int, std::pair<unsigned int, unsigned int>>
   Array<double> _x(gdim, x.data());
   Array<double> _y(gdim, y.data());
 
-  std::vector<std::size_t> slave_entities;
-  std::vector<std::vector<double>> slave_mapped_coords;
-
-  // Min/max coordinates of facet midpoints [min_x, max_x]. Used to
-  // build bounding box of all master entity midpoints on this process
-  std::vector<double> x_min_max;
+  // Master entities (local index and midpoint) and slave entities
+  // (local index and mapped midpoint), coordinates stored
+  // contiguously
+  std::vector<unsigned int> master_entities, slave_entities;
+  std::vector<double> master_coords, slave_mapped_coords;
 
-  // Map from master entity midpoint coordinate to local facet index
-  std::map<std::vector<double>, unsigned int, lt_coordinate>
-    master_coord_to_entity_index((lt_coordinate(sub_domain.map_tolerance)));
+  // Bounding box of master entity midpoints, stored as [-min_x, max_x]
+  // such that it can be reduced with a single max operation
+  std::vector<double> bounding_box(2*gdim,
+                                   -std::numeric_limits<double>::max());
 
   // Initialise facet-cell connectivity
   mesh.init(tdim - 1, tdim);
@@ -127,21 +214,16 @@ std::map<unsigned int, std::pair<unsigned int, unsigned int>>
         // Check if entity lies on a 'master' or 'slave' boundary
         if (sub_domain.inside(_x, true))
         {
-          // Build bounding box data for master entity midpoints
-          if (x_min_max.empty())
-          {
-            x_min_max = x;
-            x_min_max.insert(x_min_max.end(), x.begin(), x.end());
-          }
-
+          // Update bounding box of master entity midpoints
           for (std::size_t i = 0; i < gdim; ++i)
           {
-            x_min_max[i]        = std::min(x_min_max[i], x[i]);
-            x_min_max[gdim + i] = std::max(x_min_max[gdim + i], x[i]);
+            bounding_box[i] = std::max(bounding_box[i], -x[i]);
+            bounding_box[gdim + i] = std::max(bounding_box[gdim + i], x[i]);
           }
 
-          // Insert (midpoint coordinates, local index) into map
-          master_coord_to_entity_index.insert(std::make_pair(x, e->index()));
+          // Store master local index and midpoint coordinates
+          master_entities.push_back(e->index());
+          master_coords.insert(master_coords.end(), x.begin(), x.end());
         }
         else
         {
@@ -170,104 +252,152 @@ std::map<unsigned int, std::pair<unsigned int, unsigned int>>
           {
             // Store slave local index and midpoint coordinates
             slave_entities.push_back(e->index());
-            slave_mapped_coords.push_back(y);
+            slave_mapped_coords.insert(slave_mapped_coords.end(),
+                                       y.begin(), y.end());
           }
         }
       }
     }
   }
 
-  // Communicate bounding boxes for master entities
-  std::vector<std::vector<double>> bounding_boxes;
-  MPI::all_gather(mpi_comm, x_min_max, bounding_boxes);
+  // Compute global bounding box of master entities. If there are no
+  // master entities, there is nothing to match.
+  bounding_box = MPI::max(mpi_comm, bounding_box);
+  std::map<unsigned int, std::pair<unsigned int, unsigned int>>
+    slave_to_master_entity;
+  if (bounding_box[0] == -std::numeric_limits<double>::max())
+    return slave_to_master_entity;
+  std::vector<double> x_min(gdim), x_max(gdim);
+  for (std::size_t i = 0; i < gdim; ++i)
+  {
+    x_min[i] = -bounding_box[i];
+    x_max[i] = bounding_box[gdim + i];
+  }
 
-  // Number of MPI processes
-  std::size_t num_processes = MPI::size(mpi_comm);
+  // Create spatial hash grid. Master midpoints are sent to the owners
+  // of all grid cells within the tolerance, slave mapped midpoints to
+  // the owner of the grid cell containing them. Matching pairs
+  // therefore always meet on (at least) one process.
+  const HashGrid grid(x_min, x_max, tol);
 
-  // Build send buffer of mapped slave midpoint coordinate to
-  // processes that may own the master entity
-  std::vector<std::vector<double>> slave_mapped_coords_send(num_processes);
+  // Pack entities to send as (type, local index, coordinates), with
+  // type 0 for masters and 1 for slaves
+  const std::size_t stride = 2 + gdim;
+  std::vector<std::vector<double>> send_entities(num_processes);
   std::vector<std::vector<unsigned int>> sent_slave_indices(num_processes);
+  std::vector<GridKey> keys;
+  std::vector<std::size_t> owners;
+  for (std::size_t i = 0; i < master_entities.size(); ++i)
+  {
+    const double* xm = &master_coords[i*gdim];
+    grid.keys(keys, xm, tol);
+    owners.clear();
+    for (std::size_t k = 0; k < keys.size(); ++k)
+      owners.push_back(HashGrid::owner(keys[k], num_processes));
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+
+    for (std::size_t k = 0; k < owners.size(); ++k)
+    {
+      std::vector<double>& send_p = send_entities[owners[k]];
+      send_p.push_back(0.0);
+      send_p.push_back(master_entities[i]);
+      send_p.insert(send_p.end(), xm, xm + gdim);
+    }
+  }
   for (std::size_t i = 0; i < slave_entities.size(); ++i)
   {
-    for (std::size_t p = 0; p < num_processes; ++p)
+    const double* ys = &slave_mapped_coords[i*gdim];
+    const std::size_t p = HashGrid::owner(grid.key(ys), num_processes);
+    std::vector<double>& send_p = send_entities[p];
+    send_p.push_back(1.0);
+    send_p.push_back(slave_entities[i]);
+    send_p.insert(send_p.end(), ys, ys + gdim);
+    sent_slave_indices[p].push_back(slave_entities[i]);
+  }
+
+  // Send masters and slaves to the owners of their grid cells
+  std::vector<std::vector<double>> recv_entities;
+  MPI::all_to_all(mpi_comm, send_entities, recv_entities);
+  dolfin_assert(recv_entities.size() == num_processes);
+
+  // Insert received masters into the grid cells owned by this process
+  const std::size_t my_rank = MPI::rank(mpi_comm);
+  boost::unordered_map<GridKey, std::vector<std::pair<unsigned int,
+                                                      std::size_t>>,
+                       GridKeyHash> grid_masters;
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const std::vector<double>& recv_p = recv_entities[p];
+    for (std::size_t i = 0; i < recv_p.size(); i += stride)
     {
-      // Slave mapped coordinates from process p
-      std::vector<double>& slave_mapped_coords_send_p
-        = slave_mapped_coords_send[p];
-
-      // Check if mapped slave falls within master entity bounding box
-      // on process p
-      if (in_bounding_box(slave_mapped_coords[i], bounding_boxes[p],
-                          sub_domain.map_tolerance))
+      if (recv_p[i] != 0.0)
+        continue;
+      grid.keys(keys, &recv_p[i + 2], tol);
+      for (std::size_t k = 0; k < keys.size(); ++k)
       {
-        sent_slave_indices[p].push_back(slave_entities[i]);
-        slave_mapped_coords_send_p.insert(slave_mapped_coords_send_p.end(),
-                                          slave_mapped_coords[i].begin(),
-                                          slave_mapped_coords[i].end());
+        if (HashGrid::owner(keys[k], num_processes) == my_rank)
+          grid_masters[keys[k]].push_back(std::make_pair(p, i));
       }
     }
   }
 
-  // Send slave midpoints to possible owners of corresponding master
-  // entity
-  std::vector<std::vector<double>> slave_mapped_coords_recv;
-  MPI::all_to_all(mpi_comm,  slave_mapped_coords_send,
-                  slave_mapped_coords_recv);
-  dolfin_assert(slave_mapped_coords_recv.size() == num_processes);
-
-  // Check if this process owns the master facet for a received (mapped)
-  // slave
-  std::vector<double> coordinates(gdim);
+  // Match received slaves against masters in the same grid cell, and
+  // return (master process, master local index) to the slave owner. If
+  // no master is found, return std::numeric_limits<unsigned int>::max().
+  // If a master is shared by processes, the lowest ranked is used.
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
   std::vector<std::vector<unsigned int>> master_local_entity(num_processes);
   for (std::size_t p = 0; p < num_processes; ++p)
   {
-    const std::vector<double>& slave_mapped_coords_p
-      = slave_mapped_coords_recv[p];
-    for (std::size_t i = 0; i < slave_mapped_coords_p.size(); i += gdim)
+    const std::vector<double>& recv_p = recv_entities[p];
+    for (std::size_t i = 0; i < recv_p.size(); i += stride)
     {
-      // Unpack received mapped slave midpoint coordinate
-      std::copy(&slave_mapped_coords_p[i],
-                &slave_mapped_coords_p[i] + gdim, coordinates.begin());
-
-      // Check is this process has a master entity that is paired with
-      // a received slave entity
-      std::map<std::vector<double>, unsigned int>::const_iterator
-        it = master_coord_to_entity_index.find(coordinates);
-
-      // If this process owns the master, insert master entity index,
-      // else insert std::numeric_limits<unsigned int>::max()
-      if (it !=  master_coord_to_entity_index.end())
-        master_local_entity[p].push_back(it->second);
-      else
-        master_local_entity[p].push_back(std::numeric_limits<unsigned int>::max());
+      if (recv_p[i] != 1.0)
+        continue;
+
+      const double* ys = &recv_p[i + 2];
+      std::pair<unsigned int, unsigned int> master(not_found, not_found);
+      auto cell = grid_masters.find(grid.key(ys));
+      if (cell != grid_masters.end())
+      {
+        for (auto m = cell->second.begin(); m != cell->second.end(); ++m)
+        {
+          const double* xm = &recv_entities[m->first][m->second + 2];
+          bool match = true;
+          for (std::size_t j = 0; j < gdim; ++j)
+            match = match && std::abs(xm[j] - ys[j]) <= tol;
+
+          const unsigned int master_index
+            = recv_entities[m->first][m->second + 1];
+          if (match && std::make_pair(m->first, master_index) < master)
+            master = std::make_pair(m->first, master_index);
+        }
+      }
+      master_local_entity[p].push_back(master.first);
+      master_local_entity[p].push_back(master.second);
     }
   }
 
-  // Send local index of master entity back to owner of slave entity
-  std::vector<std::vector<unsigned int>> master_entity_local_index_recv;
-  MPI::all_to_all(mpi_comm, master_local_entity,
-                  master_entity_local_index_recv);
+  // Send master (process, local index) back to owner of slave entity
+  std::vector<std::vector<unsigned int>> master_entity_recv;
+  MPI::all_to_all(mpi_comm, master_local_entity, master_entity_recv);
 
-  // Build map from slave facets on this process to master facet (local
-  // facet index, process owner)
-  std::map<unsigned int, std::pair<unsigned int, unsigned int>>
-    slave_to_master_entity;
-  std::size_t num_local_slave_entities = 0;
+  // Build map from slave entities on this process to master entity
+  // (process owner, local entity index)
   for (std::size_t p = 0; p < num_processes; ++p)
   {
-    const std::vector<unsigned int> master_entity_index_p
-      = master_entity_local_index_recv[p];
-    const std::vector<unsigned int> sent_slaves_p = sent_slave_indices[p];
-    dolfin_assert(master_entity_index_p.size() == sent_slaves_p.size());
+    const std::vector<unsigned int>& master_entity_p = master_entity_recv[p];
+    const std::vector<unsigned int>& sent_slaves_p = sent_slave_indices[p];
+    dolfin_assert(master_entity_p.size() == 2*sent_slaves_p.size());
 
-    for (std::size_t i = 0; i < master_entity_index_p.size(); ++i)
+    for (std::size_t i = 0; i < sent_slaves_p.size(); ++i)
     {
-      if (master_entity_index_p[i] < std::numeric_limits<unsigned int>::max())
+      if (master_entity_p[2*i] != not_found)
       {
-        ++num_local_slave_entities;
         slave_to_master_entity.insert(std::make_pair(sent_slaves_p[i],
-                                      std::make_pair(p, master_entity_index_p[i])));
+                                      std::make_pair(master_entity_p[2*i],
+                                                     master_entity_p[2*i + 1])));
       }
     }
   }
@@ -275,6 +405,50 @@ std::map<unsigned int, std::pair<unsigned int, unsigned int>>
   return slave_to_master_entity;
 }
 //-----------------------------------------------------------------------------
+std::shared_ptr<const std::map<unsigned int,
+                               std::pair<unsigned int, unsigned int>>>
+PeriodicBoundaryComputation::cached_periodic_pairs(
+  const Mesh& mesh,
+  std::shared_ptr<const SubDomain> sub_domain,
+  const std::size_t dim)
+{
+  dolfin_assert(sub_domain);
+
+  // Drop cached pairs for sub domains that have been destroyed
+  std::vector<PeriodicPairs>& cache = periodic_pairs_cache();
+  cache.erase(std::remove_if(cache.begin(), cache.end(),
+                             [](const PeriodicPairs& c)
+                             { return c.sub_domain.expired(); }),
+              cache.end());
+
+  // Look for cached pairs for this sub domain and dimension on an
+  // identical mesh (the hash is computed collectively, so all
+  // processes agree on whether the pairs are recomputed)
+  const std::size_t mesh_hash = mesh.hash();
+  for (auto c = cache.begin(); c != cache.end(); ++c)
+  {
+    if (!c->sub_domain.owner_before(sub_domain)
+        && !sub_domain.owner_before(c->sub_domain)
+        && c->mesh_hash == mesh_hash && c->dim == dim)
+    {
+      return c->pairs;
+    }
+  }
+
+  // Compute and cache pairs
+  PeriodicPairs c;
+  c.sub_domain = sub_domain;
+  c.mesh_hash = mesh_hash;
+  c.dim = dim;
+  c.pairs = std::make_shared<const std::map<unsigned int,
+    std::pair<unsigned int, unsigned int>>>(compute_periodic_pairs(mesh,
+                                                                  *sub_domain,
+                                                                  dim));
+  cache.push_back(c);
+
+  return c.pairs;
+}
+//-----------------------------------------------------------------------------
 MeshFunction<std::size_t>
 PeriodicBoundaryComputation::masters_slaves(std::shared_ptr<const Mesh> mesh,
                                             const SubDomain& sub_domain,
@@ -359,25 +533,3 @@ PeriodicBoundaryComputation::masters_slaves(std::shared_ptr<const Mesh> mesh,
   return mf;
 }
 //-----------------------------------------------------------------------------
-bool
-PeriodicBoundaryComputation::in_bounding_box(const std::vector<double>& point,
-                                       const std::vector<double>& bounding_box,
-                                       const double tol)
-{
-  // Return false if bounding box is empty
-  if (bounding_box.empty())
-    return false;
-
-  const std::size_t gdim = point.size();
-  dolfin_assert(bounding_box.size() == 2*gdim);
-  for (std::size_t i = 0; i < gdim; ++i)
-  {
-    if (!(point[i] >= (bounding_box[i] - tol)
-          && point[i] <= (bounding_box[gdim + i] + tol)))
-    {
-      return false;
-    }
-  }
-  return true;
-}
-//-----------------------------------------------------------------------------
@@ -16,12 +16,13 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2012-01-10
-// Last changed:
+// Last changed: 2015-06-12
 
 #ifndef __PERIODIC_BOUNDARY_COMPUTATION_H
 #define __PERIODIC_BOUNDARY_COMPUTATION_H
 
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <dolfin/common/constants.h>
@@ -43,10 +44,27 @@ namespace dolfin
     /// on this process (local index) to its master entity (owning
     /// process, local index on owner). If a master entity is shared
     /// by processes, only one of the owning processes is returned.
+    ///
+    /// Slave (mapped) and master midpoints are matched by spatial
+    /// hashing with tolerance sub_domain.map_tolerance: each process
+    /// owns a part of a uniform grid and receives the masters and
+    /// slaves in its grid cells.
     static std::map<unsigned int, std::pair<unsigned int, unsigned int> >
       compute_periodic_pairs(const Mesh& mesh, const SubDomain& sub_domain,
                              const std::size_t dim);
 
+    /// Same as compute_periodic_pairs, but the pairs are cached and
+    /// returned by later calls for the same sub domain object and
+    /// dimension on an identical mesh (same Mesh::hash). The cached
+    /// pairs are released when the sub domain is destroyed. This
+    /// function must be called collectively.
+    static std::shared_ptr<const std::map<unsigned int,
+                                          std::pair<unsigned int,
+                                                    unsigned int>>>
+      cached_periodic_pairs(const Mesh& mesh,
+                            std::shared_ptr<const SubDomain> sub_domain,
+                            const std::size_t dim);
+
     /// This function returns a MeshFunction which marks mesh entities
     /// of dimension dim according to:
     ///
@@ -60,13 +78,6 @@ namespace dolfin
       masters_slaves(std::shared_ptr<const Mesh> mesh,
                      const SubDomain& sub_domain, const std::size_t dim);
 
-  private:
-
-    // Return true is point lies within bounding box
-    static bool in_bounding_box(const std::vector<double>& point,
-                                const std::vector<double>& bounding_box,
-                                const double tol);
-
   };
 
 }
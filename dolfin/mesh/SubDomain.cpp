@@ -18,8 +18,10 @@
 // Modified by Niclas Jansson 2009.
 //
 // First added:  2007-04-24
-// Last changed: 2011-08-31
+// Last changed: 2015-06-12
 
+#include <utility>
+#include <vector>
 #include <dolfin/common/Array.h>
 #include <dolfin/common/RangedIndexSet.h>
 #include <dolfin/log/log.h>
@@ -35,6 +37,33 @@
 
 using namespace dolfin;
 
+namespace
+{
+  // Set value for list of entities in MeshFunction
+  template<typename T>
+  void set_entity_values(MeshFunction<T>& sub_domains,
+                         const std::vector<std::size_t>& entities,
+                         T sub_domain)
+  {
+    for (auto e : entities)
+      sub_domains[e] = sub_domain;
+  }
+
+  // Set value for list of entities in MeshValueCollection, inserting
+  // all values in one operation
+  template<typename T>
+  void set_entity_values(MeshValueCollection<T>& sub_domains,
+                         const std::vector<std::size_t>& entities,
+                         T sub_domain)
+  {
+    std::vector<std::pair<std::size_t, T>> values;
+    values.reserve(entities.size());
+    for (auto e : entities)
+      values.push_back(std::make_pair(e, sub_domain));
+    sub_domains.set_values(values);
+  }
+}
+
 //-----------------------------------------------------------------------------
 SubDomain::SubDomain(const double map_tol) : map_tolerance(map_tol),
                                              _geometric_dimension(0)
@@ -192,6 +221,9 @@ void SubDomain::apply_markers(S& sub_domains,
   // Always false when not marking facets
   bool on_boundary = false;
 
+  // Entities with all vertices inside
+  std::vector<std::size_t> marked_entities;
+
   // Compute sub domain markers
   Progress p("Computing sub domain markers", mesh.num_entities(dim));
   for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
@@ -237,21 +269,25 @@ void SubDomain::apply_markers(S& sub_domains,
 
     // Mark entity with all vertices inside
     if (all_points_inside)
-      sub_domains.set_value(entity->index(), sub_domain);
+      marked_entities.push_back(entity->index());
 
     p++;
   }
+
+  // Set markers
+  set_entity_values(sub_domains, marked_entities, sub_domain);
 }
 //-----------------------------------------------------------------------------
 template<typename T>
-void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
+void SubDomain::apply_markers(boost::container::flat_map<std::size_t,
+                                                         std::size_t>& sub_domains,
                               std::size_t dim,
                               T sub_domain,
                               const Mesh& mesh,
                               bool check_midpoint) const
 {
   // FIXME: This function can probably be folded into the above
-  //        function operator[] in std::map and MeshFunction.
+  //        function.
 
   log(TRACE, "Computing sub domain markers for sub domain %d.", sub_domain);
 
@@ -276,6 +312,9 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
   // Always false when not marking facets
   bool on_boundary = false;
 
+  // Entities with all vertices inside
+  std::vector<std::size_t> marked_entities;
+
   // Compute sub domain markers
   Progress p("Computing sub domain markers", mesh.num_entities(dim));
   for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
@@ -321,9 +360,27 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
 
     // Mark entity with all vertices inside
     if (all_points_inside)
-      sub_domains[entity->index()] =  sub_domain;
+      marked_entities.push_back(entity->index());
 
     p++;
   }
+
+  // Merge new markers (sorted by entity index) with existing markers,
+  // overwriting existing markers for marked entities
+  std::vector<std::pair<std::size_t, std::size_t>> markers;
+  markers.reserve(sub_domains.size() + marked_entities.size());
+  auto existing = sub_domains.begin();
+  for (auto e : marked_entities)
+  {
+    for (; existing != sub_domains.end() && existing->first < e; ++existing)
+      markers.push_back(*existing);
+    if (existing != sub_domains.end() && existing->first == e)
+      ++existing;
+    markers.push_back(std::make_pair(e, (std::size_t) sub_domain));
+  }
+  markers.insert(markers.end(), existing, sub_domains.end());
+  sub_domains
+    = boost::container::flat_map<std::size_t, std::size_t>(
+      boost::container::ordered_unique_range, markers.begin(), markers.end());
 }
 //-----------------------------------------------------------------------------
@@ -16,13 +16,13 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2007-04-10
-// Last changed: 2013-04-12
+// Last changed: 2015-06-12
 
 #ifndef __SUB_DOMAIN_H
 #define __SUB_DOMAIN_H
 
 #include <cstddef>
-#include <map>
+#include <boost/container/flat_map.hpp>
 #include <dolfin/common/constants.h>
 
 namespace dolfin
@@ -267,7 +267,8 @@ namespace dolfin
                        bool check_midpoint) const;
 
     template<typename T>
-      void apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
+      void apply_markers(boost::container::flat_map<std::size_t,
+                                                    std::size_t>& sub_domains,
                          std::size_t dim,
                          T sub_domain,
                          const Mesh& mesh,
@@ -16,17 +16,25 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2009-02-11
-// Last changed: 2014-02-06
+// Last changed: 2015-06-12
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <utility>
 #include <vector>
+#include <boost/container/flat_map.hpp>
 
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Cell.h"
 #include "Mesh.h"
+#include "MeshConnectivity.h"
 #include "MeshEditor.h"
 #include "MeshEntityIterator.h"
 #include "MeshFunction.h"
+#include "MeshGeometry.h"
+#include "MeshTopology.h"
 #include "SubDomain.h"
 #include "SubMesh.h"
 #include "Vertex.h"
@@ -77,14 +85,13 @@ SubMesh::SubMesh(const Mesh& mesh, std::size_t sub_domain)
   }
 
   // Get cell markers
-  const std::map<std::size_t, std::size_t>& cell_markers
+  const boost::container::flat_map<std::size_t, std::size_t>& cell_markers
     = mesh.domains().markers(D);
 
   // Build vector for all cells to hold markers
   std::vector<std::size_t> sub_domains(mesh.num_cells(),
                                 std::numeric_limits<std::size_t>::max());
-  std::map<std::size_t, std::size_t>::const_iterator it;
-  for (it = cell_markers.begin(); it != cell_markers.end(); ++it)
+  for (auto it = cell_markers.begin(); it != cell_markers.end(); ++it)
     sub_domains[it->first] = it->second;
 
   // Create sub mesh
@@ -100,129 +107,103 @@ void SubMesh::init(const Mesh& mesh,
                    const std::vector<std::size_t>& sub_domains,
                    std::size_t sub_domain)
 {
+  if (MPI::size(mesh.mpi_comm()) > 1)
+    error("SubMesh::init not working in parallel");
+
   // Open mesh for editing
   MeshEditor editor;
   const std::size_t D = mesh.topology().dim();
   editor.open(*this, mesh.type().cell_type(), D,
               mesh.geometry().dim());
 
-  // Build set of cells that are in sub-mesh
-  std::vector<bool> parent_cell_in_subdomain(mesh.num_cells(), false);
-  std::set<std::size_t> submesh_cells;
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  // Build list of parent cells that are in sub-mesh (submesh cell ->
+  // parent cell)
+  std::vector<std::size_t> submesh_cell_parent_indices;
+  for (std::size_t c = 0; c < mesh.num_cells(); c++)
   {
-    if (sub_domains[cell->index()] == sub_domain)
-    {
-      parent_cell_in_subdomain[cell->index()] = true;
-      submesh_cells.insert(cell->index());
-    }
+    if (sub_domains[c] == sub_domain)
+      submesh_cell_parent_indices.push_back(c);
   }
-
-  // Map from parent vertex index to submesh vertex index
-  std::map<std::size_t, std::size_t> parent_to_submesh_vertex_indices;
-
-  // Map from submesh cell to parent cell
-  std::vector<std::size_t> submesh_cell_parent_indices;
-  submesh_cell_parent_indices.reserve(submesh_cells.size());
+  const std::int64_t num_submesh_cells = submesh_cell_parent_indices.size();
 
   // Vector from parent cell index to submesh cell index
   std::vector<std::size_t> parent_to_submesh_cell_indices(mesh.num_cells(), 0);
-
-  // Add sub-mesh cells
-  editor.init_cells_global(submesh_cells.size(), submesh_cells.size());
-  std::size_t current_cell = 0;
-  std::size_t current_vertex = 0;
-  for (std::set<std::size_t>::iterator cell_it = submesh_cells.begin();
-       cell_it != submesh_cells.end(); ++cell_it)
+  for (std::int64_t c = 0; c < num_submesh_cells; c++)
+    parent_to_submesh_cell_indices[submesh_cell_parent_indices[c]] = c;
+
+  // Number submesh vertices in the order they are first seen from the
+  // submesh cells. The flat map from parent vertex index to submesh
+  // vertex index holds -1 for vertices not in the submesh.
+  const std::size_t num_cell_vertices = mesh.type().num_vertices(D);
+  const std::vector<unsigned int>& parent_cells = mesh.cells();
+  std::vector<int> parent_to_submesh_vertex_indices(mesh.num_vertices(), -1);
+  std::vector<std::size_t> parent_vertex_indices;
+  for (std::int64_t c = 0; c < num_submesh_cells; c++)
   {
-    // Data structure to hold new vertex indices for cell
-    std::vector<std::size_t> cell_vertices;
-
-    // Create cell
-    Cell cell(mesh, *cell_it);
-
-    // Iterate over cell vertices
-    for (VertexIterator vertex(cell); !vertex.end(); ++vertex)
+    const unsigned int* vertices
+      = &parent_cells[submesh_cell_parent_indices[c]*num_cell_vertices];
+    for (std::size_t i = 0; i < num_cell_vertices; i++)
     {
-      const std::size_t parent_vertex_index = vertex->index();
-
-      // Look for parent vertex in map
-      std::map<std::size_t, std::size_t>::iterator vertex_it
-        = parent_to_submesh_vertex_indices.find(parent_vertex_index);
-
-      // If vertex has been inserted, get new index, otherwise
-      // increment and insert
-      std::size_t submesh_vertex_index = 0;
-      if (vertex_it != parent_to_submesh_vertex_indices.end())
-        submesh_vertex_index = vertex_it->second;
-      else
+      if (parent_to_submesh_vertex_indices[vertices[i]] < 0)
       {
-        submesh_vertex_index = current_vertex++;
-        parent_to_submesh_vertex_indices[parent_vertex_index]
-          = submesh_vertex_index;
+        parent_to_submesh_vertex_indices[vertices[i]]
+          = parent_vertex_indices.size();
+        parent_vertex_indices.push_back(vertices[i]);
       }
-
-      // Add vertex to list of cell vertices (new indexing)
-      cell_vertices.push_back(submesh_vertex_index);
     }
-
-    // Add parent cell index to list
-    submesh_cell_parent_indices.push_back(cell.index());
-
-    // Store parent cell -> submesh cell indices
-    parent_to_submesh_cell_indices[cell.index()] = current_cell;
-
-    // Add cell to mesh
-    editor.add_cell(current_cell++, cell_vertices);
   }
-
-  // Vector to hold submesh vertex -> parent vertex
-  std::vector<std::size_t> parent_vertex_indices;
-  parent_vertex_indices.resize(parent_to_submesh_vertex_indices.size());
+  const std::int64_t num_submesh_vertices = parent_vertex_indices.size();
 
   // Initialise mesh editor
-  editor.init_vertices_global(parent_to_submesh_vertex_indices.size(),
-                              parent_to_submesh_vertex_indices.size());
-
-  // Add vertices
-  for (std::map<std::size_t, std::size_t>::iterator it
-         = parent_to_submesh_vertex_indices.begin();
-       it != parent_to_submesh_vertex_indices.end(); ++it)
+  editor.init_vertices_global(num_submesh_vertices, num_submesh_vertices);
+  editor.init_cells_global(num_submesh_cells, num_submesh_cells);
+
+  // Fill vertex coordinates and cells directly, bypassing the
+  // (sequential) MeshEditor insertion
+  // FIXME: Get global vertex index
+  const std::size_t gdim = mesh.geometry().dim();
+  MeshGeometry& geometry = this->geometry();
+  MeshTopology& topology = this->topology();
+  MeshConnectivity& cell_vertices = topology(D, 0);
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) dolfin::parameters["num_threads"], 1);
+  #pragma omp parallel num_threads(num_threads)
+  #endif
   {
-    Vertex vertex(mesh, it->first);
-    if (MPI::size(mesh.mpi_comm()) > 1)
-      error("SubMesh::init not working in parallel");
+    std::vector<double> x(gdim);
+    std::vector<std::size_t> cell(num_cell_vertices);
 
-    // FIXME: Get global vertex index
-    editor.add_vertex(it->second, vertex.point());
-    parent_vertex_indices[it->second] = it->first;
+    #ifdef HAS_OPENMP
+    #pragma omp for
+    #endif
+    for (std::int64_t i = 0; i < num_submesh_vertices; i++)
+    {
+      const double* _x = mesh.geometry().x(parent_vertex_indices[i]);
+      std::copy(_x, _x + gdim, x.begin());
+      geometry.set(i, x);
+      topology.set_global_index(0, i, i);
+    }
+
+    #ifdef HAS_OPENMP
+    #pragma omp for
+    #endif
+    for (std::int64_t c = 0; c < num_submesh_cells; c++)
+    {
+      const unsigned int* vertices
+        = &parent_cells[submesh_cell_parent_indices[c]*num_cell_vertices];
+      for (std::size_t i = 0; i < num_cell_vertices; i++)
+        cell[i] = parent_to_submesh_vertex_indices[vertices[i]];
+      cell_vertices.set(c, cell);
+      topology.set_global_index(D, c, c);
+    }
   }
 
   // Close editor
   editor.close();
 
-  // Build submesh-to-parent map for vertices
-  std::vector<std::size_t>& parent_vertex_indices_mf
-    = data().create_array("parent_vertex_indices", 0);
-  parent_vertex_indices_mf.resize(num_vertices());
-  for (std::map<std::size_t, std::size_t>::iterator it
-         = parent_to_submesh_vertex_indices.begin();
-       it != parent_to_submesh_vertex_indices.end(); ++it)
-  {
-    parent_vertex_indices_mf[it->second] = it->first;
-  }
-
-  // Build submesh-to-parent map for cells
-  std::vector<std::size_t>& parent_cell_indices
-    = data().create_array("parent_cell_indices", D);
-  parent_cell_indices.resize(num_cells());
-  current_cell = 0;
-  for (std::vector<std::size_t>::iterator it
-         = submesh_cell_parent_indices.begin();
-       it != submesh_cell_parent_indices.end(); ++it)
-  {
-    parent_cell_indices[current_cell++] = *it;
-  }
+  // Store submesh-to-parent maps for vertices and cells
+  data().create_array("parent_vertex_indices", 0) = parent_vertex_indices;
+  data().create_array("parent_cell_indices", D) = submesh_cell_parent_indices;
 
   // Initialise present MeshDomain
   const MeshDomains& parent_domains = mesh.domains();
@@ -253,17 +234,15 @@ void SubMesh::init(const Mesh& mesh,
       entity_map.insert(std::make_pair(vertex_list, e->index()));
     }
 
-    // Get submesh marker map
-    std::map<std::size_t, std::size_t>& submesh_markers
-      = this->domains().markers(dim_t);
+    // Submesh markers, inserted in one operation
+    std::vector<std::pair<std::size_t, std::size_t>> submesh_markers;
 
     // Get values map from parent MeshValueCollection
-    const std::map<std::size_t, std::size_t>& parent_markers
-      = parent_domains.markers(dim_t);
+    const boost::container::flat_map<std::size_t, std::size_t>&
+      parent_markers = parent_domains.markers(dim_t);
 
     // Iterate over all parents marker values
-    std::map<std::size_t, std::size_t>::const_iterator itt;
-    for (itt = parent_markers.begin(); itt != parent_markers.end(); itt++)
+    for (auto itt = parent_markers.begin(); itt != parent_markers.end(); itt++)
     {
       // Create parent entity
       const MeshEntity parent_entity(mesh, dim_t, itt->first);
@@ -296,7 +275,8 @@ void SubMesh::init(const Mesh& mesh,
           // Get submesh cell index
           const std::size_t submesh_cell_index
             = parent_to_submesh_cell_indices[parent_cell_index];
-	  submesh_markers[submesh_cell_index] = itt->second;
+	  submesh_markers.push_back(std::make_pair(submesh_cell_index,
+                                                   itt->second));
         }
 	else
 	{
@@ -310,11 +290,51 @@ void SubMesh::init(const Mesh& mesh,
             submesh_it = entity_map.find(parent_vertex_list);
           dolfin_assert(submesh_it != entity_map.end());
 
-          submesh_markers[submesh_it->second] = itt->second;
+          submesh_markers.push_back(std::make_pair(submesh_it->second,
+                                                   itt->second));
 	}
       }
     }
+
+    // Set submesh markers
+    this->domains().set_markers(submesh_markers, dim_t);
   }
 
 }
 //-----------------------------------------------------------------------------
+void SubMesh::update_coordinates(const Mesh& mesh)
+{
+  const std::vector<std::size_t>& parent_vertex_indices
+    = data().array("parent_vertex_indices", 0);
+  const std::int64_t num_vertices = this->num_vertices();
+  const std::size_t gdim = geometry().dim();
+
+  // Check that mesh is compatible with vertex map
+  bool compatible = (mesh.geometry().dim() == gdim
+                     && parent_vertex_indices.size()
+                     == (std::size_t) num_vertices);
+  if (compatible && num_vertices > 0)
+  {
+    compatible = *std::max_element(parent_vertex_indices.begin(),
+                                   parent_vertex_indices.end())
+      < mesh.num_vertices();
+  }
+  if (!compatible)
+  {
+    dolfin_error("SubMesh.cpp",
+                 "update coordinates of submesh",
+                 "Mesh does not match the mesh the submesh was created from");
+  }
+
+  // Copy coordinates of parent vertices
+  #ifdef HAS_OPENMP
+  const int num_threads = std::max((int) dolfin::parameters["num_threads"], 1);
+  #pragma omp parallel for num_threads(num_threads)
+  #endif
+  for (std::int64_t i = 0; i < num_vertices; i++)
+  {
+    const double* x = mesh.geometry().x(parent_vertex_indices[i]);
+    std::copy(x, x + gdim, geometry().x(i));
+  }
+}
+//-----------------------------------------------------------------------------
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2009-02-11
-// Last changed: 2013-02-11
+// Last changed: 2015-06-12
 
 #ifndef __SUB_MESH_H
 #define __SUB_MESH_H
@@ -54,6 +54,16 @@ namespace dolfin
     /// Destructor
     ~SubMesh();
 
+    /// Update the vertex coordinates of the submesh from the (moved)
+    /// mesh it was created from. This may be used instead of creating
+    /// a new submesh when only the coordinates of the mesh have
+    /// changed, not its topology.
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh from which the submesh was created.
+    void update_coordinates(const Mesh& mesh);
+
   private:
 
     /// Create sub mesh
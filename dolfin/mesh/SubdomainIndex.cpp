@@ -0,0 +1,99 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#include <algorithm>
+#include <numeric>
+#include <boost/functional/hash.hpp>
+#include "MeshFunction.h"
+#include "SubdomainIndex.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+SubdomainIndex::SubdomainIndex() : _offsets(1, 0), _id(0), _state(0),
+                                   _size(0), _hash(0)
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+SubdomainIndex::SubdomainIndex(const MeshFunction<std::size_t>& markers)
+{
+  build(markers);
+}
+//-----------------------------------------------------------------------------
+SubdomainIndex::~SubdomainIndex()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+bool SubdomainIndex::update(const MeshFunction<std::size_t>& markers)
+{
+  // Skip hashing if the markers are known to be replaced or modified
+  if (markers.id() == _id && markers.state() == _state
+      && markers.size() == _size && compute_hash(markers) == _hash)
+  {
+    return false;
+  }
+
+  build(markers);
+  return true;
+}
+//-----------------------------------------------------------------------------
+std::size_t
+SubdomainIndex::compute_hash(const MeshFunction<std::size_t>& markers)
+{
+  return boost::hash_range(markers.values(),
+                           markers.values() + markers.size());
+}
+//-----------------------------------------------------------------------------
+void SubdomainIndex::build(const MeshFunction<std::size_t>& markers)
+{
+  _id = markers.id();
+  _state = markers.state();
+  _size = markers.size();
+  _hash = compute_hash(markers);
+  const std::size_t size = _size;
+  const std::size_t* values = markers.values();
+
+  // Find distinct marker values
+  _values.assign(values, values + size);
+  std::sort(_values.begin(), _values.end());
+  _values.erase(std::unique(_values.begin(), _values.end()), _values.end());
+
+  // Map each entity to position of its marker value and count
+  // entities per value
+  std::vector<unsigned int> position(size);
+  _offsets.assign(_values.size() + 1, 0);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    position[i] = std::lower_bound(_values.begin(), _values.end(), values[i])
+      - _values.begin();
+    ++_offsets[position[i] + 1];
+  }
+  std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+
+  // Fill entities grouped by marker value (in increasing order within
+  // each group)
+  std::vector<std::size_t> next(_offsets.begin(), _offsets.end() - 1);
+  _entities.resize(size);
+  for (std::size_t i = 0; i < size; ++i)
+    _entities[next[position[i]]++] = i;
+}
+//-----------------------------------------------------------------------------
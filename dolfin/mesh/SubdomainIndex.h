@@ -0,0 +1,113 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-12
+// Last changed:
+
+#ifndef __SUBDOMAIN_INDEX_H
+#define __SUBDOMAIN_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include <dolfin/common/ArrayView.h>
+
+namespace dolfin
+{
+
+  template <typename T> class MeshFunction;
+
+  /// This class stores the entities of a mesh function of subdomain
+  /// markers grouped by marker value (in compressed row format),
+  /// such that the entities of a given subdomain can be visited
+  /// without testing the marker of every entity of the mesh.
+  ///
+  /// The index records the id, modification counter (see
+  /// MeshFunction::state) and a hash of the values of the markers it
+  /// was built from. update() rebuilds the index if the markers have
+  /// been replaced or their values have changed. The values are
+  /// hashed only if the modification counter is unchanged, since
+  /// writes through an array view of the values are not counted.
+
+  class SubdomainIndex
+  {
+  public:
+
+    /// Create empty index
+    SubdomainIndex();
+
+    /// Create index for subdomain markers
+    ///
+    /// *Arguments*
+    ///     markers (_MeshFunction_ <std::size_t>)
+    ///         The subdomain markers.
+    explicit SubdomainIndex(const MeshFunction<std::size_t>& markers);
+
+    /// Destructor
+    ~SubdomainIndex();
+
+    /// Rebuild index if markers are not the (unmodified) markers the
+    /// index was built from
+    ///
+    /// *Arguments*
+    ///     markers (_MeshFunction_ <std::size_t>)
+    ///         The subdomain markers.
+    ///
+    /// *Returns*
+    ///     bool
+    ///         True if the index has been rebuilt.
+    bool update(const MeshFunction<std::size_t>& markers);
+
+    /// Return number of distinct marker values
+    std::size_t num_values() const
+    { return _values.size(); }
+
+    /// Return marker values (sorted)
+    const std::vector<std::size_t>& values() const
+    { return _values; }
+
+    /// Return entities marked with i-th marker value (sorted)
+    ArrayView<const unsigned int> entities(std::size_t i) const
+    {
+      return ArrayView<const unsigned int>(_offsets[i + 1] - _offsets[i],
+                                           _entities.data() + _offsets[i]);
+    }
+
+  private:
+
+    // Compute hash of marker values
+    static std::size_t compute_hash(const MeshFunction<std::size_t>& markers);
+
+    // Build index
+    void build(const MeshFunction<std::size_t>& markers);
+
+    // Marker values
+    std::vector<std::size_t> _values;
+
+    // Offsets into _entities for each marker value
+    std::vector<std::size_t> _offsets;
+
+    // Entities grouped by marker value
+    std::vector<unsigned int> _entities;
+
+    // Id, modification counter, size and hash of markers
+    std::size_t _id, _state, _size, _hash;
+
+  };
+
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <dolfin/mesh/LocalMeshValueCollection.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/MeshValueCollection.h>
+#include <dolfin/mesh/CompactMeshFunction.h>
 #include <dolfin/mesh/MeshColoring.h>
 #include <dolfin/mesh/MeshRenumbering.h>
 #include <dolfin/mesh/MeshTransformation.h>
@@ -0,0 +1,287 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-10
+// Last changed:
+
+#include <algorithm>
+#include <Eigen/Dense>
+
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/la/GenericVector.h>
+#include <dolfin/log/log.h>
+#include "NonlinearProblem.h"
+#include "FixedPointSolver.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+Parameters FixedPointSolver::default_parameters()
+{
+  Parameters p("fixed_point_solver");
+
+  p.add("maximum_iterations",      100);
+  p.add("relative_tolerance",      1e-9);
+  p.add("absolute_tolerance",      1e-10);
+  p.add("relaxation_parameter",    1.0);
+  p.add("anderson_depth",          5, 0, 1000);
+  p.add("report",                  true);
+  p.add("error_on_nonconvergence", true);
+
+  return p;
+}
+//-----------------------------------------------------------------------------
+FixedPointSolver::FixedPointSolver()
+  : Variable("Fixed-point solver", "unamed"), _iteration(0), _residual(0.0),
+    _residual0(0.0)
+{
+  // Set default parameters
+  parameters = default_parameters();
+}
+//-----------------------------------------------------------------------------
+FixedPointSolver::~FixedPointSolver()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::pair<std::size_t, bool>
+FixedPointSolver::solve(NonlinearProblem& nonlinear_problem, GenericVector& x)
+{
+  Timer timer("Fixed-point solver");
+
+  // Extract parameters
+  const std::size_t maxiter = parameters["maximum_iterations"];
+  const double rtol = parameters["relative_tolerance"];
+  const double atol = parameters["absolute_tolerance"];
+  const double beta = parameters["relaxation_parameter"];
+  const std::size_t depth = parameters["anderson_depth"];
+  const bool report = parameters["report"];
+  const MPI_Comm mpi_comm = x.mpi_comm();
+
+  // Create residual vector with layout of x
+  if (!_b || _b->size() != x.size())
+    _b = x.copy();
+
+  // Local parts of current and previous iterates and residuals
+  const std::size_t n = x.local_size();
+  std::vector<double> x_k, f_k, x_prev, f_prev;
+  std::vector<double> gamma;
+
+  // Allocate history (up to depth columns, oldest first)
+  _dx_history.resize(n*depth);
+  _df_history.resize(n*depth);
+  std::size_t num_history = 0;
+
+  bool converged = false;
+  _iteration = 0;
+  while (true)
+  {
+    // Compute residual F(x)
+    nonlinear_problem.F(*_b, x);
+    _residual = _b->norm("l2");
+    if (_iteration == 0)
+      _residual0 = _residual;
+
+    // Check for convergence
+    const double relative_residual = this->relative_residual();
+    if (report && dolfin::MPI::rank(mpi_comm) == 0)
+    {
+      info("Fixed-point iteration %d: r (abs) = %.3e (tol = %.3e) r (rel) = %.3e (tol = %.3e)",
+           _iteration, _residual, atol, relative_residual, rtol);
+    }
+    if (relative_residual < rtol || _residual < atol)
+    {
+      converged = true;
+      break;
+    }
+    if (_iteration >= maxiter)
+      break;
+
+    // Get local parts of iterate and residual
+    x.get_local(x_k);
+    _b->get_local(f_k);
+    dolfin_assert(x_k.size() == n);
+    if (f_k.size() != n)
+    {
+      dolfin_error("FixedPointSolver.cpp",
+                   "solve nonlinear problem by fixed-point iteration",
+                   "Residual vector and solution vector have different local sizes");
+    }
+
+    // Store differences of iterates and residuals in history
+    // (discarding the oldest column if the history is full)
+    if (depth > 0 && _iteration > 0)
+    {
+      if (num_history == depth)
+      {
+        std::copy(_dx_history.begin() + n, _dx_history.end(),
+                  _dx_history.begin());
+        std::copy(_df_history.begin() + n, _df_history.end(),
+                  _df_history.begin());
+        --num_history;
+      }
+      double* dx = _dx_history.data() + num_history*n;
+      double* df = _df_history.data() + num_history*n;
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        dx[i] = x_k[i] - x_prev[i];
+        df[i] = f_k[i] - f_prev[i];
+      }
+      ++num_history;
+    }
+    x_prev = x_k;
+    f_prev = f_k;
+
+    // Compute Anderson mixing coefficients (linearly dependent
+    // columns are removed from the history)
+    num_history = compute_mixing_coefficients(gamma, f_k, num_history,
+                                              mpi_comm);
+
+    // Update x <- x - beta*F - (dX - beta*dF)*gamma
+    Eigen::Map<Eigen::VectorXd> _x(x_k.data(), n);
+    Eigen::Map<const Eigen::VectorXd> _f(f_k.data(), n);
+    _x -= beta*_f;
+    if (num_history > 0)
+    {
+      Eigen::Map<const Eigen::MatrixXd> dX(_dx_history.data(), n, num_history);
+      Eigen::Map<const Eigen::MatrixXd> dF(_df_history.data(), n, num_history);
+      Eigen::Map<const Eigen::VectorXd> _gamma(gamma.data(), num_history);
+      _x -= dX*_gamma - beta*(dF*_gamma);
+    }
+    x.set_local(x_k);
+    x.apply("insert");
+
+    ++_iteration;
+  }
+
+  if (converged)
+  {
+    if (dolfin::MPI::rank(mpi_comm) == 0)
+      info("Fixed-point solver finished in %d iterations.", _iteration);
+  }
+  else
+  {
+    const bool error_on_nonconvergence = parameters["error_on_nonconvergence"];
+    if (error_on_nonconvergence)
+    {
+      dolfin_error("FixedPointSolver.cpp",
+                   "solve nonlinear system with FixedPointSolver",
+                   "Fixed-point solver did not converge");
+    }
+    else
+      warning("Fixed-point solver did not converge.");
+  }
+
+  return std::make_pair(_iteration, converged);
+}
+//-----------------------------------------------------------------------------
+std::size_t FixedPointSolver::iteration() const
+{
+  return _iteration;
+}
+//-----------------------------------------------------------------------------
+double FixedPointSolver::residual() const
+{
+  return _residual;
+}
+//-----------------------------------------------------------------------------
+double FixedPointSolver::relative_residual() const
+{
+  // Zero initial residual (initial guess is the solution)
+  if (_residual0 == 0.0)
+    return 0.0;
+  return _residual/_residual0;
+}
+//-----------------------------------------------------------------------------
+std::size_t
+FixedPointSolver::compute_mixing_coefficients(std::vector<double>& gamma,
+                                              const std::vector<double>& f,
+                                              std::size_t m,
+                                              MPI_Comm mpi_comm)
+{
+  gamma.resize(m);
+  if (m == 0)
+    return 0;
+
+  // Compute local QR factorisation dF = Q R and Q^T f, and gather
+  // the (small) factors R and Q^T f from all processes (padded with
+  // zeros to m rows)
+  const std::size_t n = f.size();
+  const std::size_t k = std::min(n, m);
+  std::vector<double> local_factors(m*m + m, 0.0);
+  Eigen::Map<Eigen::MatrixXd> R(local_factors.data(), m, m);
+  Eigen::Map<Eigen::VectorXd> qtf(local_factors.data() + m*m, m);
+  if (n > 0)
+  {
+    Eigen::Map<const Eigen::MatrixXd> dF(_df_history.data(), n, m);
+    Eigen::Map<const Eigen::VectorXd> _f(f.data(), n);
+    const Eigen::HouseholderQR<Eigen::MatrixXd> local_qr(dF);
+    R.topRows(k)
+      = local_qr.matrixQR().topRows(k).triangularView<Eigen::Upper>();
+    const Eigen::VectorXd _qtf = local_qr.householderQ().adjoint()*_f;
+    qtf.head(k) = _qtf.head(k);
+  }
+  std::vector<double> factors;
+  MPI::all_gather(mpi_comm, local_factors, factors);
+
+  // Solve least-squares problem min |R gamma - Q^T f| for the
+  // stacked factors, which is equivalent to min |dF gamma - f|
+  const std::size_t num_blocks = factors.size()/(m*m + m);
+  Eigen::MatrixXd R_all(num_blocks*m, m);
+  Eigen::VectorXd qtf_all(num_blocks*m);
+  for (std::size_t p = 0; p < num_blocks; ++p)
+  {
+    const double* block = factors.data() + p*(m*m + m);
+    R_all.middleRows(p*m, m) = Eigen::Map<const Eigen::MatrixXd>(block, m, m);
+    qtf_all.segment(p*m, m)
+      = Eigen::Map<const Eigen::VectorXd>(block + m*m, m);
+  }
+
+  // Drop oldest columns until the remaining columns are linearly
+  // independent (columns with relative pivot below the threshold
+  // are treated as linearly dependent)
+  std::size_t num_dropped = 0;
+  Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr;
+  qr.setThreshold(1.0e-10);
+  while (num_dropped < m)
+  {
+    qr.compute(R_all.rightCols(m - num_dropped));
+    if (static_cast<std::size_t>(qr.rank()) == m - num_dropped)
+      break;
+    ++num_dropped;
+  }
+  const std::size_t rank = m - num_dropped;
+
+  if (num_dropped > 0)
+  {
+    std::copy(_dx_history.begin() + num_dropped*n,
+              _dx_history.begin() + m*n, _dx_history.begin());
+    std::copy(_df_history.begin() + num_dropped*n,
+              _df_history.begin() + m*n, _df_history.begin());
+  }
+
+  gamma.resize(rank);
+  if (rank > 0)
+  {
+    Eigen::Map<Eigen::VectorXd> _gamma(gamma.data(), rank);
+    _gamma = qr.solve(qtf_all);
+  }
+
+  return rank;
+}
+//-----------------------------------------------------------------------------
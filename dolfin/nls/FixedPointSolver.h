@@ -0,0 +1,124 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-10
+// Last changed:
+
+#ifndef __FIXED_POINT_SOLVER_H
+#define __FIXED_POINT_SOLVER_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Variable.h>
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class GenericVector;
+  class NonlinearProblem;
+
+  /// This class defines a fixed-point (Picard) solver with Anderson
+  /// acceleration for nonlinear systems of equations of the form
+  /// :math:`F(x) = 0`, where the residual is written as
+  /// :math:`F(x) = x - G(x)` for a fixed-point map :math:`G`.
+  ///
+  /// The iteration is
+  ///
+  /// .. math::
+  ///
+  ///     x_{k+1} = x_k - \beta F(x_k) - (\Delta X_k - \beta \Delta F_k) \gamma_k
+  ///
+  /// where the columns of :math:`\Delta X_k` and :math:`\Delta F_k`
+  /// are the differences of the last m iterates and residuals, and
+  /// :math:`\gamma_k` minimises :math:`\|F(x_k) - \Delta F_k
+  /// \gamma\|`. With m = 0 (parameter "anderson_depth") this is the
+  /// damped fixed-point iteration.
+  ///
+  /// Only the residual F of the NonlinearProblem is evaluated; the
+  /// Jacobian J is never requested.
+
+  class FixedPointSolver : public Variable
+  {
+  public:
+
+    /// Create fixed-point solver
+    FixedPointSolver();
+
+    /// Destructor
+    virtual ~FixedPointSolver();
+
+    /// Solve nonlinear problem :math:`F(x) = 0` by accelerated
+    /// fixed-point iteration.
+    ///
+    /// *Arguments*
+    ///     nonlinear_problem (_NonlinearProblem_)
+    ///         The nonlinear problem.
+    ///     x (_GenericVector_)
+    ///         The vector (initial guess on input).
+    ///
+    /// *Returns*
+    ///     std::pair<std::size_t, bool>
+    ///         Pair of number of iterations, and whether iteration
+    ///         converged)
+    std::pair<std::size_t, bool> solve(NonlinearProblem& nonlinear_problem,
+                                       GenericVector& x);
+
+    /// Return iteration number
+    std::size_t iteration() const;
+
+    /// Return current residual
+    double residual() const;
+
+    /// Return current relative residual
+    double relative_residual() const;
+
+    /// Default parameter values
+    static Parameters default_parameters();
+
+  private:
+
+    // Compute Anderson mixing coefficients gamma from history of
+    // residual differences (local parts, m columns) and residual f
+    // by QR factorisation. Linearly dependent columns are removed
+    // from the history, and the number of remaining columns is
+    // returned.
+    std::size_t compute_mixing_coefficients(std::vector<double>& gamma,
+                                            const std::vector<double>& f,
+                                            std::size_t m,
+                                            MPI_Comm mpi_comm);
+
+    // Current number of iterations
+    std::size_t _iteration;
+
+    // Most recent residual and initial residual
+    double _residual, _residual0;
+
+    // Residual vector
+    std::shared_ptr<GenericVector> _b;
+
+    // History of differences of iterates and residuals (local parts,
+    // stored contiguously column by column)
+    std::vector<double> _dx_history, _df_history;
+
+  };
+
+}
+
+#endif
@@ -20,8 +20,10 @@
 // Modified by Johan Hake 2010
 //
 // First added:  2005-10-23
-// Last changed: 2014-05-27
+// Last changed: 2015-06-08
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <dolfin/common/constants.h>
 #include <dolfin/common/NoDeleter.h>
@@ -54,7 +56,44 @@ Parameters NewtonSolver::default_parameters()
   p.add("report",                  true);
   p.add("error_on_nonconvergence", true);
 
-  //p.add("reuse_preconditioner", false);
+  // Assemble residual and Jacobian together when both are needed
+  // (see NonlinearProblem::F_and_J)
+  p.add("fused_assembly", false);
+
+  // Rebuild Jacobian every jacobian_lag iterations, or when the
+  // residual is reduced by less than jacobian_lag_rate
+  p.add("jacobian_lag", 1, 1, 1000000);
+  p.add("jacobian_lag_rate", 0.5);
+
+  // Rebuild preconditioner every preconditioner_lag Jacobians
+  p.add("preconditioner_lag", 1, 1, 1000000);
+
+  // Relative tolerance for Krylov solver: fixed (from krylov_solver
+  // parameters) or Eisenstat-Walker forcing terms (choice 2)
+  p.add("krylov_forcing_term", "fixed", {"fixed", "eisenstat_walker"});
+  Parameters p_ew("eisenstat_walker");
+  p_ew.add("eta_0", 0.3);
+  p_ew.add("eta_max", 0.9);
+  p_ew.add("gamma", 0.9);
+  p_ew.add("alpha", 2.0);
+  p.add(p_ew);
+
+  // Globalization: damped update with relaxation_parameter ("none"),
+  // line search along the Newton direction or dogleg trust region.
+  // Only the residual F is evaluated at trial points.
+  p.add("globalization", "none",
+        {"none", "backtracking", "critical_point", "trust_region"});
+  Parameters p_ls("line_search");
+  p_ls.add("maximum_iterations", 10);
+  p_ls.add("alpha", 1e-4);
+  p_ls.add("minimum_step", 1e-8);
+  p.add(p_ls);
+  Parameters p_tr("trust_region");
+  p_tr.add("initial_radius", 0.0);
+  p_tr.add("maximum_radius", 1e10);
+  p_tr.add("eta", 1e-4);
+  p_tr.add("maximum_iterations", 10);
+  p.add(p_tr);
 
   p.add(LUSolver::default_parameters());
   p.add(KrylovSolver::default_parameters());
@@ -65,7 +104,9 @@ Parameters NewtonSolver::default_parameters()
 NewtonSolver::NewtonSolver()
   : Variable("Newton solver", "unamed"), _newton_iteration(0), _residual(0.0),
     _residual0(0.0), _matA(new Matrix), _dx(new Vector), _b(new Vector),
-    _mpi_comm(MPI_COMM_WORLD)
+    _trust_radius(0.0), _mpi_comm(MPI_COMM_WORLD),
+    _rtol(parameters, "relative_tolerance"),
+    _atol(parameters, "absolute_tolerance"), _report(parameters, "report")
 {
   // Set default parameters
   parameters = default_parameters();
@@ -76,7 +117,9 @@ NewtonSolver::NewtonSolver(std::shared_ptr<GenericLinearSolver> solver,
   : Variable("Newton solver", "unamed"), _newton_iteration(0), _residual(0.0),
     _residual0(0.0), _solver(solver), _matA(factory.create_matrix()),
     _dx(factory.create_vector()), _b(factory.create_vector()),
-    _mpi_comm(MPI_COMM_WORLD)
+    _trust_radius(0.0), _mpi_comm(MPI_COMM_WORLD),
+    _rtol(parameters, "relative_tolerance"),
+    _atol(parameters, "absolute_tolerance"), _report(parameters, "report")
 {
   // Set default parameters
   parameters = default_parameters();
@@ -102,6 +145,21 @@ NewtonSolver::solve(NonlinearProblem& nonlinear_problem,
   // Extract parameters
   const std::string convergence_criterion = parameters["convergence_criterion"];
   const std::size_t maxiter = parameters["maximum_iterations"];
+  const bool fused_assembly = parameters["fused_assembly"];
+  const std::size_t jacobian_lag = parameters["jacobian_lag"];
+  const double jacobian_lag_rate = parameters["jacobian_lag_rate"];
+  const std::size_t preconditioner_lag = parameters["preconditioner_lag"];
+  const std::string forcing_term = parameters["krylov_forcing_term"];
+  const std::string globalization = parameters["globalization"];
+
+  if (convergence_criterion != "residual"
+      && convergence_criterion != "incremental")
+  {
+    dolfin_error("NewtonSolver.cpp",
+                 "check for convergence",
+                 "The convergence criterion %s is unknown, known criteria are 'residual' or 'incremental'",
+                 convergence_criterion.c_str());
+  }
 
   // Create linear solver if not already created
   const std::string solver_type = parameters["linear_solver"];
@@ -116,31 +174,50 @@ NewtonSolver::solve(NonlinearProblem& nonlinear_problem,
   // Set parameters for linear solver
   _solver->update_parameters(parameters(_solver->parameter_type()));
 
+  // Eisenstat-Walker forcing terms require a Krylov solver
+  bool eisenstat_walker = (forcing_term == "eisenstat_walker");
+  if (eisenstat_walker
+      && !_solver->parameters.has_parameter("relative_tolerance"))
+  {
+    warning("Eisenstat-Walker forcing terms require a Krylov solver. Using fixed tolerance.");
+    eisenstat_walker = false;
+  }
+
+  // Residual norms are needed by Eisenstat-Walker and by rate
+  // controlled Jacobian lagging
+  const bool need_residual_norm = eisenstat_walker || jacobian_lag > 1;
+
   // Reset iteration counts
   std::size_t krylov_iterations = 0;
+  std::size_t num_jacobians = 0;
+  std::size_t jacobian_age = 0;
   _newton_iteration = 0;
+  _trust_radius = 0.0;
 
-  // Compute F(u)
-  nonlinear_problem.F(*_b, x);
-  nonlinear_problem.form(*_matA, *_b, x);
+  // Compute F(u), and J(u) if assembled together with F
+  bool jacobian_current = compute_residual(nonlinear_problem, x,
+                                           fused_assembly);
 
   // Check convergence
   bool newton_converged = false;
   if (convergence_criterion == "residual")
     newton_converged = converged(*_b, nonlinear_problem, 0);
-  else if (convergence_criterion == "incremental")
+  else
   {
     // We need to do at least one Newton step with the ||dx||-stopping
     // criterion.
     newton_converged = false;
   }
-  else
+
+  // Residual norms and forcing term for current and previous iteration
+  double residual_norm = 0.0, residual_norm_prev = 0.0;
+  double eta = 0.0;
+  if (need_residual_norm)
   {
-    dolfin_error("NewtonSolver.cpp",
-                 "check for convergence",
-                 "The convergence criterion %s is unknown, known criteria are 'residual' or 'incremental'",
-                 convergence_criterion.c_str());
+    residual_norm = (convergence_criterion == "residual")
+      ? _residual : _b->norm("l2");
   }
+  const double residual_norm0 = residual_norm;
 
   // Get relaxation parameter
   const double relaxation = parameters["relaxation_parameter"];
@@ -148,11 +225,45 @@ NewtonSolver::solve(NonlinearProblem& nonlinear_problem,
   // Start iterations
   while (!newton_converged && _newton_iteration < maxiter)
   {
-    // Compute Jacobian
-    nonlinear_problem.J(*_matA, x);
+    // Decide whether to rebuild Jacobian or reuse (lag) the old one
+    const bool rebuild_jacobian = _newton_iteration == 0
+      || jacobian_age >= jacobian_lag
+      || (need_residual_norm
+          && residual_norm > jacobian_lag_rate*residual_norm_prev);
+
+    // Compute Jacobian, unless computed together with F
+    if (rebuild_jacobian && !jacobian_current)
+    {
+      nonlinear_problem.J(*_matA, x);
+      jacobian_current = true;
+    }
 
     // Update Jacobian in linear solver
-    _solver->set_operator(_matA);
+    if (jacobian_current)
+    {
+      if (preconditioner_lag > 1)
+      {
+        // Keep a copy of the Jacobian from which the preconditioner
+        // is built, and refresh it every preconditioner_lag Jacobians
+        if (!_matP || num_jacobians % preconditioner_lag == 0)
+          _matP = _matA->copy();
+        _solver->set_operators(_matA, _matP);
+      }
+      else
+        _solver->set_operator(_matA);
+
+      jacobian_age = 0;
+      ++num_jacobians;
+    }
+
+    // Set Krylov solver tolerance from Eisenstat-Walker forcing term
+    if (eisenstat_walker)
+    {
+      eta = forcing_term_eisenstat_walker(residual_norm, residual_norm_prev,
+                                          residual_norm0, eta,
+                                          _newton_iteration);
+      _solver->parameters["relative_tolerance"] = eta;
+    }
 
     // Perform linear solve and update total number of Krylov
     // iterations
@@ -160,38 +271,55 @@ NewtonSolver::solve(NonlinearProblem& nonlinear_problem,
       _dx->zero();
     krylov_iterations += _solver->solve(*_dx, *_b);
 
-    // Update solution
-    if (std::abs(1.0 - relaxation) < DOLFIN_EPS)
-      x -= (*_dx);
-    else
-      x.axpy(-relaxation, *_dx);
-
     // Increment iteration count
     _newton_iteration++;
+    jacobian_age++;
 
-    // FIXME: This step is not needed if residual is based on dx and
-    //        this has converged.
-    // FIXME: But, this function call may update internal variable, etc.
-    // Compute F
-    nonlinear_problem.F(*_b, x);
-    nonlinear_problem.form(*_matA, *_b, x);
+    if (globalization == "none")
+    {
+      // Update solution
+      if (std::abs(1.0 - relaxation) < DOLFIN_EPS)
+        x -= (*_dx);
+      else
+        x.axpy(-relaxation, *_dx);
+
+      // FIXME: This step is not needed if residual is based on dx and
+      //        this has converged.
+      // FIXME: But, this function call may update internal variable, etc.
+      // Compute F, and J if assembled together with F and the
+      // Jacobian will not be lagged
+      jacobian_current = compute_residual(nonlinear_problem, x,
+                                          fused_assembly
+                                          && jacobian_age >= jacobian_lag);
+    }
+    else
+    {
+      // Update solution and F by line search or trust region step
+      if (globalization == "trust_region")
+        trust_region_update(nonlinear_problem, x);
+      else
+        line_search_update(nonlinear_problem, x, globalization);
+      nonlinear_problem.form(*_matA, *_b, x);
+      jacobian_current = false;
+    }
 
     // Test for convergence
     if (convergence_criterion == "residual")
       newton_converged = converged(*_b, nonlinear_problem, _newton_iteration);
-    else if (convergence_criterion == "incremental")
+    else
     {
       // Subtract 1 to make sure that the initial residual0 is
       // properly set.
       newton_converged = converged(*_dx, nonlinear_problem,
                                    _newton_iteration - 1);
     }
-    else
+
+    // Update residual norms
+    if (need_residual_norm)
     {
-      dolfin_error("NewtonSolver.cpp",
-                   "check for convergence",
-                   "The convergence criterion %s is unknown, known criteria are 'residual' or 'incremental'",
-                   convergence_criterion.c_str());
+      residual_norm_prev = residual_norm;
+      residual_norm = (convergence_criterion == "residual")
+        ? _residual : _b->norm("l2");
     }
   }
 
@@ -201,6 +329,8 @@ NewtonSolver::solve(NonlinearProblem& nonlinear_problem,
     {
       info("Newton solver finished in %d iterations and %d linear solver iterations.",
            _newton_iteration, krylov_iterations);
+      if (jacobian_lag > 1 || fused_assembly)
+        info("Newton solver assembled %d Jacobians.", num_jacobians);
     }
   }
   else
@@ -248,13 +378,272 @@ GenericLinearSolver& NewtonSolver::linear_solver() const
   return *_solver;
 }
 //-----------------------------------------------------------------------------
+bool NewtonSolver::compute_residual(NonlinearProblem& nonlinear_problem,
+                                    const GenericVector& x,
+                                    bool compute_jacobian)
+{
+  // Compute F, and J if requested and supported by the problem
+  bool jacobian_computed = false;
+  if (compute_jacobian)
+    jacobian_computed = nonlinear_problem.F_and_J(*_b, *_matA, x);
+  if (!jacobian_computed)
+    nonlinear_problem.F(*_b, x);
+  nonlinear_problem.form(*_matA, *_b, x);
+
+  return jacobian_computed;
+}
+//-----------------------------------------------------------------------------
+double NewtonSolver::forcing_term_eisenstat_walker(double residual,
+                                                   double residual_prev,
+                                                   double residual0,
+                                                   double eta_prev,
+                                                   std::size_t iteration) const
+{
+  const Parameters& p = parameters("eisenstat_walker");
+  const double eta_0 = p["eta_0"];
+  const double eta_max = p["eta_max"];
+  const double gamma = p["gamma"];
+  const double alpha = p["alpha"];
+
+  // Initial forcing term
+  if (iteration == 0)
+    return eta_0;
+
+  // Eisenstat-Walker choice 2
+  double eta = gamma*std::pow(residual/residual_prev, alpha);
+
+  // Safeguard against too rapid decrease of eta
+  const double eta_safe = gamma*std::pow(eta_prev, alpha);
+  if (eta_safe > 0.1)
+    eta = std::max(eta, eta_safe);
+
+  // Avoid oversolving near nonlinear convergence
+  const double rtol = _rtol.value();
+  const double atol = _atol.value();
+  const double nonlinear_tol = std::max(atol, rtol*residual0);
+  if (residual > 0.0)
+    eta = std::max(eta, 0.5*nonlinear_tol/residual);
+
+  return std::min(eta, eta_max);
+}
+//-----------------------------------------------------------------------------
+void NewtonSolver::line_search_update(NonlinearProblem& nonlinear_problem,
+                                      GenericVector& x,
+                                      std::string type)
+{
+  const Parameters& p = parameters("line_search");
+  const std::size_t maxiter = p["maximum_iterations"];
+  const double alpha = p["alpha"];
+  const double min_step = p["minimum_step"];
+  const double step0 = parameters["relaxation_parameter"];
+
+  // Create work vectors
+  init_trial_vectors();
+
+  // Keep current iterate, such that trial points are computed in
+  // place (F is evaluated at the vector x of the nonlinear problem)
+  *_x_prev = x;
+
+  // Move x to x_prev - step*dx and evaluate residual there, return
+  // norm
+  auto trial = [&](double step) -> double
+  {
+    x = *_x_prev;
+    x.axpy(-step, *_dx);
+    nonlinear_problem.F(*_b_trial, x);
+    return _b_trial->norm("l2");
+  };
+
+  double step = step0;
+  if (type == "backtracking")
+  {
+    // Backtrack with safeguarded quadratic interpolation of
+    // ||F(x - step*dx)||^2 until sufficient decrease
+    // ||F(x - step*dx)|| <= (1 - alpha*step)||F(x)||
+    const double f0 = _b->norm("l2");
+    double f = trial(step);
+    std::size_t i = 1;
+    while (f > (1.0 - alpha*step)*f0 && i < maxiter && step > min_step)
+    {
+      const double phi0 = f0*f0;
+      const double dphi0 = -2.0*f0*f0;
+      const double phi = f*f;
+      double step_new = -dphi0*step*step/(2.0*(phi - phi0 - dphi0*step));
+      step_new = std::max(0.1*step, std::min(0.5*step, step_new));
+      step = step_new;
+      f = trial(step);
+      ++i;
+    }
+
+    if (f > (1.0 - alpha*step)*f0)
+      warning("Newton line search did not find sufficient decrease.");
+  }
+  else if (type == "critical_point")
+  {
+    // Find root of F(x - step*dx).dx (critical point of the
+    // underlying energy along the Newton direction) by the secant
+    // method
+    double step_prev = 0.0;
+    double g_prev = _b->inner(*_dx);
+    trial(step);
+    double g = _b_trial->inner(*_dx);
+    for (std::size_t i = 1; i < maxiter; ++i)
+    {
+      if (g == g_prev)
+        break;
+      double step_new = step - g*(step - step_prev)/(g - g_prev);
+      if (!std::isfinite(step_new) || step_new < min_step)
+        break;
+      if (std::abs(step_new - step) < min_step)
+        break;
+      step_prev = step;
+      g_prev = g;
+      step = step_new;
+      trial(step);
+      g = _b_trial->inner(*_dx);
+    }
+  }
+  else
+  {
+    dolfin_error("NewtonSolver.cpp",
+                 "perform line search",
+                 "Unknown line search type \"%s\"", type.c_str());
+  }
+
+  // Accept trial point (x is already at trial point)
+  std::swap(_b, _b_trial);
+
+  if (_report.value() && dolfin::MPI::rank(_mpi_comm) == 0)
+    info("Newton line search: step length %.3e", step);
+}
+//-----------------------------------------------------------------------------
+void NewtonSolver::trust_region_update(NonlinearProblem& nonlinear_problem,
+                                       GenericVector& x)
+{
+  const Parameters& p = parameters("trust_region");
+  const double max_radius = p["maximum_radius"];
+  const double eta = p["eta"];
+  const std::size_t maxiter = p["maximum_iterations"];
+
+  // Create work vectors and keep current iterate
+  init_trial_vectors();
+  *_x_prev = x;
+  if (!_g || _g->size() != _dx->size())
+    _g = _dx->copy();
+  if (!_s || _s->size() != _dx->size())
+    _s = _dx->copy();
+  if (!_Jv || _Jv->size() != _b->size())
+    _Jv = _b->copy();
+
+  // Merit function f = 0.5*||F||^2 at x
+  const double fnorm = _b->norm("l2");
+  const double f0 = 0.5*fnorm*fnorm;
+
+  // Length of Newton step (s_N = -dx)
+  const double newton_norm = _dx->norm("l2");
+
+  // Initialise trust region radius
+  if (_trust_radius <= 0.0)
+  {
+    const double initial_radius = p["initial_radius"];
+    _trust_radius = initial_radius > 0.0 ? initial_radius : newton_norm;
+  }
+
+  // Compute steepest descent direction g = J^T F and Cauchy step
+  // s_C = -tau_c g
+  _matA->transpmult(*_b, *_g);
+  const double gnorm = _g->norm("l2");
+  _matA->mult(*_g, *_Jv);
+  const double Jgnorm = _Jv->norm("l2");
+  const double tau_c = Jgnorm > 0.0 ? gnorm*gnorm/(Jgnorm*Jgnorm) : 0.0;
+  const double cauchy_norm = tau_c*gnorm;
+
+  bool accepted = false;
+  for (std::size_t i = 0; i < maxiter && !accepted; ++i)
+  {
+    // Compute dogleg step s
+    if (newton_norm <= _trust_radius || gnorm == 0.0)
+    {
+      *_s = *_dx;
+      *_s *= -1.0;
+    }
+    else if (cauchy_norm >= _trust_radius)
+    {
+      *_s = *_g;
+      *_s *= -_trust_radius/gnorm;
+    }
+    else
+    {
+      // s = s_C + tau*(s_N - s_C) with ||s|| = radius
+      *_s = *_g;
+      *_s *= tau_c;
+      _s->axpy(-1.0, *_dx);
+      const double a = _s->inner(*_s);
+      const double b = -2.0*tau_c*_g->inner(*_s);
+      const double c = cauchy_norm*cauchy_norm - _trust_radius*_trust_radius;
+      const double tau = (-b + std::sqrt(b*b - 4.0*a*c))/(2.0*a);
+      *_s *= tau;
+      _s->axpy(-tau_c, *_g);
+    }
+    const double snorm = _s->norm("l2");
+
+    // Predicted reduction from linear model 0.5*||F + J s||^2
+    _matA->mult(*_s, *_Jv);
+    *_Jv += *_b;
+    const double model_norm = _Jv->norm("l2");
+    const double predicted = f0 - 0.5*model_norm*model_norm;
+
+    // Actual reduction (only the residual is computed at trial point,
+    // which is set in place)
+    x += *_s;
+    nonlinear_problem.F(*_b_trial, x);
+    const double trial_norm = _b_trial->norm("l2");
+    const double actual = f0 - 0.5*trial_norm*trial_norm;
+
+    // Update trust region radius
+    const double rho = predicted > 0.0 ? actual/predicted : -1.0;
+    if (rho < 0.25)
+      _trust_radius = 0.25*snorm;
+    else if (rho > 0.75 && snorm > 0.99*_trust_radius)
+      _trust_radius = std::min(2.0*_trust_radius, max_radius);
+
+    accepted = rho > eta;
+
+    // Restore x if step is rejected
+    if (!accepted)
+      x = *_x_prev;
+
+    if (_report.value() && dolfin::MPI::rank(_mpi_comm) == 0)
+    {
+      info("Newton trust region: step %.3e, radius %.3e, reduction ratio %.3e",
+           snorm, _trust_radius, rho);
+    }
+  }
+
+  // Keep x and F(x) if no step was accepted (the trust region radius
+  // has been reduced for the next iteration), otherwise accept
+  // trial point
+  if (accepted)
+    std::swap(_b, _b_trial);
+  else
+    warning("Newton trust region step not accepted, keeping current iterate.");
+}
+//-----------------------------------------------------------------------------
+void NewtonSolver::init_trial_vectors()
+{
+  if (!_x_prev || _x_prev->size() != _dx->size())
+    _x_prev = _dx->copy();
+  if (!_b_trial || _b_trial->size() != _b->size())
+    _b_trial = _b->copy();
+}
+//-----------------------------------------------------------------------------
 bool NewtonSolver::converged(const GenericVector& r,
                              const NonlinearProblem& nonlinear_problem,
                              std::size_t newton_iteration)
 {
-  const double rtol = parameters["relative_tolerance"];
-  const double atol = parameters["absolute_tolerance"];
-  const bool report = parameters["report"];
+  const double rtol = _rtol.value();
+  const double atol = _atol.value();
+  const bool report = _report.value();
 
   _residual = r.norm("l2");
 
@@ -19,7 +19,7 @@
 // Modified by Anders E. Johansen 2011
 //
 // First added:  2005-10-23
-// Last changed: 2013-11-20
+// Last changed: 2015-06-08
 
 #ifndef __NEWTON_SOLVER_H
 #define __NEWTON_SOLVER_H
@@ -28,6 +28,7 @@
 #include <memory>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/Variable.h>
+#include <dolfin/parameter/CachedParameter.h>
 
 namespace dolfin
 {
@@ -41,6 +42,20 @@ namespace dolfin
 
   /// This class defines a Newton solver for nonlinear systems of
   /// equations of the form :math:`F(x) = 0`.
+  ///
+  /// The cost of the iteration may be reduced by reusing (lagging)
+  /// the Jacobian and the preconditioner over several iterations
+  /// (parameters "jacobian_lag", "jacobian_lag_rate" and
+  /// "preconditioner_lag"), by solving the linear systems inexactly
+  /// to Eisenstat-Walker forcing terms (parameter
+  /// "krylov_forcing_term") and by assembling the residual and the
+  /// Jacobian in a single pass (parameter "fused_assembly").
+  ///
+  /// The iteration may be globalized by a line search (backtracking
+  /// or critical point) or by a dogleg trust region (parameter
+  /// "globalization"). Trial points only require evaluation of the
+  /// residual F; NonlinearProblem::form is called at accepted
+  /// iterates only.
 
   class NewtonSolver : public Variable
   {
@@ -115,6 +130,31 @@ namespace dolfin
 
   private:
 
+    // Compute F at x (and J if compute_jacobian is true and F and J
+    // can be computed together). Return true if J was computed.
+    bool compute_residual(NonlinearProblem& nonlinear_problem,
+                          const GenericVector& x, bool compute_jacobian);
+
+    // Return Eisenstat-Walker forcing term (relative tolerance for
+    // the linear solve)
+    double forcing_term_eisenstat_walker(double residual,
+                                         double residual_prev,
+                                         double residual0,
+                                         double eta_prev,
+                                         std::size_t iteration) const;
+
+    // Update x by line search along -dx and compute F at new x
+    void line_search_update(NonlinearProblem& nonlinear_problem,
+                            GenericVector& x, std::string type);
+
+    // Update x by dogleg trust region step and compute F at new x
+    // (x and F are left unchanged if no step is accepted)
+    void trust_region_update(NonlinearProblem& nonlinear_problem,
+                             GenericVector& x);
+
+    // Create work vectors for trial points
+    void init_trial_vectors();
+
     // Convergence test
     virtual bool converged(const GenericVector& r,
                            const NonlinearProblem& nonlinear_problem,
@@ -132,15 +172,29 @@ namespace dolfin
     // Jacobian matrix
     std::shared_ptr<GenericMatrix> _matA;
 
+    // Matrix from which the preconditioner is built (when lagged)
+    std::shared_ptr<GenericMatrix> _matP;
+
     // Solution vector
     std::shared_ptr<GenericVector> _dx;
 
     // Residual vector
     std::shared_ptr<GenericVector> _b;
 
+    // Work vectors for line search and trust region (x_prev holds
+    // the iterate while x is moved to trial points)
+    std::shared_ptr<GenericVector> _x_prev, _b_trial, _g, _s, _Jv;
+
+    // Trust region radius
+    double _trust_radius;
+
     // MPI communicator
     MPI_Comm _mpi_comm;
 
+    // Parameters accessed in every iteration
+    CachedParameter<double> _rtol, _atol;
+    CachedParameter<bool> _report;
+
   };
 
 }
@@ -18,7 +18,7 @@
 // Modified by Anders Logg, 2008.
 //
 // First added:  2005-10-24
-// Last changed: 2011-01-14
+// Last changed: 2015-06-08
 
 #ifndef __NONLINEAR_PROBLEM_H
 #define __NONLINEAR_PROBLEM_H
@@ -57,6 +57,14 @@ namespace dolfin
     /// Compute J = F' at current point x
     virtual void J(GenericMatrix& A, const GenericVector& x) = 0;
 
+    /// Compute F and J = F' together at current point x. This may be
+    /// overloaded to assemble the residual and the Jacobian in a
+    /// single pass over the mesh. Return false if not supported, in
+    /// which case F and J are computed by separate calls.
+    virtual bool F_and_J(GenericVector& b, GenericMatrix& A,
+                         const GenericVector& x)
+    { return false; }
+
   };
 
 }
@@ -5,6 +5,7 @@
 
 #include <dolfin/nls/NonlinearProblem.h>
 #include <dolfin/nls/NewtonSolver.h>
+#include <dolfin/nls/FixedPointSolver.h>
 #include <dolfin/nls/OptimisationProblem.h>
 #include <dolfin/nls/PETScSNESSolver.h>
 #include <dolfin/nls/PETScTAOSolver.h>
@@ -0,0 +1,130 @@
+// Copyright (C) 2015 The DOLFIN authors
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2015-06-04
+// Last changed:
+
+#ifndef __CACHED_PARAMETER_H
+#define __CACHED_PARAMETER_H
+
+#include <string>
+#include <dolfin/log/log.h>
+#include "Parameter.h"
+#include "Parameters.h"
+
+namespace dolfin
+{
+
+  /// This class provides fast, typed access to a parameter in a
+  /// parameter set for use in performance critical code. The key is
+  /// resolved once and the value is converted once; subsequent reads
+  /// cost two integer comparisons. The value is re-read automatically
+  /// when the parameter is changed, and when the parameter set has
+  /// been modified such that the parameter has been removed or
+  /// replaced (for example by assignment of the parameter set).
+  ///
+  /// A cached parameter may be used as follows:
+  ///
+  ///   CachedParameter<double> rtol(parameters, "relative_tolerance");
+  ///   ...
+  ///   if (residual < rtol.value())
+  ///     ...
+  ///
+  /// The parameter set must outlive the cached parameter.
+
+  template<typename T>
+  class CachedParameter
+  {
+  public:
+
+    /// Create cached parameter for given key in parameter set. The
+    /// key is resolved on first access.
+    CachedParameter(const Parameters& parameters, std::string key)
+      : _parameters(parameters), _key(key), _parameter(0),
+        _structure_count(0), _change_count(0), _value() {}
+
+    /// Return parameter value
+    const T& value() const
+    {
+      if (changed())
+        update();
+      return _value;
+    }
+
+    /// Return true if the parameter has changed since it was last
+    /// read
+    bool changed() const
+    {
+      return !_parameter
+        || _parameters.structure_count() != _structure_count
+        || _parameter->change_count() != _change_count;
+    }
+
+    /// Return parameter key
+    std::string key() const
+    { return _key; }
+
+  private:
+
+    // Disable copying (the cached parameter refers to its parameter set)
+    CachedParameter(const CachedParameter&);
+    CachedParameter& operator= (const CachedParameter&);
+
+    // Resolve key (if necessary) and read value
+    void update() const
+    {
+      if (!_parameter || _parameters.structure_count() != _structure_count)
+      {
+        _parameter = _parameters.find_parameter(_key);
+        if (!_parameter)
+        {
+          dolfin_error("CachedParameter.h",
+                       "access parameter",
+                       "Parameter \"%s.%s\" not defined",
+                       _parameters.name().c_str(), _key.c_str());
+        }
+        _structure_count = _parameters.structure_count();
+      }
+
+      _change_count = _parameter->change_count();
+      const T value = *_parameter;
+      _value = value;
+    }
+
+    // Parameter set
+    const Parameters& _parameters;
+
+    // Parameter key
+    const std::string _key;
+
+    // Resolved parameter
+    mutable const Parameter* _parameter;
+
+    // Structure count of parameter set when key was resolved
+    mutable std::size_t _structure_count;
+
+    // Change count of parameter when value was read
+    mutable std::size_t _change_count;
+
+    // Cached value
+    mutable T _value;
+
+  };
+
+}
+
+#endif
@@ -18,7 +18,7 @@
 // Modified by Fredrik Valdmanis, 2011
 //
 // First added:  2009-07-02
-// Last changed: 2013-06-21
+// Last changed: 2015-06-12
 
 #ifndef __GLOBAL_PARAMETERS_H
 #define __GLOBAL_PARAMETERS_H
@@ -55,6 +55,14 @@ namespace dolfin
       // Prefix for timer tasks
       p.add("timer_prefix", "");
 
+      // Collect hardware performance counters (of the calling thread)
+      // for timer tasks
+      p.add("timer_hardware_counters", false);
+
+      // Raw (processor specific) hardware event counting floating
+      // point operations, 0 = do not count
+      p.add("timer_flops_event", 0);
+
       // Allow extrapolation in function interpolation
       p.add("allow_extrapolation", false);
 
@@ -152,6 +160,10 @@ namespace dolfin
       allowed_backends.insert("PETSc");
       default_backend = "PETSc";
       p.add("use_petsc_signal_handler", false);
+
+      // Use PETSc block (BAIJ) matrices for block size > 1. Off by
+      // default since some preconditioners (e.g. Hypre) require AIJ.
+      p.add("use_petsc_block_matrices", false);
       #endif
       #ifdef HAS_PETSC_CUSP
       allowed_backends.insert("PETScCusp");
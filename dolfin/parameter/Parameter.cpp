@@ -61,6 +61,7 @@ bool Parameter::is_set() const
 void Parameter::reset()
 {
   _is_set = false;
+  _change_count++;
 }
 //-----------------------------------------------------------------------------
 std::size_t Parameter::access_count() const
@@ -44,7 +44,7 @@ typedef std::map<std::string, Parameters*>::iterator parameter_set_iterator;
 typedef std::map<std::string, Parameters*>::const_iterator const_parameter_set_iterator;
 
 //-----------------------------------------------------------------------------
-Parameters::Parameters(std::string key) : _key(key)
+Parameters::Parameters(std::string key) : _key(key), _structure_count(0)
 {
   // Check that key name is allowed
   Parameter::check_key(key);
@@ -55,7 +55,7 @@ Parameters::~Parameters()
   clear();
 }
 //-----------------------------------------------------------------------------
-Parameters::Parameters(const Parameters& parameters)
+Parameters::Parameters(const Parameters& parameters) : _structure_count(0)
 {
   *this = parameters;
 }
@@ -91,6 +91,9 @@ void Parameters::clear()
 
   // Reset key
   _key = "";
+
+  // References to parameters have been invalidated
+  ++_structure_count;
 }
 //-----------------------------------------------------------------------------
 void Parameters::add(std::string key, int value)
@@ -259,6 +262,14 @@ void Parameters::remove(std::string key)
   num_removed += _parameters.erase(key);
   num_removed += _parameter_sets.erase(key);
   dolfin_assert(num_removed == 1);
+
+  // References to parameters have been invalidated
+  ++_structure_count;
+}
+//-----------------------------------------------------------------------------
+std::size_t Parameters::structure_count() const
+{
+  return _structure_count;
 }
 //-----------------------------------------------------------------------------
 void Parameters::parse(int argc, char* argv[])
@@ -173,6 +173,12 @@ namespace dolfin
     /// Remove parameter or parameter set with given key
     void remove(std::string key);
 
+    /// Return structure count (number of times parameters or
+    /// parameter sets have been removed from this set). References
+    /// to parameters obtained from the set remain valid as long as
+    /// the structure count is unchanged.
+    std::size_t structure_count() const;
+
     /// Parse parameters from command-line
     virtual void parse(int argc, char* argv[]);
 
@@ -253,6 +259,9 @@ namespace dolfin
     // Map from key to parameter sets
     std::map<std::string, Parameters*> _parameter_sets;
 
+    // Structure count
+    std::size_t _structure_count;
+
   };
 
   // Specialised templated for unset parameters
@@ -5,6 +5,7 @@
 
 #include <dolfin/parameter/Parameter.h>
 #include <dolfin/parameter/Parameters.h>
+#include <dolfin/parameter/CachedParameter.h>
 #include <dolfin/parameter/GlobalParameters.h>
 
 #endif
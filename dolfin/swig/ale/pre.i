@@ -26,3 +26,6 @@
 //=============================================================================
 
 %rename(sub) dolfin::MeshDisplacement::operator[];
+
+// Static version of HarmonicSmoothing::move is available as ALE.move
+%ignore dolfin::HarmonicSmoothing::move(dolfin::Mesh&, const dolfin::BoundaryMesh&);
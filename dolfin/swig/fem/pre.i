@@ -140,6 +140,7 @@ PROBLEM_RENAMES(NonlinearVariational)
 %ignore dolfin::Form::dS;
 %ignore dolfin::Form::dP;
 %ignore dolfin::Form::operator==;
+%ignore dolfin::Form::domain_index;
 
 //-----------------------------------------------------------------------------
 // Ignore dolfin::Cell versions of signatures as these now are handled by
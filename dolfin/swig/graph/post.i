@@ -9,4 +9,5 @@
 // ---------------------------------------------------------------------------
 // Instantiate template classes
 // ---------------------------------------------------------------------------
-%template(Graph) std::vector<dolfin::graph_set_type>;
+%ignore dolfin::CSRGraph::operator[];
+%template(Graph) dolfin::CSRGraph<int>;
@@ -137,12 +137,12 @@ del _subdomain_mark_doc_string
   TYPE _getitem(std::size_t i)
   { return (*self)[i]; }
   void _setitem(std::size_t i, TYPE val)
-  { (*self)[i] = val; }
+  { self->set_value(i, val); }
 
   TYPE _getitem(dolfin::MeshEntity& e)
   { return (*self)[e]; }
   void _setitem(dolfin::MeshEntity& e, TYPE val)
-  { (*self)[e] = val; }
+  { self->set_value(e.index(), val); }
 
 %pythoncode%{
 def array(self):
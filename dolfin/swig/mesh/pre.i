@@ -104,6 +104,7 @@ ALL_VALUES(dolfin::MeshFunction<std::size_t>, size_t)
 %ignore dolfin::MeshTopology::operator=;
 %ignore dolfin::MeshTopology::shared_entities(unsigned int) const;
 %ignore dolfin::MeshValueCollection::operator=;
+%ignore dolfin::MeshValueCollection::set_values;
 %ignore dolfin::MeshConnectivity::operator=;
 %ignore dolfin::MeshConnectivity::set;
 %ignore dolfin::MeshEntityIterator::operator->;
@@ -113,8 +114,11 @@ ALL_VALUES(dolfin::MeshFunction<std::size_t>, size_t)
 %ignore dolfin::SubsetIterator::operator[];
 %ignore dolfin::MeshDomains::operator=;
 %ignore dolfin::MeshDomains::markers(std::size_t) const;
+%ignore dolfin::MeshDomains::set_markers;
 %ignore dolfin::MeshData::array(std::string) const;
 %ignore dolfin::MeshHierarchy::operator[];
+%ignore dolfin::PeriodicBoundaryComputation::cached_periodic_pairs;
+%rename(__getitem__) dolfin::CompactMeshFunction::operator[];
 
 //-----------------------------------------------------------------------------
 // Map increment, decrease and dereference operators for iterators
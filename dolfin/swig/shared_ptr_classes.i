@@ -130,6 +130,7 @@
 %shared_ptr(dolfin::LocalMeshData)
 %shared_ptr(dolfin::MeshData)
 %shared_ptr(dolfin::MeshHierarchy)
+%shared_ptr(dolfin::CompactMeshFunction)
 
 // NOTE: Most of the MeshFunctions are declared shared pointers in
 // NOTE: mesh/pre.i, mesh/post.i
@@ -201,6 +202,7 @@
 %shared_ptr(dolfin::GenericLUSolver)
 %shared_ptr(dolfin::KrylovSolver)
 %shared_ptr(dolfin::LUSolver)
+%shared_ptr(dolfin::SymmetricEigenSolver)
 
 %shared_ptr(dolfin::GenericSparsityPattern)
 %shared_ptr(dolfin::SparsityPattern)
@@ -219,6 +221,7 @@
 
 // nls
 %shared_ptr(dolfin::NewtonSolver)
+%shared_ptr(dolfin::FixedPointSolver)
 %shared_ptr(dolfin::PETScSNESSolver)
 #ifdef ENABLE_PETSC_TAO
 %shared_ptr(dolfin::TAOLinearBoundSolver)
@@ -40,8 +40,8 @@ namespace std
 }
 
 //-----------------------------------------------------------------------------
-// Help macro for defining (arg)out typemaps for either std::unordered_map or
-// std::map
+// Help macro for defining (arg)out typemaps for either std::unordered_map,
+// std::map or boost::container::flat_map
 //
 //    const MAP_TYPE<KEY_TYPE, VALUE_TYPE>&, (out)
 //    const MAP_TYPE<KEY_TYPE, std::vector<VALUE_TYPE> >& (out)
@@ -203,6 +203,7 @@ namespace std
 %define MAP_OUT_TYPEMAPS(KEY_TYPE, VALUE_TYPE, TYPENAME, NUMPY_TYPE)
 MAP_SPECIFIC_OUT_TYPEMAPS(std::unordered_map, KEY_TYPE, VALUE_TYPE, TYPENAME, NUMPY_TYPE)
 MAP_SPECIFIC_OUT_TYPEMAPS(std::map, KEY_TYPE, VALUE_TYPE, TYPENAME, NUMPY_TYPE)
+MAP_SPECIFIC_OUT_TYPEMAPS(boost::container::flat_map, KEY_TYPE, VALUE_TYPE, TYPENAME, NUMPY_TYPE)
 %enddef
 
 //-----------------------------------------------------------------------------
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2011-03-28
-// Last changed: 2011-03-31
+// Last changed: 2015-06-04
 //
 // Unit tests for the parameter library
 
@@ -30,6 +30,7 @@ class InputOutput : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(InputOutput);
   CPPUNIT_TEST(test_simple);
   CPPUNIT_TEST(test_nested);
+  CPPUNIT_TEST(test_cached);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -114,6 +115,33 @@ public:
     CPPUNIT_ASSERT(monitor_convergence == true);
   }
 
+  void test_cached()
+  {
+    Parameters p("test");
+    p.add("tolerance", 0.001);
+    p.add("method", "full");
+
+    CachedParameter<double> tolerance(p, "tolerance");
+    CachedParameter<std::string> method(p, "method");
+    CPPUNIT_ASSERT(tolerance.value() == 0.001);
+    CPPUNIT_ASSERT(method.value() == "full");
+    CPPUNIT_ASSERT(!tolerance.changed());
+
+    // Change value
+    p["tolerance"] = 0.01;
+    CPPUNIT_ASSERT(tolerance.changed());
+    CPPUNIT_ASSERT(tolerance.value() == 0.01);
+    CPPUNIT_ASSERT(!tolerance.changed());
+
+    // Replace parameter set
+    Parameters q("test");
+    q.add("tolerance", 0.1);
+    q.add("method", "partial");
+    p = q;
+    CPPUNIT_ASSERT(tolerance.value() == 0.1);
+    CPPUNIT_ASSERT(method.value() == "partial");
+  }
+
 };
 
 
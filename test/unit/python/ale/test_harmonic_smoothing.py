@@ -23,7 +23,7 @@ from __future__ import print_function
 import pytest
 from dolfin import UnitSquareMesh, BoundaryMesh, Expression, \
                    CellFunction, SubMesh, Constant, MPI, MeshQuality,\
-                   mpi_comm_world
+                   mpi_comm_world, HarmonicSmoothing
 from dolfin_utils.test import skip_in_parallel
 
 def test_HarmonicSmoothing():
@@ -55,6 +55,40 @@ def test_HarmonicSmoothing():
     rmin = MeshQuality.radius_ratio_min_max(mesh)[0]
     assert rmin > magic_number
 
+@pytest.mark.parametrize("smoothing_parameters",
+                         [{}, {"reassemble_operator": True,
+                               "warm_start": True}])
+def test_HarmonicSmoothing_repeated(smoothing_parameters):
+    # Move mesh repeatedly, reusing operator and solver
+    mesh = UnitSquareMesh(10, 10)
+    reference_mesh = UnitSquareMesh(10, 10)
+    smoothing = HarmonicSmoothing(mesh)
+    smoothing.parameters.update(smoothing_parameters)
+    disp = Expression(("0.05*x[0]*x[1]", "0.1*(1.0-x[1])"))
+    for i in range(3):
+        boundary = BoundaryMesh(mesh, 'exterior')
+        boundary.move(disp)
+        smoothing.move(boundary)
+
+        # Check that coordinates of boundary are almost equal
+        boundary_new = BoundaryMesh(mesh, 'exterior')
+        err = sum(sum(abs(boundary.coordinates() \
+                        - boundary_new.coordinates()))) / mesh.num_vertices()
+        assert round(err - 0.0, 5) == 0
+
+        # With reassembly, result should match moving without cache
+        if smoothing_parameters.get("reassemble_operator", False):
+            reference_boundary = BoundaryMesh(reference_mesh, 'exterior')
+            reference_boundary.move(disp)
+            reference_mesh.move(reference_boundary)
+            diff = abs(mesh.coordinates() - reference_mesh.coordinates())
+            assert diff.max() < 1e-4
+
+    # Check mesh quality
+    magic_number = 0.35
+    rmin = MeshQuality.radius_ratio_min_max(mesh)[0]
+    assert rmin > magic_number
+
 @skip_in_parallel
 def test_ale():
     #print("Testing ALE::move(Mesh& mesh0, const Mesh& mesh1)")
@@ -0,0 +1,55 @@
+#!/usr/bin/env py.test
+
+"""Unit tests for timers and hardware performance counters"""
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+#
+# First added:  2015-06-12
+# Last changed:
+
+from __future__ import print_function
+import pytest
+from dolfin import *
+
+
+def test_timer_hardware_counters():
+    "Test hardware counters of nested timers"
+    previous = parameters["timer_hardware_counters"]
+    parameters["timer_hardware_counters"] = True
+    try:
+        for i in range(3):
+            outer = Timer("test_timer outer")
+            inner = Timer("test_timer inner")
+            sum(range(100000))
+            inner.stop()
+            sum(range(100000))
+            outer.stop()
+    finally:
+        parameters["timer_hardware_counters"] = previous
+
+    t = timings(TimingClear_keep, [TimingType_wall, TimingType_instructions])
+    for task in ["test_timer outer", "test_timer inner"]:
+        assert timing(task, TimingClear_clear)[0] == 3
+
+    # Counters read as -1 if not supported by the platform
+    inner = t.get_value("test_timer inner", "instr tot")
+    outer = t.get_value("test_timer outer", "instr tot")
+    if inner < 0.0:
+        assert outer < 0.0
+    else:
+        assert 0.0 < inner < outer
@@ -28,7 +28,8 @@ import os
 import numpy
 from dolfin import *
 
-from dolfin_utils.test import skip_in_parallel, filedir
+from dolfin_utils.test import skip_in_parallel, skip_in_serial, \
+    skip_if_not_PETSc, filedir
 
 
 def test_cell_size_assembly_1D():
@@ -483,6 +484,161 @@ def test_subdomain_assembly_form_2():
     assert round(assemble(a1) - 1.0, 7) == 0
 
 
+def test_subdomain_assembly_markers_changed():
+    "Test repeated assembly of a form over subdomains with changed markers"
+
+    mesh = UnitSquareMesh(8, 8)
+    D = mesh.topology().dim()
+    cell_domains = MeshFunction("size_t", mesh, D, 0)
+    exterior_facet_domains = MeshFunction("size_t", mesh, D - 1, 0)
+    AutoSubDomain(lambda x: x[0] < 0.5 + DOLFIN_EPS).mark(cell_domains, 1)
+    AutoSubDomain(lambda x: near(x[0], 0.0)).mark(exterior_facet_domains, 1)
+
+    c = Constant(1.0)
+    a0 = Form(c*dx(1, domain=mesh, subdomain_data=cell_domains))
+    a1 = Form(c*ds(1, domain=mesh, subdomain_data=exterior_facet_domains))
+    assert round(assemble(a0) - 0.5, 7) == 0
+    assert round(assemble(a1) - 1.0, 7) == 0
+
+    # Change markers and assemble same forms again
+    AutoSubDomain(lambda x: x[1] < 0.5 + DOLFIN_EPS).mark(cell_domains, 1)
+    AutoSubDomain(lambda x: near(x[1], 0.0)).mark(exterior_facet_domains, 1)
+    assert round(assemble(a0) - 0.75, 7) == 0
+    assert round(assemble(a1) - 2.0, 7) == 0
+
+    # Change markers entity by entity and all at once
+    cell_domains.set_all(1)
+    assert round(assemble(a0) - 1.0, 7) == 0
+    cell_domains[0] = 0
+    assert round(assemble(a0) - (1.0 - Cell(mesh, 0).volume()), 7) == 0
+
+    # Change markers through an array view held across assemblies
+    values = cell_domains.array()
+    values[:] = 1
+    assert round(assemble(a0) - 1.0, 7) == 0
+    values[0] = 0
+    assert round(assemble(a0) - (1.0 - Cell(mesh, 0).volume()), 7) == 0
+    values[:] = 0
+    assert round(assemble(a0), 7) == 0
+
+
+def test_bulk_insertion_assembly():
+    "Test assembly of matrix with bulk insertion of values"
+
+    ghost_mode = parameters["ghost_mode"]
+    try:
+        parameters["ghost_mode"] = "shared_facet"
+        mesh = UnitSquareMesh(24, 24)
+    finally:
+        parameters["ghost_mode"] = ghost_mode
+    V = FunctionSpace(mesh, "DG", 1)
+    v = TestFunction(V)
+    u = TrialFunction(V)
+
+    n = FacetNormal(mesh)
+    h = CellSize(mesh)
+    h_avg = (h('+') + h('-'))/2
+    a = dot(grad(v), grad(u))*dx \
+        - dot(avg(grad(v)), jump(u, n))*dS \
+        - dot(jump(v, n), avg(grad(u)))*dS \
+        + 4.0/h_avg*dot(jump(v, n), jump(u, n))*dS \
+        - dot(grad(v), u*n)*ds \
+        - dot(v*n, grad(u))*ds \
+        + 8.0/h*v*u*ds
+
+    # Reference matrix assembled without bulk insertion
+    A0 = assemble(a)
+    x = Function(V).vector()
+    x[:] = numpy.arange(x.local_size(), dtype=float) \
+           + x.local_range()[0]
+    y0 = A0*x
+
+    assembler = Assembler()
+    assembler.bulk_insertion = True
+    A = Matrix()
+    assembler.assemble(A, Form(a))
+    assert A.nnz() == A0.nnz()
+    assert round(A.norm("frobenius") - A0.norm("frobenius"), 10) == 0
+    assert round((A*x - y0).norm("linf")/y0.norm("linf"), 12) == 0
+
+    # Assemble again into existing matrix (values inserted directly)
+    assembler.assemble(A, Form(a))
+    assert round((A*x - y0).norm("linf")/y0.norm("linf"), 12) == 0
+
+    # Compare with direct insertion for continuous space (rows owned by
+    # other processes are sent ahead of insertion in parallel)
+    V = VectorFunctionSpace(mesh, "Lagrange", 2)
+    f = interpolate(Expression("1.0 + x[0]*x[1]", degree=2),
+                    FunctionSpace(mesh, "Lagrange", 2))
+    u, v = TrialFunction(V), TestFunction(V)
+    a = f*inner(grad(u), grad(v))*dx + inner(u, v)*ds
+    A = Matrix()
+    assembler.assemble(A, Form(a))
+    B = assemble(a)
+    assert round(A.norm("frobenius") - B.norm("frobenius"), 10) == 0
+    x = Vector()
+    B.init_vector(x, 1)
+    x[:] = 1.0
+    y, z = Vector(), Vector()
+    A.init_vector(y, 0)
+    B.init_vector(z, 0)
+    A.mult(x, y)
+    B.mult(x, z)
+    assert round((y - z).norm("l2"), 10) == 0
+
+
+def test_assembly_with_ghosted_coefficients():
+    "Test assembly with coefficients whose ghost values are updated"
+
+    mesh = UnitSquareMesh(16, 16)
+    V = FunctionSpace(mesh, "Lagrange", 2)
+    W = VectorFunctionSpace(mesh, "Lagrange", 2)
+    u = interpolate(Expression("x[0]*x[1]", degree=2), V)
+    w = interpolate(Expression(("x[0]", "x[1]"), degree=1), W)
+    v = TestFunction(V)
+
+    assert round(assemble(u*u*dx) - 1.0/9.0, 10) == 0
+    assert round(assemble(u*w[0]*dx) - 1.0/6.0, 10) == 0
+    assert round(assemble(u*v*dx).sum() - 0.25, 10) == 0
+
+    # Set values, such that the update of ghost values started by
+    # apply() is completed during assembly
+    u0 = Function(V)
+    u0.vector().set_local(u.vector().get_local())
+    u0.vector().apply("insert")
+    assert round(assemble(u0*u0*dx) - 1.0/9.0, 10) == 0
+    assert round(assemble(u0*v*dx).sum() - 0.25, 10) == 0
+
+
+@skip_in_serial
+@skip_if_not_PETSc
+def test_ghost_update_overlaps_restriction():
+    "Test that restriction to cells with owned dofs does not wait for ghosts"
+
+    mesh = UnitSquareMesh(16, 16)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u = Function(V)
+    x = as_backend_type(u.vector())
+    x.set_local(numpy.ones(x.local_size()))
+    x.apply("insert")
+    assert x.ghost_update_pending()
+
+    # Owned dofs are numbered before unowned dofs
+    owned = [(V.dofmap().cell_dofs(c.index()) < x.local_size()).all()
+             for c in cells(mesh)]
+
+    # Evaluation in a cell with only owned dofs leaves update pending
+    cell = Cell(mesh, owned.index(True))
+    assert round(u(cell.midpoint()) - 1.0, 10) == 0
+    assert x.ghost_update_pending()
+
+    # Evaluation in a cell with unowned dofs completes update
+    if False in owned:
+        cell = Cell(mesh, owned.index(False))
+        assert round(u(cell.midpoint()) - 1.0, 10) == 0
+        assert not x.ghost_update_pending()
+
+
 @skip_in_parallel
 def test_colored_cell_assembly():
 
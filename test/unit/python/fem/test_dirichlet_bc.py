@@ -113,6 +113,26 @@ def test_user_meshfunction_domains():
         DirichletBC(V, 0.0, FacetFunction("size_t", mesh1), 0)
 
 
+def test_compact_meshfunction_domains():
+    "Test DirichletBC with markers given by a CompactMeshFunction"
+    mesh = UnitSquareMesh(12, 12)
+    V = FunctionSpace(mesh, "CG", 1)
+    markers = FacetFunction("size_t", mesh, 0)
+    CompiledSubDomain("near(x[0], 0.0) && on_boundary").mark(markers, 1)
+    CompiledSubDomain("near(x[1], 1.0) && on_boundary").mark(markers, 2)
+
+    for storage in ["auto", "uint8", "sparse", "runlength"]:
+        compact = CompactMeshFunction(markers, storage)
+        for marker in [1, 2]:
+            bc0 = DirichletBC(V, Constant(1.0), markers, marker)
+            bc1 = DirichletBC(V, Constant(1.0), compact, marker)
+            assert bc0.get_boundary_values() == bc1.get_boundary_values()
+
+    with pytest.raises(RuntimeError):
+        DirichletBC(V, 0.0, CompactMeshFunction(CellFunction("size_t", mesh)),
+                    0)
+
+
 @skip_in_parallel
 def test_bc_for_piola_on_manifolds():
     "Testing DirichletBC for piolas over standard domains vs manifolds."
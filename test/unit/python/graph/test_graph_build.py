@@ -36,3 +36,13 @@ def test_build_from_mesh_simple():
     GraphBuilder.local_graph(mesh, 2, D)
     GraphBuilder.local_graph(mesh, 1, D)
     GraphBuilder.local_graph(mesh, 0, D)
+
+
+def test_build_from_mesh_compressed():
+    """Check size of compressed vertex-vertex graph"""
+
+    mesh = UnitSquareMesh(8, 8)
+    mesh.init(1)
+    graph = GraphBuilder.local_graph(mesh, 0, 1)
+    assert graph.size() == mesh.num_vertices()
+    assert graph.num_edges() == 2*mesh.num_edges()
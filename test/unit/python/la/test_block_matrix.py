@@ -0,0 +1,93 @@
+#!/usr/bin/env py.test
+
+"Unit tests for BlockMatrix and BlockPreconditioner"
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+
+from dolfin import *
+import numpy
+import pytest
+from dolfin_utils.test import *
+
+
+def assemble_blocks(tensor_type):
+    "Assemble 2 x 2 block matrix (K M; M K) with K = stiffness + mass"
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    K = assemble(inner(grad(u), grad(v))*dx + u*v*dx, tensor=tensor_type())
+    M = assemble(0.5*u*v*dx, tensor=tensor_type())
+    AA = BlockMatrix(2, 2)
+    AA[0, 0] = K
+    AA[0, 1] = M
+    AA[1, 0] = M
+    AA[1, 1] = K
+    return AA, K, M
+
+
+@skip_in_parallel
+@pytest.mark.parametrize("tensor_type", [EigenMatrix, uBLASSparseMatrix])
+def test_mult(tensor_type):
+    "Test block matrix-vector product against products with blocks"
+    AA, K, M = assemble_blocks(tensor_type)
+    xx = BlockVector(2)
+    AA.init_vector(xx, 1)
+    n = K.size(1)
+    for i in range(2):
+        xx[i].set_local(numpy.linspace(i, i + 1.0, n))
+    yy = BlockVector(2)
+    AA.init_vector(yy, 0)
+    AA.mult(xx, yy)
+
+    for i in range(2):
+        y0 = K*xx[i]
+        y0.axpy(1.0, M*xx[1 - i])
+        y0.axpy(-1.0, yy[i])
+        assert round(y0.norm("l2"), 10) == 0
+
+
+@skip_in_parallel
+@pytest.mark.parametrize("pc_type", ["jacobi", "upper triangular",
+                                     "lower triangular"])
+def test_block_preconditioner(pc_type):
+    "Test uBLAS Krylov solver for block system with block preconditioner"
+    if not has_linear_algebra_backend("uBLAS"):
+        pytest.skip("Need uBLAS as backend to run this test")
+
+    AA, K, M = assemble_blocks(uBLASSparseMatrix)
+    solvers = []
+    pc = BlockPreconditioner(pc_type)
+    for i in range(2):
+        solver = uBLASKrylovSolver("gmres", "ilu")
+        solver.set_operator(K)
+        solver.parameters["relative_tolerance"] = 1.0e-12
+        solvers.append(solver)
+        pc.set_block_solver(i, solver)
+
+    n = K.size(0)
+    b = uBLASVector(2*n)
+    b[:] = 1.0
+    x = uBLASVector(2*n)
+    solver = uBLASKrylovSolver("gmres", pc)
+    solver.parameters["relative_tolerance"] = 1.0e-10
+    solver.solve(AA, x, b)
+
+    r = uBLASVector(2*n)
+    AA.mult(x, r)
+    r.axpy(-1.0, b)
+    assert r.norm("l2") < 1.0e-8*b.norm("l2")
@@ -21,7 +21,7 @@
 
 from dolfin import *
 import pytest
-from dolfin_utils.test import skip_if_not_PETSc
+from dolfin_utils.test import skip_if_not_PETSc, skip_in_parallel
 
 @skip_if_not_PETSc
 def test_krylov_samg_solver_elasticity():
@@ -123,3 +123,40 @@ def test_krylov_samg_solver_elasticity():
             assert niter < 12
 
     parameters["linear_algebra_backend"] = previous_backend
+
+
+@skip_in_parallel
+@pytest.mark.parametrize("method", ["gmres", "bicgstab"])
+def test_ublas_krylov_solver_threads(method):
+    "Test that threaded uBLAS Krylov solver gives same solution as serial"
+    if not has_linear_algebra_backend("uBLAS"):
+        pytest.skip("Need uBLAS as backend to run this test")
+
+    mesh = UnitSquareMesh(64, 64)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    A = assemble(inner(grad(u), grad(v))*dx + u*v*dx,
+                 tensor=uBLASSparseMatrix())
+    b = assemble(v*dx, tensor=uBLASVector())
+
+    previous_num_threads = parameters["num_threads"]
+    x = []
+    try:
+        for num_threads in [1, 2]:
+            parameters["num_threads"] = num_threads
+            solver = uBLASKrylovSolver(method, "ilu")
+            solver.parameters["relative_tolerance"] = 1.0e-12
+
+            # Lower thresholds such that vector operations and ILU
+            # levels of this small problem are threaded
+            solver.parameters["minimum_size_per_thread"] = 1
+            solver.parameters["preconditioner"]["minimum_level_size"] = 1
+
+            solver.set_operator(A)
+            x.append(uBLASVector(b.size()))
+            solver.solve(x[-1], b)
+    finally:
+        parameters["num_threads"] = previous_num_threads
+
+    x[1].axpy(-1.0, x[0])
+    assert round(x[1].norm("l2")/x[0].norm("l2"), 8) == 0
@@ -102,3 +102,59 @@ def test_nullspace_check(backend):
 
     # Reset backend
     parameters["linear_algebra_backend"] = prev_backend
+
+
+@pytest.mark.parametrize('backend', backends)
+def test_nullspace_orthogonalize(backend):
+    # Check whether backend is available
+    if not has_linear_algebra_backend(backend):
+        pytest.skip('Need %s as backend to run this test' % backend)
+
+    # Set linear algebra backend
+    prev_backend = parameters["linear_algebra_backend"]
+    parameters["linear_algebra_backend"] = backend
+
+    # Elasticity function space and compatible vector
+    mesh = UnitSquareMesh(12, 12)
+    V = VectorFunctionSpace(mesh, 'CG', 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    A = assemble(inner(u, v)*dx)
+    x = Vector()
+    A.init_vector(x, 1)
+
+    # Translational and rotational modes
+    basis = [x.copy() for i in range(3)]
+    V.sub(0).dofmap().set(basis[0], 1.0)
+    V.sub(1).dofmap().set(basis[1], 1.0)
+    V.sub(0).dofmap().set_x(basis[2], -1.0, 1, V.mesh())
+    V.sub(1).dofmap().set_x(basis[2], 1.0, 0, V.mesh())
+    for b in basis:
+        b.apply("insert")
+
+    # Orthonormalize null space basis (vectors are modified in place)
+    null_space = VectorSpaceBasis(basis)
+    null_space.orthonormalize()
+    for i in range(3):
+        for j in range(3):
+            dot = basis[i].inner(basis[j])
+            assert round(dot - (1.0 if i == j else 0.0), 10) == 0
+
+    # Orthogonalize vector with respect to null space
+    y = x.copy()
+    y[:] = 1.0
+    z = y.copy()
+    null_space.orthogonalize(y)
+    for b in basis:
+        assert round(b.inner(y), 10) == 0
+    z.axpy(-1.0, y)
+    assert round(z.inner(y), 8) == 0
+
+    # Linearly dependent basis is detected
+    basis[1].zero()
+    V.sub(0).dofmap().set(basis[1], 2.0)
+    basis[1].apply("insert")
+    with pytest.raises(RuntimeError):
+        VectorSpaceBasis(basis).orthonormalize()
+
+    # Reset backend
+    parameters["linear_algebra_backend"] = prev_backend
@@ -0,0 +1,133 @@
+#!/usr/bin/env py.test
+
+"Unit tests for SLEPcEigenSolver"
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+
+from dolfin import *
+import pytest
+from dolfin_utils.test import *
+
+
+def assemble_problem():
+    "Assemble stiffness and mass matrix of 1D Laplacian"
+    mesh = UnitIntervalMesh(100)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    A = assemble(inner(grad(u), grad(v))*dx, tensor=PETScMatrix())
+    M = assemble(u*v*dx, tensor=PETScMatrix())
+    return A, M
+
+
+def smallest_eigenvalues(A, M, n):
+    "Compute n smallest eigenvalues by shift-and-invert around -1"
+    solver = SLEPcEigenSolver(A, M)
+    solver.parameters["problem_type"] = "gen_hermitian"
+    solver.parameters["spectral_transform"] = "shift-and-invert"
+    solver.parameters["spectral_shift"] = -1.0
+    solver.parameters["spectrum"] = "target magnitude"
+    solver.solve(n)
+    return sorted(solver.get_eigenvalue(i)[0] for i in range(n))
+
+
+@skip_if_not_PETsc_or_not_slepc
+def test_repeated_solve():
+    "Test that repeated solves (reusing the transform) give same result"
+    A, M = assemble_problem()
+    solver = SLEPcEigenSolver(A, M)
+    solver.parameters["problem_type"] = "gen_hermitian"
+    solver.parameters["spectral_transform"] = "shift-and-invert"
+    solver.parameters["spectral_shift"] = 10.0
+    solver.parameters["spectrum"] = "target magnitude"
+    solver.parameters["warm_start"] = True
+
+    solver.solve(1)
+    lr0, lc0 = solver.get_eigenvalue(0)
+    solver.solve(1)
+    lr1, lc1 = solver.get_eigenvalue(0)
+    assert round(lr0 - pi**2, 2) == 0
+    assert round(lr1 - lr0, 8) == 0
+
+    # Modified matrices are passed to the solver again
+    A *= 2.0
+    solver.solve(1)
+    lr2, lc2 = solver.get_eigenvalue(0)
+    assert round(lr2 - 2.0*lr0, 6) == 0
+
+
+def num_factorizations():
+    "Return number of numeric factorizations logged by PETSc"
+    from petsc4py import PETSc
+    events = ["MatLUFactorNum", "MatCholFctrNum"]
+    return sum(PETSc.Log.Event(e).getPerfInfo()["count"] for e in events)
+
+
+@skip_if_not_PETsc_or_not_slepc
+@skip_if_not_petsc4py
+def test_repeated_solve_reuses_factorization():
+    "Test that repeated solves do not refactorize unmodified operators"
+    from petsc4py import PETSc
+    PETSc.Log.begin()
+
+    A, M = assemble_problem()
+    solver = SLEPcEigenSolver(A, M)
+    solver.parameters["problem_type"] = "gen_hermitian"
+    solver.parameters["spectral_transform"] = "shift-and-invert"
+    solver.parameters["spectral_shift"] = 10.0
+    solver.parameters["spectrum"] = "target magnitude"
+    solver.parameters["warm_start"] = True
+
+    solver.solve(1)
+    count = num_factorizations()
+    assert count > 0
+
+    # Unmodified operators: factorization is reused
+    solver.solve(1)
+    assert num_factorizations() == count
+
+    # Modified operator: shifted operator is factorized again
+    A *= 2.0
+    solver.solve(1)
+    assert num_factorizations() > count
+
+
+@skip_if_not_PETsc_or_not_slepc
+def test_multishift_solve():
+    "Test computation of eigenpairs around several shifts"
+    A, M = assemble_problem()
+    solver = SLEPcEigenSolver(A, M)
+    solver.parameters["problem_type"] = "gen_hermitian"
+    solver.solve(2, [10.0, 40.0])
+
+    n = solver.get_number_converged()
+    assert n >= 4
+    values = sorted(solver.get_eigenvalue(i)[0] for i in range(n))
+    reference = smallest_eigenvalues(A, M, 4)
+    for value, ref in zip(values[:4], reference):
+        assert round(value - ref, 6) == 0
+
+    # Eigenpairs are returned for multi-shift solve
+    lr, lc, r, c = solver.get_eigenpair(0)
+    y = PETScVector()
+    A.init_vector(y, 0)
+    A.mult(r, y)
+    z = PETScVector()
+    M.init_vector(z, 0)
+    M.mult(r, z)
+    y.axpy(-lr, z)
+    assert y.norm("l2") < 1.0e-6*max(1.0, lr)*r.norm("l2")
@@ -0,0 +1,112 @@
+#!/usr/bin/env py.test
+
+"Unit tests for SymmetricEigenSolver"
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+
+from dolfin import *
+import numpy
+import pytest
+from dolfin_utils.test import *
+
+
+def assemble_problem():
+    "Assemble stiffness and mass matrix of 1D Laplacian"
+    mesh = UnitIntervalMesh(100)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    A = assemble(inner(grad(u), grad(v))*dx, tensor=EigenMatrix())
+    M = assemble(u*v*dx, tensor=EigenMatrix())
+    P = assemble((inner(grad(u), grad(v)) + u*v)*dx, tensor=EigenMatrix())
+    return A, M, P
+
+
+@skip_in_parallel
+@pytest.mark.parametrize("method", ["lobpcg", "lanczos"])
+def test_generalized_problem(method):
+    "Test computation of smallest eigenvalues of 1D Laplacian"
+    A, M, P = assemble_problem()
+    solver = SymmetricEigenSolver(A, M)
+    solver.parameters["solver"] = method
+    if method == "lobpcg":
+        solver.set_preconditioner(EigenLUSolver(P))
+    solver.solve(3)
+
+    # Eigenvalues of Neumann problem are (i*pi)**2
+    assert solver.get_number_converged() == 3
+    for i in range(3):
+        reference = (i*pi)**2
+        assert abs(solver.get_eigenvalue(i) - reference) < 1.0e-2*(1.0 + reference)
+
+    # Check residual of eigenpair
+    x = EigenVector()
+    lmbda = solver.get_eigenpair(x, 1)
+    y = EigenVector()
+    A.init_vector(y, 0)
+    A.mult(x, y)
+    z = EigenVector()
+    M.init_vector(z, 0)
+    M.mult(x, z)
+    y.axpy(-lmbda, z)
+    assert y.norm("l2") < 1.0e-6*lmbda*x.norm("l2")
+
+
+@skip_in_parallel
+@pytest.mark.parametrize("method", ["lobpcg", "lanczos"])
+def test_largest_eigenvalues(method):
+    "Test computation of largest eigenvalues of 1D Laplacian"
+    A, M, P = assemble_problem()
+    solver = SymmetricEigenSolver(A, M)
+    solver.parameters["solver"] = method
+    solver.parameters["spectrum"] = "largest real"
+    solver.solve(2)
+
+    # Compare with eigenvalues of dense problem
+    values = numpy.linalg.eigvals(numpy.linalg.solve(M.array(), A.array()))
+    reference = sorted(values.real, reverse=True)
+    assert solver.get_number_converged() == 2
+    for i in range(2):
+        assert abs(solver.get_eigenvalue(i) - reference[i]) < 1.0e-6*reference[i]
+
+
+@skip_in_parallel
+def test_ublas_backend():
+    "Test LOBPCG with uBLAS matrices and iterative preconditioner"
+    if not has_linear_algebra_backend("uBLAS"):
+        pytest.skip("Need uBLAS as backend to run this test")
+
+    mesh = UnitIntervalMesh(100)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u, v = TrialFunction(V), TestFunction(V)
+    A = assemble(inner(grad(u), grad(v))*dx, tensor=uBLASSparseMatrix())
+    M = assemble(u*v*dx, tensor=uBLASSparseMatrix())
+    P = assemble((inner(grad(u), grad(v)) + u*v)*dx,
+                 tensor=uBLASSparseMatrix())
+
+    preconditioner = uBLASKrylovSolver("gmres", "ilu")
+    preconditioner.parameters["relative_tolerance"] = 1.0e-4
+    preconditioner.set_operator(P)
+
+    solver = SymmetricEigenSolver(A, M)
+    solver.set_preconditioner(preconditioner)
+    solver.solve(3)
+
+    assert solver.get_number_converged() == 3
+    for i in range(3):
+        reference = (i*pi)**2
+        assert abs(solver.get_eigenvalue(i) - reference) < 1.0e-2*(1.0 + reference)
@@ -54,4 +54,29 @@ def test_3D_mesh():
     bmesh1 = BoundaryMesh(mesh, "exterior")
     assert MPI.sum(mesh.mpi_comm(), bmesh1.num_cells()) == 6*8*8*2
     assert bmesh1.size_global(2) == 6*8*8*2
-    assert bmesh1.topology().dim() == 2
\ No newline at end of file
+    assert bmesh1.topology().dim() == 2
+
+
+def test_update_coordinates():
+    mesh = UnitCubeMesh(4, 4, 4)
+    bmesh = BoundaryMesh(mesh, "exterior")
+
+    # Check vertex map
+    vertex_map = bmesh.entity_map(0).array()
+    assert numpy.allclose(bmesh.coordinates(),
+                          mesh.coordinates()[vertex_map])
+
+    # Move mesh and update boundary mesh coordinates
+    mesh.coordinates()[:] *= 2.0
+    bmesh.update_coordinates(mesh)
+    assert numpy.allclose(bmesh.coordinates(),
+                          mesh.coordinates()[vertex_map])
+
+    # Updated boundary mesh matches a recomputed boundary mesh
+    bmesh2 = BoundaryMesh(mesh, "exterior")
+    assert numpy.allclose(bmesh.coordinates(), bmesh2.coordinates())
+    assert (bmesh.cells() == bmesh2.cells()).all()
+
+    # Mesh of another size is rejected
+    with pytest.raises(RuntimeError):
+        bmesh.update_coordinates(UnitCubeMesh(2, 2, 2))
@@ -179,6 +179,26 @@ def test_UnitCubeMeshDistributedLocal():
     assert mesh.num_cells() == 1890
 
 
+@pytest.mark.parametrize("diagonal", ["left", "right", "left/right",
+                                      "right/left", "crossed"])
+def test_RectangleMeshDiagonals(diagonal):
+    """Create distributed rectangle mesh with each diagonal type."""
+    mesh = RectangleMesh(0.0, 0.0, 2.0, 3.0, 5, 7, diagonal)
+    num_vertices = 48 + (35 if diagonal == "crossed" else 0)
+    num_cells = (4 if diagonal == "crossed" else 2)*35
+    assert mesh.size_global(0) == num_vertices
+    assert mesh.size_global(2) == num_cells
+    assert round(assemble(Constant(1.0)*dx(mesh)) - 6.0, 7) == 0
+
+
+def test_BoxMeshVolume():
+    """Create distributed box mesh and check volume."""
+    mesh = BoxMesh(0.0, 0.0, 0.0, 2.0, 3.0, 4.0, 5, 7, 9)
+    assert mesh.size_global(0) == 480
+    assert mesh.size_global(3) == 1890
+    assert round(assemble(Constant(1.0)*dx(mesh)) - 24.0, 7) == 0
+
+
 @skip_in_parallel
 def test_LocalRefineUnitIntervalMesh():
     """Refine mesh of unit interval."""
@@ -432,3 +452,20 @@ def test_shared_entities():
                     sharing = e.sharing_processes()
                     assert isinstance(sharing, numpy.ndarray)
                     assert (sharing.size > 0) == e.is_shared()
+
+
+@skip_in_parallel
+def test_mesh_smooth():
+    "Test that smoothing improves quality of a perturbed mesh"
+    mesh = UnitSquareMesh(8, 8)
+    x = mesh.coordinates()
+    interior = numpy.logical_and(numpy.all(x > DOLFIN_EPS, axis=1),
+                                 numpy.all(x < 1.0 - DOLFIN_EPS, axis=1))
+    numpy.random.seed(1)
+    x[interior] += 0.03*(numpy.random.rand(interior.sum(), 2) - 0.5)
+    x_boundary = x[~interior].copy()
+    rmin = MeshQuality.radius_ratio_min_max(mesh)[0]
+
+    mesh.smooth(10)
+    assert MeshQuality.radius_ratio_min_max(mesh)[0] > rmin
+    assert numpy.allclose(mesh.coordinates()[~interior], x_boundary)
@@ -20,7 +20,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2011-03-10
-# Last changed: 2011-03-10
+# Last changed: 2015-06-12
 
 import pytest
 import numpy.random
@@ -139,3 +139,68 @@ def test_Assign(f, cube):
     f[3] = 10
     v = Vertex(cube, 3)
     assert f[v] == 10
+
+
+def test_state():
+    "Test that modification of values increases modification counter"
+    mesh = UnitSquareMesh(2, 2)
+    f = CellFunction("size_t", mesh, 0)
+    state = f.state()
+    f.set_all(1)
+    assert f.state() > state
+    state = f.state()
+    f[0] = 2
+    assert f.state() > state
+    state = f.state()
+    f.array()[:] = 3
+    assert f.state() > state
+
+
+@pytest.mark.parametrize("storage", ["auto", "uint8", "uint16", "uint64",
+                                     "sparse", "runlength"])
+def test_compact_mesh_function(storage):
+    "Test compact copy of facet markers"
+    mesh = UnitCubeMesh(4, 4, 4)
+    f = FacetFunction("size_t", mesh, 0)
+    DomainBoundary().mark(f, 3)
+    CompiledSubDomain("near(x[0], 0.0)").mark(f, 7)
+
+    g = CompactMeshFunction(f, storage)
+    assert g.dim() == f.dim()
+    assert g.size() == f.size()
+    for facet in facets(mesh):
+        assert g[facet] == f[facet]
+        assert g[facet.index()] == f[facet]
+
+    if storage == "auto":
+        assert g.storage() == "sparse"
+        assert g.num_bytes() < f.size()
+    else:
+        assert g.storage() == storage
+
+    h = FacetFunction("size_t", mesh)
+    g.get_values(h)
+    assert (h.array() == f.array()).all()
+
+
+def test_compact_mesh_function_storage_error():
+    "Test that values too large for storage format are detected"
+    mesh = UnitSquareMesh(2, 2)
+    f = CellFunction("size_t", mesh, 1000)
+    assert CompactMeshFunction(f, "uint16").storage() == "uint16"
+    with pytest.raises(RuntimeError):
+        CompactMeshFunction(f, "uint8")
+
+
+def test_compact_mesh_function_runlength():
+    "Test run-length storage of cell markers in contiguous blocks"
+    mesh = UnitSquareMesh(16, 16)
+    f = CellFunction("size_t", mesh)
+    n = mesh.num_cells()
+    for cell in cells(mesh):
+        f[cell] = 0 if cell.index() < n//3 else (2 if cell.index() < 2*n//3 else 5)
+
+    g = CompactMeshFunction(f)
+    assert g.storage() == "runlength"
+    for cell in cells(mesh):
+        assert g[cell] == f[cell]
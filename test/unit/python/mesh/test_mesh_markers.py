@@ -22,7 +22,7 @@ interaction between Mesh - MeshDomains - MeshMarkers"""
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2011-09-01
-# Last changed: 2011-09-02
+# Last changed: 2015-06-12
 
 import pytest
 from dolfin import *
@@ -63,3 +63,33 @@ def test_subdomain_marking():
 
     # FIXME: Add test here
     assert 0 == 0
+
+
+def test_subdomain_marking_overwrite():
+    "Test that marking mesh domains overwrites existing markers"
+
+    class Left(SubDomain):
+        def inside(self, x, on_boundary):
+            return x[0] < 0.5 + DOLFIN_EPS
+    class Everywhere(SubDomain):
+        def inside(self, x, on_boundary):
+            return True
+
+    mesh = UnitSquareMesh(4, 4)
+    Left().mark_cells(mesh, 1)
+    markers = mesh.domains().markers(2)
+    assert len(markers) == mesh.num_cells()//2
+    assert set(markers.values()) == set([1])
+
+    Everywhere().mark_cells(mesh, 2)
+    markers = mesh.domains().markers(2)
+    assert sorted(markers.keys()) == list(range(mesh.num_cells()))
+    assert set(markers.values()) == set([2])
+
+    # Mark MeshValueCollection and check against MeshFunction
+    mvc = MeshValueCollection("size_t", mesh, 1)
+    Left().mark(mvc, 3)
+    f = MeshFunction("size_t", mesh, mvc)
+    for facet in facets(mesh):
+        if facet.midpoint().x() < 0.5 + DOLFIN_EPS:
+            assert f[facet] == 3
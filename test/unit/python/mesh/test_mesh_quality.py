@@ -46,6 +46,22 @@ def test_radius_ratio_tetrahedron():
         assert round(ratios[c] - 0.717438935214, 7) == 0
         #print ratio[c]
 
+def test_cell_quality():
+
+    # Right-angled triangles
+    mesh = UnitSquareMesh(12, 12)
+    radius_ratio, aspect_ratio, min_angle = MeshQuality.cell_quality(mesh)
+    assert numpy.allclose(radius_ratio, 0.828427124746)
+    assert numpy.allclose(aspect_ratio,
+                          sqrt(2.0)*(2.0 + sqrt(2.0))/(2.0*sqrt(3.0)))
+    assert numpy.allclose(min_angle, 45.0)
+
+    # Tetrahedra of unit cube
+    mesh = UnitCubeMesh(4, 4, 4)
+    radius_ratio, aspect_ratio, min_angle = MeshQuality.cell_quality(mesh)
+    assert numpy.allclose(radius_ratio, 0.717438935214)
+    assert numpy.allclose(min_angle, 45.0)
+
 def test_radius_ratio_triangle_min_max():
 
     # Create mesh, collpase and compute min ratio
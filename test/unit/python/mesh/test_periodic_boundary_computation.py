@@ -20,7 +20,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-04-12
-# Last changed: 2014-05-30
+# Last changed: 2015-06-12
 
 import pytest
 import numpy as np
@@ -69,3 +69,43 @@ def test_MastersSlaves(pbc, periodic_boundary, mesh):
     mf = pbc.masters_slaves(mesh, periodic_boundary, 1)
     assert len(np.where(mf.array() == 1)[0]) == 4
     assert len(np.where(mf.array() == 2)[0]) == 4
+
+
+@skip_in_parallel
+def test_ComputePeriodicPairsMatch(pbc, periodic_boundary):
+
+    # Verify that each slave vertex is paired with the master vertex
+    # at its mapped position
+    mesh = UnitSquareMesh(64, 64)
+    x = mesh.coordinates()
+    vertices = pbc.compute_periodic_pairs(mesh, periodic_boundary, 0)
+    assert len(vertices) == 65
+    for slave, (process, master) in vertices.items():
+        assert process == 0
+        assert np.allclose(x[master], x[slave] - [1.0, 0.0])
+
+
+def test_CachedPeriodicPairs(periodic_boundary, mesh):
+
+    # Periodic pairs are cached by DofMapBuilder, so count how often
+    # they are computed when building function spaces
+    def num_computed():
+        V = FunctionSpace(mesh, "CG", 1, constrained_domain=periodic_boundary)
+        assert V.dim() == 20
+        return timing("Compute periodic pairs", TimingClear_keep)[0]
+
+    # Same sub domain on an unchanged mesh: cache hit
+    n = num_computed()
+    assert num_computed() == n
+
+    # Modified mesh: recomputed, then cached again
+    mesh.coordinates()[:, 1] += 0.5
+    assert num_computed() > n
+    n = num_computed()
+    assert num_computed() == n
+
+    # New sub domain: recomputed, then cached again
+    periodic_boundary = type(periodic_boundary)()
+    assert num_computed() > n
+    n = num_computed()
+    assert num_computed() == n
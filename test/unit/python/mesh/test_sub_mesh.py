@@ -20,6 +20,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 
 import os
+import numpy
 import pytest
 from dolfin import *
 import six
@@ -110,3 +111,17 @@ def test_facet_domain_propagation(datadir):
                 (outer_facets.array()==value).sum())
         assert ((parent_facets.array()==value).sum() ==
                 (outer_facets.array()==value).sum())
+
+@skip_in_parallel
+def test_update_coordinates():
+    mesh = UnitSquareMesh(8, 8)
+    smesh = SubMesh(mesh, CompiledSubDomain("x[0] <= 0.5 + DOLFIN_EPS"))
+    parent_vertices = smesh.data().array("parent_vertex_indices", 0)
+    assert numpy.allclose(smesh.coordinates(),
+                          mesh.coordinates()[parent_vertices])
+
+    # Move mesh and update submesh coordinates
+    mesh.coordinates()[:, 1] += 1.0
+    smesh.update_coordinates(mesh)
+    assert numpy.allclose(smesh.coordinates(),
+                          mesh.coordinates()[parent_vertices])
@@ -0,0 +1,116 @@
+#!/usr/bin/env py.test
+
+"""Unit tests for the fixed-point solver"""
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+#
+# First added:  2015-06-10
+# Last changed:
+
+from __future__ import print_function
+from dolfin import *
+import numpy
+import pytest
+
+from dolfin_utils.test import *
+
+
+class CosineProblem(NonlinearProblem):
+    "Fixed-point problem x = 0.9 cos(x), residual F(x) = x - 0.9 cos(x)"
+
+    def __init__(self):
+        NonlinearProblem.__init__(self)
+
+    def F(self, b, x):
+        values = x.array()
+        b.set_local(values - 0.9*numpy.cos(values))
+        b.apply("insert")
+
+    def J(self, A, x):
+        pass
+
+
+@pytest.mark.parametrize("depth", [0, 1, 5])
+def test_fixed_point_solver(depth):
+    "Test fixed-point solver with and without Anderson acceleration"
+    x = Vector(mpi_comm_world(), 20)
+    x.zero()
+
+    solver = FixedPointSolver()
+    solver.parameters["anderson_depth"] = depth
+    solver.parameters["absolute_tolerance"] = 1e-12
+    solver.parameters["relative_tolerance"] = 1e-12
+    num_iterations, converged = solver.solve(CosineProblem(), x)
+    assert converged
+
+    # Solution of x = 0.9 cos(x)
+    values = x.array()
+    assert numpy.allclose(values, 0.9*numpy.cos(values), atol=1e-10)
+
+
+def test_anderson_acceleration():
+    "Test that Anderson acceleration reduces the number of iterations"
+    iterations = []
+    for depth in [0, 3]:
+        x = Vector(mpi_comm_world(), 20)
+        x.zero()
+        solver = FixedPointSolver()
+        solver.parameters["anderson_depth"] = depth
+        solver.parameters["absolute_tolerance"] = 1e-12
+        iterations.append(solver.solve(CosineProblem(), x)[0])
+    assert iterations[1] < iterations[0]
+
+
+def test_linearly_dependent_history():
+    "Test that linearly dependent history columns are dropped"
+    # All entries of the iterates are equal, so the differences of
+    # residuals are parallel and only one history column is useful
+    iterations = []
+    for depth in [1, 5]:
+        x = Vector(mpi_comm_world(), 20)
+        x.zero()
+        solver = FixedPointSolver()
+        solver.parameters["anderson_depth"] = depth
+        solver.parameters["absolute_tolerance"] = 1e-12
+        iterations.append(solver.solve(CosineProblem(), x)[0])
+    assert iterations[1] <= iterations[0]
+
+
+class IdentityProblem(NonlinearProblem):
+    "Fixed-point problem x = 0, residual F(x) = x"
+
+    def __init__(self):
+        NonlinearProblem.__init__(self)
+
+    def F(self, b, x):
+        b.set_local(x.array())
+        b.apply("insert")
+
+    def J(self, A, x):
+        pass
+
+
+def test_zero_initial_residual():
+    "Test that an exact initial guess is accepted"
+    x = Vector(mpi_comm_world(), 20)
+    x.zero()
+    solver = FixedPointSolver()
+    num_iterations, converged = solver.solve(IdentityProblem(), x)
+    assert converged
+    assert num_iterations == 0
+    assert solver.relative_residual() == 0.0
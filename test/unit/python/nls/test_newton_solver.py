@@ -0,0 +1,100 @@
+#!/usr/bin/env py.test
+
+"""Unit tests for the Newton solver"""
+
+# Copyright (C) 2015 The DOLFIN authors
+#
+# This file is part of DOLFIN.
+#
+# DOLFIN is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# DOLFIN is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+#
+# First added:  2015-06-08
+# Last changed:
+
+from __future__ import print_function
+from dolfin import *
+import pytest
+
+from dolfin_utils.test import *
+
+
+def solve_nonlinear_poisson(newton_parameters):
+    "Solve -div((1 + u^2) grad(u)) = f and return the solution"
+    mesh = UnitSquareMesh(16, 16)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u = Function(V)
+    v = TestFunction(V)
+    du = TrialFunction(V)
+    f = Constant(10.0)
+    F = (1.0 + u**2)*inner(grad(u), grad(v))*dx - f*v*dx
+    J = derivative(F, u, du)
+    bc = DirichletBC(V, 0.0, "on_boundary")
+
+    problem = NonlinearVariationalProblem(F, u, bc, J)
+    solver = NonlinearVariationalSolver(problem)
+    solver.parameters["newton_solver"]["relative_tolerance"] = 1e-10
+    solver.parameters["newton_solver"]["absolute_tolerance"] = 1e-10
+    solver.parameters["newton_solver"]["maximum_iterations"] = 50
+    solver.parameters["newton_solver"].update(newton_parameters)
+    num_iterations, converged = solver.solve()
+    assert converged
+
+    return u
+
+
+@pytest.mark.parametrize("newton_parameters",
+                         [{"jacobian_lag": 3},
+                          {"jacobian_lag": 3, "preconditioner_lag": 2,
+                           "linear_solver": "gmres",
+                           "preconditioner": "ilu"},
+                          {"krylov_forcing_term": "eisenstat_walker",
+                           "linear_solver": "gmres",
+                           "preconditioner": "ilu"},
+                          {"fused_assembly": True},
+                          {"globalization": "backtracking"},
+                          {"globalization": "critical_point"},
+                          {"globalization": "trust_region"}])
+def test_newton_solver_options(newton_parameters):
+    "Test that Newton solver options give the same solution"
+    u0 = solve_nonlinear_poisson({"linear_solver": "lu"})
+    u1 = solve_nonlinear_poisson(newton_parameters)
+    assert round(errornorm(u0, u1, norm_type="L2", degree_rise=0), 7) == 0
+
+
+@pytest.mark.parametrize("globalization", ["backtracking", "critical_point",
+                                           "trust_region"])
+def test_newton_solver_damped_step(globalization):
+    "Test globalization on problem for which the full Newton step diverges"
+    # Newton's method for atan(u - 3) = 0 diverges from u = 0, so the
+    # globalized solver converges only if residuals are evaluated at
+    # the trial points
+    mesh = UnitSquareMesh(8, 8)
+    V = FunctionSpace(mesh, "Lagrange", 1)
+    u = Function(V)
+    v = TestFunction(V)
+    du = TrialFunction(V)
+    F = 0.01*inner(grad(u), grad(v))*dx + atan(u - 3.0)*v*dx
+    J = derivative(F, u, du)
+
+    problem = NonlinearVariationalProblem(F, u, [], J)
+    solver = NonlinearVariationalSolver(problem)
+    solver.parameters["newton_solver"]["relative_tolerance"] = 1e-10
+    solver.parameters["newton_solver"]["absolute_tolerance"] = 1e-10
+    solver.parameters["newton_solver"]["maximum_iterations"] = 50
+    solver.parameters["newton_solver"]["globalization"] = globalization
+    num_iterations, converged = solver.solve()
+    assert converged
+
+    u_exact = interpolate(Constant(3.0), V)
+    assert round(errornorm(u_exact, u, norm_type="L2", degree_rise=0), 7) == 0